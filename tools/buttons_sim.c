@@ -0,0 +1,197 @@
+//*****************************************************************************
+//
+// buttons_sim.c - Runs the firmware's button pin tables against simulated
+// GPIO ports.
+//
+// With no arguments, prints every player's pin map, then presses each pin
+// of every port in turn on otherwise idle ports and checks that each button
+// is pressed by exactly one pin and that no pin is shared between buttons.
+// The exit status is non-zero if the check fails.
+//
+// Arguments of the form PORT=VALUE set the simulated port values instead
+// and print the buttons each player would report, for example
+//
+//     buttons_sim B=0x41 F=0x01
+//
+// Ports not given read as idle, with every button released.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "button_map.h"
+
+//*****************************************************************************
+//
+// Fills in the port values with every button released.
+//
+//*****************************************************************************
+static void
+PortsIdle(uint8_t *pui8Ports, const uint8_t *pui8ActiveLow)
+{
+    uint32_t ui32Port;
+
+    for(ui32Port = 0; ui32Port < BUTTON_PORTS; ui32Port++)
+    {
+        pui8Ports[ui32Port] = pui8ActiveLow[ui32Port];
+    }
+}
+
+static void
+ButtonsPrint(uint32_t ui32Player, uint16_t ui16Buttons)
+{
+    uint32_t ui32Idx;
+
+    printf("player %u:", ui32Player + 1);
+    for(ui32Idx = 0; ui32Idx < BUTTON_MAP_BUTTONS; ui32Idx++)
+    {
+        if(ui16Buttons & (1 << ui32Idx))
+        {
+            printf(" %u", ui32Idx + 1);
+        }
+    }
+    printf("%s\n", ui16Buttons ? "" : " none");
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint8_t pui8Pins[BUTTON_PORTS], pui8ActiveLow[BUTTON_PORTS];
+    uint8_t pui8Ports[BUTTON_PORTS];
+    uint16_t pui16Seen[BUTTON_MAP_PLAYERS];
+    const tButtonMap *psMap;
+    const tButtonPin *psPin;
+    uint32_t ui32Player, ui32Port, ui32Bit, ui32Idx, ui32Hits, ui32Errors;
+    uint16_t ui16Buttons;
+    char cPort;
+    int iArg;
+
+    memset(pui8Pins, 0, sizeof(pui8Pins));
+    memset(pui8ActiveLow, 0, sizeof(pui8ActiveLow));
+    for(ui32Player = 0; ui32Player < BUTTON_MAP_PLAYERS; ui32Player++)
+    {
+        ButtonMapPins(&g_psButtonMaps[ui32Player], pui8Pins, pui8ActiveLow);
+    }
+    PortsIdle(pui8Ports, pui8ActiveLow);
+
+    //
+    // Map the given port values.
+    //
+    if(argc > 1)
+    {
+        for(iArg = 1; iArg < argc; iArg++)
+        {
+            cPort = argv[iArg][0] & ~0x20;
+            if((cPort < 'A') || (cPort >= ('A' + BUTTON_PORTS)) ||
+               (argv[iArg][1] != '='))
+            {
+                fprintf(stderr, "usage: buttons_sim [PORT=VALUE ...]\n");
+                return(2);
+            }
+            pui8Ports[cPort - 'A'] =
+                (uint8_t)strtoul(&argv[iArg][2], NULL, 0);
+        }
+
+        for(ui32Player = 0; ui32Player < BUTTON_MAP_PLAYERS; ui32Player++)
+        {
+            ButtonsPrint(ui32Player,
+                         ButtonMapApply(&g_psButtonMaps[ui32Player],
+                                        pui8Ports));
+        }
+
+        return(0);
+    }
+
+    //
+    // Print the tables.
+    //
+    for(ui32Player = 0; ui32Player < BUTTON_MAP_PLAYERS; ui32Player++)
+    {
+        psMap = &g_psButtonMaps[ui32Player];
+        printf("player %u, %u buttons\n", ui32Player + 1,
+               psMap->ui32NumButtons);
+
+        for(ui32Idx = 0; ui32Idx < psMap->ui32NumButtons; ui32Idx++)
+        {
+            psPin = &psMap->psPins[ui32Idx];
+            for(ui32Bit = 0; !(psPin->ui8Pin & (1 << ui32Bit)); ui32Bit++)
+            {
+            }
+            printf("  button %2u  P%c%u  active %s\n", ui32Idx + 1,
+                   'A' + psPin->ui8Port, ui32Bit,
+                   (psPin->ui8Flags & BUTTON_PIN_ACTIVE_LOW) ? "low" : "high");
+        }
+    }
+
+    //
+    // Press every pin in turn.
+    //
+    ui32Errors = 0;
+    memset(pui16Seen, 0, sizeof(pui16Seen));
+
+    for(ui32Port = 0; ui32Port < BUTTON_PORTS; ui32Port++)
+    {
+        for(ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+        {
+            PortsIdle(pui8Ports, pui8ActiveLow);
+            pui8Ports[ui32Port] ^= 1 << ui32Bit;
+            ui32Hits = 0;
+
+            for(ui32Player = 0; ui32Player < BUTTON_MAP_PLAYERS; ui32Player++)
+            {
+                ui16Buttons = ButtonMapApply(&g_psButtonMaps[ui32Player],
+                                             pui8Ports);
+                if(!ui16Buttons)
+                {
+                    continue;
+                }
+
+                if(ui16Buttons & (ui16Buttons - 1))
+                {
+                    printf("P%c%u presses several of player %u's buttons\n",
+                           'A' + ui32Port, ui32Bit, ui32Player + 1);
+                    ui32Errors++;
+                }
+                if(ui16Buttons & pui16Seen[ui32Player])
+                {
+                    printf("P%c%u presses a button of player %u that "
+                           "another pin also presses\n", 'A' + ui32Port,
+                           ui32Bit, ui32Player + 1);
+                    ui32Errors++;
+                }
+                pui16Seen[ui32Player] |= ui16Buttons;
+                ui32Hits++;
+            }
+
+            if(ui32Hits > 1)
+            {
+                printf("P%c%u is shared between players\n", 'A' + ui32Port,
+                       ui32Bit);
+                ui32Errors++;
+            }
+            if(!ui32Hits && (pui8Pins[ui32Port] & (1 << ui32Bit)))
+            {
+                printf("P%c%u presses nothing\n", 'A' + ui32Port, ui32Bit);
+                ui32Errors++;
+            }
+        }
+    }
+
+    for(ui32Player = 0; ui32Player < BUTTON_MAP_PLAYERS; ui32Player++)
+    {
+        if(pui16Seen[ui32Player] !=
+           (uint16_t)((1 << g_psButtonMaps[ui32Player].ui32NumButtons) - 1))
+        {
+            printf("player %u has buttons no pin presses\n", ui32Player + 1);
+            ui32Errors++;
+        }
+    }
+
+    printf("%s, %u error%s\n", ui32Errors ? "FAIL" : "ok", ui32Errors,
+           (ui32Errors == 1) ? "" : "s");
+
+    return(ui32Errors ? 1 : 0);
+}
@@ -0,0 +1,271 @@
+//*****************************************************************************
+//
+// gamepad_decode.c - Host-side decoder for the arcade stick input report.
+//
+// Reads raw input reports either from a Linux hidraw node or as hex text on
+// standard input and prints the decoded fields.  The layout comes from the
+// same schema the firmware uses, in usb_gamepad_report.h.
+//
+//     gamepad_decode /dev/hidraw3
+//     echo "00 02 08 20 80 00 00" | gamepad_decode
+//
+// When built with HIRES=1 for a firmware built with GAMEPAD_HIRES, the button
+// history in each report is stitched into a single timeline on the device's
+// sample clock and every button edge is printed with its time.  -e prints
+// only the edges.
+//
+//     gamepad_decode -e /dev/hidraw3
+//
+//*****************************************************************************
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "usb_gamepad_report.h"
+
+//*****************************************************************************
+//
+// Set by -e to print only reconstructed edges.
+//
+//*****************************************************************************
+static bool g_bEdgesOnly;
+
+//*****************************************************************************
+//
+// Prints one decoded report on a single line.
+//
+//*****************************************************************************
+#define PRINT_AXIS(name, usage, bits, min, max)                               \
+    printf(" " #name "=%u", psFields->ui16##name);
+#define PRINT_BUTTONS(name, count)                                            \
+    printf(" " #name "=0x%0*x", ((count) + 3) / 4,                            \
+           (unsigned)psFields->ui32##name);
+#define PRINT_VENDOR(name, bits, count)                                       \
+    for(ui32Idx = 0; ui32Idx < (count); ui32Idx++)                            \
+    {                                                                         \
+        printf(" " #name "[%u]=%u", ui32Idx, psFields->pui16##name[ui32Idx]); \
+    }
+
+static void
+ReportPrint(const tGamepadReportFields *psFields)
+{
+    uint32_t ui32Idx;
+
+    if(g_bEdgesOnly)
+    {
+        return;
+    }
+
+    ui32Idx = 0;
+
+    GAMEPAD_REPORT_FIELDS(PRINT_AXIS, PRINT_BUTTONS, PRINT_VENDOR)
+
+    (void)ui32Idx;
+    printf("\n");
+}
+
+#if GAMEPAD_HIRES
+//*****************************************************************************
+//
+// The reconstructed timeline.  g_ui64Sample is the absolute number of the
+// newest sample seen, counted from the newest slot of the first report, and
+// g_ui32State is the button state at that sample.
+//
+//*****************************************************************************
+static bool g_bTimelineValid;
+static uint64_t g_ui64Sample;
+static uint32_t g_ui32Seq;
+static uint32_t g_ui32State;
+
+//*****************************************************************************
+//
+// Prints every button that differs between two consecutive samples.
+//
+//*****************************************************************************
+static void
+EdgesPrint(uint64_t ui64Sample, uint32_t ui32Old, uint32_t ui32New,
+           uint32_t ui32LatencyUs)
+{
+    uint32_t ui32Changed, ui32Button;
+
+    ui32Changed = ui32Old ^ ui32New;
+
+    for(ui32Button = 0; ui32Changed; ui32Button++, ui32Changed >>= 1)
+    {
+        if(ui32Changed & 1)
+        {
+            printf("%12.3f ms Button%-2u %-7s reported after %u us\n",
+                   (double)(ui64Sample * GAMEPAD_HIRES_SLOT_US) / 1000.0,
+                   ui32Button + 1,
+                   (ui32New & (1 << ui32Button)) ? "press" : "release",
+                   ui32LatencyUs);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Merges the button history of one report into the timeline.  Slots already
+// seen in an earlier report are skipped, and a jump in the sequence number
+// larger than one report's worth of slots is reported as a gap.
+//
+//*****************************************************************************
+static void
+HiresDecode(const tGamepadReportFields *psFields)
+{
+    uint32_t ui32Seq, ui32New, ui32Idx, ui32Age, ui32LatencyUs;
+
+    ui32Seq = psFields->pui16HiresSeq[0];
+    ui32Age = psFields->pui16HiresAge[0];
+
+    if(!g_bTimelineValid)
+    {
+        //
+        // The first report only sets the starting state.
+        //
+        g_bTimelineValid = true;
+        g_ui64Sample = 0;
+        g_ui32Seq = ui32Seq;
+        g_ui32State = psFields->pui16HiresSlots[GAMEPAD_HIRES_SLOTS - 1];
+        return;
+    }
+
+    ui32New = (ui32Seq - g_ui32Seq) & 0xff;
+    g_ui32Seq = ui32Seq;
+
+    if(ui32New > GAMEPAD_HIRES_SLOTS)
+    {
+        printf("%12.3f ms gap of %u samples\n",
+               (double)((g_ui64Sample + 1) * GAMEPAD_HIRES_SLOT_US) / 1000.0,
+               ui32New - GAMEPAD_HIRES_SLOTS);
+        g_ui64Sample += ui32New - GAMEPAD_HIRES_SLOTS;
+        ui32New = GAMEPAD_HIRES_SLOTS;
+    }
+
+    for(ui32Idx = GAMEPAD_HIRES_SLOTS - ui32New; ui32Idx < GAMEPAD_HIRES_SLOTS;
+        ui32Idx++)
+    {
+        g_ui64Sample++;
+
+        //
+        // How long before the report was packed this slot was sampled.
+        //
+        ui32LatencyUs = ui32Age + ((GAMEPAD_HIRES_SLOTS - 1 - ui32Idx) *
+                                   GAMEPAD_HIRES_SLOT_US);
+
+        if(psFields->pui16HiresSlots[ui32Idx] != g_ui32State)
+        {
+            EdgesPrint(g_ui64Sample, g_ui32State,
+                       psFields->pui16HiresSlots[ui32Idx], ui32LatencyUs);
+            g_ui32State = psFields->pui16HiresSlots[ui32Idx];
+        }
+    }
+}
+#endif
+
+//*****************************************************************************
+//
+// Decodes and prints one packed report.
+//
+//*****************************************************************************
+static void
+ReportDecode(const uint8_t *pui8Report)
+{
+    tGamepadReportFields sFields;
+
+    GamepadReportUnpack(pui8Report, &sFields);
+    ReportPrint(&sFields);
+#if GAMEPAD_HIRES
+    HiresDecode(&sFields);
+#endif
+}
+
+//*****************************************************************************
+//
+// Reads whitespace separated hex bytes from standard input, one report per
+// GAMEPAD_REPORT_SIZE bytes.
+//
+//*****************************************************************************
+static int
+DecodeText(void)
+{
+    uint8_t pui8Report[GAMEPAD_REPORT_SIZE];
+    unsigned int uiByte;
+    uint32_t ui32Count;
+
+    ui32Count = 0;
+    while(scanf("%x", &uiByte) == 1)
+    {
+        pui8Report[ui32Count++] = (uint8_t)uiByte;
+        if(ui32Count == GAMEPAD_REPORT_SIZE)
+        {
+            ReportDecode(pui8Report);
+            ui32Count = 0;
+        }
+    }
+
+    if(ui32Count)
+    {
+        fprintf(stderr, "gamepad_decode: %u trailing bytes ignored\n",
+                ui32Count);
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Reads binary reports from a hidraw node until it is closed.
+//
+//*****************************************************************************
+static int
+DecodeDevice(const char *pcPath)
+{
+    uint8_t pui8Report[64];
+    ssize_t iRead;
+    int iFd;
+
+    iFd = open(pcPath, O_RDONLY);
+    if(iFd < 0)
+    {
+        perror(pcPath);
+        return(1);
+    }
+
+    while((iRead = read(iFd, pui8Report, sizeof(pui8Report))) > 0)
+    {
+        if(iRead != GAMEPAD_REPORT_SIZE)
+        {
+            fprintf(stderr, "gamepad_decode: %d byte report, expected %d\n",
+                    (int)iRead, GAMEPAD_REPORT_SIZE);
+            continue;
+        }
+
+        ReportDecode(pui8Report);
+        fflush(stdout);
+    }
+
+    close(iFd);
+    return(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    if((argc > 1) && !strcmp(argv[1], "-e"))
+    {
+        g_bEdgesOnly = true;
+        argc--;
+        argv++;
+    }
+
+    if(argc > 1)
+    {
+        return(DecodeDevice(argv[1]));
+    }
+
+    return(DecodeText());
+}
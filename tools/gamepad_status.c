@@ -0,0 +1,409 @@
+//*****************************************************************************
+//
+// gamepad_status.c - Reads the arcade stick's status feature report.
+//
+// Prints the polling interval the device published and the report rate the
+// host is really achieving, as measured by the firmware from SOF and
+// TX_COMPLETE counts.  With -i, asks the device to re-enumerate with a new
+// polling interval.  With -m, switches between reporting the buttons on the
+// gamepad and as keys on the keyboard interface.
+//
+// Also prints player one's configuration.  The other options change it,
+// starting from the configuration read back from the device:
+//
+//     -b INPUT=BUTTON  drive report button BUTTON from input INPUT, both
+//                      counting from 1; BUTTON 0 ignores the input
+//     -d MS            hold each button for MS milliseconds after a change
+//     -t HZ            turbo rate in presses per second, 0 for none
+//     -T LIST          turbo buttons, as a comma separated list or "none"
+//     -x MIN,MID,MAX   raw ADC calibration of the X axis
+//     -y MIN,MID,MAX   raw ADC calibration of the Y axis
+//     -o LIST          options: "always" sends a report every poll,
+//                      "noaxes" reports the axes centered, "none" clears
+//     -s               keep the new configuration over power off
+//     -r               go back to, and keep, the built-in configuration
+//
+//     gamepad_status /dev/hidraw3
+//     gamepad_status -i 1 /dev/hidraw3
+//     gamepad_status -m keyboard /dev/hidraw3
+//     gamepad_status -b 13=15 -b 15=13 -t 15 -T 1,2 -s /dev/hidraw3
+//     gamepad_status -x 120,2010,3980 /dev/hidraw3
+//
+//*****************************************************************************
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+#include "usb_gamepad_report.h"
+
+//*****************************************************************************
+//
+// Little endian field access.  The device uses no report IDs, so hidraw
+// returns the report number 0 in the first byte ahead of the data.
+//
+//*****************************************************************************
+#define STATUS_U8(pui8Buf, ui32Off)                                           \
+    ((uint32_t)(pui8Buf)[1 + (ui32Off)])
+#define STATUS_U16(pui8Buf, ui32Off)                                          \
+    (STATUS_U8(pui8Buf, ui32Off) | (STATUS_U8(pui8Buf, (ui32Off) + 1) << 8))
+#define STATUS_U32(pui8Buf, ui32Off)                                          \
+    (STATUS_U16(pui8Buf, ui32Off) | (STATUS_U16(pui8Buf, (ui32Off) + 2) << 16))
+#define STATUS_SET16(pui8Buf, ui32Off, ui32Value)                             \
+    do                                                                        \
+    {                                                                         \
+        (pui8Buf)[1 + (ui32Off)] = (uint8_t)(ui32Value);                      \
+        (pui8Buf)[2 + (ui32Off)] = (uint8_t)((ui32Value) >> 8);               \
+    }                                                                         \
+    while(0)
+
+static void
+Usage(void)
+{
+    fprintf(stderr, "usage: gamepad_status [-i interval_ms] "
+                    "[-m gamepad|keyboard] [-b input=button] [-d ms]\n"
+                    "                      [-t hz] [-T buttons] "
+                    "[-x min,mid,max] [-y min,mid,max]\n"
+                    "                      [-o options] [-s] [-r] "
+                    "/dev/hidrawN\n");
+    exit(2);
+}
+
+//*****************************************************************************
+//
+// Parses a comma separated list of report buttons, counting from 1, into a
+// mask.  "none" is the empty list.
+//
+//*****************************************************************************
+static uint32_t
+ButtonListParse(const char *pcList)
+{
+    uint32_t ui32Mask;
+    unsigned long ulButton;
+    char *pcEnd;
+
+    if(!strcmp(pcList, "none"))
+    {
+        return(0);
+    }
+
+    ui32Mask = 0;
+    while(*pcList)
+    {
+        ulButton = strtoul(pcList, &pcEnd, 10);
+        if((pcEnd == pcList) || (ulButton < 1) ||
+           (ulButton > GAMEPAD_CONFIG_INPUTS) ||
+           (*pcEnd && (*pcEnd != ',')))
+        {
+            Usage();
+        }
+        ui32Mask |= 1 << (ulButton - 1);
+        pcList = *pcEnd ? pcEnd + 1 : pcEnd;
+    }
+
+    return(ui32Mask);
+}
+
+//*****************************************************************************
+//
+// Parses an axis calibration into the report.
+//
+//*****************************************************************************
+static void
+CalParse(uint8_t *pui8Buf, uint32_t ui32Off, const char *pcCal)
+{
+    unsigned int puiCal[3];
+    uint32_t ui32Idx;
+
+    if(sscanf(pcCal, "%u,%u,%u", &puiCal[0], &puiCal[1], &puiCal[2]) != 3)
+    {
+        Usage();
+    }
+
+    for(ui32Idx = 0; ui32Idx < 3; ui32Idx++)
+    {
+        STATUS_SET16(pui8Buf, ui32Off + (ui32Idx * 2), puiCal[ui32Idx]);
+    }
+}
+
+//*****************************************************************************
+//
+// Prints the configuration fields of the report.
+//
+//*****************************************************************************
+static void
+ConfigPrint(const uint8_t *pui8Buf)
+{
+    uint32_t ui32Idx, ui32Button, ui32Mask, ui32Options;
+
+    printf("debounce       %u ms\n",
+           STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_DEBOUNCE));
+
+    printf("turbo          %u Hz, buttons",
+           STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_TURBO_HZ));
+    ui32Mask = STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_TURBO_MASK);
+    for(ui32Idx = 0; ui32Idx < GAMEPAD_CONFIG_INPUTS; ui32Idx++)
+    {
+        if(ui32Mask & (1 << ui32Idx))
+        {
+            printf(" %u", ui32Idx + 1);
+        }
+    }
+    printf("%s\n", ui32Mask ? "" : " none");
+
+    ui32Options = STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_OPTIONS);
+    printf("options       %s%s%s\n",
+           (ui32Options & GAMEPAD_CONFIG_OPT_ALWAYS) ? " always" : "",
+           (ui32Options & GAMEPAD_CONFIG_OPT_NO_AXES) ? " noaxes" : "",
+           ui32Options ? "" : " none");
+
+    printf("X calibration  %u, %u, %u\n",
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_CAL_X),
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_CAL_X + 2),
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_CAL_X + 4));
+    printf("Y calibration  %u, %u, %u\n",
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_CAL_Y),
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_CAL_Y + 2),
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_CAL_Y + 4));
+
+    printf("button map    ");
+    for(ui32Idx = 0; ui32Idx < GAMEPAD_CONFIG_INPUTS; ui32Idx++)
+    {
+        ui32Button = STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_BUTTON_MAP + ui32Idx);
+        if(ui32Button == GAMEPAD_CONFIG_BUTTON_NONE)
+        {
+            printf(" %u=0", ui32Idx + 1);
+        }
+        else if(ui32Button != ui32Idx)
+        {
+            printf(" %u=%u", ui32Idx + 1, ui32Button + 1);
+        }
+    }
+    printf(" (others unchanged)\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint8_t pui8Buf[GAMEPAD_STATUS_SIZE + 1];
+    uint8_t pui8Config[GAMEPAD_STATUS_SIZE + 1];
+    uint32_t ui32Seq;
+    unsigned int uiInput, uiButton;
+    int iOpt, iFd, iInterval, iMode, iCmd;
+    const char *pcDevice;
+    bool bConfig;
+
+    //
+    // Options that change the configuration are applied to a copy of the
+    // report once it has been read, so record them first.
+    //
+    iInterval = 0;
+    iMode = 0;
+    iCmd = GAMEPAD_CONFIG_CMD_APPLY;
+    bConfig = false;
+    while((iOpt = getopt(argc, argv, "i:m:b:d:t:T:x:y:o:sr")) != -1)
+    {
+        if(iOpt == 'i')
+        {
+            iInterval = atoi(optarg);
+        }
+        else if(strchr("bdtTxyosr", iOpt))
+        {
+            bConfig = true;
+            if(iOpt == 's')
+            {
+                iCmd = GAMEPAD_CONFIG_CMD_SAVE;
+            }
+            else if(iOpt == 'r')
+            {
+                iCmd = GAMEPAD_CONFIG_CMD_DEFAULTS;
+            }
+        }
+        else if((iOpt == 'm') && !strcmp(optarg, "gamepad"))
+        {
+            iMode = GAMEPAD_STATUS_MODE_GAMEPAD;
+        }
+        else if((iOpt == 'm') && !strcmp(optarg, "keyboard"))
+        {
+            iMode = GAMEPAD_STATUS_MODE_KEYBOARD;
+        }
+        else
+        {
+            Usage();
+        }
+    }
+
+    if(optind >= argc)
+    {
+        Usage();
+    }
+    pcDevice = argv[optind];
+
+    iFd = open(pcDevice, O_RDWR);
+    if(iFd < 0)
+    {
+        perror(pcDevice);
+        return(1);
+    }
+
+    memset(pui8Buf, 0, sizeof(pui8Buf));
+    if(ioctl(iFd, HIDIOCGFEATURE(sizeof(pui8Buf)), pui8Buf) < 0)
+    {
+        perror("HIDIOCGFEATURE");
+        return(1);
+    }
+
+    if(STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_VERSION) != GAMEPAD_STATUS_VERSION)
+    {
+        fprintf(stderr, "gamepad_status: unknown status version %u\n",
+                STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_VERSION));
+        return(1);
+    }
+
+    printf("bInterval      %u ms\n",
+           STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_INTERVAL));
+    printf("report rate    %u Hz\n",
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_REPORT_HZ));
+    printf("SOF rate       %u Hz\n",
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_SOF_HZ));
+    printf("poll phase     %u us after SOF\n",
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_PHASE_US));
+    printf("sync error     %u us mean\n",
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_ERROR_US));
+    printf("missed polls   %u of %u\n",
+           STATUS_U16(pui8Buf, GAMEPAD_STATUS_O_MISSED),
+           STATUS_U32(pui8Buf, GAMEPAD_STATUS_O_REPORTS));
+    printf("mode           %s\n",
+           (STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_MODE) ==
+            GAMEPAD_STATUS_MODE_KEYBOARD) ? "keyboard" : "gamepad");
+    ConfigPrint(pui8Buf);
+
+    //
+    // Apply the configuration options to what the device has now.
+    //
+    memcpy(pui8Config, pui8Buf, sizeof(pui8Config));
+    optind = 1;
+    while(bConfig && ((iOpt = getopt(argc, argv, "i:m:b:d:t:T:x:y:o:sr")) != -1))
+    {
+        switch(iOpt)
+        {
+            case 'b':
+            {
+                if((sscanf(optarg, "%u=%u", &uiInput, &uiButton) != 2) ||
+                   (uiInput < 1) || (uiInput > GAMEPAD_CONFIG_INPUTS) ||
+                   (uiButton > GAMEPAD_CONFIG_INPUTS))
+                {
+                    Usage();
+                }
+                pui8Config[1 + GAMEPAD_STATUS_O_BUTTON_MAP + uiInput - 1] =
+                    uiButton ? (uint8_t)(uiButton - 1) :
+                               GAMEPAD_CONFIG_BUTTON_NONE;
+                break;
+            }
+
+            case 'd':
+            {
+                pui8Config[1 + GAMEPAD_STATUS_O_DEBOUNCE] =
+                    (uint8_t)atoi(optarg);
+                break;
+            }
+
+            case 't':
+            {
+                pui8Config[1 + GAMEPAD_STATUS_O_TURBO_HZ] =
+                    (uint8_t)atoi(optarg);
+                break;
+            }
+
+            case 'T':
+            {
+                STATUS_SET16(pui8Config, GAMEPAD_STATUS_O_TURBO_MASK,
+                             ButtonListParse(optarg));
+                break;
+            }
+
+            case 'x':
+            case 'y':
+            {
+                CalParse(pui8Config, (iOpt == 'x') ? GAMEPAD_STATUS_O_CAL_X :
+                                                     GAMEPAD_STATUS_O_CAL_Y,
+                         optarg);
+                break;
+            }
+
+            case 'o':
+            {
+                pui8Config[1 + GAMEPAD_STATUS_O_OPTIONS] =
+                    (strstr(optarg, "always") ? GAMEPAD_CONFIG_OPT_ALWAYS : 0) |
+                    (strstr(optarg, "noaxes") ? GAMEPAD_CONFIG_OPT_NO_AXES : 0);
+                break;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    if(iInterval || iMode || bConfig)
+    {
+        //
+        // The interval and mode are only changed if asked for, and the
+        // configuration only if the command byte is set.
+        //
+        ui32Seq = STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_CONFIG_SEQ);
+        memcpy(pui8Buf, pui8Config, sizeof(pui8Buf));
+        pui8Buf[1 + GAMEPAD_STATUS_O_INTERVAL] = (uint8_t)iInterval;
+        pui8Buf[1 + GAMEPAD_STATUS_O_MODE] = (uint8_t)iMode;
+        pui8Buf[1 + GAMEPAD_STATUS_O_CONFIG_CMD] =
+            bConfig ? (uint8_t)iCmd : 0;
+        if(ioctl(iFd, HIDIOCSFEATURE(sizeof(pui8Buf)), pui8Buf) < 0)
+        {
+            perror("HIDIOCSFEATURE");
+            return(1);
+        }
+        if(iInterval)
+        {
+            printf("requested %d ms, device will re-enumerate\n", iInterval);
+        }
+        if(iMode)
+        {
+            printf("requested %s mode\n",
+                   (iMode == GAMEPAD_STATUS_MODE_KEYBOARD) ? "keyboard" :
+                                                             "gamepad");
+        }
+    }
+
+    //
+    // The device swaps a new configuration in before its next report, so
+    // by the time it answers another request the sequence number shows
+    // whether it was taken.
+    //
+    if(bConfig)
+    {
+        usleep(10000);
+        memset(pui8Buf, 0, sizeof(pui8Buf));
+        if(ioctl(iFd, HIDIOCGFEATURE(sizeof(pui8Buf)), pui8Buf) < 0)
+        {
+            perror("HIDIOCGFEATURE");
+            return(1);
+        }
+        if(STATUS_U8(pui8Buf, GAMEPAD_STATUS_O_CONFIG_SEQ) == ui32Seq)
+        {
+            fprintf(stderr, "gamepad_status: configuration rejected\n");
+            return(1);
+        }
+        printf("new configuration%s\n",
+               (iCmd == GAMEPAD_CONFIG_CMD_APPLY) ? "" : ", saved");
+        ConfigPrint(pui8Buf);
+    }
+
+    close(iFd);
+    return(0);
+}
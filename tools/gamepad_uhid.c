@@ -0,0 +1,234 @@
+//*****************************************************************************
+//
+// gamepad_uhid.c - Simulated arcade stick on a Linux uhid virtual device.
+//
+// Creates a hidraw node that produces reports in the GAMEPAD_TRACE layout, so
+// that hidlat and gamepad_decode can be exercised without the board.  The
+// simulated device runs its own microsecond clock with a configurable offset
+// and drift from the host, presses and releases buttons at random and can
+// drop reports to exercise gap detection.  Needs write access to /dev/uhid.
+//
+//     gamepad_uhid -d 40 -l 0.001 &
+//     hidlat -n 20000 /dev/hidrawN
+//
+//*****************************************************************************
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/uhid.h>
+#include "usb_gamepad_report.h"
+
+#if !GAMEPAD_TRACE
+#error gamepad_uhid must be built with GAMEPAD_TRACE=1
+#endif
+
+//*****************************************************************************
+//
+// A vendor-defined report descriptor with one input report of the same size
+// as the real one.  hidraw passes the bytes through untouched, so the real
+// field layout is not needed here.
+//
+//*****************************************************************************
+static const uint8_t g_pui8Descriptor[] =
+{
+    0x06, 0x00, 0xff,                   // Usage Page (Vendor)
+    0x09, 0x01,                         // Usage (1)
+    0xa1, 0x01,                         // Collection (Application)
+    0x15, 0x00,                         //   Logical Minimum (0)
+    0x26, 0xff, 0x00,                   //   Logical Maximum (255)
+    0x75, 0x08,                         //   Report Size (8)
+    0x95, GAMEPAD_REPORT_SIZE,          //   Report Count
+    0x09, 0x01,                         //   Usage (1)
+    0x81, 0x02,                         //   Input (Data, Variable, Absolute)
+    0xc0                                // End Collection
+};
+
+static volatile sig_atomic_t g_bStop;
+
+static void
+StopHandler(int iSig)
+{
+    (void)iSig;
+    g_bStop = 1;
+}
+
+//*****************************************************************************
+//
+// Returns the host monotonic clock in microseconds.
+//
+//*****************************************************************************
+static int64_t
+HostUs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return((int64_t)sNow.tv_sec * 1000000 + sNow.tv_nsec / 1000);
+}
+
+static void
+Usage(void)
+{
+    fprintf(stderr, "usage: gamepad_uhid [-r rate_hz] [-d drift_ppm] "
+                    "[-o offset_us] [-p press_prob] [-l loss_prob]\n");
+    exit(2);
+}
+
+static int
+EventWrite(int iFd, const struct uhid_event *psEvent)
+{
+    if(write(iFd, psEvent, sizeof(*psEvent)) != sizeof(*psEvent))
+    {
+        perror("uhid write");
+        return(-1);
+    }
+
+    return(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    double dDriftPpm, dPress, dLoss;
+    int64_t i64OffsetUs, i64Start, i64Host, i64PeriodUs;
+    uint32_t ui32Rate, ui32Dev, ui32Edge, ui32Seq;
+    tGamepadReportFields sFields;
+    struct uhid_event sEvent;
+    struct sigaction sAction;
+    struct timespec sNext;
+    int iOpt, iFd;
+
+    ui32Rate = 1000;
+    dDriftPpm = 25.0;
+    i64OffsetUs = 123456789;
+    dPress = 0.02;
+    dLoss = 0.0;
+
+    while((iOpt = getopt(argc, argv, "r:d:o:p:l:")) != -1)
+    {
+        switch(iOpt)
+        {
+            case 'r': ui32Rate = strtoul(optarg, NULL, 0); break;
+            case 'd': dDriftPpm = atof(optarg); break;
+            case 'o': i64OffsetUs = strtoll(optarg, NULL, 0); break;
+            case 'p': dPress = atof(optarg); break;
+            case 'l': dLoss = atof(optarg); break;
+            default: Usage();
+        }
+    }
+
+    if(!ui32Rate || (ui32Rate > 8000))
+    {
+        Usage();
+    }
+    i64PeriodUs = 1000000 / ui32Rate;
+
+    iFd = open("/dev/uhid", O_RDWR | O_CLOEXEC | O_NONBLOCK);
+    if(iFd < 0)
+    {
+        perror("/dev/uhid");
+        return(1);
+    }
+
+    memset(&sEvent, 0, sizeof(sEvent));
+    sEvent.type = UHID_CREATE2;
+    strcpy((char *)sEvent.u.create2.name, "Simulated arcade stick");
+    memcpy(sEvent.u.create2.rd_data, g_pui8Descriptor,
+           sizeof(g_pui8Descriptor));
+    sEvent.u.create2.rd_size = sizeof(g_pui8Descriptor);
+    sEvent.u.create2.bus = BUS_USB;
+    sEvent.u.create2.vendor = 0x1cbe;
+    sEvent.u.create2.product = 0xfffe;
+    if(EventWrite(iFd, &sEvent))
+    {
+        return(1);
+    }
+
+    memset(&sAction, 0, sizeof(sAction));
+    sAction.sa_handler = StopHandler;
+    sigaction(SIGINT, &sAction, NULL);
+    sigaction(SIGTERM, &sAction, NULL);
+
+    printf("simulating %u reports/s, drift %+.1f ppm, offset %lld us\n",
+           ui32Rate, dDriftPpm, (long long)i64OffsetUs);
+
+    memset(&sFields, 0, sizeof(sFields));
+    sFields.ui16X = sFields.ui16Y = sFields.ui16Z = sFields.ui16RX = 512;
+    ui32Seq = 0;
+    i64Start = HostUs();
+    clock_gettime(CLOCK_MONOTONIC, &sNext);
+
+    while(!g_bStop)
+    {
+        //
+        // Drain the events the kernel sends us.  None need a reply.
+        //
+        while(read(iFd, &sEvent, sizeof(sEvent)) > 0)
+        {
+        }
+
+        sNext.tv_nsec += i64PeriodUs * 1000;
+        while(sNext.tv_nsec >= 1000000000)
+        {
+            sNext.tv_nsec -= 1000000000;
+            sNext.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sNext, NULL);
+
+        //
+        // The device clock runs at (1 + drift) times the host rate from an
+        // arbitrary starting point, and never reads 0.
+        //
+        i64Host = HostUs();
+        ui32Dev = (uint32_t)(i64OffsetUs + (i64Host - i64Start) +
+                             (int64_t)((double)(i64Host - i64Start) *
+                                       dDriftPpm * 1e-6));
+        ui32Dev = ui32Dev ? ui32Dev : 1;
+
+        //
+        // Now and then flip a button, first seen at a random point in the
+        // last period.
+        //
+        ui32Edge = 0;
+        if(((double)rand() / RAND_MAX) < dPress)
+        {
+            sFields.ui32Buttons ^= 1 << (rand() % 15);
+            ui32Edge = ui32Dev - (uint32_t)(rand() % i64PeriodUs);
+            ui32Edge = ui32Edge ? ui32Edge : 1;
+        }
+
+        sFields.pui16TraceSeq[0] = (uint16_t)ui32Seq++;
+        GamepadTraceTimeSet(sFields.pui16TraceEdgeUs, ui32Edge);
+        GamepadTraceTimeSet(sFields.pui16TraceSentUs, ui32Dev);
+
+        if(((double)rand() / RAND_MAX) < dLoss)
+        {
+            continue;
+        }
+
+        memset(&sEvent, 0, sizeof(sEvent));
+        sEvent.type = UHID_INPUT2;
+        sEvent.u.input2.size = GAMEPAD_REPORT_SIZE;
+        GamepadReportPack(&sFields, sEvent.u.input2.data);
+        if(EventWrite(iFd, &sEvent) && (errno != EAGAIN))
+        {
+            break;
+        }
+    }
+
+    memset(&sEvent, 0, sizeof(sEvent));
+    sEvent.type = UHID_DESTROY;
+    EventWrite(iFd, &sEvent);
+    close(iFd);
+
+    return(0);
+}
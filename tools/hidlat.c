@@ -0,0 +1,465 @@
+//*****************************************************************************
+//
+// hidlat.c - End-to-end input latency measurement over hidraw.
+//
+// Reads reports from firmware built with GAMEPAD_TRACE (or from the
+// gamepad_uhid simulator) and timestamps each one on arrival.  The device and
+// host clocks are related by fitting a line through the lower envelope of
+// (host arrival - device send) over the run, which gives the clock offset and
+// drift.  Each button edge is then placed on the host clock and its latency
+// is the time from the first sample that saw it to the host read() returning.
+//
+// The lower envelope assumes that the fastest reports of the run spent no
+// time in transit, so the latencies are relative to the best case delivery
+// rather than absolute.  That best case is a fraction of the polling
+// interval, and it is constant for a given host, so the numbers can be
+// compared between builds and cabinets.
+//
+//     hidlat /dev/hidraw3
+//     hidlat -n 10000 /dev/hidraw3
+//
+// A summary is printed after -n reports, or on Ctrl-C.
+//
+//*****************************************************************************
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "usb_gamepad_report.h"
+
+#if !GAMEPAD_TRACE
+#error hidlat must be built with GAMEPAD_TRACE=1
+#endif
+
+//*****************************************************************************
+//
+// The number of reports in each window of the clock offset fit.  Each window
+// contributes its fastest delivery as one point on the lower envelope.
+//
+//*****************************************************************************
+#define FIT_WINDOW              500
+
+//*****************************************************************************
+//
+// Histogram bucket width and count.  The last bucket collects everything
+// beyond the range.
+//
+//*****************************************************************************
+#define HIST_BUCKET_US          250
+#define HIST_BUCKETS            20
+#define HIST_BAR                50
+
+//*****************************************************************************
+//
+// One received report, with both device times extended to 64 bits.
+//
+//*****************************************************************************
+typedef struct
+{
+    int64_t i64HostUs;
+    int64_t i64SentUs;
+    int64_t i64EdgeUs;
+    bool bEdge;
+}
+tSample;
+
+static tSample *g_psSamples;
+static size_t g_szSamples;
+static size_t g_szAlloc;
+
+//*****************************************************************************
+//
+// Sequence tracking.
+//
+//*****************************************************************************
+static bool g_bSeqValid;
+static uint32_t g_ui32Seq;
+static uint32_t g_ui32Gaps;
+static uint32_t g_ui32Lost;
+
+//*****************************************************************************
+//
+// Device clock extension.
+//
+//*****************************************************************************
+static bool g_bClockValid;
+static uint32_t g_ui32LastSent;
+static int64_t g_i64Sent;
+
+static volatile sig_atomic_t g_bStop;
+
+static void
+StopHandler(int iSig)
+{
+    (void)iSig;
+    g_bStop = 1;
+}
+
+//*****************************************************************************
+//
+// Returns the host monotonic clock in microseconds.
+//
+//*****************************************************************************
+static int64_t
+HostUs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return((int64_t)sNow.tv_sec * 1000000 + sNow.tv_nsec / 1000);
+}
+
+//*****************************************************************************
+//
+// Records one report.
+//
+//*****************************************************************************
+static void
+SampleAdd(const tGamepadReportFields *psFields, int64_t i64HostUs)
+{
+    uint32_t ui32Seq, ui32Sent, ui32Edge;
+    tSample *psSample;
+
+    //
+    // Look for reports that the device sent but the host never read.
+    //
+    ui32Seq = psFields->pui16TraceSeq[0];
+    if(g_bSeqValid && (((ui32Seq - g_ui32Seq) & 0xffff) != 1))
+    {
+        printf("gap: sequence %u to %u, %u reports lost\n", g_ui32Seq,
+               ui32Seq, ((ui32Seq - g_ui32Seq) & 0xffff) - 1);
+        g_ui32Gaps++;
+        g_ui32Lost += ((ui32Seq - g_ui32Seq) & 0xffff) - 1;
+    }
+    g_ui32Seq = ui32Seq;
+    g_bSeqValid = true;
+
+    //
+    // Extend the 32-bit device clock.
+    //
+    ui32Sent = GamepadTraceTimeGet(psFields->pui16TraceSentUs);
+    ui32Edge = GamepadTraceTimeGet(psFields->pui16TraceEdgeUs);
+    if(!g_bClockValid)
+    {
+        g_i64Sent = ui32Sent;
+        g_bClockValid = true;
+    }
+    else
+    {
+        g_i64Sent += (int32_t)(ui32Sent - g_ui32LastSent);
+    }
+    g_ui32LastSent = ui32Sent;
+
+    if(g_szSamples == g_szAlloc)
+    {
+        g_szAlloc = g_szAlloc ? (g_szAlloc * 2) : 4096;
+        g_psSamples = realloc(g_psSamples, g_szAlloc * sizeof(tSample));
+        if(!g_psSamples)
+        {
+            perror("hidlat");
+            exit(1);
+        }
+    }
+
+    psSample = &g_psSamples[g_szSamples++];
+    psSample->i64HostUs = i64HostUs;
+    psSample->i64SentUs = g_i64Sent;
+    psSample->bEdge = ui32Edge != 0;
+    psSample->i64EdgeUs = g_i64Sent - (int64_t)(uint32_t)(ui32Sent - ui32Edge);
+}
+
+//*****************************************************************************
+//
+// Fits host = device + dOffset + dDrift * (device - first device time)
+// through the fastest delivery of each window.
+//
+//*****************************************************************************
+static void
+ClockFit(double *pdOffset, double *pdDrift)
+{
+    double dX, dY, dSx, dSy, dSxx, dSxy, dN;
+    int64_t i64Base, i64Min, i64Delta;
+    size_t szIdx, szEnd, szMin;
+
+    i64Base = g_psSamples[0].i64SentUs;
+    dSx = dSy = dSxx = dSxy = dN = 0;
+
+    for(szIdx = 0; szIdx < g_szSamples; szIdx = szEnd)
+    {
+        szEnd = szIdx + FIT_WINDOW;
+        if(szEnd > g_szSamples)
+        {
+            szEnd = g_szSamples;
+        }
+
+        szMin = szIdx;
+        i64Min = INT64_MAX;
+        for(; szIdx < szEnd; szIdx++)
+        {
+            i64Delta = g_psSamples[szIdx].i64HostUs -
+                       g_psSamples[szIdx].i64SentUs;
+            if(i64Delta < i64Min)
+            {
+                i64Min = i64Delta;
+                szMin = szIdx;
+            }
+        }
+
+        dX = (double)(g_psSamples[szMin].i64SentUs - i64Base);
+        dY = (double)i64Min;
+        dSx += dX;
+        dSy += dY;
+        dSxx += dX * dX;
+        dSxy += dX * dY;
+        dN += 1;
+    }
+
+    if((dN < 2) || ((dN * dSxx - dSx * dSx) == 0))
+    {
+        *pdDrift = 0;
+        *pdOffset = dSy / dN;
+        return;
+    }
+
+    *pdDrift = (dN * dSxy - dSx * dSy) / (dN * dSxx - dSx * dSx);
+    *pdOffset = (dSy - *pdDrift * dSx) / dN;
+}
+
+static int
+CompareI64(const void *pvA, const void *pvB)
+{
+    int64_t i64A = *(const int64_t *)pvA, i64B = *(const int64_t *)pvB;
+
+    return((i64A > i64B) - (i64A < i64B));
+}
+
+//*****************************************************************************
+//
+// Prints p50/p99/max and a histogram of the given latencies, which are
+// sorted in place.
+//
+//*****************************************************************************
+static void
+LatencyPrint(const char *pcName, int64_t *pi64Us, size_t szCount)
+{
+    size_t pszHist[HIST_BUCKETS], szIdx, szMax, szBucket;
+    uint32_t ui32Bar;
+
+    if(!szCount)
+    {
+        printf("%s: no samples\n", pcName);
+        return;
+    }
+
+    qsort(pi64Us, szCount, sizeof(int64_t), CompareI64);
+
+    printf("%s: %zu samples, p50 %lld us, p99 %lld us, max %lld us\n",
+           pcName, szCount, (long long)pi64Us[szCount / 2],
+           (long long)pi64Us[(szCount * 99) / 100],
+           (long long)pi64Us[szCount - 1]);
+
+    memset(pszHist, 0, sizeof(pszHist));
+    for(szIdx = 0; szIdx < szCount; szIdx++)
+    {
+        szBucket = (pi64Us[szIdx] < 0) ? 0 :
+                   (size_t)(pi64Us[szIdx] / HIST_BUCKET_US);
+        if(szBucket >= HIST_BUCKETS)
+        {
+            szBucket = HIST_BUCKETS - 1;
+        }
+        pszHist[szBucket]++;
+    }
+
+    szMax = 0;
+    for(szIdx = 0; szIdx < HIST_BUCKETS; szIdx++)
+    {
+        if(pszHist[szIdx] > szMax)
+        {
+            szMax = pszHist[szIdx];
+        }
+    }
+
+    for(szIdx = 0; szIdx < HIST_BUCKETS; szIdx++)
+    {
+        if(!pszHist[szIdx])
+        {
+            continue;
+        }
+
+        if(szIdx == HIST_BUCKETS - 1)
+        {
+            printf("  %5u+      us %8zu ", HIST_BUCKET_US * (unsigned)szIdx,
+                   pszHist[szIdx]);
+        }
+        else
+        {
+            printf("  %5u-%-5u us %8zu ", HIST_BUCKET_US * (unsigned)szIdx,
+                   HIST_BUCKET_US * (unsigned)(szIdx + 1), pszHist[szIdx]);
+        }
+
+        for(ui32Bar = 0; ui32Bar < (pszHist[szIdx] * HIST_BAR) / szMax;
+            ui32Bar++)
+        {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+//*****************************************************************************
+//
+// Prints the summary for everything received so far.
+//
+//*****************************************************************************
+static void
+SummaryPrint(void)
+{
+    double dOffset, dDrift, dSeconds;
+    int64_t *pi64Edge, *pi64Report, i64Base, i64Host;
+    size_t szIdx, szEdges;
+
+    if(g_szSamples < 2)
+    {
+        printf("not enough reports\n");
+        return;
+    }
+
+    ClockFit(&dOffset, &dDrift);
+
+    dSeconds = (double)(g_psSamples[g_szSamples - 1].i64HostUs -
+                        g_psSamples[0].i64HostUs) / 1e6;
+    printf("\n%zu reports in %.1f s (%.0f/s), %u gaps, %u reports lost\n",
+           g_szSamples, dSeconds, (double)g_szSamples / dSeconds, g_ui32Gaps,
+           g_ui32Lost);
+    printf("clock offset %.0f us, device clock %+.1f ppm against host\n",
+           dOffset, -dDrift * 1e6);
+
+    pi64Edge = malloc(g_szSamples * sizeof(int64_t));
+    pi64Report = malloc(g_szSamples * sizeof(int64_t));
+    if(!pi64Edge || !pi64Report)
+    {
+        perror("hidlat");
+        exit(1);
+    }
+
+    i64Base = g_psSamples[0].i64SentUs;
+    szEdges = 0;
+    for(szIdx = 0; szIdx < g_szSamples; szIdx++)
+    {
+        i64Host = g_psSamples[szIdx].i64HostUs;
+
+        pi64Report[szIdx] = i64Host - (int64_t)(g_psSamples[szIdx].i64SentUs +
+            dOffset + dDrift * (double)(g_psSamples[szIdx].i64SentUs -
+                                        i64Base));
+
+        if(g_psSamples[szIdx].bEdge)
+        {
+            pi64Edge[szEdges++] = i64Host -
+                (int64_t)(g_psSamples[szIdx].i64EdgeUs + dOffset + dDrift *
+                          (double)(g_psSamples[szIdx].i64EdgeUs - i64Base));
+        }
+    }
+
+    LatencyPrint("edge to host", pi64Edge, szEdges);
+    LatencyPrint("report to host", pi64Report, g_szSamples);
+
+    free(pi64Edge);
+    free(pi64Report);
+}
+
+static void
+Usage(void)
+{
+    fprintf(stderr, "usage: hidlat [-n reports] /dev/hidrawN\n");
+    exit(2);
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint8_t pui8Report[64];
+    tGamepadReportFields sFields;
+    struct sigaction sAction;
+    unsigned long ulLimit;
+    ssize_t iRead;
+    int64_t i64Now;
+    int iOpt, iFd;
+
+    ulLimit = 0;
+    while((iOpt = getopt(argc, argv, "n:")) != -1)
+    {
+        if(iOpt == 'n')
+        {
+            ulLimit = strtoul(optarg, NULL, 0);
+        }
+        else
+        {
+            Usage();
+        }
+    }
+
+    if(optind >= argc)
+    {
+        Usage();
+    }
+
+    iFd = open(argv[optind], O_RDONLY);
+    if(iFd < 0)
+    {
+        perror(argv[optind]);
+        return(1);
+    }
+
+    //
+    // Let Ctrl-C interrupt the blocking read so the summary is printed.
+    //
+    memset(&sAction, 0, sizeof(sAction));
+    sAction.sa_handler = StopHandler;
+    sigaction(SIGINT, &sAction, NULL);
+    sigaction(SIGTERM, &sAction, NULL);
+
+    while(!g_bStop && (!ulLimit || (g_szSamples < ulLimit)))
+    {
+        iRead = read(iFd, pui8Report, sizeof(pui8Report));
+        i64Now = HostUs();
+
+        if(iRead < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            perror("read");
+            break;
+        }
+
+        if(iRead == 0)
+        {
+            break;
+        }
+
+        if(iRead != GAMEPAD_REPORT_SIZE)
+        {
+            fprintf(stderr, "hidlat: %d byte report, expected %d\n",
+                    (int)iRead, GAMEPAD_REPORT_SIZE);
+            continue;
+        }
+
+        GamepadReportUnpack(pui8Report, &sFields);
+        SampleAdd(&sFields, i64Now);
+    }
+
+    close(iFd);
+    SummaryPrint();
+    free(g_psSamples);
+
+    return(0);
+}
@@ -0,0 +1,260 @@
+//*****************************************************************************
+//
+// lcd_asset.c - Converts images into compressed assets for the firmware.
+//
+// Reads one or more binary PPM (P6) or uncompressed BMP images of the same
+// size, up to 128x160 pixels, and writes C source holding them as an array
+// of tLCDAsset from lcd_asset.h, for LCDAssetDraw() to draw.  Each band of
+// rows is stored in whichever stream encoding from lcd_stream.h comes out
+// smallest.  With several images the array is an animation, and with -d
+// every frame after the first holds only the rectangles that changed since
+// the frame before it.  Every frame is decoded again with the firmware's
+// own decoder and checked against its image before anything is written.
+//
+//     lcd_asset -n Splash -o splash splash.bmp
+//     lcd_asset -n Coin -o coin -d coin0.bmp coin1.bmp coin2.bmp
+//
+// writes splash.c and splash.h, with the array g_psSplash.  PNG and other
+// formats can be converted to BMP first with any image editor, or with
+// ImageMagick's "convert art.png BMP3:art.bmp".
+//
+//*****************************************************************************
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "lcd_stream.h"
+#include "lcd_image.h"
+
+//*****************************************************************************
+//
+// The number of stream bytes per line of the generated source.
+//
+//*****************************************************************************
+#define LCD_ASSET_LINE_BYTES    12
+
+static void
+Usage(void)
+{
+    fprintf(stderr, "usage: lcd_asset [-e raw|rle|pal] [-d] -n Name "
+                    "-o file image...\n");
+    exit(2);
+}
+
+//*****************************************************************************
+//
+// Writes the frames' streams and the array describing them.
+//
+//*****************************************************************************
+static int
+SourceWrite(const char *pcBase, const char *pcName, const tStream *psFrames,
+            uint32_t ui32Frames, uint32_t ui32Width, uint32_t ui32Height)
+{
+    char pcPath[1024];
+    uint32_t ui32Frame, ui32Idx;
+    FILE *psFile;
+
+    snprintf(pcPath, sizeof(pcPath), "%s.c", pcBase);
+    psFile = fopen(pcPath, "w");
+    if(!psFile)
+    {
+        perror(pcPath);
+        return(-1);
+    }
+
+    fprintf(psFile,
+            "//*********************************************************"
+            "********************\n"
+            "//\n"
+            "// %s - Generated by tools/lcd_asset.  Do not edit.\n"
+            "//\n"
+            "//*********************************************************"
+            "********************\n\n"
+            "#include <stdint.h>\n"
+            "#include \"lcd_asset.h\"\n", strrchr(pcPath, '/') ?
+            strrchr(pcPath, '/') + 1 : pcPath);
+
+    for(ui32Frame = 0; ui32Frame < ui32Frames; ui32Frame++)
+    {
+        fprintf(psFile, "\nstatic const uint8_t g_pui8%sFrame%u[%u] =\n{",
+                pcName, ui32Frame, psFrames[ui32Frame].ui32Len);
+        for(ui32Idx = 0; ui32Idx < psFrames[ui32Frame].ui32Len; ui32Idx++)
+        {
+            fprintf(psFile, "%s0x%02x%s",
+                    (ui32Idx % LCD_ASSET_LINE_BYTES) ? " " : "\n    ",
+                    psFrames[ui32Frame].pui8Data[ui32Idx],
+                    ((ui32Idx + 1) < psFrames[ui32Frame].ui32Len) ? "," : "");
+        }
+        fprintf(psFile, "\n};\n");
+    }
+
+    fprintf(psFile, "\nconst tLCDAsset g_ps%s[%u] =\n{\n", pcName,
+            ui32Frames);
+    for(ui32Frame = 0; ui32Frame < ui32Frames; ui32Frame++)
+    {
+        fprintf(psFile, "    { %u, %u, sizeof(g_pui8%sFrame%u), "
+                "g_pui8%sFrame%u }%s\n", ui32Width, ui32Height, pcName,
+                ui32Frame, pcName, ui32Frame,
+                ((ui32Frame + 1) < ui32Frames) ? "," : "");
+    }
+    fprintf(psFile, "};\n");
+
+    if(fclose(psFile))
+    {
+        perror(pcPath);
+        return(-1);
+    }
+
+    snprintf(pcPath, sizeof(pcPath), "%s.h", pcBase);
+    psFile = fopen(pcPath, "w");
+    if(!psFile)
+    {
+        perror(pcPath);
+        return(-1);
+    }
+
+    fprintf(psFile,
+            "//*********************************************************"
+            "********************\n"
+            "//\n"
+            "// %s - Generated by tools/lcd_asset.  Do not edit.\n"
+            "//\n"
+            "//*********************************************************"
+            "********************\n\n", strrchr(pcPath, '/') ?
+            strrchr(pcPath, '/') + 1 : pcPath);
+    fprintf(psFile, "extern const tLCDAsset g_ps%s[%u];\n", pcName,
+            ui32Frames);
+
+    if(fclose(psFile))
+    {
+        perror(pcPath);
+        return(-1);
+    }
+
+    return(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const char * const ppcNames[] = { "raw", "rle", "pal" };
+    uint32_t ui32Width, ui32Height, ui32FrameWidth, ui32FrameHeight;
+    uint32_t ui32Frame, ui32Frames, ui32Total;
+    uint16_t *pui16Image, *pui16Prev;
+    const char *pcName, *pcBase;
+    tStream *psFrames;
+    bool bDelta;
+    int iOpt, iEnc, iRects;
+
+    iEnc = -1;
+    bDelta = false;
+    pcName = pcBase = NULL;
+
+    while((iOpt = getopt(argc, argv, "e:dn:o:")) != -1)
+    {
+        switch(iOpt)
+        {
+            case 'd': bDelta = true; break;
+            case 'n': pcName = optarg; break;
+            case 'o': pcBase = optarg; break;
+            case 'e':
+            {
+                for(iEnc = 0; (iEnc < 3) && strcmp(optarg, ppcNames[iEnc]);
+                    iEnc++)
+                {
+                }
+                if(iEnc == 3)
+                {
+                    Usage();
+                }
+                break;
+            }
+            default: Usage();
+        }
+    }
+
+    if(!pcName || !pcBase || (optind >= argc))
+    {
+        Usage();
+    }
+
+    for(iOpt = 0; pcName[iOpt]; iOpt++)
+    {
+        if(!isalnum((unsigned char)pcName[iOpt]) && (pcName[iOpt] != '_'))
+        {
+            fprintf(stderr, "lcd_asset: %s is not a C identifier\n", pcName);
+            return(1);
+        }
+    }
+
+    ui32Frames = argc - optind;
+    psFrames = calloc(ui32Frames, sizeof(tStream));
+    if(!psFrames)
+    {
+        perror("calloc");
+        return(1);
+    }
+
+    ui32Width = ui32Height = 0;
+    ui32Total = 0;
+    pui16Prev = NULL;
+    for(ui32Frame = 0; ui32Frame < ui32Frames; ui32Frame++)
+    {
+        pui16Image = ImageRead(argv[optind + ui32Frame], &ui32FrameWidth,
+                               &ui32FrameHeight);
+        if(!pui16Image)
+        {
+            return(1);
+        }
+
+        if(!ui32Frame)
+        {
+            ui32Width = ui32FrameWidth;
+            ui32Height = ui32FrameHeight;
+        }
+        else if((ui32FrameWidth != ui32Width) ||
+                (ui32FrameHeight != ui32Height))
+        {
+            fprintf(stderr, "lcd_asset: %s is not the same size as %s\n",
+                    argv[optind + ui32Frame], argv[optind]);
+            return(1);
+        }
+
+        iRects = ImageEncode(&psFrames[ui32Frame], pui16Image,
+                             bDelta ? pui16Prev : NULL, ui32Width,
+                             ui32Height, 0, 0, iEnc);
+        if(iRects < 0)
+        {
+            fprintf(stderr, "lcd_asset: %s has more than %u colors\n",
+                    argv[optind + ui32Frame], LCD_STREAM_PALETTE_SIZE);
+            return(1);
+        }
+
+        printf("%s: %d rectangles, %u bytes (%.1f%% of raw)\n",
+               argv[optind + ui32Frame], iRects, psFrames[ui32Frame].ui32Len,
+               (100.0 * psFrames[ui32Frame].ui32Len) /
+               (ui32Width * ui32Height * 2));
+
+        if(StreamCheck(&psFrames[ui32Frame], pui16Image,
+                       bDelta ? pui16Prev : NULL, false, 0, 0, ui32Width,
+                       ui32Height))
+        {
+            return(1);
+        }
+
+        ui32Total += psFrames[ui32Frame].ui32Len;
+        free(pui16Prev);
+        pui16Prev = pui16Image;
+    }
+
+    printf("%u frames of %ux%u: %u bytes of flash (%.1f%% of raw)\n",
+           ui32Frames, ui32Width, ui32Height, ui32Total,
+           (100.0 * ui32Total) / (ui32Frames * ui32Width * ui32Height * 2));
+
+    return(SourceWrite(pcBase, pcName, psFrames, ui32Frames, ui32Width,
+                       ui32Height) ? 1 : 0);
+}
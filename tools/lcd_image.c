@@ -0,0 +1,729 @@
+//*****************************************************************************
+//
+// lcd_image.c - Image loading and LCD stream encoding shared by the host
+// tools.
+//
+// Images are read from binary PPM (P6) or uncompressed BMP files and
+// converted to the panel's RGB565.  Each region is encoded as whichever of
+// the stream encodings in lcd_stream.h comes out smallest, and a stream can
+// be decoded again with the firmware's own decoder to check it.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lcd_stream.h"
+#include "lcd_image.h"
+
+//*****************************************************************************
+//
+// The screen as rebuilt by the decoder for StreamCheck(), the rectangle
+// being drawn and the number of pixels the decoder produced past its end.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint16_t pui16Pixels[LCD_STREAM_WIDTH * LCD_STREAM_HEIGHT];
+    uint32_t ui32X;
+    uint32_t ui32Y;
+    uint32_t ui32Width;
+    uint32_t ui32Height;
+    uint32_t ui32Done;
+    uint32_t ui32Overrun;
+}
+tScreen;
+
+void
+StreamByte(tStream *psStream, uint8_t ui8Byte)
+{
+    if(psStream->ui32Len == psStream->ui32Size)
+    {
+        psStream->ui32Size = psStream->ui32Size ? psStream->ui32Size * 2 :
+                                                  1024;
+        psStream->pui8Data = realloc(psStream->pui8Data, psStream->ui32Size);
+        if(!psStream->pui8Data)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+
+    psStream->pui8Data[psStream->ui32Len++] = ui8Byte;
+}
+
+void
+StreamColor(tStream *psStream, uint16_t ui16Color)
+{
+    StreamByte(psStream, (uint8_t)ui16Color);
+    StreamByte(psStream, (uint8_t)(ui16Color >> 8));
+}
+
+//*****************************************************************************
+//
+// Converts 8-bit R, G and B to the panel's 16-bit color, the same way as
+// ST7735_Color565() in the firmware.
+//
+//*****************************************************************************
+uint16_t
+Color565(uint8_t ui8R, uint8_t ui8G, uint8_t ui8B)
+{
+    return((uint16_t)(((ui8B & 0xf8) << 8) | ((ui8G & 0xfc) << 3) |
+                      (ui8R >> 3)));
+}
+
+//*****************************************************************************
+//
+// Reads a binary PPM with a maximum value of 255.
+//
+//*****************************************************************************
+static int
+PPMTokenRead(FILE *psFile, uint32_t *pui32Value)
+{
+    int iChar;
+
+    //
+    // Skip white space and comments.
+    //
+    do
+    {
+        iChar = fgetc(psFile);
+        if(iChar == '#')
+        {
+            while((iChar != '\n') && (iChar != EOF))
+            {
+                iChar = fgetc(psFile);
+            }
+        }
+    }
+    while((iChar == ' ') || (iChar == '\t') || (iChar == '\r') ||
+          (iChar == '\n'));
+
+    if((iChar < '0') || (iChar > '9'))
+    {
+        return(-1);
+    }
+
+    *pui32Value = 0;
+    while((iChar >= '0') && (iChar <= '9'))
+    {
+        *pui32Value = (*pui32Value * 10) + (iChar - '0');
+        iChar = fgetc(psFile);
+    }
+
+    return(0);
+}
+
+static uint16_t *
+PPMRead(const char *pcPath, uint32_t *pui32Width, uint32_t *pui32Height)
+{
+    uint32_t ui32Max, ui32Idx, ui32Count;
+    uint8_t pui8RGB[3];
+    uint16_t *pui16Image;
+    FILE *psFile;
+
+    psFile = fopen(pcPath, "rb");
+    if(!psFile)
+    {
+        perror(pcPath);
+        return(NULL);
+    }
+
+    if((fgetc(psFile) != 'P') || (fgetc(psFile) != '6') ||
+       PPMTokenRead(psFile, pui32Width) || PPMTokenRead(psFile, pui32Height) ||
+       PPMTokenRead(psFile, &ui32Max) || (ui32Max != 255))
+    {
+        fprintf(stderr, "%s: not a binary PPM with 8-bit samples\n", pcPath);
+        fclose(psFile);
+        return(NULL);
+    }
+
+    ui32Count = *pui32Width * *pui32Height;
+    if(!ui32Count || (*pui32Width > LCD_STREAM_WIDTH) ||
+       (*pui32Height > LCD_STREAM_HEIGHT))
+    {
+        fprintf(stderr, "%s: %ux%u does not fit the %ux%u screen\n", pcPath,
+                *pui32Width, *pui32Height, LCD_STREAM_WIDTH,
+                LCD_STREAM_HEIGHT);
+        fclose(psFile);
+        return(NULL);
+    }
+
+    pui16Image = malloc(ui32Count * sizeof(uint16_t));
+    for(ui32Idx = 0; pui16Image && (ui32Idx < ui32Count); ui32Idx++)
+    {
+        if(fread(pui8RGB, 3, 1, psFile) != 1)
+        {
+            fprintf(stderr, "%s: truncated\n", pcPath);
+            free(pui16Image);
+            pui16Image = NULL;
+            break;
+        }
+
+        pui16Image[ui32Idx] = Color565(pui8RGB[0], pui8RGB[1], pui8RGB[2]);
+    }
+
+    fclose(psFile);
+    return(pui16Image);
+}
+
+
+//*****************************************************************************
+//
+// Reads an uncompressed Windows BMP of 8, 24 or 32 bits per pixel, bottom up
+// or top down.
+//
+//*****************************************************************************
+static uint32_t
+LE32(const uint8_t *pui8Data)
+{
+    return(pui8Data[0] | (pui8Data[1] << 8) | (pui8Data[2] << 16) |
+           ((uint32_t)pui8Data[3] << 24));
+}
+
+static uint16_t *
+BMPRead(const char *pcPath, uint32_t *pui32Width, uint32_t *pui32Height)
+{
+    uint8_t pui8Header[54], pui8Table[256 * 4], *pui8Row;
+    uint32_t ui32Offset, ui32Info, ui32Bits, ui32Colors, ui32Stride;
+    uint32_t ui32Row, ui32Col, ui32Line;
+    const uint8_t *pui8Pixel;
+    uint16_t *pui16Image;
+    int32_t i32Height;
+    FILE *psFile;
+
+    psFile = fopen(pcPath, "rb");
+    if(!psFile)
+    {
+        perror(pcPath);
+        return(NULL);
+    }
+
+    if((fread(pui8Header, sizeof(pui8Header), 1, psFile) != 1) ||
+       (pui8Header[0] != 'B') || (pui8Header[1] != 'M'))
+    {
+        fprintf(stderr, "%s: not a BMP\n", pcPath);
+        fclose(psFile);
+        return(NULL);
+    }
+
+    ui32Offset = LE32(pui8Header + 10);
+    ui32Info = LE32(pui8Header + 14);
+    *pui32Width = LE32(pui8Header + 18);
+    i32Height = (int32_t)LE32(pui8Header + 22);
+    ui32Bits = pui8Header[28] | (pui8Header[29] << 8);
+    ui32Colors = LE32(pui8Header + 46);
+    *pui32Height = (i32Height < 0) ? -i32Height : i32Height;
+
+    //
+    // BI_BITFIELDS is only accepted at 32 bits, where every writer in
+    // common use puts the channels where BI_RGB would.
+    //
+    if((ui32Info < 40) ||
+       ((ui32Bits != 8) && (ui32Bits != 24) && (ui32Bits != 32)) ||
+       (LE32(pui8Header + 30) && ((LE32(pui8Header + 30) != 3) ||
+                                  (ui32Bits != 32))))
+    {
+        fprintf(stderr, "%s: only uncompressed 8, 24 and 32-bit BMPs are "
+                        "supported\n", pcPath);
+        fclose(psFile);
+        return(NULL);
+    }
+
+    if(!*pui32Width || !*pui32Height ||
+       (*pui32Width > LCD_STREAM_WIDTH) || (*pui32Height > LCD_STREAM_HEIGHT))
+    {
+        fprintf(stderr, "%s: %ux%u does not fit the %ux%u screen\n", pcPath,
+                *pui32Width, *pui32Height, LCD_STREAM_WIDTH,
+                LCD_STREAM_HEIGHT);
+        fclose(psFile);
+        return(NULL);
+    }
+
+    if(ui32Bits == 8)
+    {
+        ui32Colors = (ui32Colors && (ui32Colors <= 256)) ? ui32Colors : 256;
+        memset(pui8Table, 0, sizeof(pui8Table));
+        if(fseek(psFile, 14 + ui32Info, SEEK_SET) ||
+           (fread(pui8Table, 4, ui32Colors, psFile) != ui32Colors))
+        {
+            fprintf(stderr, "%s: truncated\n", pcPath);
+            fclose(psFile);
+            return(NULL);
+        }
+    }
+
+    ui32Stride = ((*pui32Width * ui32Bits / 8) + 3) & ~3;
+    pui16Image = malloc(*pui32Width * *pui32Height * sizeof(uint16_t));
+    pui8Row = malloc(ui32Stride);
+    if(!pui16Image || !pui8Row || fseek(psFile, ui32Offset, SEEK_SET))
+    {
+        fprintf(stderr, "%s: cannot read pixels\n", pcPath);
+        free(pui16Image);
+        free(pui8Row);
+        fclose(psFile);
+        return(NULL);
+    }
+
+    for(ui32Row = 0; ui32Row < *pui32Height; ui32Row++)
+    {
+        if(fread(pui8Row, ui32Stride, 1, psFile) != 1)
+        {
+            fprintf(stderr, "%s: truncated\n", pcPath);
+            free(pui16Image);
+            pui16Image = NULL;
+            break;
+        }
+
+        ui32Line = (i32Height < 0) ? ui32Row : (*pui32Height - 1 - ui32Row);
+        for(ui32Col = 0; ui32Col < *pui32Width; ui32Col++)
+        {
+            if(ui32Bits == 8)
+            {
+                pui8Pixel = pui8Table + (pui8Row[ui32Col] * 4);
+            }
+            else
+            {
+                pui8Pixel = pui8Row + (ui32Col * (ui32Bits / 8));
+            }
+
+            pui16Image[(ui32Line * *pui32Width) + ui32Col] =
+                Color565(pui8Pixel[2], pui8Pixel[1], pui8Pixel[0]);
+        }
+    }
+
+    free(pui8Row);
+    fclose(psFile);
+    return(pui16Image);
+}
+
+//*****************************************************************************
+//
+// Reads a BMP or a binary PPM, chosen by the file's first bytes, as RGB565.
+//
+//*****************************************************************************
+uint16_t *
+ImageRead(const char *pcPath, uint32_t *pui32Width, uint32_t *pui32Height)
+{
+    FILE *psFile;
+    int iChar;
+
+    psFile = fopen(pcPath, "rb");
+    if(!psFile)
+    {
+        perror(pcPath);
+        return(NULL);
+    }
+    iChar = fgetc(psFile);
+    fclose(psFile);
+
+    if(iChar == 'B')
+    {
+        return(BMPRead(pcPath, pui32Width, pui32Height));
+    }
+
+    return(PPMRead(pcPath, pui32Width, pui32Height));
+}
+
+//*****************************************************************************
+//
+// Encoders.  Each appends a complete rectangle command to the stream, or
+// returns -1 if the image cannot be expressed in that encoding.
+//
+//*****************************************************************************
+static void
+RectHeader(tStream *psStream, uint32_t ui32X, uint32_t ui32Y,
+           uint32_t ui32Width, uint32_t ui32Height, uint8_t ui8Encoding)
+{
+    StreamByte(psStream, LCD_STREAM_CMD_RECT);
+    StreamByte(psStream, (uint8_t)ui32X);
+    StreamByte(psStream, (uint8_t)ui32Y);
+    StreamByte(psStream, (uint8_t)ui32Width);
+    StreamByte(psStream, (uint8_t)ui32Height);
+    StreamByte(psStream, ui8Encoding);
+}
+
+static int
+EncodeRaw(tStream *psStream, const uint16_t *pui16Image, uint32_t ui32X,
+          uint32_t ui32Y, uint32_t ui32Width, uint32_t ui32Height)
+{
+    uint32_t ui32Idx;
+
+    RectHeader(psStream, ui32X, ui32Y, ui32Width, ui32Height,
+               LCD_STREAM_ENC_RAW);
+    for(ui32Idx = 0; ui32Idx < (ui32Width * ui32Height); ui32Idx++)
+    {
+        StreamColor(psStream, pui16Image[ui32Idx]);
+    }
+
+    return(0);
+}
+
+static int
+EncodeRLE(tStream *psStream, const uint16_t *pui16Image, uint32_t ui32X,
+          uint32_t ui32Y, uint32_t ui32Width, uint32_t ui32Height)
+{
+    uint32_t ui32Idx, ui32Count, ui32Run, ui32Lit;
+
+    RectHeader(psStream, ui32X, ui32Y, ui32Width, ui32Height,
+               LCD_STREAM_ENC_RLE);
+
+    ui32Count = ui32Width * ui32Height;
+    ui32Idx = 0;
+    while(ui32Idx < ui32Count)
+    {
+        for(ui32Run = 1; ((ui32Idx + ui32Run) < ui32Count) &&
+                         (ui32Run < LCD_STREAM_RLE_MAX) &&
+                         (pui16Image[ui32Idx + ui32Run] ==
+                          pui16Image[ui32Idx]); ui32Run++)
+        {
+        }
+
+        if(ui32Run > 1)
+        {
+            StreamByte(psStream, (uint8_t)(0x80 | (ui32Run - 1)));
+            StreamColor(psStream, pui16Image[ui32Idx]);
+            ui32Idx += ui32Run;
+            continue;
+        }
+
+        //
+        // Gather literals up to the start of the next run of two or more.
+        //
+        for(ui32Lit = 1; ((ui32Idx + ui32Lit) < ui32Count) &&
+                         (ui32Lit < LCD_STREAM_RLE_MAX); ui32Lit++)
+        {
+            if(((ui32Idx + ui32Lit + 1) < ui32Count) &&
+               (pui16Image[ui32Idx + ui32Lit] ==
+                pui16Image[ui32Idx + ui32Lit + 1]))
+            {
+                break;
+            }
+        }
+
+        StreamByte(psStream, (uint8_t)(ui32Lit - 1));
+        while(ui32Lit--)
+        {
+            StreamColor(psStream, pui16Image[ui32Idx++]);
+        }
+    }
+
+    return(0);
+}
+
+static int
+EncodePalette(tStream *psStream, const uint16_t *pui16Image, uint32_t ui32X,
+              uint32_t ui32Y, uint32_t ui32Width, uint32_t ui32Height)
+{
+    uint16_t pui16Palette[LCD_STREAM_PALETTE_SIZE];
+    uint32_t ui32Colors, ui32Idx, ui32Count, ui32Entry, ui32Run;
+
+    ui32Count = ui32Width * ui32Height;
+    ui32Colors = 0;
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        for(ui32Entry = 0; (ui32Entry < ui32Colors) &&
+                           (pui16Palette[ui32Entry] != pui16Image[ui32Idx]);
+            ui32Entry++)
+        {
+        }
+
+        if(ui32Entry == ui32Colors)
+        {
+            if(ui32Colors == LCD_STREAM_PALETTE_SIZE)
+            {
+                return(-1);
+            }
+            pui16Palette[ui32Colors++] = pui16Image[ui32Idx];
+        }
+    }
+
+    StreamByte(psStream, LCD_STREAM_CMD_PALETTE);
+    StreamByte(psStream, (uint8_t)ui32Colors);
+    for(ui32Entry = 0; ui32Entry < ui32Colors; ui32Entry++)
+    {
+        StreamColor(psStream, pui16Palette[ui32Entry]);
+    }
+
+    RectHeader(psStream, ui32X, ui32Y, ui32Width, ui32Height,
+               LCD_STREAM_ENC_PAL_RLE);
+
+    ui32Idx = 0;
+    while(ui32Idx < ui32Count)
+    {
+        for(ui32Run = 1; ((ui32Idx + ui32Run) < ui32Count) &&
+                         (ui32Run < 16) &&
+                         (pui16Image[ui32Idx + ui32Run] ==
+                          pui16Image[ui32Idx]); ui32Run++)
+        {
+        }
+
+        for(ui32Entry = 0; pui16Palette[ui32Entry] != pui16Image[ui32Idx];
+            ui32Entry++)
+        {
+        }
+
+        StreamByte(psStream, (uint8_t)(((ui32Run - 1) << 4) | ui32Entry));
+        ui32Idx += ui32Run;
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Decoder callbacks for StreamCheck().
+//
+//*****************************************************************************
+static void
+ScreenWindow(void *pvCBData, uint32_t ui32X, uint32_t ui32Y,
+             uint32_t ui32Width, uint32_t ui32Height)
+{
+    tScreen *psScreen = pvCBData;
+
+    psScreen->ui32X = ui32X;
+    psScreen->ui32Y = ui32Y;
+    psScreen->ui32Width = ui32Width;
+    psScreen->ui32Height = ui32Height;
+    psScreen->ui32Done = 0;
+}
+
+static void
+ScreenPixels(void *pvCBData, uint16_t ui16Color, uint32_t ui32Count)
+{
+    tScreen *psScreen = pvCBData;
+    uint32_t ui32Col, ui32Row;
+
+    while(ui32Count--)
+    {
+        if(psScreen->ui32Done >= (psScreen->ui32Width * psScreen->ui32Height))
+        {
+            psScreen->ui32Overrun++;
+            continue;
+        }
+
+        ui32Col = psScreen->ui32X + (psScreen->ui32Done % psScreen->ui32Width);
+        ui32Row = psScreen->ui32Y + (psScreen->ui32Done / psScreen->ui32Width);
+        psScreen->pui16Pixels[(ui32Row * LCD_STREAM_WIDTH) + ui32Col] =
+            ui16Color;
+        psScreen->ui32Done++;
+    }
+}
+
+//*****************************************************************************
+//
+// Decodes the stream in USB-packet-sized pieces, as the firmware sees it,
+// and compares the result with the image.
+//
+//*****************************************************************************
+int
+StreamCheck(const tStream *psStream, const uint16_t *pui16Image,
+            const uint16_t *pui16Prev, bool bClear, uint32_t ui32X,
+            uint32_t ui32Y, uint32_t ui32Width, uint32_t ui32Height)
+{
+    tLCDStreamDecoder sDecoder;
+    static tScreen sScreen;
+    uint32_t ui32Off, ui32Len, ui32Row, ui32Col, ui32Bad;
+
+    //
+    // Start from a screen that matches neither image unless the stream
+    // clears it, or from the previous image for a dirty rectangle update.
+    //
+    for(ui32Off = 0; ui32Off < (LCD_STREAM_WIDTH * LCD_STREAM_HEIGHT);
+        ui32Off++)
+    {
+        sScreen.pui16Pixels[ui32Off] = bClear ? 0 : 0xa5a5;
+    }
+    sScreen.ui32Overrun = 0;
+    for(ui32Row = 0; pui16Prev && (ui32Row < ui32Height); ui32Row++)
+    {
+        memcpy(&sScreen.pui16Pixels[((ui32Y + ui32Row) * LCD_STREAM_WIDTH) +
+                                    ui32X],
+               pui16Prev + (ui32Row * ui32Width),
+               ui32Width * sizeof(uint16_t));
+    }
+    LCDStreamInit(&sDecoder, ScreenWindow, ScreenPixels, &sScreen);
+
+    for(ui32Off = 0; ui32Off < psStream->ui32Len; ui32Off += ui32Len)
+    {
+        ui32Len = psStream->ui32Len - ui32Off;
+        ui32Len = (ui32Len > 64) ? 64 : ui32Len;
+        LCDStreamDecode(&sDecoder, psStream->pui8Data + ui32Off, ui32Len);
+    }
+
+    ui32Bad = 0;
+    for(ui32Row = 0; ui32Row < ui32Height; ui32Row++)
+    {
+        for(ui32Col = 0; ui32Col < ui32Width; ui32Col++)
+        {
+            if(sScreen.pui16Pixels[((ui32Y + ui32Row) * LCD_STREAM_WIDTH) +
+                                   ui32X + ui32Col] !=
+               pui16Image[(ui32Row * ui32Width) + ui32Col])
+            {
+                ui32Bad++;
+            }
+        }
+    }
+
+    printf("check: %u pixels differ, %u decoder errors, %u pixels past their "
+           "rectangle\n", ui32Bad, sDecoder.ui32Errors, sScreen.ui32Overrun);
+
+    return((ui32Bad || sDecoder.ui32Errors || sScreen.ui32Overrun) ? -1 : 0);
+}
+
+
+//*****************************************************************************
+//
+// Encodes one region of the image every way allowed and appends the
+// smallest to the stream.
+//
+// \return Returns the encoding used, or -1 if none could express it.
+//
+//*****************************************************************************
+int
+RegionEncode(tStream *psOut, const uint16_t *pui16Image, uint32_t ui32Stride,
+             uint32_t ui32X, uint32_t ui32Y, uint32_t ui32Width,
+             uint32_t ui32Height, uint32_t ui32ScreenX, uint32_t ui32ScreenY,
+             int iEnc)
+{
+    typedef int (*tEncodeFn)(tStream *, const uint16_t *, uint32_t, uint32_t,
+                             uint32_t, uint32_t);
+    static const tEncodeFn ppfnEncoders[] =
+    {
+        EncodeRaw, EncodeRLE, EncodePalette
+    };
+    tStream sStream, sBest;
+    uint16_t *pui16Region;
+    uint32_t ui32Row;
+    int iIdx, iBest;
+
+    //
+    // Copy the region out so the encoders see contiguous rows.
+    //
+    pui16Region = malloc(ui32Width * ui32Height * sizeof(uint16_t));
+    if(!pui16Region)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    for(ui32Row = 0; ui32Row < ui32Height; ui32Row++)
+    {
+        memcpy(pui16Region + (ui32Row * ui32Width),
+               pui16Image + ((ui32Y + ui32Row) * ui32Stride) + ui32X,
+               ui32Width * sizeof(uint16_t));
+    }
+
+    memset(&sBest, 0, sizeof(sBest));
+    iBest = -1;
+    for(iIdx = 0; iIdx < 3; iIdx++)
+    {
+        if((iEnc >= 0) && (iIdx != iEnc))
+        {
+            continue;
+        }
+
+        memset(&sStream, 0, sizeof(sStream));
+        if(ppfnEncoders[iIdx](&sStream, pui16Region, ui32ScreenX + ui32X,
+                              ui32ScreenY + ui32Y, ui32Width, ui32Height))
+        {
+            free(sStream.pui8Data);
+            continue;
+        }
+
+        if((iBest < 0) || (sStream.ui32Len < sBest.ui32Len))
+        {
+            free(sBest.pui8Data);
+            sBest = sStream;
+            iBest = iIdx;
+        }
+        else
+        {
+            free(sStream.pui8Data);
+        }
+    }
+
+    for(ui32Row = 0; ui32Row < sBest.ui32Len; ui32Row++)
+    {
+        StreamByte(psOut, sBest.pui8Data[ui32Row]);
+    }
+
+    free(sBest.pui8Data);
+    free(pui16Region);
+
+    return(iBest);
+}
+
+
+//*****************************************************************************
+//
+// Encodes an image to be drawn at (ui32X, ui32Y), as the smallest encoding
+// allowed for each band of LCD_IMAGE_BAND rows.  If pui16Prev is given,
+// only the rectangles that differ from it are encoded: each band gets the
+// bounding box of its changes, which keeps the rectangles tight without
+// much overhead.
+//
+// \param iEnc is the LCD_STREAM_ENC_x encoding to use, or -1 for any.
+//
+// \return Returns the number of rectangles encoded, or -1 if a band could
+// not be expressed in the encodings allowed.
+//
+//*****************************************************************************
+int
+ImageEncode(tStream *psOut, const uint16_t *pui16Image,
+            const uint16_t *pui16Prev, uint32_t ui32Width, uint32_t ui32Height,
+            uint32_t ui32X, uint32_t ui32Y, int iEnc)
+{
+    uint32_t ui32Band, ui32Row, ui32Col, ui32X0, ui32X1, ui32Y0, ui32Y1;
+    int iRects;
+
+    iRects = 0;
+    for(ui32Band = 0; ui32Band < ui32Height; ui32Band += LCD_IMAGE_BAND)
+    {
+        ui32Y0 = ui32Band;
+        ui32Y1 = ui32Band + LCD_IMAGE_BAND;
+        ui32Y1 = (ui32Y1 > ui32Height) ? ui32Height : ui32Y1;
+        ui32X0 = 0;
+        ui32X1 = ui32Width;
+
+        if(pui16Prev)
+        {
+            ui32X0 = ui32Width;
+            ui32X1 = 0;
+            ui32Y0 = ui32Height;
+            ui32Y1 = 0;
+            for(ui32Row = ui32Band; (ui32Row < (ui32Band + LCD_IMAGE_BAND)) &&
+                                    (ui32Row < ui32Height); ui32Row++)
+            {
+                for(ui32Col = 0; ui32Col < ui32Width; ui32Col++)
+                {
+                    if(pui16Image[(ui32Row * ui32Width) + ui32Col] !=
+                       pui16Prev[(ui32Row * ui32Width) + ui32Col])
+                    {
+                        ui32X0 = (ui32Col < ui32X0) ? ui32Col : ui32X0;
+                        ui32X1 = (ui32Col >= ui32X1) ? ui32Col + 1 : ui32X1;
+                        ui32Y0 = (ui32Row < ui32Y0) ? ui32Row : ui32Y0;
+                        ui32Y1 = ui32Row + 1;
+                    }
+                }
+            }
+
+            if(ui32X0 >= ui32X1)
+            {
+                continue;
+            }
+        }
+
+        if(RegionEncode(psOut, pui16Image, ui32Width, ui32X0, ui32Y0,
+                        ui32X1 - ui32X0, ui32Y1 - ui32Y0, ui32X, ui32Y,
+                        iEnc) < 0)
+        {
+            return(-1);
+        }
+        iRects++;
+    }
+
+    return(iRects);
+}
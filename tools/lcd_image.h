@@ -0,0 +1,55 @@
+//*****************************************************************************
+//
+// lcd_image.h - Image loading and LCD stream encoding shared by the host
+// tools.
+//
+//*****************************************************************************
+
+#ifndef _LCD_IMAGE_H_
+#define _LCD_IMAGE_H_
+
+//*****************************************************************************
+//
+// The height of the bands of rows that each get their own dirty rectangle
+// when only the changes from a previous image are encoded.
+//
+//*****************************************************************************
+#define LCD_IMAGE_BAND          16
+
+//*****************************************************************************
+//
+// A growable output buffer for the encoded stream.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t *pui8Data;
+    uint32_t ui32Len;
+    uint32_t ui32Size;
+}
+tStream;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void StreamByte(tStream *psStream, uint8_t ui8Byte);
+extern void StreamColor(tStream *psStream, uint16_t ui16Color);
+extern uint16_t Color565(uint8_t ui8R, uint8_t ui8G, uint8_t ui8B);
+extern uint16_t *ImageRead(const char *pcPath, uint32_t *pui32Width,
+                           uint32_t *pui32Height);
+extern int RegionEncode(tStream *psOut, const uint16_t *pui16Image,
+                        uint32_t ui32Stride, uint32_t ui32X, uint32_t ui32Y,
+                        uint32_t ui32Width, uint32_t ui32Height,
+                        uint32_t ui32ScreenX, uint32_t ui32ScreenY, int iEnc);
+extern int ImageEncode(tStream *psOut, const uint16_t *pui16Image,
+                       const uint16_t *pui16Prev, uint32_t ui32Width,
+                       uint32_t ui32Height, uint32_t ui32X, uint32_t ui32Y,
+                       int iEnc);
+extern int StreamCheck(const tStream *psStream, const uint16_t *pui16Image,
+                       const uint16_t *pui16Prev, bool bClear, uint32_t ui32X,
+                       uint32_t ui32Y, uint32_t ui32Width,
+                       uint32_t ui32Height);
+
+#endif
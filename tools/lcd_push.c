@@ -0,0 +1,361 @@
+//*****************************************************************************
+//
+// lcd_push.c - Draws an image on the arcade stick's LCD over USB.
+//
+// Reads a binary PPM (P6) or uncompressed BMP of up to 128x160 pixels,
+// converts it to the panel's RGB565, compresses it with whichever stream
+// encoding from lcd_stream.h comes out smallest and writes it to the
+// stick's vendor bulk interface through usbfs, so no driver or library is needed.  The stick is
+// found by scanning /dev/bus/usb for the TI vendor ID and a vendor-specific
+// interface with a bulk OUT endpoint; a device node may also be given.
+// Needs write access to the device node.
+//
+//     lcd_push -c splash.ppm
+//     lcd_push -x 32 -y 40 -e rle icon.ppm /dev/bus/usb/001/007
+//     lcd_push -d movelist1.ppm movelist2.ppm
+//     lcd_push -t -o frame.bin splash.ppm
+//
+// With -d only the rectangles that differ from the previous image are sent.
+// With -t the stream is decoded again with the firmware's own decoder and
+// checked against the image, and with -o it is written to a file instead of
+// the device.
+//
+//*****************************************************************************
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/usbdevice_fs.h>
+#include "lcd_stream.h"
+#include "lcd_image.h"
+
+//*****************************************************************************
+//
+// The stick's USB vendor ID.
+//
+//*****************************************************************************
+#define LCD_PUSH_VID            0x1cbe
+
+//*****************************************************************************
+//
+// The largest bulk transfer handed to usbfs at once, and how long to wait
+// for it.  The device only accepts data as fast as it can draw.
+//
+//*****************************************************************************
+#define LCD_PUSH_CHUNK          4096
+#define LCD_PUSH_TIMEOUT_MS     5000
+
+
+static void
+Usage(void)
+{
+    fprintf(stderr, "usage: lcd_push [-x x] [-y y] [-e raw|rle|pal] "
+                    "[-d previous.ppm] [-c] [-t] [-o file]\n"
+                    "                image.ppm [/dev/bus/usb/BBB/DDD]\n");
+    exit(2);
+}
+
+//*****************************************************************************
+//
+// Looks through a device's descriptors, as read from its usbfs node, for a
+// TI device with a vendor-specific interface that has a bulk OUT endpoint.
+//
+//*****************************************************************************
+static bool
+DescriptorsMatch(const uint8_t *pui8Desc, int iLen, uint32_t *pui32Interface,
+                 uint32_t *pui32Endpoint)
+{
+    int iOff;
+    bool bVendor;
+
+    if((iLen < 18) || (pui8Desc[1] != 1) ||
+       ((pui8Desc[8] | (pui8Desc[9] << 8)) != LCD_PUSH_VID))
+    {
+        return(false);
+    }
+
+    bVendor = false;
+    for(iOff = 0; (iOff + 2) <= iLen; iOff += pui8Desc[iOff])
+    {
+        if(pui8Desc[iOff] < 2)
+        {
+            break;
+        }
+
+        if((pui8Desc[iOff + 1] == 4) && ((iOff + 9) <= iLen))
+        {
+            bVendor = (pui8Desc[iOff + 5] == 0xff);
+            *pui32Interface = pui8Desc[iOff + 2];
+        }
+        else if(bVendor && (pui8Desc[iOff + 1] == 5) && ((iOff + 7) <= iLen) &&
+                !(pui8Desc[iOff + 2] & 0x80) && ((pui8Desc[iOff + 3] & 3) == 2))
+        {
+            *pui32Endpoint = pui8Desc[iOff + 2];
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+static int
+DeviceOpen(const char *pcPath, uint32_t *pui32Interface,
+           uint32_t *pui32Endpoint)
+{
+    uint8_t pui8Desc[1024];
+    int iFd, iLen;
+
+    iFd = open(pcPath, O_RDWR);
+    if(iFd < 0)
+    {
+        return(-1);
+    }
+
+    iLen = read(iFd, pui8Desc, sizeof(pui8Desc));
+    if(!DescriptorsMatch(pui8Desc, iLen, pui32Interface, pui32Endpoint))
+    {
+        close(iFd);
+        errno = ENODEV;
+        return(-1);
+    }
+
+    return(iFd);
+}
+
+static int
+DeviceFind(uint32_t *pui32Interface, uint32_t *pui32Endpoint)
+{
+    char pcPath[16 + (2 * sizeof(((struct dirent *)0)->d_name))];
+    struct dirent *psBus, *psDev;
+    DIR *psBusDir, *psDevDir;
+    int iFd;
+
+    iFd = -1;
+    psBusDir = opendir("/dev/bus/usb");
+    while(psBusDir && (iFd < 0) && ((psBus = readdir(psBusDir)) != NULL))
+    {
+        if(psBus->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        snprintf(pcPath, sizeof(pcPath), "/dev/bus/usb/%s", psBus->d_name);
+        psDevDir = opendir(pcPath);
+        while(psDevDir && (iFd < 0) && ((psDev = readdir(psDevDir)) != NULL))
+        {
+            if(psDev->d_name[0] == '.')
+            {
+                continue;
+            }
+
+            snprintf(pcPath, sizeof(pcPath), "/dev/bus/usb/%s/%s",
+                     psBus->d_name, psDev->d_name);
+            iFd = DeviceOpen(pcPath, pui32Interface, pui32Endpoint);
+        }
+        if(psDevDir)
+        {
+            closedir(psDevDir);
+        }
+    }
+    if(psBusDir)
+    {
+        closedir(psBusDir);
+    }
+
+    return(iFd);
+}
+
+static int
+DeviceWrite(int iFd, uint32_t ui32Endpoint, const tStream *psStream)
+{
+    struct usbdevfs_bulktransfer sBulk;
+    uint32_t ui32Off, ui32Len;
+
+    for(ui32Off = 0; ui32Off < psStream->ui32Len; ui32Off += ui32Len)
+    {
+        ui32Len = psStream->ui32Len - ui32Off;
+        ui32Len = (ui32Len > LCD_PUSH_CHUNK) ? LCD_PUSH_CHUNK : ui32Len;
+
+        sBulk.ep = ui32Endpoint;
+        sBulk.len = ui32Len;
+        sBulk.timeout = LCD_PUSH_TIMEOUT_MS;
+        sBulk.data = psStream->pui8Data + ui32Off;
+        if(ioctl(iFd, USBDEVFS_BULK, &sBulk) != (int)ui32Len)
+        {
+            perror("USBDEVFS_BULK");
+            return(-1);
+        }
+    }
+
+    return(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const char * const ppcNames[] = { "raw", "rle", "pal" };
+    uint32_t ui32X, ui32Y, ui32Width, ui32Height, ui32Interface, ui32Endpoint;
+    uint32_t ui32PrevWidth, ui32PrevHeight;
+    uint16_t *pui16Image, *pui16Prev;
+    const char *pcOut, *pcPrev;
+    bool bClear, bCheck;
+    int iOpt, iEnc, iFd, iRects;
+    tStream sStream;
+    FILE *psOut;
+
+    ui32X = ui32Y = 0;
+    iEnc = -1;
+    bClear = bCheck = false;
+    pcOut = pcPrev = NULL;
+
+    while((iOpt = getopt(argc, argv, "x:y:e:d:cto:")) != -1)
+    {
+        switch(iOpt)
+        {
+            case 'x': ui32X = strtoul(optarg, NULL, 0); break;
+            case 'y': ui32Y = strtoul(optarg, NULL, 0); break;
+            case 'd': pcPrev = optarg; break;
+            case 'c': bClear = true; break;
+            case 't': bCheck = true; break;
+            case 'o': pcOut = optarg; break;
+            case 'e':
+            {
+                for(iEnc = 0; (iEnc < 3) && strcmp(optarg, ppcNames[iEnc]);
+                    iEnc++)
+                {
+                }
+                if(iEnc == 3)
+                {
+                    Usage();
+                }
+                break;
+            }
+            default: Usage();
+        }
+    }
+
+    if((optind >= argc) || ((argc - optind) > 2))
+    {
+        Usage();
+    }
+
+    pui16Image = ImageRead(argv[optind], &ui32Width, &ui32Height);
+    if(!pui16Image)
+    {
+        return(1);
+    }
+
+    if(((ui32X + ui32Width) > LCD_STREAM_WIDTH) ||
+       ((ui32Y + ui32Height) > LCD_STREAM_HEIGHT))
+    {
+        fprintf(stderr, "lcd_push: image does not fit at %u,%u\n", ui32X,
+                ui32Y);
+        return(1);
+    }
+
+    pui16Prev = NULL;
+    if(pcPrev)
+    {
+        pui16Prev = ImageRead(pcPrev, &ui32PrevWidth, &ui32PrevHeight);
+        if(!pui16Prev)
+        {
+            return(1);
+        }
+        if((ui32PrevWidth != ui32Width) || (ui32PrevHeight != ui32Height))
+        {
+            fprintf(stderr, "lcd_push: %s is not the same size\n", pcPrev);
+            return(1);
+        }
+    }
+
+    memset(&sStream, 0, sizeof(sStream));
+    if(bClear)
+    {
+        StreamByte(&sStream, LCD_STREAM_CMD_FILL);
+        StreamByte(&sStream, 0);
+        StreamByte(&sStream, 0);
+        StreamByte(&sStream, LCD_STREAM_WIDTH);
+        StreamByte(&sStream, LCD_STREAM_HEIGHT);
+        StreamColor(&sStream, 0);
+    }
+
+    //
+    // Send the whole image, or with -d only the rectangles that changed
+    // since the previous one.
+    //
+    iRects = ImageEncode(&sStream, pui16Image, pui16Prev, ui32Width,
+                         ui32Height, ui32X, ui32Y, iEnc);
+    if(iRects < 0)
+    {
+        fprintf(stderr, "lcd_push: image has more than %u colors\n",
+                LCD_STREAM_PALETTE_SIZE);
+        return(1);
+    }
+
+    printf("%ux%u at %u,%u: %d rectangles, %u bytes (%.1f%% of raw)\n",
+           ui32Width, ui32Height, ui32X, ui32Y, iRects, sStream.ui32Len,
+           (100.0 * sStream.ui32Len) / (ui32Width * ui32Height * 2));
+
+    if(bCheck && StreamCheck(&sStream, pui16Image, pui16Prev, bClear, ui32X,
+                             ui32Y, ui32Width, ui32Height))
+    {
+        return(1);
+    }
+
+    if(pcOut)
+    {
+        psOut = strcmp(pcOut, "-") ? fopen(pcOut, "wb") : stdout;
+        if(!psOut ||
+           (fwrite(sStream.pui8Data, 1, sStream.ui32Len, psOut) !=
+            sStream.ui32Len))
+        {
+            perror(pcOut);
+            return(1);
+        }
+        if(psOut != stdout)
+        {
+            fclose(psOut);
+        }
+        return(0);
+    }
+
+    if(bCheck || !sStream.ui32Len)
+    {
+        return(0);
+    }
+
+    if((argc - optind) == 2)
+    {
+        iFd = DeviceOpen(argv[optind + 1], &ui32Interface, &ui32Endpoint);
+    }
+    else
+    {
+        iFd = DeviceFind(&ui32Interface, &ui32Endpoint);
+    }
+    if(iFd < 0)
+    {
+        fprintf(stderr, "lcd_push: no stick with an LCD interface found: %s\n",
+                strerror(errno));
+        return(1);
+    }
+
+    if(ioctl(iFd, USBDEVFS_CLAIMINTERFACE, &ui32Interface) < 0)
+    {
+        perror("USBDEVFS_CLAIMINTERFACE");
+        return(1);
+    }
+
+    iOpt = DeviceWrite(iFd, ui32Endpoint, &sStream);
+
+    ioctl(iFd, USBDEVFS_RELEASEINTERFACE, &ui32Interface);
+    close(iFd);
+
+    return(iOpt ? 1 : 0);
+}
@@ -25,6 +25,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "inc/hw_types.h"
+#include "inc/hw_ints.h"
 #include "inc/hw_memmap.h"
 #include "inc/hw_gpio.h"
 #include "driverlib/sysctl.h"
@@ -32,7 +33,9 @@
 #include "driverlib/rom_map.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
 #include "drivers/buttons.h"
+#include "button_map.h"
 
 //*****************************************************************************
 //
@@ -43,192 +46,424 @@
 
 //*****************************************************************************
 //
-// Holds the current, debounced state of each button.  A 1 in a bit indicates
-// that that button is currently pressed, otherwise it is released.
+// The GPIO port behind each BUTTON_PORT_x index.  Ports D and E are used
+// through the AHB aperture since the USB and ADC setup switch them to it.
+//
+//*****************************************************************************
+static const uint32_t g_pui32ButtonPortBase[BUTTON_PORTS] =
+{
+    GPIO_PORTA_BASE,
+    GPIO_PORTB_BASE,
+    GPIO_PORTC_BASE,
+    GPIO_PORTD_AHB_BASE,
+    GPIO_PORTE_AHB_BASE,
+    GPIO_PORTF_BASE
+};
+
+static const uint32_t g_pui32ButtonPortPeriph[BUTTON_PORTS] =
+{
+    SYSCTL_PERIPH_GPIOA,
+    SYSCTL_PERIPH_GPIOB,
+    SYSCTL_PERIPH_GPIOC,
+    SYSCTL_PERIPH_GPIOD,
+    SYSCTL_PERIPH_GPIOE,
+    SYSCTL_PERIPH_GPIOF
+};
+
+static const uint32_t g_pui32ButtonPortInt[BUTTON_PORTS] =
+{
+    INT_GPIOA,
+    INT_GPIOB,
+    INT_GPIOC,
+    INT_GPIOD,
+    INT_GPIOE,
+    INT_GPIOF
+};
+
+//*****************************************************************************
+//
+// The number of players being sampled, the pins they use on each port and
+// which of those are active low.
+//
+//*****************************************************************************
+static uint32_t g_ui32ButtonPlayers;
+static uint8_t g_pui8ButtonPins[BUTTON_PORTS];
+static uint8_t g_pui8ButtonActiveLow[BUTTON_PORTS];
+
+//*****************************************************************************
+//
+// The function called from ButtonsIntHandler() when a button is pressed.
+//
+//*****************************************************************************
+static void (*g_pfnButtonsInt)(void);
+
+//*****************************************************************************
+//
+// Holds the current, debounced state of each player's buttons.  A 1 in a bit
+// indicates that that button is currently pressed, otherwise it is released.
 // We assume that we start with all the buttons released (though if one is
 // pressed when the application starts, this will be detected).
 //
 //*****************************************************************************
-static uint16_t g_ui16ButtonStates = ALL_BUTTONS;
+static uint16_t g_pui16ButtonStates[BUTTON_MAP_PLAYERS];
+
+//*****************************************************************************
+//
+// The two bits of each button's debounce counter, per player.
+//
+//*****************************************************************************
+static uint16_t g_pui16SwitchClockA[BUTTON_MAP_PLAYERS];
+static uint16_t g_pui16SwitchClockB[BUTTON_MAP_PLAYERS];
+
+//*****************************************************************************
+//
+// Reads every port the players use, once each, and maps the result to every
+// player's buttons.
+//
+//*****************************************************************************
+static void
+ButtonsSample(uint16_t *pui16Raw)
+{
+    uint8_t pui8Ports[BUTTON_PORTS];
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < BUTTON_PORTS; ui32Idx++)
+    {
+        pui8Ports[ui32Idx] = 0;
+        if(g_pui8ButtonPins[ui32Idx])
+        {
+            pui8Ports[ui32Idx] =
+                (uint8_t)ROM_GPIOPinRead(g_pui32ButtonPortBase[ui32Idx],
+                                         g_pui8ButtonPins[ui32Idx]);
+        }
+    }
+
+    for(ui32Idx = 0; ui32Idx < g_ui32ButtonPlayers; ui32Idx++)
+    {
+        pui16Raw[ui32Idx] = ButtonMapApply(&g_psButtonMaps[ui32Idx],
+                                           pui8Ports);
+    }
+}
+
+//*****************************************************************************
+//
+//! Reads the raw state of one player's buttons.
+//!
+//! \param ui32Player is the player, counting from 0.
+//!
+//! This function samples the button GPIOs once, with no debouncing.  It does
+//! not touch the debounce state, so it may be called at any rate and from
+//! interrupt context without disturbing ButtonsPoll().
+//!
+//! \return Returns the player's buttons, with a 1 for each one pressed.
+//
+//*****************************************************************************
+uint16_t
+ButtonsRead(uint32_t ui32Player)
+{
+    uint16_t pui16Raw[BUTTON_MAP_PLAYERS];
+
+    if(ui32Player >= g_ui32ButtonPlayers)
+    {
+        return(0);
+    }
+
+    ButtonsSample(pui16Raw);
+
+    return(pui16Raw[ui32Player]);
+}
 
 //*****************************************************************************
 //
 //! Polls the current state of the buttons and determines which have changed.
 //!
-//! \param pui16Delta points to a character that will be written to indicate
-//! which button states changed since the last time this function was called.
-//! This value is derived from the debounced state of the buttons.
-//! \param pui16RawState points to a location where the raw button state will
-//! be stored.
+//! \param pui16Delta points to an array, with an entry per player, that will
+//! be written to indicate which button states changed since the last time
+//! this function was called.  This value is derived from the debounced state
+//! of the buttons.
+//! \param pui16RawState points to an array, with an entry per player, where
+//! the raw button state will be stored.
 //!
 //! This function should be called periodically by the application to poll the
-//! pushbuttons.  It determines both the current debounced state of the buttons
-//! and also which buttons have changed state since the last time the function
-//! was called.
+//! pushbuttons.  The ports are read once for all players, then each player's
+//! buttons are debounced separately.  It determines both the current
+//! debounced state of the buttons and also which buttons have changed state
+//! since the last time the function was called.
 //!
 //! In order for button debouncing to work properly, this function should be
 //! called at a regular interval, even if the state of the buttons is not needed
 //! that often.
 //!
-//! If button debouncing is not required, the the caller can pass a pointer
-//! for the \e pui16RawState parameter in order to get the raw state of the
-//! buttons.  The value returned in \e pui16RawState will be a bit mask where
-//! a 1 indicates the buttons is pressed.
+//! If button debouncing is not required, the caller can use the raw state
+//! written to \e pui16RawState.  It is a bit mask where a 1 indicates the
+//! button is pressed.
 //!
-//! \return Returns the current debounced state of the buttons where a 1 in the
-//! button ID's position indicates that the button is pressed and a 0
-//! indicates that it is released.
+//! \return None.
 //
 //*****************************************************************************
-uint16_t
+void
 ButtonsPoll(uint16_t *pui16Delta, uint16_t *pui16RawState)
 {
-    uint32_t ui32Delta;
-    uint32_t ui32Data;
-    static uint16_t ui16SwitchClockA = 0;
-    static uint16_t ui16SwitchClockB = 0;
+    uint16_t pui16Raw[BUTTON_MAP_PLAYERS];
+    uint32_t ui32Player, ui32Delta, ui32Data;
+    uint16_t ui16ClockA, ui16ClockB;
 
     //
-    // Read the raw state of the push buttons.  Save the raw state
-    //  if the caller supplied storage for the
-    // raw value.
+    // Read the raw state of every player's push buttons in one pass.
     //
-    ui32Data  = (ROM_GPIOPinRead(BUTTONS_GPIO_BASE3,  GPIO_PIN_4)<<10) |
-            (ROM_GPIOPinRead(BUTTONS_GPIO_BASE2,  GPIO_PIN_0)<<12) |
-                (ROM_GPIOPinRead(BUTTONS_GPIO_BASE2,  GPIO_PIN_4)<<9)  |
-               ((ROM_GPIOPinRead(BUTTONS_GPIO_BASE1, ALL_BUTTONS1))<<4)|
-                (ROM_GPIOPinRead(BUTTONS_GPIO_BASE, ALL_BUTTONS));
+    ButtonsSample(pui16Raw);
 
-
-
-
-    if(pui16RawState)
+    for(ui32Player = 0; ui32Player < g_ui32ButtonPlayers; ui32Player++)
     {
-        *pui16RawState =(uint16_t)ui32Data;
-    }
+        ui32Data = pui16Raw[ui32Player];
 
-    //
-    // Determine the switches that are at a different state than the debounced
-    // state.
-    //
-    ui32Delta = ui32Data ^ g_ui16ButtonStates;
+        if(pui16RawState)
+        {
+            pui16RawState[ui32Player] = (uint16_t)ui32Data;
+        }
 
-    //
-    // Increment the clocks by one.
-    //
-    ui16SwitchClockA ^= ui16SwitchClockB;
-    ui16SwitchClockB = ~ui16SwitchClockB;
+        //
+        // Determine the switches that are at a different state than the
+        // debounced state.
+        //
+        ui32Delta = ui32Data ^ g_pui16ButtonStates[ui32Player];
 
-    //
-    // Reset the clocks corresponding to switches that have not changed state.
-    //
-    ui16SwitchClockA &= ui32Delta;
-    ui16SwitchClockB &= ui32Delta;
+        //
+        // Increment the clocks by one.
+        //
+        ui16ClockA = g_pui16SwitchClockA[ui32Player];
+        ui16ClockB = g_pui16SwitchClockB[ui32Player];
+        ui16ClockA ^= ui16ClockB;
+        ui16ClockB = ~ui16ClockB;
 
-    //
-    // Get the new debounced switch state.
-    //
-    g_ui16ButtonStates &= ui16SwitchClockA | ui16SwitchClockB;
-    g_ui16ButtonStates |= (~(ui16SwitchClockA | ui16SwitchClockB)) & ui32Data;
+        //
+        // Reset the clocks corresponding to switches that have not changed
+        // state.
+        //
+        ui16ClockA &= ui32Delta;
+        ui16ClockB &= ui32Delta;
+        g_pui16SwitchClockA[ui32Player] = ui16ClockA;
+        g_pui16SwitchClockB[ui32Player] = ui16ClockB;
 
-    //
-    // Determine the switches that just changed debounced state.
-    //
-    ui32Delta ^= (ui16SwitchClockA | ui16SwitchClockB);
+        //
+        // Get the new debounced switch state.
+        //
+        g_pui16ButtonStates[ui32Player] &= ui16ClockA | ui16ClockB;
+        g_pui16ButtonStates[ui32Player] |= (~(ui16ClockA | ui16ClockB)) &
+                                           ui32Data;
 
-    //
-    // Store the bit mask for the buttons that have changed for return to
-    // caller.
-    //
-    if(pui16Delta)
-    {
-        *pui16Delta = (uint16_t)ui32Delta;
-    }
+        //
+        // Determine the switches that just changed debounced state, and
+        // store the bit mask for return to the caller.
+        //
+        ui32Delta ^= (ui16ClockA | ui16ClockB);
 
-    //
-    // Return the debounced buttons states to the caller.  Invert the bit
-    // sense so that a '1' indicates the button is pressed, which is a
-    // sensible way to interpret the return value.
-    //
-    return(~g_ui16ButtonStates);
+        if(pui16Delta)
+        {
+            pui16Delta[ui32Player] = (uint16_t)ui32Delta;
+        }
+    }
 }
 
 //*****************************************************************************
 //
-//! Initializes the GPIO pins used by the board pushbuttons.
+//! Initializes the GPIO pins used by the pushbuttons.
+//!
+//! \param ui32Players is the number of players whose buttons are used, up to
+//! BUTTON_MAP_PLAYERS.
 //!
 //! This function must be called during application initialization to
 //! configure the GPIO pins to which the pushbuttons are attached.  It enables
-//! the port used by the buttons and configures each button GPIO as an input
-//! with a weak pull-down.
+//! each port used by the players' pin tables and configures each button GPIO
+//! as an input with a weak pull-up if it is active low, or a weak pull-down
+//! otherwise.
 //!
 //! \return None.
 //
 //*****************************************************************************
 void
-ButtonsInit(void)
+ButtonsInit(uint32_t ui32Players)
 {
-    //
-    // Enable the GPIO port to which the pushbuttons are connected.
-    //
-    ROM_SysCtlPeripheralEnable(BUTTONS_GPIO_PERIPH);
-    ROM_SysCtlPeripheralEnable(BUTTONS_GPIO_PERIPH1);
-    ROM_SysCtlPeripheralEnable(BUTTONS_GPIO_PERIPH2);
-    ROM_SysCtlPeripheralEnable(BUTTONS_GPIO_PERIPH3);
+    uint32_t ui32Idx, ui32Base;
+    uint8_t ui8Pins;
+
+    if(ui32Players > BUTTON_MAP_PLAYERS)
+    {
+        ui32Players = BUTTON_MAP_PLAYERS;
+    }
+    g_ui32ButtonPlayers = ui32Players;
 
     //
-    // Unlock PB0 & PC0 so we can change it to a GPIO input
-    // Once we have enabled (unlocked) the commit register then re-lock it
-    // to prevent further changes.  PF0 & PC0 is muxed with NMI thus a special case.
+    // Collect the pins each port needs.
     //
-    HWREG(BUTTONS_GPIO_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(BUTTONS_GPIO_BASE + GPIO_O_CR) |= 0x01;
-    HWREG(BUTTONS_GPIO_BASE + GPIO_O_LOCK) = 0;
+    for(ui32Idx = 0; ui32Idx < BUTTON_PORTS; ui32Idx++)
+    {
+        g_pui8ButtonPins[ui32Idx] = 0;
+        g_pui8ButtonActiveLow[ui32Idx] = 0;
+    }
 
-    HWREG(BUTTONS_GPIO_BASE1 + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(BUTTONS_GPIO_BASE1 + GPIO_O_CR) |= 0x01;
-    HWREG(BUTTONS_GPIO_BASE1 + GPIO_O_LOCK) = 0;
+    for(ui32Idx = 0; ui32Idx < ui32Players; ui32Idx++)
+    {
+        ButtonMapPins(&g_psButtonMaps[ui32Idx], g_pui8ButtonPins,
+                      g_pui8ButtonActiveLow);
+    }
 
-    HWREG(BUTTONS_GPIO_BASE2 + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(BUTTONS_GPIO_BASE2 + GPIO_O_CR) |= 0x01;
-    HWREG(BUTTONS_GPIO_BASE2 + GPIO_O_LOCK) = 0;
+    for(ui32Idx = 0; ui32Idx < BUTTON_PORTS; ui32Idx++)
+    {
+        ui8Pins = g_pui8ButtonPins[ui32Idx];
+        if(!ui8Pins)
+        {
+            continue;
+        }
 
-    HWREG(BUTTONS_GPIO_BASE3 + GPIO_O_LOCK) = GPIO_LOCK_KEY;
-    HWREG(BUTTONS_GPIO_BASE3 + GPIO_O_CR) |= 0x01;
-    HWREG(BUTTONS_GPIO_BASE3 + GPIO_O_LOCK) = 0;
+        //
+        // Enable the GPIO port to which the pushbuttons are connected.
+        //
+        ROM_SysCtlPeripheralEnable(g_pui32ButtonPortPeriph[ui32Idx]);
+        if((ui32Idx == BUTTON_PORT_D) || (ui32Idx == BUTTON_PORT_E))
+        {
+            SysCtlGPIOAHBEnable(g_pui32ButtonPortPeriph[ui32Idx]);
+        }
+        ui32Base = g_pui32ButtonPortBase[ui32Idx];
+
+        //
+        // Unlock the pins so we can change them to GPIO inputs.  Once we
+        // have enabled (unlocked) the commit register then re-lock it to
+        // prevent further changes.  PF0 and PD7 are muxed with NMI and so
+        // are a special case.
+        //
+        HWREG(ui32Base + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+        HWREG(ui32Base + GPIO_O_CR) |= ui8Pins;
+        HWREG(ui32Base + GPIO_O_LOCK) = 0;
+
+        //
+        // Set each of the button GPIO pins as an input with a pull-up if it
+        // is active low and a pull-down otherwise.
+        //
+        ROM_GPIODirModeSet(ui32Base, ui8Pins, GPIO_DIR_MODE_IN);
+        if(ui8Pins & ~g_pui8ButtonActiveLow[ui32Idx])
+        {
+            MAP_GPIOPadConfigSet(ui32Base,
+                                 ui8Pins & ~g_pui8ButtonActiveLow[ui32Idx],
+                                 GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPD);
+        }
+        if(g_pui8ButtonActiveLow[ui32Idx])
+        {
+            MAP_GPIOPadConfigSet(ui32Base, g_pui8ButtonActiveLow[ui32Idx],
+                                 GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
+        }
+    }
 
     //
-    // Set each of the button GPIO pins as an input with a pull-down.
+    // Initialize the debounced button state with the current state read from
+    // the GPIO ports.
     //
-    ROM_GPIODirModeSet(BUTTONS_GPIO_BASE, ALL_BUTTONS, GPIO_DIR_MODE_IN);
-    MAP_GPIOPadConfigSet(BUTTONS_GPIO_BASE, ALL_BUTTONS,
-                         GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPD );
+    ButtonsSample(g_pui16ButtonStates);
+}
+
+//*****************************************************************************
+//
+//! Enables an interrupt on a press of any button.
+//!
+//! \param pfnHandler is the function called from ButtonsIntHandler() when a
+//! button is pressed.
+//! \param ui32Priority is the interrupt priority for the button ports.
+//!
+//! Each button pin interrupts on the edge that presses it.  The interrupt
+//! stays enabled until ButtonsIntDisable() is called, and is meant for
+//! waking the processor rather than for reading the buttons, so no
+//! debouncing is done.  ButtonsIntHandler() must be in the vector table for
+//! every port the buttons use.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ButtonsIntEnable(void (*pfnHandler)(void), uint32_t ui32Priority)
+{
+    uint32_t ui32Idx, ui32Base;
+    uint8_t ui8Pins, ui8ActiveLow;
 
-    ROM_GPIODirModeSet(BUTTONS_GPIO_BASE1, ALL_BUTTONS1, GPIO_DIR_MODE_IN);
-    MAP_GPIOPadConfigSet(BUTTONS_GPIO_BASE1, ALL_BUTTONS1,
-                         GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPD );
+    g_pfnButtonsInt = pfnHandler;
 
-    ROM_GPIODirModeSet(BUTTONS_GPIO_BASE2, ALL_BUTTONS2, GPIO_DIR_MODE_IN);
-    MAP_GPIOPadConfigSet(BUTTONS_GPIO_BASE2, ALL_BUTTONS2,
-                         GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU );
+    for(ui32Idx = 0; ui32Idx < BUTTON_PORTS; ui32Idx++)
+    {
+        ui8Pins = g_pui8ButtonPins[ui32Idx];
+        if(!ui8Pins)
+        {
+            continue;
+        }
+        ui8ActiveLow = g_pui8ButtonActiveLow[ui32Idx];
+        ui32Base = g_pui32ButtonPortBase[ui32Idx];
 
-    ROM_GPIODirModeSet(BUTTONS_GPIO_BASE3, ALL_BUTTONS3, GPIO_DIR_MODE_IN);
-    MAP_GPIOPadConfigSet(BUTTONS_GPIO_BASE3, ALL_BUTTONS3,
-                         GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPD );
+        if(ui8Pins & ~ui8ActiveLow)
+        {
+            ROM_GPIOIntTypeSet(ui32Base, ui8Pins & ~ui8ActiveLow,
+                               GPIO_RISING_EDGE);
+        }
+        if(ui8ActiveLow)
+        {
+            ROM_GPIOIntTypeSet(ui32Base, ui8ActiveLow, GPIO_FALLING_EDGE);
+        }
+        ROM_GPIOIntClear(ui32Base, ui8Pins);
+        ROM_GPIOIntEnable(ui32Base, ui8Pins);
 
-    //
-    // Initialize the debounced button state with the current state read from
-    // the GPIO bank.
-    //
-    g_ui16ButtonStates =
-            (ROM_GPIOPinRead(BUTTONS_GPIO_BASE3,  GPIO_PIN_4)<<10) |
-            (ROM_GPIOPinRead(BUTTONS_GPIO_BASE2,  GPIO_PIN_0)<<12) |
-            (ROM_GPIOPinRead(BUTTONS_GPIO_BASE2,  GPIO_PIN_4)<<9) |
-            (ROM_GPIOPinRead(BUTTONS_GPIO_BASE1, ALL_BUTTONS1)<<4)|
-            ROM_GPIOPinRead(BUTTONS_GPIO_BASE, ALL_BUTTONS);
+        ROM_IntPrioritySet(g_pui32ButtonPortInt[ui32Idx], ui32Priority);
+        ROM_IntEnable(g_pui32ButtonPortInt[ui32Idx]);
+    }
+}
+
+//*****************************************************************************
+//
+//! Disables the button press interrupt.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ButtonsIntDisable(void)
+{
+    uint32_t ui32Idx;
 
+    for(ui32Idx = 0; ui32Idx < BUTTON_PORTS; ui32Idx++)
+    {
+        if(g_pui8ButtonPins[ui32Idx])
+        {
+            ROM_IntDisable(g_pui32ButtonPortInt[ui32Idx]);
+            ROM_GPIOIntDisable(g_pui32ButtonPortBase[ui32Idx],
+                               g_pui8ButtonPins[ui32Idx]);
+        }
+    }
+}
 
+//*****************************************************************************
+//
+//! Handles the GPIO interrupts of the button ports.
+//!
+//! This clears the interrupts of every button pin and calls the function
+//! given to ButtonsIntEnable().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ButtonsIntHandler(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < BUTTON_PORTS; ui32Idx++)
+    {
+        if(g_pui8ButtonPins[ui32Idx])
+        {
+            ROM_GPIOIntClear(g_pui32ButtonPortBase[ui32Idx],
+                             g_pui8ButtonPins[ui32Idx]);
+        }
+    }
 
+    if(g_pfnButtonsInt)
+    {
+        g_pfnButtonsInt();
+    }
 }
 
 //*****************************************************************************
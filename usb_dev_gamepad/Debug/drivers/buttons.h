@@ -38,9 +38,8 @@ extern "C"
 
 //*****************************************************************************
 //
-// Defines for the hardware resources used by the pushbuttons.
-//
-// The switches are on the following ports/pins:
+// The buttons are described by the per-player pin tables in button_map.c.
+// Player one's are:
 //! Button0 - PB0
 //! Button1 - PB1
 //! Button2 - PB2
@@ -56,47 +55,13 @@ extern "C"
 //! Button12 - PF0
 //! BUTTON13 - PF4
 //! BUTTON14 - PA4
-// The switches tie the GPIO to ground, so the GPIOs need to be configured
-// with pull-ups, and a value of 1 means the switch is pressed.
+// and player two's are PD0-PD3, PD6, PD7, PE0, PE4 and PE5.  The on-board
+// switches on PF0 and PF4 tie the GPIO to ground and are given pull-ups.
+// The rest pull the GPIO high when pressed and are given pull-downs.
+// Every state returned by this driver has a 1 for each pressed button, in
+// the bit order of the report's Buttons field.
 //
 //*****************************************************************************
-#define BUTTONS_GPIO_PERIPH     SYSCTL_PERIPH_GPIOB
-#define BUTTONS_GPIO_BASE       GPIO_PORTB_BASE
-
-#define BUTTONS_GPIO_PERIPH1    SYSCTL_PERIPH_GPIOC
-#define BUTTONS_GPIO_BASE1      GPIO_PORTC_BASE
-
-#define BUTTONS_GPIO_PERIPH2    SYSCTL_PERIPH_GPIOF
-#define BUTTONS_GPIO_BASE2      GPIO_PORTF_BASE
-
-#define BUTTONS_GPIO_PERIPH3    SYSCTL_PERIPH_GPIOA
-#define BUTTONS_GPIO_BASE3      GPIO_PORTA_BASE
-
-
-
-#define NUM_BUTTONS            15
-#define BUTTON0                GPIO_PIN_0
-#define BUTTON1                GPIO_PIN_1
-#define BUTTON2                GPIO_PIN_2
-#define BUTTON3                GPIO_PIN_3
-#define BUTTON4                GPIO_PIN_4
-#define BUTTON5                GPIO_PIN_5
-#define BUTTON6                GPIO_PIN_6
-#define BUTTON7                GPIO_PIN_7
-
-#define BUTTON8                GPIO_PIN_4
-#define BUTTON9                GPIO_PIN_5
-#define BUTTON10               GPIO_PIN_6
-#define BUTTON11               GPIO_PIN_7
-#define BUTTON12               GPIO_PIN_0
-#define BUTTON13               GPIO_PIN_4
-#define BUTTON14               GPIO_PIN_4
-
-
-#define ALL_BUTTONS             (BUTTON0 | BUTTON1 | BUTTON2 | BUTTON3 | BUTTON4 |BUTTON5 | BUTTON6 |BUTTON7)
-#define ALL_BUTTONS1            (BUTTON8 | BUTTON9 | BUTTON10 | BUTTON11 )
-#define ALL_BUTTONS2            (BUTTON12 | BUTTON13)
-#define ALL_BUTTONS3            (BUTTON14)
 
 //*****************************************************************************
 //
@@ -125,9 +90,12 @@ extern "C"
 // Functions exported from buttons.c
 //
 //*****************************************************************************
-extern void ButtonsInit(void);
-extern uint16_t ButtonsPoll(uint16_t *pui16Delta,
-                             uint16_t *pui16Raw);
+extern void ButtonsInit(uint32_t ui32Players);
+extern void ButtonsPoll(uint16_t *pui16Delta, uint16_t *pui16Raw);
+extern uint16_t ButtonsRead(uint32_t ui32Player);
+extern void ButtonsIntEnable(void (*pfnHandler)(void), uint32_t ui32Priority);
+extern void ButtonsIntDisable(void);
+extern void ButtonsIntHandler(void);
 
 //*****************************************************************************
 //
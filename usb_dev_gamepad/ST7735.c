@@ -119,6 +119,8 @@ uint16_t StTextColor = ST7735_YELLOW;
 #define ST7735_RAMRD   0x2E
 
 #define ST7735_PTLAR   0x30
+#define ST7735_VSCRDEF 0x33
+#define ST7735_VSCSAD  0x37
 #define ST7735_COLMOD  0x3A
 #define ST7735_MADCTL  0x36
 
@@ -491,37 +493,359 @@ static int16_t _width = ST7735_TFTWIDTH;   // this could probably be a constant,
 static int16_t _height = ST7735_TFTHEIGHT;
 
 
-// The Data/Command pin must be valid when the eighth bit is
-// sent.  The SSI module has hardware input and output FIFOs
-// that are 8 locations deep.  Based on the observation that
-// the LCD interface tends to send a few commands and then a
-// lot of data, the FIFOs are not used when writing
-// commands, and they are used when writing data.  This
-// ensures that the Data/Command pin status matches the byte
-// that is actually being transmitted.
-// The write command operation waits until all data has been
-// sent, configures the Data/Command pin for commands, sends
-// the command, and then waits for the transmission to
-// finish.
-// The write data operation waits until there is room in the
-// transmit FIFO, configures the Data/Command pin for data,
-// and then adds the data to the transmit FIFO.
-// NOTE: These functions will crash or stall indefinitely if
-// the SSI0 module is not initialized and enabled.
+// All transmission goes through a queue drained by the uDMA
+// controller, so drawing calls return as soon as their bytes
+// are queued and the panel is written while the caller gets
+// on with something else.  The queue holds four kinds of
+// segment:
+//   command  one byte sent with Data/Command low
+//   data     a run of bytes copied into DMAData[], sent as
+//            8-bit frames with Data/Command high
+//   pixels   a run of pixel colors copied into DMAData[], sent
+//            as 16-bit frames, one FIFO entry per pixel
+//   fill     a pixel color repeated count times, sent as
+//            16-bit frames from a non-incrementing source
+// DMAData[] holds 16-bit items so both data and pixels are
+// moved by 16-bit transfers; in 8-bit frame mode the SSI sends
+// only the low byte of each.  RAMWR payloads are pixels unless
+// ST7735_SetPixelFrames() asks for the old byte pairs.
+// The Data/Command pin must be valid when the last bit of each
+// byte is sent, so the engine only waits for the SSI to go idle
+// where the pin or the frame size changes.  That wait is the
+// SSI end of transmission interrupt, not a busy loop.  Runs of
+// the same kind are handed from one uDMA transfer to the next
+// without a gap.  uDMA channel 11 (SSI0 TX) moves the bytes;
+// its completion is signaled on the SSI0 interrupt, which runs
+// at the lowest priority so it never holds up USB.
+// The queue has one writer, the main program, and one reader,
+// the SSI0 interrupt, and needs no locking.  The writer only
+// starts the engine when it is idle, and an idle engine has no
+// interrupt that could run at the same time.  A writer that
+// finds the queue full waits for room, so drawing must not be
+// done with interrupts disabled.
+// NOTE: These functions will stall indefinitely if the SSI0
+// module and the uDMA controller are not initialized.
+#define SSI_CR0_DSS_16          0x0000000F  // 16-bit data
+#define SSI_CR1_EOT             0x00000010  // End of Transmission
+#define SSI_IM_TXIM             0x00000008  // SSI Transmit FIFO Interrupt Mask
+#define SSI_DMACTL_TXDMAE       0x00000002  // Transmit DMA Enable
+#define UDMA_CFG_MASTEN         0x00000001  // Controller Master Enable
+#define DMA_CHANNEL             11          // SSI0 TX, encoding 0
+#define DMA_CHANNEL_BIT         (1<<DMA_CHANNEL)
+#define DMA_MAX_ITEMS           1024        // most items in one uDMA transfer
+#define DMA_CTL_DST_FIXED       0xC0000000  // destination does not increment
+#define DMA_CTL_SRC_FIXED       0x0C000000  // source does not increment
+#define DMA_CTL_SIZE_16         0x11000000  // 16-bit source and destination
+#define DMA_CTL_SRC_INC_16      0x04000000  // source increments by a halfword
+#define DMA_CTL_ARB_4           0x00008000  // rearbitrate every 4 items
+#define DMA_CTL_BASIC           0x00000001  // basic transfer mode
+#define SEG_COMMAND             0
+#define SEG_DATA                1
+#define SEG_FILL                2
+#define SEG_PIXELS              3
+#define SEG_OPEN                0xFFFFFFFF  // data segment still growing
+#define DMA_SEGMENTS            64          // queue entries, power of two
+#define DMA_DATA_SIZE           512         // data items, power of two
+
+typedef struct {
+  uint8_t type;         // SEG_COMMAND, SEG_DATA, SEG_PIXELS or SEG_FILL
+  uint8_t command;      // the byte for SEG_COMMAND
+  uint16_t color;       // the pixel for SEG_FILL, and its uDMA source
+  uint32_t count;       // pixels left for SEG_FILL; for SEG_DATA and
+                        // SEG_PIXELS the index in DMAData[] it ends at,
+                        // or SEG_OPEN
+} dmaSegment;
+
+// The uDMA channel control table must be 1024-byte aligned.
+// Only channel 11's primary entry is used.
+#if defined(ccs)
+#pragma DATA_ALIGN(DMAControlTable, 1024)
+static uint32_t DMAControlTable[256];
+#else
+static uint32_t DMAControlTable[256] __attribute__ ((aligned(1024)));
+#endif
+
+static dmaSegment DMASegments[DMA_SEGMENTS];
+static volatile uint32_t DMAHead, DMATail;       // segments queued and retired
+static uint16_t DMAData[DMA_DATA_SIZE];
+static volatile uint32_t DMADataHead, DMADataTail; // data items queued and sent
+static uint8_t DMADataOpen;            // type of the open run at the end of the
+                                       // queue, SEG_DATA or SEG_PIXELS; 0 if none
+static int PixelFrames16 = 1;          // send pixels as 16-bit frames
+static volatile int DMABusy;           // a transfer or an idle wait is running
+static uint32_t DMAItems;              // items in the running transfer
+static uint32_t DMADC = DC_DATA;       // Data/Command pin as last set
+static uint32_t DMAFrame = SSI_CR0_DSS_8; // SSI frame size as last set
+
+// The CASET and RASET ranges last sent, in controller coordinates,
+// so setAddrWindow() can leave out whichever is unchanged; RAMWR
+// alone moves the write back to the window's start.  Forgotten by
+// anything else that sets them or changes their meaning.
+static uint8_t WindowCol0, WindowCol1, WindowRow0, WindowRow1;
+static int WindowColKnown = 0, WindowRowKnown = 0;
+static uint32_t BytesSent, BytesSaved; // SPI bytes queued and left out
+
+// Start a basic uDMA transfer of n 16-bit items to the SSI0
+// data register.
+void static dmaStart(const volatile uint16_t *src, uint32_t n, uint32_t ctl){
+  uint32_t *entry = &DMAControlTable[DMA_CHANNEL*4];
+  if(ctl&DMA_CTL_SRC_FIXED){
+    entry[0] = (uint32_t)src;                // source end pointer
+  } else{
+    entry[0] = (uint32_t)(src + n - 1);
+  }
+  entry[1] = (uint32_t)&SSI0_DR_R;           // destination end pointer
+  entry[2] = ctl|DMA_CTL_DST_FIXED|DMA_CTL_ARB_4|((n - 1)<<4)|DMA_CTL_BASIC;
+  DMAItems = n;
+  UDMA_ENASET_R = DMA_CHANNEL_BIT;
+}
+
+// Start on the next queued segment, or leave the engine idle if
+// there is none.  Called from the SSI0 interrupt, or by the
+// writer when the engine is idle.
+void static dmaNext(void){
+  dmaSegment *seg;
+  uint32_t dc, frame, end, n;
+  DMABusy = 1;
+  while(DMATail != DMAHead){
+    seg = &DMASegments[DMATail&(DMA_SEGMENTS-1)];
+    if((seg->type == SEG_DATA) || (seg->type == SEG_PIXELS)){
+      end = seg->count;
+      if(end == SEG_OPEN){
+        end = DMADataHead;
+        if(end == DMADataTail){
+          break;                             // wait for the writer
+        }
+      } else if(end == DMADataTail){
+        DMATail++;                           // closed and all sent
+        continue;
+      }
+    }
+    dc = (seg->type == SEG_COMMAND) ? DC_COMMAND : DC_DATA;
+    frame = ((seg->type == SEG_FILL) || (seg->type == SEG_PIXELS)) ?
+            SSI_CR0_DSS_16 : SSI_CR0_DSS_8;
+    if((dc != DMADC) || (frame != DMAFrame)){
+      if(SSI0_SR_R&SSI_SR_BSY){
+        SSI0_IM_R |= SSI_IM_TXIM;            // interrupt when the last bit is out
+        return;
+      }
+      if(frame != DMAFrame){
+        SSI0_CR1_R &= ~SSI_CR1_SSE;          // frame size only changes while disabled
+        SSI0_CR0_R = (SSI0_CR0_R&~SSI_CR0_DSS_M)+frame;
+        SSI0_CR1_R |= SSI_CR1_SSE;
+        DMAFrame = frame;
+      }
+      DC = dc;
+      DMADC = dc;
+    }
+    if(seg->type == SEG_COMMAND){
+      if((SSI0_SR_R&SSI_SR_TNF)==0){
+        SSI0_IM_R |= SSI_IM_TXIM;            // FIFO full, wait for it to empty
+        return;
+      }
+      SSI0_DR_R = seg->command;
+      DMATail++;
+      continue;
+    }
+    if(seg->type == SEG_FILL){
+      n = (seg->count < DMA_MAX_ITEMS) ? seg->count : DMA_MAX_ITEMS;
+      dmaStart(&seg->color, n, DMA_CTL_SRC_FIXED|DMA_CTL_SIZE_16);
+    } else{
+      n = end - DMADataTail;                 // stop at the end of the buffer
+      if(n > (DMA_DATA_SIZE - (DMADataTail&(DMA_DATA_SIZE-1)))){
+        n = DMA_DATA_SIZE - (DMADataTail&(DMA_DATA_SIZE-1));
+      }
+      if(n > DMA_MAX_ITEMS){
+        n = DMA_MAX_ITEMS;
+      }
+      dmaStart(&DMAData[DMADataTail&(DMA_DATA_SIZE-1)], n,
+               DMA_CTL_SRC_INC_16|DMA_CTL_SIZE_16);
+    }
+    return;
+  }
+  DMABusy = 0;
+}
+
+//------------ST7735_SSI0Handler------------
+// SSI0 interrupt: a uDMA transfer finished or the SSI went idle.
+// Moves on to the next piece of the queue.
+// Input: none
+// Output: none
+void ST7735_SSI0Handler(void){
+  dmaSegment *seg;
+  SSI0_IM_R &= ~SSI_IM_TXIM;
+  if(UDMA_CHIS_R&DMA_CHANNEL_BIT){
+    UDMA_CHIS_R = DMA_CHANNEL_BIT;           // acknowledge
+    seg = &DMASegments[DMATail&(DMA_SEGMENTS-1)];
+    if(seg->type == SEG_FILL){
+      seg->count -= DMAItems;
+      if(seg->count == 0){
+        DMATail++;
+      }
+    } else{
+      DMADataTail += DMAItems;               // those items are free again
+    }
+  }
+  dmaNext();
+}
+
+// Queue a command or fill segment, ending any open data run.
+void static queueSegment(uint8_t type, uint8_t command, uint16_t color, uint32_t count){
+  dmaSegment *seg;
+  if(DMADataOpen){
+    DMASegments[(DMAHead-1)&(DMA_SEGMENTS-1)].count = DMADataHead;
+    DMADataOpen = 0;
+  }
+  while((DMAHead - DMATail) >= DMA_SEGMENTS){}; // wait for room
+  seg = &DMASegments[DMAHead&(DMA_SEGMENTS-1)];
+  seg->type = type;
+  seg->command = command;
+  seg->color = color;
+  seg->count = count;
+  DMAHead++;
+  if(DMABusy == 0){
+    dmaNext();
+  }
+}
+
 void static writecommand(uint8_t c) {
-                                        // wait until SSI0 not busy/transmit FIFO empty
-  while((SSI0_SR_R&SSI_SR_BSY)==SSI_SR_BSY){};
-  DC = DC_COMMAND;
-  SSI0_DR_R = c;                        // data out
-                                        // wait until SSI0 not busy/transmit FIFO empty
-  while((SSI0_SR_R&SSI_SR_BSY)==SSI_SR_BSY){};
+  BytesSent++;
+  queueSegment(SEG_COMMAND, c, 0, 0);
+}
+
+
+// Add an item to the open run of the given type, starting a
+// new run if the open one is of the other type.
+void static writeitem(uint8_t type, uint16_t c) {
+  if(DMADataOpen != type){
+    queueSegment(type, 0, 0, SEG_OPEN);
+    DMADataOpen = type;
+  }
+  BytesSent += (type == SEG_PIXELS) ? 2 : 1;
+  while((DMADataHead - DMADataTail) >= DMA_DATA_SIZE){}; // wait for room
+  DMAData[DMADataHead&(DMA_DATA_SIZE-1)] = c;
+  DMADataHead++;
+  if(DMABusy == 0){
+    dmaNext();
+  }
 }
 
 
 void static writedata(uint8_t c) {
-  while((SSI0_SR_R&SSI_SR_TNF)==0){};   // wait until transmit FIFO not full
+  writeitem(SEG_DATA, c);
+}
+
+
+// Send one pixel, most significant byte first.
+void static writepixel(uint16_t color) {
+  if(PixelFrames16){
+    writeitem(SEG_PIXELS, color);
+  } else{
+    writeitem(SEG_DATA, color >> 8);
+    writeitem(SEG_DATA, color&0xFF);
+  }
+}
+
+
+// Send count copies of a pixel color.
+void static writefill(uint16_t color, uint32_t count) {
+  if(PixelFrames16 == 0){
+    while(count--){
+      writepixel(color);
+    }
+  } else if(count){
+    BytesSent += 2*count;
+    queueSegment(SEG_FILL, 0, color, count);
+  }
+}
+
+
+//------------ST7735_TransferStats------------
+// Report the SPI traffic since startup.
+// Input: sent  where to store the number of bytes queued for the
+//              panel, counting each pixel as 2
+//        saved where to store the number of bytes of address
+//              window setup left out because the panel already
+//              had the same columns or rows
+// Output: none
+void ST7735_TransferStats(uint32_t *sent, uint32_t *saved){
+  *sent = BytesSent;
+  *saved = BytesSaved;
+}
+
+
+//------------ST7735_Flush------------
+// Wait until everything queued has been sent to the panel.
+// Input: none
+// Output: none
+void ST7735_Flush(void){
+  while(DMABusy){};
+  while((SSI0_SR_R&SSI_SR_BSY)==SSI_SR_BSY){};
+}
+
+
+// Smallest even SSI0 prescaler that keeps SSIClk at or below
+// sclk, with SCR = 0 so SSIClk = SysClk/CPSDVSR.
+uint32_t static clockDivider(uint32_t busClk, uint32_t sclk){
+  uint32_t div = (busClk + sclk - 1)/sclk; // round up
+  div = (div + 1)&~1;                   // must be even
+  if(div < 2) div = 2;                  // SSIClk at most SysClk/2
+  if(div > 254) div = 254;
+  return div;
+}
+
+
+//------------ST7735_SetSPIClock------------
+// Set the fastest SPI clock not above a limit, given the system clock.
+// ST7735_InitB() and ST7735_InitR() assume the 80 MHz of PLL_Init();
+// call this again whenever the system clock changes.
+// Input: busClk system clock in Hz
+//        sclk   highest SPI clock wanted in Hz, normally ST7735_SCLK_MAX
+// Output: the SPI clock set, in Hz
+uint32_t ST7735_SetSPIClock(uint32_t busClk, uint32_t sclk){
+  uint32_t div = clockDivider(busClk, sclk);
+  ST7735_Flush();                       // the prescaler only changes while disabled
+  SSI0_CR1_R &= ~SSI_CR1_SSE;
+  SSI0_CPSR_R = (SSI0_CPSR_R&~SSI_CPSR_CPSDVSR_M)+div;
+  SSI0_CR1_R |= SSI_CR1_SSE;
+  return busClk/div;
+}
+
+
+//------------ST7735_SetPixelFrames------------
+// Choose how pixel data is framed on SSI0.
+// Input: bits 16 (the default) to send each pixel as one 16-bit frame;
+//             8 to send it as two 8-bit frames, as the driver used to
+// Output: none
+void ST7735_SetPixelFrames(int bits){
+  PixelFrames16 = (bits == 16);         // queued pixels keep their framing
+}
+
+
+// Set up uDMA channel 11 to feed SSI0 and the SSI0 interrupt
+// to drive it.  SSI0 must be disabled.
+void static dmaInit(void){
+  SYSCTL_RCGCDMA_R |= 0x01;              // activate uDMA
+  while((SYSCTL_PRDMA_R&0x01)==0){};     // allow time for clock to start
+  UDMA_CFG_R = UDMA_CFG_MASTEN;
+  UDMA_CTLBASE_R = (uint32_t)DMAControlTable;
+  UDMA_CHMAP1_R &= ~0x0000F000;          // channel 11 is SSI0 TX
+  UDMA_PRIOCLR_R = DMA_CHANNEL_BIT;      // default priority
+  UDMA_ALTCLR_R = DMA_CHANNEL_BIT;       // primary control structure
+  UDMA_USEBURSTCLR_R = DMA_CHANNEL_BIT;  // single and burst requests
+  UDMA_REQMASKCLR_R = DMA_CHANNEL_BIT;   // allow requests
+  DMAHead = DMATail = 0;
+  DMADataHead = DMADataTail = 0;
+  DMADataOpen = 0;
+  DMABusy = 0;
   DC = DC_DATA;
-  SSI0_DR_R = c;                        // data out
+  DMADC = DC_DATA;
+  DMAFrame = SSI_CR0_DSS_8;
+  SSI0_CR1_R |= SSI_CR1_EOT;             // TX interrupt means the last bit is out
+  SSI0_IM_R = 0;
+  SSI0_DMACTL_R = SSI_DMACTL_TXDMAE;     // SSI0 requests uDMA for TX
+  NVIC_PRI1_R = (NVIC_PRI1_R&0x00FFFFFF)|0xE0000000; // SSI0 priority 7, the lowest
+  NVIC_EN0_R = 1<<7;                     // enable interrupt 7 in NVIC
 }
 // Subroutine to wait 1 msec
 // Inputs: None
@@ -676,43 +1000,41 @@ static const uint8_t
       100 };                  //     100 ms delay
 
 
-// Companion code to the above tables.  Reads and issues
-// a series of LCD commands stored in ROM byte array.
-void static commandList(const uint8_t *addr) {
-
-  uint8_t numCommands, numArgs;
-  uint16_t ms;
-
-  numCommands = *(addr++);               // Number of commands to follow
-  while(numCommands--) {                 // For each command...
-    writecommand(*(addr++));             //   Read, issue command
-    numArgs  = *(addr++);                //   Number of args to follow
-    ms       = numArgs & DELAY;          //   If hibit set, delay follows args
-    numArgs &= ~DELAY;                   //   Mask out delay bit
-    while(numArgs--) {                   //   For each argument...
-      writedata(*(addr++));              //     Read, issue argument
-    }
-
-    if(ms) {
-      ms = *(addr++);             // Read post-command delay time (ms)
-      if(ms == 255) ms = 500;     // If 255, delay for 500 ms
-      Delay1ms(ms);
-    }
-  }
-}
-
-
-// Initialization code common to both 'B' and 'R' type displays
-void static commonInit(const uint8_t *cmdList) {
-  volatile uint32_t delay;
-  ColStart  = RowStart = 0; // May be overridden in init func
-
+// Initialization is a reset pulse followed by the command lists
+// above, with a wait after the pulse and after each command that
+// has a delay.  It runs as a state machine so that the waits can
+// be spent in the caller's main loop: initStart() sets up the
+// pins and SSI0 and starts the pulse, then each initStep() does
+// whatever has come due.  ST7735_InitB() and ST7735_InitR() just
+// step it to the end, counting the time with Delay1ms().
+// The reset times are the ST7735R minimums with some margin: the
+// pulse needs 10 us and commands may follow 120 ms after it.
+#define INIT_RESET_LOW   2              // ms the reset pin is held low
+#define INIT_RESET_WAIT  120            // ms from reset to the first command
+#define INIT_IDLE        0              // not started
+#define INIT_RESET       1              // reset pin low
+#define INIT_WAIT        2              // waiting before the next command
+#define INIT_DONE        3              // screen ready
+static uint32_t InitState = INIT_IDLE;
+static const uint8_t *InitLists[4];     // command lists to send, ended by 0
+static uint32_t InitList;               // index of the next list
+static const uint8_t *InitAddr;         // next command of the current list
+static uint32_t InitCommands;           // commands left in the current list
+static uint32_t InitFrom;               // ms the wait started
+static uint32_t InitWait;               // ms to wait
+static enum initRFlags InitOption;      // none for an ST7735B
+
+
+// Set up the pins and SSI0, queue the command lists and start
+// the reset pulse.  Nothing is sent until initStep().
+void static initStart(const uint8_t *list1, const uint8_t *list2,
+                      const uint8_t *list3, uint32_t ms) {
   SYSCTL_RCGCSSI_R |= 0x01;  // activate SSI0
   SYSCTL_RCGCGPIO_R |= 0x01; // activate port A
   while((SYSCTL_PRGPIO_R&0x01)==0){}; // allow time for clock to start
 
-  // toggle RST low to reset; CS low so it'll listen to us
-  // SSI0Fss is temporarily used as GPIO
+  // RST and D/C are GPIO; CS is held low through the reset so it'll
+  // listen to us, with SSI0Fss temporarily used as GPIO
   GPIO_PORTA_DIR_R |= 0xC8;             // make PA3,6,7 out
   GPIO_PORTA_AFSEL_R &= ~0xC8;          // disable alt funct on PA3,6,7
   GPIO_PORTA_DEN_R |= 0xC8;             // enable digital I/O on PA3,6,7
@@ -720,12 +1042,7 @@ void static commonInit(const uint8_t *cmdList) {
   GPIO_PORTA_PCTL_R = (GPIO_PORTA_PCTL_R&0x00FF0FFF)+0x00000000;
   GPIO_PORTA_AMSEL_R &= ~0xC8;          // disable analog functionality on PA3,6,7
   TFT_CS = TFT_CS_LOW;
-  RESET = RESET_HIGH;
-  Delay1ms(500);
-  RESET = RESET_LOW;
-  Delay1ms(500);
-  RESET = RESET_HIGH;
-  Delay1ms(500);
+  RESET = RESET_LOW;                    // start the reset pulse
 
   // initialize SSI0
   GPIO_PORTA_AFSEL_R |= 0x2C;           // enable alt funct on PA2,3,5
@@ -737,22 +1054,108 @@ void static commonInit(const uint8_t *cmdList) {
   SSI0_CR1_R &= ~SSI_CR1_MS;            // master mode
                                         // configure for system clock/PLL baud clock source
   SSI0_CC_R = (SSI0_CC_R&~SSI_CC_CS_M)+SSI_CC_CS_SYSPLL;
-//                                        // clock divider for 3.125 MHz SSIClk (50 MHz PIOSC/16)
-//  SSI0_CPSR_R = (SSI0_CPSR_R&~SSI_CPSR_CPSDVSR_M)+16;
-                                        // clock divider for 8 MHz SSIClk (80 MHz PLL/24)
+                                        // clock divider for the fastest SSIClk the panel takes
                                         // SysClk/(CPSDVSR*(1+SCR))
-                                        // 80/(10*(1+0)) = 8 MHz (slower than 4 MHz)
-  SSI0_CPSR_R = (SSI0_CPSR_R&~SSI_CPSR_CPSDVSR_M)+10; // must be even number
-  SSI0_CR0_R &= ~(SSI_CR0_SCR_M |       // SCR = 0 (8 Mbps data rate)
+                                        // 80/(6*(1+0)) = 13.3 MHz from PLL_Init()
+                                        // ST7735_SetSPIClock() redoes this for other clocks
+  SSI0_CPSR_R = (SSI0_CPSR_R&~SSI_CPSR_CPSDVSR_M)+clockDivider(80000000, ST7735_SCLK_MAX);
+  SSI0_CR0_R &= ~(SSI_CR0_SCR_M |       // SCR = 0 (13.3 Mbps data rate)
                   SSI_CR0_SPH |         // SPH = 0
                   SSI_CR0_SPO);         // SPO = 0
                                         // FRF = Freescale format
   SSI0_CR0_R = (SSI0_CR0_R&~SSI_CR0_FRF_M)+SSI_CR0_FRF_MOTO;
                                         // DSS = 8-bit data
   SSI0_CR0_R = (SSI0_CR0_R&~SSI_CR0_DSS_M)+SSI_CR0_DSS_8;
+  dmaInit();                            // transfers go through uDMA
   SSI0_CR1_R |= SSI_CR1_SSE;            // enable SSI
 
-  if(cmdList) commandList(cmdList);
+  WindowColKnown = 0;                   // lists may set CASET and RASET
+  WindowRowKnown = 0;
+  InitLists[0] = list1;
+  InitLists[1] = list2;
+  InitLists[2] = list3;
+  InitLists[3] = 0;
+  InitList = 0;
+  InitCommands = 0;
+  InitFrom = ms;
+  InitWait = INIT_RESET_LOW;
+  InitState = INIT_RESET;
+}
+
+
+// Finish off once the lists are sent.
+void static initFinish(void) {
+  // if black, change MADCTL color filter
+  if (InitOption == INITR_BLACKTAB) {
+    writecommand(ST7735_MADCTL);
+    writedata(0xC0);
+  }
+  if(InitOption != none) {
+    TabColor = InitOption;
+  }
+  ST7735_SetCursor(0,0);
+  StTextColor = ST7735_YELLOW;
+  ST7735_FillScreen(0);                 // set screen to black
+}
+
+
+// Do whatever is due at time ms: end the reset pulse, or send
+// commands up to and including the next one with a delay.
+// Returns 1 once the screen is ready.
+int static initStep(uint32_t ms) {
+  uint8_t numArgs;
+  uint16_t delay;
+
+  if(InitState == INIT_DONE) return 1;
+  if(InitState == INIT_IDLE) return 0;
+  if((ms - InitFrom) <= InitWait) return 0; // wait at least InitWait ms
+
+  if(InitState == INIT_RESET) {
+    RESET = RESET_HIGH;                 // end the reset pulse
+    InitFrom = ms;
+    InitWait = INIT_RESET_WAIT;
+    InitState = INIT_WAIT;
+    return 0;
+  }
+
+  while(1) {
+    while(InitCommands == 0) {          // on to the next list
+      if(InitLists[InitList] == 0) {
+        initFinish();
+        InitState = INIT_DONE;
+        return 1;
+      }
+      InitAddr = InitLists[InitList++];
+      InitCommands = *(InitAddr++);     // Number of commands to follow
+    }
+    InitCommands--;
+    writecommand(*(InitAddr++));        // Read, issue command
+    numArgs  = *(InitAddr++);           // Number of args to follow
+    delay    = numArgs & DELAY;         // If hibit set, delay follows args
+    numArgs &= ~DELAY;                  // Mask out delay bit
+    while(numArgs--) {                  // For each argument...
+      writedata(*(InitAddr++));         //   Read, issue argument
+    }
+
+    if(delay) {
+      delay = *(InitAddr++);            // Read post-command delay time (ms)
+      if(delay == 255) delay = 500;     // If 255, delay for 500 ms
+      ST7735_Flush();                   // the delay runs from the command being sent
+      InitFrom = ms;
+      InitWait = delay;
+      return 0;
+    }
+  }
+}
+
+
+// Step the initialization to the end, blocking.
+void static initRun(void) {
+  uint32_t ms = 0;
+  while(initStep(ms) == 0) {
+    Delay1ms(1);
+    ms++;
+  }
 }
 
 
@@ -761,68 +1164,141 @@ void static commonInit(const uint8_t *cmdList) {
 // Input: none
 // Output: none
 void ST7735_InitB(void) {
-  commonInit(Bcmd);
-  ST7735_SetCursor(0,0);
-  StTextColor = ST7735_YELLOW;
-  ST7735_FillScreen(0);                 // set screen to black
+  ColStart = RowStart = 0;
+  InitOption = none;
+  initStart(Bcmd, 0, 0, 0);
+  initRun();
 }
 
 
-//------------ST7735_InitR------------
-// Initialization for ST7735R screens (green or red tabs).
+//------------ST7735_InitRStart------------
+// Start initializing an ST7735R screen without waiting for it.
+// Sets up SSI0 and the control pins and begins the reset pulse;
+// ST7735_InitProcess() then does the rest of ST7735_InitR().
 // Input: option one of the enumerated options depending on tabs
+//        ms     the time in ms, on the clock later passed to
+//               ST7735_InitProcess()
 // Output: none
-void ST7735_InitR(enum initRFlags option) {
-  commonInit(Rcmd1);
+void ST7735_InitRStart(enum initRFlags option, uint32_t ms) {
+  InitOption = option;
   if(option == INITR_GREENTAB) {
-    commandList(Rcmd2green);
     ColStart = 2;
     RowStart = 1;
+    initStart(Rcmd1, Rcmd2green, Rcmd3, ms);
   } else {
     // colstart, rowstart left at default '0' values
-    commandList(Rcmd2red);
+    ColStart = RowStart = 0;
+    initStart(Rcmd1, Rcmd2red, Rcmd3, ms);
   }
-  commandList(Rcmd3);
+}
 
-  // if black, change MADCTL color filter
-  if (option == INITR_BLACKTAB) {
-    writecommand(ST7735_MADCTL);
-    writedata(0xC0);
+
+//------------ST7735_InitR------------
+// Initialization for ST7735R screens (green or red tabs).
+// Input: option one of the enumerated options depending on tabs
+// Output: none
+void ST7735_InitR(enum initRFlags option) {
+  ST7735_InitRStart(option, 0);
+  initRun();
+}
+
+
+//------------ST7735_InitProcess------------
+// Carry on with the initialization started by
+// ST7735_InitRStart(), sending whatever has come due.
+// Input: ms the time in ms on any free-running millisecond clock
+// Output: 1 once the screen is ready; 0 until then
+int ST7735_InitProcess(uint32_t ms) {
+  return initStep(ms);
+}
+
+
+// The text functions keep a shadow of the characters in screen
+// RAM, one cell per character position, and only send the cells
+// that change.  A cell is the 6 by 8 pixels of a glyph at the
+// top of a 6 by 10 text position.  Cells are indexed by RAM
+// position, so console scrolling does not move them.  Any other
+// drawing forgets the cells its address window touches, except
+// a black fill, which leaves the cells it covers known blank.
+typedef struct {
+  char ch;                              // character shown; ' ' if blank
+  uint8_t known;                        // 0 if the pixels are not known
+  uint16_t color;                       // text color; 0 if blank
+} textCell;
+
+static textCell TextCells[16][21];
+
+// Forget the cells that overlap a rectangle of RAM.
+void static gridForget(int32_t x0, int32_t y0, int32_t x1, int32_t y1){
+  int32_t row, col, col0;
+  row = (y0 > 7) ? (y0 - 7 + 9)/10 : 0;
+  col0 = (x0 > 5) ? (x0 - 5 + 5)/6 : 0;
+  for(; (row <= 15) && (row*10 <= y1); row=row+1){
+    for(col=col0; (col <= 20) && (col*6 <= x1); col=col+1){
+      TextCells[row][col].known = 0;
+    }
+  }
+}
+
+// Mark the cells wholly inside a rectangle of RAM as blank.
+void static gridBlank(int32_t x0, int32_t y0, int32_t x1, int32_t y1){
+  int32_t row, col, col0;
+  row = (y0 > 0) ? (y0 + 9)/10 : 0;
+  col0 = (x0 > 0) ? (x0 + 5)/6 : 0;
+  for(; (row <= 15) && ((row*10 + 7) <= y1); row=row+1){
+    for(col=col0; (col <= 20) && ((col*6 + 5) <= x1); col=col+1){
+      TextCells[row][col].ch = ' ';
+      TextCells[row][col].known = 1;
+      TextCells[row][col].color = 0;
+    }
   }
-  TabColor = option;
-  ST7735_SetCursor(0,0);
-  StTextColor = ST7735_YELLOW;
-  ST7735_FillScreen(0);                 // set screen to black
 }
 
 
 // Set the region of the screen RAM to be modified
 // Pixel colors are sent left to right, top to bottom
 // (same as Font table is encoded; different from regular bitmap)
-// Requires 11 bytes of transmission
+// Requires 11 bytes of transmission, 6 if the columns or the rows
+// are the same as last time and 1 if both are
 void static setAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+  uint8_t xs = x0+ColStart, xe = x1+ColStart;
+  uint8_t ys = y0+RowStart, ye = y1+RowStart;
+  gridForget(x0, y0, x1, y1);           // whatever is drawn replaces the text
 
-  writecommand(ST7735_CASET); // Column addr set
-  writedata(0x00);
-  writedata(x0+ColStart);     // XSTART
-  writedata(0x00);
-  writedata(x1+ColStart);     // XEND
+  if(WindowColKnown && (xs == WindowCol0) && (xe == WindowCol1)){
+    BytesSaved += 5;
+  } else{
+    writecommand(ST7735_CASET); // Column addr set
+    writedata(0x00);
+    writedata(xs);              // XSTART
+    writedata(0x00);
+    writedata(xe);              // XEND
+    WindowCol0 = xs;
+    WindowCol1 = xe;
+    WindowColKnown = 1;
+  }
 
-  writecommand(ST7735_RASET); // Row addr set
-  writedata(0x00);
-  writedata(y0+RowStart);     // YSTART
-  writedata(0x00);
-  writedata(y1+RowStart);     // YEND
+  if(WindowRowKnown && (ys == WindowRow0) && (ye == WindowRow1)){
+    BytesSaved += 5;
+  } else{
+    writecommand(ST7735_RASET); // Row addr set
+    writedata(0x00);
+    writedata(ys);              // YSTART
+    writedata(0x00);
+    writedata(ye);              // YEND
+    WindowRow0 = ys;
+    WindowRow1 = ye;
+    WindowRowKnown = 1;
+  }
 
   writecommand(ST7735_RAMWR); // write to RAM
 }
 
 
-// Send two bytes of data, most significant byte first
+// Send one pixel, most significant byte first
 // Requires 2 bytes of transmission
 void static pushColor(uint16_t color) {
-  writedata((uint8_t)(color >> 8));
-  writedata((uint8_t)color);
+  writepixel(color);
 }
 
 
@@ -858,17 +1334,12 @@ void ST7735_DrawPixel(int16_t x, int16_t y, uint16_t color) {
 //        color 16-bit color, which can be produced by ST7735_Color565()
 // Output: none
 void ST7735_DrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
-  uint8_t hi = color >> 8, lo = color;
-
   // Rudimentary clipping
   if((x >= _width) || (y >= _height)) return;
   if((y+h-1) >= _height) h = _height-y;
   setAddrWindow(x, y, x, y+h-1);
 
-  while (h--) {
-    writedata(hi);
-    writedata(lo);
-  }
+  writefill(color, h);
 }
 
 
@@ -882,17 +1353,12 @@ void ST7735_DrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
 //        color 16-bit color, which can be produced by ST7735_Color565()
 // Output: none
 void ST7735_DrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
-  uint8_t hi = color >> 8, lo = color;
-
   // Rudimentary clipping
   if((x >= _width) || (y >= _height)) return;
   if((x+w-1) >= _width)  w = _width-x;
   setAddrWindow(x, y, x+w-1, y);
 
-  while (w--) {
-    writedata(hi);
-    writedata(lo);
-  }
+  writefill(color, w);
 }
 
 
@@ -917,20 +1383,58 @@ void ST7735_FillScreen(uint16_t color) {
 //        color 16-bit color, which can be produced by ST7735_Color565()
 // Output: none
 void ST7735_FillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
-  uint8_t hi = color >> 8, lo = color;
-
   // rudimentary clipping (drawChar w/big text requires this)
   if((x >= _width) || (y >= _height)) return;
   if((x + w - 1) >= _width)  w = _width  - x;
   if((y + h - 1) >= _height) h = _height - y;
 
   setAddrWindow(x, y, x+w-1, y+h-1);
+  if(color == ST7735_BLACK){
+    gridBlank(x, y, x+w-1, y+h-1);
+  }
 
-  for(y=h; y>0; y--) {
-    for(x=w; x>0; x--) {
-      writedata(hi);
-      writedata(lo);
-    }
+  writefill(color, w*h);
+}
+
+
+//------------ST7735_SetWindow------------
+// Select a rectangle of screen RAM to be written by following calls to
+// ST7735_PushColor().  Pixels fill the window left to right, top to
+// bottom, and wrap back to the top left corner when it is full.
+// Requires 11 bytes of transmission
+// Input: x     horizontal position of the top left corner of the window, columns from the left edge
+//        y     vertical position of the top left corner of the window, rows from the top edge
+//        w     horizontal width of the window
+//        h     vertical height of the window
+// Output: none
+// The window must lie entirely on the screen; there is no clipping.
+void ST7735_SetWindow(int16_t x, int16_t y, int16_t w, int16_t h) {
+  setAddrWindow(x, y, x+w-1, y+h-1);
+}
+
+
+//------------ST7735_PushColor------------
+// Write count pixels of one color into the window selected by
+// ST7735_SetWindow(), continuing from where the last write stopped.
+// Requires 2*count bytes of transmission
+// Input: color 16-bit color, which can be produced by ST7735_Color565()
+//        count number of pixels
+// Output: none
+void ST7735_PushColor(uint16_t color, uint32_t count) {
+  writefill(color, count);
+}
+
+
+//------------ST7735_PushPixels------------
+// Write count pixels, each its own color, into the window selected by
+// ST7735_SetWindow(), continuing from where the last write stopped.
+// Requires 2*count bytes of transmission
+// Input: pixels pointer to the 16-bit colors
+//        count  number of pixels
+// Output: none
+void ST7735_PushPixels(const uint16_t *pixels, uint32_t count) {
+  while(count--){
+    writepixel(*(pixels++));
   }
 }
 
@@ -1013,10 +1517,7 @@ void ST7735_DrawBitmap(int16_t x, int16_t y, const uint16_t *image, int16_t w, i
 
   for(y=0; y<h; y=y+1){
     for(x=0; x<w; x=x+1){
-                                        // send the top 8 bits
-      writedata((uint8_t)(image[i] >> 8));
-                                        // send the bottom 8 bits
-      writedata((uint8_t)image[i]);
+      writepixel(image[i]);             // send both halves as one frame
       i = i + 1;                        // go to the next pixel
     }
     i = i + skipC;
@@ -1025,14 +1526,138 @@ void ST7735_DrawBitmap(int16_t x, int16_t y, const uint16_t *image, int16_t w, i
 }
 
 
+// Text is drawn a run of characters at a time.  One address
+// window covers the whole run, and each of its 8 rows is sent
+// as the glyphs' pixels side by side, so a run of n characters
+// costs 11 + 96*n bytes instead of 624*n through DrawPixel.
+// Font[] stores each glyph as 5 columns; TextGlyphs[] is a
+// small cache of glyphs turned on their side into 8 rows of 6
+// bits, the 6th column always background.  Rows become pixels
+// through TextNibble[], the 16 patterns of 4 pixels in the
+// current text and background colors, rebuilt when they change.
+#define TEXT_GLYPHS 32                  // glyph cache entries, power of two
+
+typedef struct {
+  uint16_t key;                         // character + 0x100 once filled
+  uint8_t rows[8];                      // bit i set for text in column i
+} textGlyph;
+
+static textGlyph TextGlyphs[TEXT_GLYPHS];
+static uint16_t TextNibble[16][4];
+static uint16_t TextFg, TextBg;         // colors TextNibble[] holds
+static int TextNibbleValid = 0;
+
+// Return the rows of a glyph, filling its cache entry on a miss.
+const static uint8_t *glyphRows(char c){
+  textGlyph *glyph = &TextGlyphs[(uint8_t)c&(TEXT_GLYPHS-1)];
+  int32_t row, col;
+  if(glyph->key != ((uint8_t)c|0x100)){
+    for(row=0; row<8; row=row+1){
+      glyph->rows[row] = 0;
+      for(col=0; col<5; col=col+1){
+        if(Font[((uint8_t)c*5)+col]&(1<<row)){
+          glyph->rows[row] |= 1<<col;
+        }
+      }
+    }
+    glyph->key = (uint8_t)c|0x100;
+  }
+  return glyph->rows;
+}
+
+// Build the pixel patterns for a pair of colors, if not already built.
+void static textColors(uint16_t textColor, uint16_t bgColor){
+  int32_t bits, i;
+  if(TextNibbleValid && (textColor == TextFg) && (bgColor == TextBg)){
+    return;
+  }
+  for(bits=0; bits<16; bits=bits+1){
+    for(i=0; i<4; i=i+1){
+      TextNibble[bits][i] = (bits&(1<<i)) ? textColor : bgColor;
+    }
+  }
+  TextFg = textColor;
+  TextBg = bgColor;
+  TextNibbleValid = 1;
+}
+
+// Draw n characters side by side, size 1, with the top left
+// corner of the first at (x, y) and every pixel painted.
+// Clipped on the right; the run is skipped if any other edge
+// is off the screen.
+void static drawText(int16_t x, int16_t y, const char *pt, uint32_t n,
+                     uint16_t textColor, uint16_t bgColor){
+  const uint8_t *rows[21];              // a full screen width of glyphs
+  int32_t w, left, row;
+  uint32_t i;
+  if((x < 0) || (y < 0) || (x >= _width) || ((y + 8) > _height)) return;
+  if(n > 21) n = 21;
+  w = 6*n;
+  if((x + w) > _width) w = _width - x;
+  if(w <= 0) return;
+
+  textColors(textColor, bgColor);
+  for(i=0; i<n; i=i+1){
+    rows[i] = glyphRows(pt[i]);
+  }
+  setAddrWindow(x, y, x+w-1, y+7);
+  for(row=0; row<8; row=row+1){
+    left = w;
+    for(i=0; (i<n) && (left>0); i=i+1){
+      const uint16_t *lo = TextNibble[rows[i][row]&0x0F];
+      const uint16_t *hi = TextNibble[rows[i][row]>>4];
+      writepixel(lo[0]); if(--left == 0) break;
+      writepixel(lo[1]); if(--left == 0) break;
+      writepixel(lo[2]); if(--left == 0) break;
+      writepixel(lo[3]); if(--left == 0) break;
+      writepixel(hi[0]); if(--left == 0) break;
+      writepixel(hi[1]); --left;
+    }
+  }
+}
+
+
+// Draw up to n characters in the text color on black at a cell
+// position, sending only the runs of cells that change.
+void static gridText(uint32_t col, uint32_t row, const char *pt, uint32_t n, uint16_t color){
+  textCell *cell;
+  uint32_t i, start;
+  if((col > 20) || (row > 15) || ((row*10 + 8) > _height)) return;
+  if(n > (21 - col)) n = 21 - col;
+  cell = &TextCells[row][col];
+  i = 0;
+  while(i < n){
+    while((i < n) && cell[i].known && (cell[i].ch == pt[i]) &&
+          ((pt[i] == ' ') || (cell[i].color == color))){
+      i = i + 1;                        // unchanged
+    }
+    start = i;
+    while((i < n) && !(cell[i].known && (cell[i].ch == pt[i]) &&
+          ((pt[i] == ' ') || (cell[i].color == color)))){
+      i = i + 1;                        // changed
+    }
+    if(i > start){
+      drawText((col + start)*6, row*10, &pt[start], i - start, color, ST7735_BLACK);
+      for(; start < i; start=start+1){
+        cell[start].ch = pt[start];
+        cell[start].known = 1;
+        cell[start].color = (pt[start] == ' ') ? 0 : color;
+      }
+    }
+  }
+}
+
+
 //------------ST7735_DrawCharS------------
 // Simple character draw function.  This is the same function from
-// Adafruit_GFX.c but adapted for this processor.  However, each call
-// to ST7735_DrawPixel() calls setAddrWindow(), which needs to send
+// Adafruit_GFX.c but adapted for this processor.  At size 1 with a
+// background it is drawn through one address window; otherwise each
+// call to ST7735_DrawPixel() calls setAddrWindow(), which needs to send
 // many extra data and commands.  If the background color is the same
 // as the text color, no background will be printed, and text can be
 // drawn right over existing images without covering them with a box.
-// Requires (11 + 2*size*size)*6*8 (image fully on screen; textcolor != bgColor)
+// Requires 107 bytes of transmission at size 1 (image fully on screen; textcolor != bgColor)
+// otherwise (11 + 2*size*size)*6*8
 // Input: x         horizontal position of the top left corner of the character, columns from the left edge
 //        y         vertical position of the top left corner of the character, rows from the top edge
 //        c         character to be printed
@@ -1049,6 +1674,15 @@ void ST7735_DrawCharS(int16_t x, int16_t y, char c, int16_t textColor, int16_t b
      ((y + 8 * size - 1) < 0))   // Clip top
     return;
 
+  if((size == 1) && (bgColor != textColor) && (x >= 0) && (y >= 0) && ((y + 8) <= _height)){
+    if((bgColor == ST7735_BLACK) && ((x%6) == 0) && ((y%10) == 0)){
+      gridText(x/6, y/10, &c, 1, textColor); // on a text position
+    } else{
+      drawText(x, y, &c, 1, textColor, bgColor);
+    }
+    return;
+  }
+
   for (i=0; i<6; i++ ) {
     if (i == 5)
       line = 0x0;
@@ -1097,6 +1731,11 @@ void ST7735_DrawChar(int16_t x, int16_t y, char c, int16_t textColor, int16_t bg
     return;
   }
 
+  if(size == 1){
+    drawText(x, y, &c, 1, textColor, bgColor);
+    return;
+  }
+
   setAddrWindow(x, y, x+6*size-1, y+8*size-1);
 
   line = 0x01;        // print the top row first
@@ -1125,10 +1764,32 @@ void ST7735_DrawChar(int16_t x, int16_t y, char c, int16_t textColor, int16_t bg
     line = line<<1;   // move up to the next row
   }
 }
+// Console mode scrolls the text rows between a fixed header and
+// footer with the controller's vertical scrolling.  Each scroll
+// rotates screen RAM by one text row, so text row r of the
+// scrolling area is drawn ConsoleTop + 10*(r - ConsoleHead)
+// pixels into the area, wrapping at its height.  Only the
+// portrait rotations scroll vertically.
+static int ConsoleOn = 0;
+static int ScopeOn = 0;                   // the area holds ST7735_Scope rows
+static uint32_t ConsoleHead, ConsoleFoot; // fixed text rows at top and bottom
+static uint32_t ConsoleTop;               // RAM offset of the top row of the area
+
+// Return the y pixel in screen RAM of a text row (0 to 15).
+int16_t static textY(uint32_t row){
+  uint32_t area;
+  if((ConsoleOn == 0) || (row < ConsoleHead) || (row > (15 - ConsoleFoot))){
+    return row*10;
+  }
+  area = (16 - ConsoleHead - ConsoleFoot)*10;
+  return ConsoleHead*10 + (ConsoleTop + (row - ConsoleHead)*10)%area;
+}
+
+
 //------------ST7735_DrawString------------
 // String draw function.
 // 16 rows (0 to 15) and 21 characters (0 to 20)
-// Requires (11 + size*size*6*8) bytes of transmission for each character
+// Requires (11 + 96*n) bytes of transmission for n characters
 // Input: x         columns from the left edge (0 to 20)
 //        y         rows from the top edge (0 to 15)
 //        pt        pointer to a null terminated string to be printed
@@ -1138,13 +1799,12 @@ void ST7735_DrawChar(int16_t x, int16_t y, char c, int16_t textColor, int16_t bg
 uint32_t ST7735_DrawString(uint16_t x, uint16_t y, char *pt, int16_t textColor){
   uint32_t count = 0;
   if(y>15) return 0;
-  while(*pt){
-    ST7735_DrawCharS(x*6, y*10, *pt, textColor, ST7735_BLACK, 1);
-    pt++;
-    x = x+1;
-    if(x>20) return count;  // number of characters printed
+  while(pt[count] && ((x+count)<=20)){
     count++;
   }
+  if(count == 0) return 0;
+  gridText(x, textY(y)/10, pt, count, textColor);
+  if((x+count)>20) return count-1;  // the last column is not counted
   return count;  // number of characters printed
 }
 
@@ -1195,7 +1855,7 @@ void ST7735_OutUDec(uint32_t n){
   StX = StX+Messageindex;
   if(StX>20){
     StX = 20;
-    ST7735_DrawCharS(StX*6,StY*10,'*',ST7735_RED,ST7735_BLACK, 1);
+    ST7735_DrawCharS(StX*6,textY(StY),'*',ST7735_RED,ST7735_BLACK, 1);
   }
 }
 
@@ -1218,6 +1878,10 @@ void ST7735_OutUDec(uint32_t n){
 // Output: none
 void ST7735_SetRotation(uint8_t m) {
 
+  ST7735_ConsoleOff();              // scrolling is tied to the rotation
+  gridForget(0, 0, ST7735_TFTHEIGHT-1, ST7735_TFTHEIGHT-1); // RAM is laid out anew
+  WindowColKnown = 0;               // and addressed anew
+  WindowRowKnown = 0;
   writecommand(ST7735_MADCTL);
   Rotation = m % 4; // can't be higher than 3
   switch (Rotation) {
@@ -1273,6 +1937,33 @@ void ST7735_InvertDisplay(int i) {
     writecommand(ST7735_INVOFF);
   }
 }
+
+
+//------------ST7735_Sleep------------
+// Blank the panel and put its controller to sleep, or wake it back up.
+// The contents of screen RAM are kept while asleep.
+// Requires 2 bytes of transmission
+// Input: i non-zero to sleep; 0 to wake
+// Output: none
+// Going to sleep only waits for the 2 bytes to be sent.  Waking up
+// blocks for 240 ms: 120 ms after SLPIN, the time the controller
+// needs before it accepts SLPOUT, in case the sleep was short, and
+// 120 ms after SLPOUT before DISPON.  Does nothing before the
+// screen has been initialized.
+void ST7735_Sleep(int i) {
+  if(InitState != INIT_DONE) return;
+  if(i){
+    writecommand(ST7735_DISPOFF);
+    writecommand(ST7735_SLPIN);
+    ST7735_Flush();
+  } else{
+    Delay1ms(120);
+    writecommand(ST7735_SLPOUT);
+    ST7735_Flush();
+    Delay1ms(120);
+    writecommand(ST7735_DISPON);
+  }
+}
 // graphics routines
 // y coordinates 0 to 31 used for labels and messages
 // y coordinates 32 to 159  128 pixels high
@@ -1281,24 +1972,60 @@ void ST7735_InvertDisplay(int i) {
 int32_t Ymax,Ymin,X;        // X goes from 0 to 127
 int32_t Yrange; //YrangeDiv2;
 
+// Rows of each column drawn by the plot functions since it was
+// last erased, so ST7735_PlotNextErase() clears only those.
+// Known once ST7735_PlotClear() has cleared the whole plot.
+static uint8_t PlotTop[128], PlotBottom[128]; // PlotTop > PlotBottom if none
+static int PlotKnown = 0;
+
+// Map a value to a plot row: Ymax is row 32 and Ymin is row 159.
+int32_t static plotRow(int32_t y){int32_t j;
+  if(y<Ymin) y=Ymin;
+  if(y>Ymax) y=Ymax;
+  j = 32+(127*(Ymax-y))/Yrange;
+  if(j<32) j = 32;
+  if(j>159) j = 159;
+  return j;
+}
+
+// Note rows j0 to j1 of column x as drawn.
+void static plotMark(int32_t x, int32_t j0, int32_t j1){
+  if((x < 0) || (x > 127)) return;
+  if(j0 < PlotTop[x]) PlotTop[x] = j0;
+  if(j1 > PlotBottom[x]) PlotBottom[x] = j1;
+}
+
+// Draw rows j0 to j1 of columns X and X+1 as one span, with one
+// address window.
+// Requires (11 + 4*(j1-j0+1)) bytes of transmission
+void static plotSpan(int32_t j0, int32_t j1, uint16_t color){
+  ST7735_FillRect(X, j0, 2, j1-j0+1, color);
+  plotMark(X, j0, j1);
+  plotMark(X+1, j0, j1);
+}
+
 // *************** ST7735_PlotClear ********************
 // Clear the graphics buffer, set X coordinate to 0
 // This routine clears the display
 // Inputs: ymin and ymax are range of the plot
 // Outputs: none
-void ST7735_PlotClear(int32_t ymin, int32_t ymax){
+void ST7735_PlotClear(int32_t ymin, int32_t ymax){int32_t i;
   ST7735_FillRect(0, 32, 128, 128, ST7735_Color565(228,228,228)); // light grey
   if(ymax>ymin){
     Ymax = ymax;
     Ymin = ymin;
-    Yrange = ymax-ymin;
   } else{
     Ymax = ymin;
     Ymin = ymax;
-    Yrange = ymax-ymin;
   }
+  Yrange = Ymax-Ymin;
   //YrangeDiv2 = Yrange/2;
   X = 0;
+  for(i=0; i<128; i++){
+    PlotTop[i] = 255;
+    PlotBottom[i] = 0;
+  }
+  PlotKnown = 1;
 }
 
 // *************** ST7735_PlotPoint ********************
@@ -1307,19 +2034,10 @@ void ST7735_PlotClear(int32_t ymin, int32_t ymax){
 // Inputs: y is the y coordinate of the point plotted
 // Outputs: none
 void ST7735_PlotPoint(int32_t y){int32_t j;
-  if(y<Ymin) y=Ymin;
-  if(y>Ymax) y=Ymax;
   // X goes from 0 to 127
   // j goes from 159 to 32
-  // y=Ymax maps to j=32
-  // y=Ymin maps to j=159
-  j = 32+(127*(Ymax-y))/Yrange;
-  if(j<32) j = 32;
-  if(j>159) j = 159;
-  ST7735_DrawPixel(X,   j,   ST7735_BLUE);
-  ST7735_DrawPixel(X+1, j,   ST7735_BLUE);
-  ST7735_DrawPixel(X,   j+1, ST7735_BLUE);
-  ST7735_DrawPixel(X+1, j+1, ST7735_BLUE);
+  j = plotRow(y);
+  plotSpan(j, j+1, ST7735_BLUE);      // 2 by 2 square, clipped at row 159
 }
 // *************** ST7735_PlotLine ********************
 // Used in the voltage versus time plot, plot line to new point
@@ -1327,31 +2045,18 @@ void ST7735_PlotPoint(int32_t y){int32_t j;
 // Inputs: y is the y coordinate of the point plotted
 // Outputs: none
 int32_t lastj=0;
-void ST7735_PlotLine(int32_t y){int32_t i,j;
-  if(y<Ymin) y=Ymin;
-  if(y>Ymax) y=Ymax;
+void ST7735_PlotLine(int32_t y){int32_t j;
   // X goes from 0 to 127
   // j goes from 159 to 32
-  // y=Ymax maps to j=32
-  // y=Ymin maps to j=159
-  j = 32+(127*(Ymax-y))/Yrange;
-  if(j < 32) j = 32;
-  if(j > 159) j = 159;
+  j = plotRow(y);
   if(lastj < 32) lastj = j;
   if(lastj > 159) lastj = j;
   if(lastj < j){
-    for(i = lastj+1; i<=j ; i++){
-      ST7735_DrawPixel(X,   i,   ST7735_BLUE) ;
-      ST7735_DrawPixel(X+1, i,   ST7735_BLUE) ;
-    }
+    plotSpan(lastj+1, j, ST7735_BLUE);
   }else if(lastj > j){
-    for(i = j; i<lastj ; i++){
-      ST7735_DrawPixel(X,   i,   ST7735_BLUE) ;
-      ST7735_DrawPixel(X+1, i,   ST7735_BLUE) ;
-    }
+    plotSpan(j, lastj-1, ST7735_BLUE);
   }else{
-    ST7735_DrawPixel(X,   j,   ST7735_BLUE) ;
-    ST7735_DrawPixel(X+1, j,   ST7735_BLUE) ;
+    plotSpan(j, j, ST7735_BLUE);
   }
   lastj = j;
 }
@@ -1363,22 +2068,14 @@ void ST7735_PlotLine(int32_t y){int32_t i,j;
 //         y2 is the y coordinate of the second point plotted
 // Outputs: none
 void ST7735_PlotPoints(int32_t y1,int32_t y2){int32_t j;
-  if(y1<Ymin) y1=Ymin;
-  if(y1>Ymax) y1=Ymax;
   // X goes from 0 to 127
   // j goes from 159 to 32
-  // y=Ymax maps to j=32
-  // y=Ymin maps to j=159
-  j = 32+(127*(Ymax-y1))/Yrange;
-  if(j<32) j = 32;
-  if(j>159) j = 159;
+  j = plotRow(y1);
   ST7735_DrawPixel(X, j, ST7735_BLUE);
-  if(y2<Ymin) y2=Ymin;
-  if(y2>Ymax) y2=Ymax;
-  j = 32+(127*(Ymax-y2))/Yrange;
-  if(j<32) j = 32;
-  if(j>159) j = 159;
+  plotMark(X, j, j);
+  j = plotRow(y2);
   ST7735_DrawPixel(X, j, ST7735_BLACK);
+  plotMark(X, j, j);
 }
 // *************** ST7735_PlotBar ********************
 // Used in the voltage versus time bar, plot one bar at y
@@ -1387,15 +2084,11 @@ void ST7735_PlotPoints(int32_t y1,int32_t y2){int32_t j;
 // Outputs: none
 void ST7735_PlotBar(int32_t y){
 int32_t j;
-  if(y<Ymin) y=Ymin;
-  if(y>Ymax) y=Ymax;
   // X goes from 0 to 127
   // j goes from 159 to 32
-  // y=Ymax maps to j=32
-  // y=Ymin maps to j=159
-  j = 32+(127*(Ymax-y))/Yrange;
+  j = plotRow(y);
   ST7735_DrawFastVLine(X, j, 159-j, ST7735_BLACK);
-
+  plotMark(X, j, 158);
 }
 
 // full scaled defined as 3V
@@ -1444,7 +2137,7 @@ int32_t j;
   // y=0 maps to j=159
   j = dBfs[y];
   ST7735_DrawFastVLine(X, j, 159-j, ST7735_BLACK);
-
+  plotMark(X, j, 158);
 }
 
 // *************** ST7735_PlotNext ********************
@@ -1464,7 +2157,9 @@ void ST7735_PlotNext(void){
 // *************** ST7735_PlotNextErase ********************
 // Used in all the plots to step the X coordinate one pixel
 // X steps from 0 to 127, then back to 0 again
-// It clears the vertical space into which the next pixel will be drawn
+// It clears the vertical space into which the next pixel will be drawn,
+// which after ST7735_PlotClear() is only the span the plot functions
+// drew in that column
 // Inputs: none
 // Outputs: none
 void ST7735_PlotNextErase(void){
@@ -1473,7 +2168,14 @@ void ST7735_PlotNextErase(void){
   } else{
     X++;
   }
-  ST7735_DrawFastVLine(X,32,128,ST7735_Color565(228,228,228));
+  if(PlotKnown == 0){
+    ST7735_DrawFastVLine(X,32,128,ST7735_Color565(228,228,228));
+  } else if(PlotTop[X] <= PlotBottom[X]){
+    ST7735_DrawFastVLine(X, PlotTop[X], PlotBottom[X]-PlotTop[X]+1,
+                         ST7735_Color565(228,228,228));
+  }
+  PlotTop[X] = 255;
+  PlotBottom[X] = 0;
 }
 
 // Used in all the plots to write buffer to LCD
@@ -1519,6 +2221,215 @@ void ST7735_PlotNextErase(void){
 //        ST7735_PlotNext();
 //    }   // called 128 times
 
+// Set the fixed and scrolling areas.  Rotation 0 mirrors rows
+// (MADCTL_MY), so the top of the image is the bottom of RAM and
+// the header is the controller's bottom fixed area.
+void static consoleDefine(void){
+  uint32_t top = ConsoleHead*10 + RowStart;
+  uint32_t bottom = ConsoleFoot*10 + RowStart;
+  uint32_t area = (16 - ConsoleHead - ConsoleFoot)*10;
+  uint32_t swap;
+  if(Rotation == 0){
+    swap = top; top = bottom; bottom = swap;
+  }
+  writecommand(ST7735_VSCRDEF);
+  writedata(top >> 8);
+  writedata(top);
+  writedata(area >> 8);
+  writedata(area);
+  writedata(bottom >> 8);
+  writedata(bottom);
+}
+
+
+// Show the scrolling area starting from ConsoleTop.
+// VSCSAD names the RAM line shown at the controller's top of the
+// area, which under rotation 0 is the image's bottom row.
+void static consoleScroll(void){
+  uint32_t area = (16 - ConsoleHead - ConsoleFoot)*10;
+  uint32_t start;
+  if(Rotation == 0){
+    start = ST7735_TFTHEIGHT + RowStart - 1 -
+            (ConsoleHead*10 + (ConsoleTop + area - 1)%area);
+  } else{
+    start = RowStart + ConsoleHead*10 + ConsoleTop;
+  }
+  writecommand(ST7735_VSCSAD);
+  writedata(start >> 8);
+  writedata(start);
+}
+
+
+// Move the cursor to the start of the next row, scrolling if it
+// is on the last row of the area, and clear the row.
+void static consoleNewline(void){
+  StX = 0;
+  if(StY < (15 - ConsoleFoot)){
+    StY++;
+  } else{
+    ConsoleTop = (ConsoleTop + 10)%((16 - ConsoleHead - ConsoleFoot)*10);
+    consoleScroll();
+  }
+  ST7735_FillRect(0, textY(StY), _width, 10, ST7735_BLACK);
+}
+
+
+//------------ST7735_ConsoleInit------------
+// Make the text rows between a fixed header and footer scroll.
+// In console mode a newline on the last row of the scrolling
+// area moves it up a row with one command and clears only the
+// row that appears, rather than going back to the top.  Rows are
+// still given in screen positions to ST7735_SetCursor() and
+// ST7735_DrawString(), and the header and footer are drawn with
+// ST7735_DrawString() as usual.  Other drawing functions take
+// screen RAM coordinates and are only in step with the
+// scrolling area until the first scroll.
+// Clears the scrolling area and moves the cursor to its top.
+// Requires 17 bytes of transmission plus the clear
+// Input: head number of fixed text rows at the top
+//        foot number of fixed text rows at the bottom
+// Output: 1 if console mode is on; 0 if head+foot is over 15 or
+//         the rotation is landscape
+int ST7735_ConsoleInit(uint32_t head, uint32_t foot){
+  if(((head + foot) > 15) || (Rotation&1)){
+    return 0;
+  }
+  ConsoleOn = 1;
+  ScopeOn = 0;
+  ConsoleHead = head;
+  ConsoleFoot = foot;
+  ConsoleTop = 0;
+  consoleDefine();
+  consoleScroll();
+  ST7735_FillRect(0, head*10, _width, (16 - head - foot)*10, ST7735_BLACK);
+  StX = 0;
+  StY = head;
+  return 1;
+}
+
+
+//------------ST7735_ConsoleOff------------
+// Leave console or scope mode.  The controller shows screen RAM
+// as it is, so the scrolling area appears rotated until it is
+// redrawn.
+// Requires 1 byte of transmission
+// Input: none
+// Output: none
+void ST7735_ConsoleOff(void){
+  if((ConsoleOn == 0) && (ScopeOn == 0)){
+    return;
+  }
+  ConsoleOn = 0;
+  ScopeOn = 0;
+  ConsoleTop = 0;
+  writecommand(ST7735_NORON);           // ends scrolling mode
+}
+
+
+// Scope mode draws a strip chart of two channels in the console's
+// scrolling area.  Each sample scrolls the area up one pixel row
+// and draws the row that appears at the bottom with one address
+// window, as a few runs of color.  Each channel is a horizontal
+// span from its column in the last row to its new one, so fast
+// changes still show as a joined trace.
+static int32_t ScopeMin, ScopeRange;
+static int32_t ScopeLast[2];              // column of each channel in the last row
+static uint32_t ScopeRows;                // rows drawn, for the graticule
+static const uint16_t ScopeColor[2] = {ST7735_GREEN, ST7735_RED};
+
+// Return the column of a value, ScopeMin at the left edge.
+int32_t static scopeColumn(int32_t v){
+  if(v < ScopeMin) v = ScopeMin;
+  if(v > (ScopeMin + ScopeRange)) v = ScopeMin + ScopeRange;
+  return ((v - ScopeMin)*(_width - 1))/ScopeRange;
+}
+
+
+//------------ST7735_ScopeInit------------
+// Turn the rows between a fixed header and footer into a strip
+// chart scrolled by the controller, like ST7735_ConsoleInit().
+// Text is not scrolled in scope mode; the header and footer are
+// drawn with ST7735_DrawString() as usual.  ST7735_ConsoleOff()
+// ends scope mode.
+// Clears the chart area.
+// Requires 17 bytes of transmission plus the clear
+// Input: head number of fixed text rows at the top
+//        foot number of fixed text rows at the bottom
+//        min  value shown at the left edge
+//        max  value shown at the right edge; max-min must be
+//             under 2^24
+// Output: 1 if scope mode is on; 0 if head+foot is over 15,
+//         max is not over min or the rotation is landscape
+int ST7735_ScopeInit(uint32_t head, uint32_t foot, int32_t min, int32_t max){
+  if((max <= min) || (ST7735_ConsoleInit(head, foot) == 0)){
+    return 0;
+  }
+  ConsoleOn = 0;
+  ScopeOn = 1;
+  ScopeMin = min;
+  ScopeRange = max - min;
+  ScopeLast[0] = -1;
+  ScopeLast[1] = -1;
+  ScopeRows = 0;
+  return 1;
+}
+
+
+//------------ST7735_ScopeSample------------
+// Scroll the chart up one row and plot a sample of each channel
+// in the new bottom row: a in green and b in red, over dotted
+// graticule lines at the quarters.
+// Requires (14 + 2*_width) bytes of transmission
+// Input: a first channel's value
+//        b second channel's value
+// Output: none
+void ST7735_ScopeSample(int32_t a, int32_t b){
+  uint32_t area = (16 - ConsoleHead - ConsoleFoot)*10;
+  int32_t x[2], lo[2], hi[2], col, run, i, y;
+  uint16_t color, c;
+  if(ScopeOn == 0){
+    return;
+  }
+  x[0] = scopeColumn(a);
+  x[1] = scopeColumn(b);
+  for(i=0; i<2; i++){
+    lo[i] = x[i];
+    hi[i] = x[i];
+    if(ScopeLast[i] >= 0){              // join to the last row's column
+      if(ScopeLast[i] < lo[i]) lo[i] = ScopeLast[i];
+      if(ScopeLast[i] > hi[i]) hi[i] = ScopeLast[i];
+    }
+    ScopeLast[i] = x[i];
+  }
+  ConsoleTop = (ConsoleTop + 1)%area;
+  consoleScroll();
+  y = ConsoleHead*10 + (ConsoleTop + area - 1)%area;
+  setAddrWindow(0, y, _width-1, y);
+  color = ST7735_BLACK;
+  run = 0;
+  for(col=0; col<_width; col++){
+    if((col >= lo[1]) && (col <= hi[1])){
+      c = ScopeColor[1];
+    } else if((col >= lo[0]) && (col <= hi[0])){
+      c = ScopeColor[0];
+    } else if(((ScopeRows&3) == 0) && ((col == _width/4) ||
+              (col == _width/2) || (col == (3*_width)/4))){
+      c = ST7735_Color565(64,64,64);
+    } else{
+      c = ST7735_BLACK;
+    }
+    if((c != color) && run){
+      writefill(color, run);
+      run = 0;
+    }
+    color = c;
+    run++;
+  }
+  writefill(color, run);
+  ScopeRows++;
+}
+
+
 // *************** ST7735_OutChar ********************
 // Output one character to the LCD
 // Position determined by ST7735_SetCursor command
@@ -1527,6 +2438,10 @@ void ST7735_PlotNextErase(void){
 // Outputs: none
 void ST7735_OutChar(char ch){
   if((ch == 10) || (ch == 13) || (ch == 27)){
+    if(ConsoleOn){
+      consoleNewline();
+      return;
+    }
     StY++; StX=0;
     if(StY>15){
       StY = 0;
@@ -1534,11 +2449,11 @@ void ST7735_OutChar(char ch){
     ST7735_DrawString(0,StY,"                     ",StTextColor);
     return;
   }
-  ST7735_DrawCharS(StX*6,StY*10,ch,ST7735_YELLOW,ST7735_BLACK, 1);
+  ST7735_DrawCharS(StX*6,textY(StY),ch,ST7735_YELLOW,ST7735_BLACK, 1);
   StX++;
   if(StX>20){
     StX = 20;
-    ST7735_DrawCharS(StX*6,StY*10,'*',ST7735_RED,ST7735_BLACK, 1);
+    ST7735_DrawCharS(StX*6,textY(StY),'*',ST7735_RED,ST7735_BLACK, 1);
   }
   return;
 }
@@ -1550,9 +2465,25 @@ void ST7735_OutChar(char ch){
 // inputs: ptr  pointer to NULL-terminated ASCII string
 // outputs: none
 void ST7735_OutString(char *ptr){
+  uint32_t n;
   while(*ptr){
-    ST7735_OutChar(*ptr);
-    ptr = ptr + 1;
+    n = 0;                              // find the run of printable characters
+    while(ptr[n] && (ptr[n] != 10) && (ptr[n] != 13) && (ptr[n] != 27)){
+      n++;
+    }
+    if(n == 0){
+      ST7735_OutChar(*ptr);             // newline
+      ptr = ptr + 1;
+      continue;
+    }
+    gridText(StX, textY(StY)/10, ptr, n, ST7735_YELLOW);
+    if((StX+n)>20){                     // same as OutChar one at a time
+      StX = 20;
+      ST7735_DrawCharS(StX*6,textY(StY),'*',ST7735_RED,ST7735_BLACK, 1);
+    } else{
+      StX = StX+n;
+    }
+    ptr = ptr + n;
   }
 }
 // ************** ST7735_SetTextColor ************************
@@ -1597,11 +2528,11 @@ void Output_Clear(void){ // Clears the display
 }
 // Turn off display (low power)
 void Output_Off(void){   // Turns off the display
-  Output_Clear();  // not implemented
+  ST7735_Sleep(1);
 }
 // Turn on display
 void Output_On(void){ // Turns on the display
-  Output_Init();      // reinitialize
+  ST7735_Sleep(0);
 }
 // set the color for future output
 // Background color is fixed at black
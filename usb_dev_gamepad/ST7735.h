@@ -101,6 +101,9 @@ enum initRFlags{
 #define ST7735_TFTWIDTH  128
 #define ST7735_TFTHEIGHT 160
 
+// fastest SPI write clock the controller accepts (66 ns serial write cycle)
+#define ST7735_SCLK_MAX  15000000
+
 
 // Color definitions
 #define ST7735_BLACK   0x0000
@@ -126,6 +129,30 @@ void ST7735_InitB(void);
 void ST7735_InitR(enum initRFlags option);
 
 
+//------------ST7735_InitRStart------------
+// Start initializing an ST7735R screen without waiting for it.
+// Sets up SSI0 and the control pins and begins the reset pulse;
+// ST7735_InitProcess() then does the rest of ST7735_InitR() as
+// its delays run out.  Nothing else may be drawn until
+// ST7735_InitProcess() has returned 1.
+// Input: option one of the enumerated options depending on tabs
+//        ms     the time in ms, on the clock later passed to
+//               ST7735_InitProcess()
+// Output: none
+void ST7735_InitRStart(enum initRFlags option, uint32_t ms);
+
+
+//------------ST7735_InitProcess------------
+// Carry on with the initialization started by
+// ST7735_InitRStart(): end the reset pulse, or send the commands
+// up to the next delay, once the wait before them is over.
+// Returns at once otherwise, so call it from a loop.
+// Input: ms the time in ms on any free-running millisecond clock
+// Output: 1 once the screen is ready, and on every call after;
+//         0 until then
+int ST7735_InitProcess(uint32_t ms);
+
+
 //------------ST7735_DrawPixel------------
 // Color the pixel at the given coordinates with the given color.
 // Requires 13 bytes of transmission
@@ -183,6 +210,51 @@ void ST7735_FillScreen(uint16_t color);
 void ST7735_FillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
 
 
+//------------ST7735_TransferStats------------
+// Report the SPI traffic since startup.
+// Input: sent  where to store the number of bytes queued for the
+//              panel, counting each pixel as 2
+//        saved where to store the number of bytes of address
+//              window setup left out because the panel already
+//              had the same columns or rows
+// Output: none
+void ST7735_TransferStats(uint32_t *sent, uint32_t *saved);
+
+
+//------------ST7735_SetWindow------------
+// Select a rectangle of screen RAM to be written by following calls to
+// ST7735_PushColor().  Pixels fill the window left to right, top to
+// bottom, and wrap back to the top left corner when it is full.
+// Requires 11 bytes of transmission
+// Input: x     horizontal position of the top left corner of the window, columns from the left edge
+//        y     vertical position of the top left corner of the window, rows from the top edge
+//        w     horizontal width of the window
+//        h     vertical height of the window
+// Output: none
+// The window must lie entirely on the screen; there is no clipping.
+void ST7735_SetWindow(int16_t x, int16_t y, int16_t w, int16_t h);
+
+
+//------------ST7735_PushColor------------
+// Write count pixels of one color into the window selected by
+// ST7735_SetWindow(), continuing from where the last write stopped.
+// Requires 2*count bytes of transmission
+// Input: color 16-bit color, which can be produced by ST7735_Color565()
+//        count number of pixels
+// Output: none
+void ST7735_PushColor(uint16_t color, uint32_t count);
+
+
+//------------ST7735_PushPixels------------
+// Write count pixels, each its own color, into the window selected by
+// ST7735_SetWindow(), continuing from where the last write stopped.
+// Requires 2*count bytes of transmission
+// Input: pixels pointer to the 16-bit colors
+//        count  number of pixels
+// Output: none
+void ST7735_PushPixels(const uint16_t *pixels, uint32_t count);
+
+
 //------------ST7735_Color565------------
 // Pass 8-bit (each) R,G,B and get back 16-bit packed color.
 // Input: r red value
@@ -300,6 +372,57 @@ void ST7735_SetRotation(uint8_t m) ;
 // Output: none
 void ST7735_InvertDisplay(int i) ;
 
+
+//------------ST7735_Sleep------------
+// Blank the panel and put its controller to sleep, or wake it back up.
+// The contents of screen RAM are kept while asleep.
+// Requires 2 bytes of transmission
+// Input: i non-zero to sleep; 0 to wake
+// Output: none
+// Going to sleep only waits for the 2 bytes to be sent.  Waking up
+// blocks for 240 ms: 120 ms after SLPIN, the time the controller
+// needs before it accepts SLPOUT, in case the sleep was short, and
+// 120 ms after SLPOUT before DISPON.  Does nothing before the
+// screen has been initialized.
+void ST7735_Sleep(int i);
+
+
+//------------ST7735_Flush------------
+// Wait until everything queued has been sent to the panel.
+// The drawing functions queue their bytes for uDMA and return
+// before they are sent; call this before anything that depends
+// on the panel having received them, such as a timed delay or
+// turning SSI0 off.
+// Input: none
+// Output: none
+void ST7735_Flush(void);
+
+
+//------------ST7735_SSI0Handler------------
+// SSI0 interrupt handler, which sends the queued bytes.
+// Input: none
+// Output: none
+void ST7735_SSI0Handler(void);
+
+
+//------------ST7735_SetSPIClock------------
+// Set the fastest SPI clock not above a limit, given the system clock.
+// ST7735_InitB(), ST7735_InitR() and ST7735_InitRStart() assume the
+// 80 MHz of PLL_Init().  Call this again whenever the system clock changes.
+// Input: busClk system clock in Hz
+//        sclk   highest SPI clock wanted in Hz, normally ST7735_SCLK_MAX
+// Output: the SPI clock set, in Hz
+uint32_t ST7735_SetSPIClock(uint32_t busClk, uint32_t sclk);
+
+
+//------------ST7735_SetPixelFrames------------
+// Choose how pixel data is framed on SSI0.
+// Input: bits 16 (the default) to send each pixel as one 16-bit frame;
+//             8 to send it as two 8-bit frames, as the driver used to
+// Output: none
+// Only meant for comparing the two; 16-bit frames are never slower.
+void ST7735_SetPixelFrames(int bits);
+
 // graphics routines
 // y coordinates 0 to 31 used for labels and messages
 // y coordinates 32 to 159  128 pixels high
@@ -360,7 +483,9 @@ void ST7735_PlotNext(void);
 // *************** ST7735_PlotNextErase ********************
 // Used in all the plots to step the X coordinate one pixel
 // X steps from 0 to 127, then back to 0 again
-// It clears the vertical space into which the next pixel will be drawn
+// It clears the vertical space into which the next pixel will be drawn,
+// which after ST7735_PlotClear() is only the span the plot functions
+// drew in that column
 // Inputs: none
 // Outputs: none
 void ST7735_PlotNextErase(void);
@@ -408,6 +533,62 @@ void ST7735_PlotNextErase(void);
 //        ST7735_PlotNext();
 //    }   // called 128 times
 
+//------------ST7735_ConsoleInit------------
+// Make the text rows between a fixed header and footer scroll.
+// In console mode a newline on the last row of the scrolling
+// area moves it up a row with one command and clears only the
+// row that appears, rather than going back to the top.  Rows are
+// still given in screen positions to ST7735_SetCursor() and
+// ST7735_DrawString(), and the header and footer are drawn with
+// ST7735_DrawString() as usual.  Other drawing functions take
+// screen RAM coordinates and are only in step with the
+// scrolling area until the first scroll.
+// Clears the scrolling area and moves the cursor to its top.
+// Requires 17 bytes of transmission plus the clear
+// Input: head number of fixed text rows at the top
+//        foot number of fixed text rows at the bottom
+// Output: 1 if console mode is on; 0 if head+foot is over 15 or
+//         the rotation is landscape
+int ST7735_ConsoleInit(uint32_t head, uint32_t foot);
+
+//------------ST7735_ConsoleOff------------
+// Leave console or scope mode.  The controller shows screen RAM
+// as it is, so the scrolling area appears rotated until it is
+// redrawn.
+// Requires 1 byte of transmission
+// Input: none
+// Output: none
+void ST7735_ConsoleOff(void);
+
+
+//------------ST7735_ScopeInit------------
+// Turn the rows between a fixed header and footer into a strip
+// chart scrolled by the controller, like ST7735_ConsoleInit().
+// Text is not scrolled in scope mode; the header and footer are
+// drawn with ST7735_DrawString() as usual.  ST7735_ConsoleOff()
+// ends scope mode.
+// Clears the chart area.
+// Requires 17 bytes of transmission plus the clear
+// Input: head number of fixed text rows at the top
+//        foot number of fixed text rows at the bottom
+//        min  value shown at the left edge
+//        max  value shown at the right edge; max-min must be
+//             under 2^24
+// Output: 1 if scope mode is on; 0 if head+foot is over 15,
+//         max is not over min or the rotation is landscape
+int ST7735_ScopeInit(uint32_t head, uint32_t foot, int32_t min, int32_t max);
+
+
+//------------ST7735_ScopeSample------------
+// Scroll the chart up one row and plot a sample of each channel
+// in the new bottom row: a in green and b in red, over dotted
+// graticule lines at the quarters.
+// Requires (14 + 2*_width) bytes of transmission
+// Input: a first channel's value
+//        b second channel's value
+// Output: none
+void ST7735_ScopeSample(int32_t a, int32_t b);
+
 // *************** ST7735_OutChar ********************
 // Output one character to the LCD
 // Position determined by ST7735_SetCursor command
@@ -0,0 +1,138 @@
+//*****************************************************************************
+//
+// button_map.c - Per-player tables mapping GPIO pins to report buttons.
+//
+// Player one is the original stick.  Player two uses the pins left over once
+// the LCD, UART, USB, ADC and LED have theirs.  On the EK-TM4C123GXL, PD0
+// and PD1 are tied to PB6 and PB7 through R9 and R10, which must be removed
+// before player two's first two buttons can be used.  This file is shared
+// with the host tools and must stay free of target-specific code.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "button_map.h"
+
+//*****************************************************************************
+//
+// The pin tables.
+//
+//*****************************************************************************
+const tButtonMap g_psButtonMaps[BUTTON_MAP_PLAYERS] =
+{
+    //
+    // Player one.
+    //
+    {
+        15,
+        {
+            { BUTTON_PORT_B, 0x01, 0 },                     // Button 1
+            { BUTTON_PORT_B, 0x02, 0 },                     // Button 2
+            { BUTTON_PORT_B, 0x04, 0 },                     // Button 3
+            { BUTTON_PORT_B, 0x08, 0 },                     // Button 4
+            { BUTTON_PORT_B, 0x10, 0 },                     // Button 5
+            { BUTTON_PORT_B, 0x20, 0 },                     // Button 6
+            { BUTTON_PORT_B, 0x40, 0 },                     // Button 7
+            { BUTTON_PORT_B, 0x80, 0 },                     // Button 8
+            { BUTTON_PORT_C, 0x10, 0 },                     // Button 9
+            { BUTTON_PORT_C, 0x20, 0 },                     // Button 10
+            { BUTTON_PORT_C, 0x40, 0 },                     // Button 11
+            { BUTTON_PORT_C, 0x80, 0 },                     // Button 12
+            { BUTTON_PORT_F, 0x01, BUTTON_PIN_ACTIVE_LOW }, // Button 13, SW2
+            { BUTTON_PORT_F, 0x10, BUTTON_PIN_ACTIVE_LOW }, // Button 14, SW1
+            { BUTTON_PORT_A, 0x10, 0 },                     // Button 15
+        }
+    },
+
+    //
+    // Player two.  PD4 and PD5 are the USB pins, PE1 to PE3 the ADC inputs.
+    //
+    {
+        9,
+        {
+            { BUTTON_PORT_D, 0x01, 0 },                     // Button 1
+            { BUTTON_PORT_D, 0x02, 0 },                     // Button 2
+            { BUTTON_PORT_D, 0x04, 0 },                     // Button 3
+            { BUTTON_PORT_D, 0x08, 0 },                     // Button 4
+            { BUTTON_PORT_D, 0x40, 0 },                     // Button 5
+            { BUTTON_PORT_D, 0x80, 0 },                     // Button 6
+            { BUTTON_PORT_E, 0x01, 0 },                     // Button 7
+            { BUTTON_PORT_E, 0x10, 0 },                     // Button 8
+            { BUTTON_PORT_E, 0x20, 0 },                     // Button 9
+        }
+    }
+};
+
+//*****************************************************************************
+//
+// Maps a snapshot of the GPIO ports to a player's report buttons.
+//
+// \param psMap is the player's pin table.
+// \param pui8Ports holds the value read from each port, indexed by
+// BUTTON_PORT_x.  Only the pins named in the tables need be valid.
+//
+// \return Returns the Buttons field, with a 1 for each pressed button.
+//
+//*****************************************************************************
+uint16_t
+ButtonMapApply(const tButtonMap *psMap, const uint8_t *pui8Ports)
+{
+    const tButtonPin *psPin;
+    uint32_t ui32Idx;
+    uint16_t ui16Buttons;
+    uint8_t ui8Level;
+
+    ui16Buttons = 0;
+
+    for(ui32Idx = 0; ui32Idx < psMap->ui32NumButtons; ui32Idx++)
+    {
+        psPin = &psMap->psPins[ui32Idx];
+        ui8Level = pui8Ports[psPin->ui8Port];
+
+        if(psPin->ui8Flags & BUTTON_PIN_ACTIVE_LOW)
+        {
+            ui8Level = ~ui8Level;
+        }
+
+        if(ui8Level & psPin->ui8Pin)
+        {
+            ui16Buttons |= 1 << ui32Idx;
+        }
+    }
+
+    return(ui16Buttons);
+}
+
+//*****************************************************************************
+//
+// Collects the pins a player uses on each port.
+//
+// \param psMap is the player's pin table.
+// \param pui8Pins has the pins used on each port ORed in, indexed by
+// BUTTON_PORT_x.
+// \param pui8ActiveLow has the active low pins on each port ORed in.
+//
+// The caller clears both arrays, so several players can be collected into
+// them.
+//
+//*****************************************************************************
+void
+ButtonMapPins(const tButtonMap *psMap, uint8_t *pui8Pins,
+              uint8_t *pui8ActiveLow)
+{
+    const tButtonPin *psPin;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < psMap->ui32NumButtons; ui32Idx++)
+    {
+        psPin = &psMap->psPins[ui32Idx];
+
+        pui8Pins[psPin->ui8Port] |= psPin->ui8Pin;
+
+        if(psPin->ui8Flags & BUTTON_PIN_ACTIVE_LOW)
+        {
+            pui8ActiveLow[psPin->ui8Port] |= psPin->ui8Pin;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+//*****************************************************************************
+//
+// button_map.h - Per-player tables mapping GPIO pins to report buttons.
+//
+// Each player has a table giving the port, pin and polarity of every button,
+// in the order of the report's Buttons field.  The buttons driver reads each
+// port the tables use once per pass and hands the port values to
+// ButtonMapApply() for every player.  This header and button_map.c are shared
+// with the host tools, which run the tables against simulated port values,
+// and so must not depend on any TivaWare header.
+//
+//*****************************************************************************
+
+#ifndef _BUTTON_MAP_H_
+#define _BUTTON_MAP_H_
+
+//*****************************************************************************
+//
+// The GPIO ports, as indexes into the array of port values.
+//
+//*****************************************************************************
+#define BUTTON_PORT_A           0
+#define BUTTON_PORT_B           1
+#define BUTTON_PORT_C           2
+#define BUTTON_PORT_D           3
+#define BUTTON_PORT_E           4
+#define BUTTON_PORT_F           5
+#define BUTTON_PORTS            6
+
+//*****************************************************************************
+//
+// The number of player tables and the most buttons a table may hold.
+//
+//*****************************************************************************
+#define BUTTON_MAP_PLAYERS      2
+#define BUTTON_MAP_BUTTONS      16
+
+//*****************************************************************************
+//
+// Pin flags.  An active low pin reads 0 when pressed and is given a pull-up.
+// Any other pin reads 1 when pressed and is given a pull-down.
+//
+//*****************************************************************************
+#define BUTTON_PIN_ACTIVE_LOW   0x01
+
+//*****************************************************************************
+//
+// One button: its port (BUTTON_PORT_x), its pin as a mask and its flags.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Port;
+    uint8_t ui8Pin;
+    uint8_t ui8Flags;
+}
+tButtonPin;
+
+//*****************************************************************************
+//
+// A player's buttons.  Entry n drives bit n of the report's Buttons field.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32NumButtons;
+    tButtonPin psPins[BUTTON_MAP_BUTTONS];
+}
+tButtonMap;
+
+extern const tButtonMap g_psButtonMaps[BUTTON_MAP_PLAYERS];
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern uint16_t ButtonMapApply(const tButtonMap *psMap,
+                               const uint8_t *pui8Ports);
+extern void ButtonMapPins(const tButtonMap *psMap, uint8_t *pui8Pins,
+                          uint8_t *pui8ActiveLow);
+
+#endif
@@ -0,0 +1,158 @@
+//*****************************************************************************
+//
+// lcd_asset.c - Compressed images stored in flash and drawn on the ST7735.
+//
+// An asset is decoded straight from flash with the same decoder as the
+// images pushed over USB, so no frame buffer is needed.  Runs of one color
+// go to the panel as fills.  Short runs and single pixels, which would each
+// cost a fill of their own, are gathered in a small line buffer and sent
+// together, so images with little repetition still move over SPI as a few
+// long transfers.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lcd_stream.h"
+#include "lcd_asset.h"
+#include "ST7735.h"
+
+//*****************************************************************************
+//
+// The size of the line buffer in pixels, and the shortest run sent as a
+// fill rather than through the line buffer.
+//
+//*****************************************************************************
+#define LCD_ASSET_LINE          128
+#define LCD_ASSET_RUN_MIN       8
+
+//*****************************************************************************
+//
+// The stream decoder.  Assets are only drawn from the main loop.
+//
+//*****************************************************************************
+static tLCDStreamDecoder g_sLCDAssetDecoder;
+
+//*****************************************************************************
+//
+// The pixels waiting to be sent.
+//
+//*****************************************************************************
+static uint16_t g_pui16LCDAssetLine[LCD_ASSET_LINE];
+static uint32_t g_ui32LCDAssetLineLen;
+
+//*****************************************************************************
+//
+// Where the asset being drawn goes on the screen, whether the current
+// rectangle fits there, and the number of rectangles that did not.
+//
+//*****************************************************************************
+static int32_t g_i32LCDAssetX;
+static int32_t g_i32LCDAssetY;
+static bool g_bLCDAssetDraw;
+static uint32_t g_ui32LCDAssetClipped;
+
+//*****************************************************************************
+//
+// Sends the pixels in the line buffer.
+//
+//*****************************************************************************
+static void
+LCDAssetLineFlush(void)
+{
+    if(g_ui32LCDAssetLineLen)
+    {
+        ST7735_PushPixels(g_pui16LCDAssetLine, g_ui32LCDAssetLineLen);
+        g_ui32LCDAssetLineLen = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Starts a new rectangle.  Rectangles that would not lie entirely on the
+// screen at the asset's position are skipped.
+//
+//*****************************************************************************
+static void
+LCDAssetWindow(void *pvCBData, uint32_t ui32X, uint32_t ui32Y,
+               uint32_t ui32Width, uint32_t ui32Height)
+{
+    int32_t i32X, i32Y;
+
+    LCDAssetLineFlush();
+
+    i32X = g_i32LCDAssetX + (int32_t)ui32X;
+    i32Y = g_i32LCDAssetY + (int32_t)ui32Y;
+    g_bLCDAssetDraw = ((i32X >= 0) && (i32Y >= 0) &&
+                       ((i32X + ui32Width) <= ST7735_TFTWIDTH) &&
+                       ((i32Y + ui32Height) <= ST7735_TFTHEIGHT));
+
+    if(g_bLCDAssetDraw)
+    {
+        ST7735_SetWindow(i32X, i32Y, ui32Width, ui32Height);
+    }
+    else
+    {
+        g_ui32LCDAssetClipped++;
+    }
+}
+
+//*****************************************************************************
+//
+// Draws the next run of pixels of the current rectangle.
+//
+//*****************************************************************************
+static void
+LCDAssetPixels(void *pvCBData, uint16_t ui16Color, uint32_t ui32Count)
+{
+    if(!g_bLCDAssetDraw)
+    {
+        return;
+    }
+
+    if(ui32Count >= LCD_ASSET_RUN_MIN)
+    {
+        LCDAssetLineFlush();
+        ST7735_PushColor(ui16Color, ui32Count);
+        return;
+    }
+
+    while(ui32Count--)
+    {
+        g_pui16LCDAssetLine[g_ui32LCDAssetLineLen++] = ui16Color;
+        if(g_ui32LCDAssetLineLen == LCD_ASSET_LINE)
+        {
+            LCDAssetLineFlush();
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Draws an asset with its top left corner at (i32X, i32Y).  This leaves the
+// console's scrolling, as the asset is placed in screen RAM.  The pixels are
+// queued for the panel and may still be being sent when this returns.
+//
+// \return Returns 0 if the whole asset was drawn, or the number of errors
+// found in its stream plus the number of its rectangles that were off the
+// screen and so skipped.
+//
+//*****************************************************************************
+uint32_t
+LCDAssetDraw(const tLCDAsset *psAsset, int32_t i32X, int32_t i32Y)
+{
+    ST7735_ConsoleOff();
+
+    g_i32LCDAssetX = i32X;
+    g_i32LCDAssetY = i32Y;
+    g_bLCDAssetDraw = false;
+    g_ui32LCDAssetClipped = 0;
+    g_ui32LCDAssetLineLen = 0;
+
+    LCDStreamInit(&g_sLCDAssetDecoder, LCDAssetWindow, LCDAssetPixels, 0);
+    LCDStreamDecode(&g_sLCDAssetDecoder, psAsset->pui8Data,
+                    psAsset->ui32Size);
+    LCDAssetLineFlush();
+
+    return(g_sLCDAssetDecoder.ui32Errors + g_ui32LCDAssetClipped);
+}
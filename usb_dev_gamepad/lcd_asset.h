@@ -0,0 +1,47 @@
+//*****************************************************************************
+//
+// lcd_asset.h - Compressed images stored in flash and drawn on the ST7735.
+//
+// This is a library for applications built on the firmware.  The stick
+// itself ships no images and does not call LCDAssetDraw().
+//
+//*****************************************************************************
+
+#ifndef _LCD_ASSET_H_
+#define _LCD_ASSET_H_
+
+//*****************************************************************************
+//
+// An image, or one frame of an animation, as a stream in the format of
+// lcd_stream.h with its rectangles placed relative to the image's top left
+// corner.  tools/lcd_asset converts BMP and PPM files into C source holding
+// an array of these.  In an animation each frame after the first may hold
+// only the rectangles that changed since the frame before it, and must then
+// be drawn at the same place.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The size of the image in pixels.
+    //
+    uint16_t ui16Width;
+    uint16_t ui16Height;
+
+    //
+    // The encoded stream and its length in bytes.
+    //
+    uint32_t ui32Size;
+    const uint8_t *pui8Data;
+}
+tLCDAsset;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern uint32_t LCDAssetDraw(const tLCDAsset *psAsset, int32_t i32X,
+                             int32_t i32Y);
+
+#endif
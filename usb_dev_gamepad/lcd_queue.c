@@ -0,0 +1,515 @@
+//*****************************************************************************
+//
+// lcd_queue.c - Time-sliced drawing queue for the ST7735.
+//
+// Drawing calls add a command to the queue and return at once.
+// LCDQueueProcess(), called from the main loop, draws from the queue a
+// slice at a time and stops once the current tick's budget of SPI bytes is
+// spent, leaving the rest for the next tick.  A tick is LCD_QUEUE_TICK_US;
+// the budget does not carry over, so however much is queued the display
+// never takes more than its share of the bus or of the main loop.  Fills,
+// bitmaps and regions are sliced by rows.  Text is drawn a command at a
+// time.  Each tick draws at least one slice, so the queue always moves.
+//
+// A command that is wholly covered by a later one is dropped when the later
+// one is queued, since everything it would draw is drawn over.  Text only
+// supersedes text, as text positions follow the console's scrolling and
+// pixel positions do not.
+//
+// The queue and the ST7735 driver are only used from the main loop.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "timestamp.h"
+#include "lcd_queue.h"
+#include "ST7735.h"
+
+//*****************************************************************************
+//
+// The command types.
+//
+//*****************************************************************************
+#define LCD_QUEUE_FILL          0
+#define LCD_QUEUE_TEXT          1
+#define LCD_QUEUE_BITMAP        2
+#define LCD_QUEUE_REGION        3
+
+//*****************************************************************************
+//
+// The SPI bytes to set an address window, and to send a character.
+//
+//*****************************************************************************
+#define LCD_QUEUE_WINDOW_BYTES  11
+#define LCD_QUEUE_CHAR_BYTES    (6 * 8 * 2)
+
+//*****************************************************************************
+//
+// A queued command.  For text, the position is in text columns and rows,
+// and the width is the number of characters.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Type;
+    int16_t i16X;
+    int16_t i16Y;
+    int16_t i16Width;
+    int16_t i16Height;
+
+    //
+    // The rows drawn so far.
+    //
+    int16_t i16Done;
+
+    uint16_t ui16Color;
+    const uint16_t *pui16Pixels;
+    tLCDQueueRowFn pfnRow;
+    void *pvCBData;
+    char pcText[22];
+}
+tLCDQueueCmd;
+
+//*****************************************************************************
+//
+// The queue, oldest first.
+//
+//*****************************************************************************
+static tLCDQueueCmd g_psLCDQueue[LCD_QUEUE_DEPTH];
+static uint32_t g_ui32LCDQueueCount;
+
+//*****************************************************************************
+//
+// The budget per tick, what is left of it, and when the tick began.
+//
+//*****************************************************************************
+static uint32_t g_ui32LCDQueueBudget = LCD_QUEUE_TICK_BYTES;
+static uint32_t g_ui32LCDQueueCredit;
+static uint32_t g_ui32LCDQueueTick;
+
+static uint32_t g_ui32LCDQueueMaxBacklog;
+static uint32_t g_ui32LCDQueueCoalesced;
+static uint32_t g_ui32LCDQueueRefused;
+
+//*****************************************************************************
+//
+// Returns the SPI bytes needed for one row of a command.
+//
+//*****************************************************************************
+static uint32_t
+LCDQueueRowBytes(const tLCDQueueCmd *psCmd)
+{
+    if(psCmd->ui8Type == LCD_QUEUE_TEXT)
+    {
+        return(LCD_QUEUE_WINDOW_BYTES +
+               (psCmd->i16Width * LCD_QUEUE_CHAR_BYTES));
+    }
+    return(psCmd->i16Width * 2);
+}
+
+//*****************************************************************************
+//
+// Returns the SPI bytes a command still needs.
+//
+//*****************************************************************************
+static uint32_t
+LCDQueueCmdBytes(const tLCDQueueCmd *psCmd)
+{
+    if(psCmd->ui8Type == LCD_QUEUE_TEXT)
+    {
+        return(LCDQueueRowBytes(psCmd));
+    }
+    return(LCD_QUEUE_WINDOW_BYTES +
+           ((psCmd->i16Height - psCmd->i16Done) * LCDQueueRowBytes(psCmd)));
+}
+
+//*****************************************************************************
+//
+// Returns true if command psNew draws over all of command psOld.
+//
+//*****************************************************************************
+static bool
+LCDQueueCovers(const tLCDQueueCmd *psNew, const tLCDQueueCmd *psOld)
+{
+    if((psNew->ui8Type == LCD_QUEUE_TEXT) !=
+       (psOld->ui8Type == LCD_QUEUE_TEXT))
+    {
+        return(false);
+    }
+
+    return((psNew->i16X <= psOld->i16X) &&
+           (psNew->i16Y <= psOld->i16Y) &&
+           ((psNew->i16X + psNew->i16Width) >=
+            (psOld->i16X + psOld->i16Width)) &&
+           ((psNew->i16Y + psNew->i16Height) >=
+            (psOld->i16Y + psOld->i16Height)));
+}
+
+//*****************************************************************************
+//
+// Adds a command to the queue, first dropping any waiting command it
+// covers.  A command already part drawn is left alone.
+//
+//*****************************************************************************
+static bool
+LCDQueueAdd(const tLCDQueueCmd *psCmd)
+{
+    uint32_t ui32Idx, ui32Keep, ui32Backlog;
+
+    ui32Keep = 0;
+    for(ui32Idx = 0; ui32Idx < g_ui32LCDQueueCount; ui32Idx++)
+    {
+        if(g_psLCDQueue[ui32Idx].i16Done ||
+           !LCDQueueCovers(psCmd, &g_psLCDQueue[ui32Idx]))
+        {
+            g_psLCDQueue[ui32Keep++] = g_psLCDQueue[ui32Idx];
+        }
+        else
+        {
+            g_ui32LCDQueueCoalesced++;
+        }
+    }
+    g_ui32LCDQueueCount = ui32Keep;
+
+    if(g_ui32LCDQueueCount == LCD_QUEUE_DEPTH)
+    {
+        g_ui32LCDQueueRefused++;
+        return(false);
+    }
+
+    g_psLCDQueue[g_ui32LCDQueueCount] = *psCmd;
+    g_psLCDQueue[g_ui32LCDQueueCount].i16Done = 0;
+    g_ui32LCDQueueCount++;
+
+    ui32Backlog = 0;
+    for(ui32Idx = 0; ui32Idx < g_ui32LCDQueueCount; ui32Idx++)
+    {
+        ui32Backlog += LCDQueueCmdBytes(&g_psLCDQueue[ui32Idx]);
+    }
+    if(ui32Backlog > g_ui32LCDQueueMaxBacklog)
+    {
+        g_ui32LCDQueueMaxBacklog = ui32Backlog;
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns true if a rectangle lies on the portrait screen.
+//
+//*****************************************************************************
+static bool
+LCDQueueOnScreen(int16_t i16X, int16_t i16Y, int16_t i16Width,
+                 int16_t i16Height)
+{
+    return((i16X >= 0) && (i16Y >= 0) && (i16Width > 0) && (i16Height > 0) &&
+           ((i16X + i16Width) <= ST7735_TFTWIDTH) &&
+           ((i16Y + i16Height) <= ST7735_TFTHEIGHT));
+}
+
+//*****************************************************************************
+//
+// Resets the queue and the tick.
+//
+//*****************************************************************************
+void
+LCDQueueInit(void)
+{
+    g_ui32LCDQueueCount = 0;
+    g_ui32LCDQueueCredit = g_ui32LCDQueueBudget;
+    g_ui32LCDQueueTick = TimestampGet();
+}
+
+//*****************************************************************************
+//
+// Sets the number of SPI bytes the queue may send per tick.  At SPI clock
+// f, a budget of b bytes keeps the bus busy for 8 * b / f per tick.
+//
+//*****************************************************************************
+void
+LCDQueueBudgetSet(uint32_t ui32BytesPerTick)
+{
+    g_ui32LCDQueueBudget = ui32BytesPerTick;
+}
+
+//*****************************************************************************
+//
+// Queues a filled rectangle.
+//
+// \return Returns false if the rectangle is not wholly on the screen or the
+// queue is full.
+//
+//*****************************************************************************
+bool
+LCDQueueFill(int16_t i16X, int16_t i16Y, int16_t i16Width, int16_t i16Height,
+             uint16_t ui16Color)
+{
+    tLCDQueueCmd sCmd;
+
+    if(!LCDQueueOnScreen(i16X, i16Y, i16Width, i16Height))
+    {
+        return(false);
+    }
+
+    sCmd.ui8Type = LCD_QUEUE_FILL;
+    sCmd.i16X = i16X;
+    sCmd.i16Y = i16Y;
+    sCmd.i16Width = i16Width;
+    sCmd.i16Height = i16Height;
+    sCmd.ui16Color = ui16Color;
+
+    return(LCDQueueAdd(&sCmd));
+}
+
+//*****************************************************************************
+//
+// Queues text for ST7735_DrawString() at a text column (0 to 20) and row
+// (0 to 15).  The text is copied, up to the end of the row.
+//
+// \return Returns false if the position is off the screen or the queue is
+// full.
+//
+//*****************************************************************************
+bool
+LCDQueueText(uint32_t ui32Col, uint32_t ui32Row, const char *pcText,
+             uint16_t ui16Color)
+{
+    tLCDQueueCmd sCmd;
+    uint32_t ui32Len;
+
+    if((ui32Col > 20) || (ui32Row > 15))
+    {
+        return(false);
+    }
+
+    for(ui32Len = 0; pcText[ui32Len] && ((ui32Col + ui32Len) <= 20);
+        ui32Len++)
+    {
+        sCmd.pcText[ui32Len] = pcText[ui32Len];
+    }
+    sCmd.pcText[ui32Len] = 0;
+
+    sCmd.ui8Type = LCD_QUEUE_TEXT;
+    sCmd.i16X = ui32Col;
+    sCmd.i16Y = ui32Row;
+    sCmd.i16Width = ui32Len;
+    sCmd.i16Height = 1;
+    sCmd.ui16Color = ui16Color;
+
+    return(LCDQueueAdd(&sCmd));
+}
+
+//*****************************************************************************
+//
+// Queues a bitmap, its rows top to bottom and each row left to right.  The
+// pixels are not copied and must stay in place until drawn.
+//
+// \return Returns false if the bitmap is not wholly on the screen or the
+// queue is full.
+//
+//*****************************************************************************
+bool
+LCDQueueBitmap(int16_t i16X, int16_t i16Y, int16_t i16Width,
+               int16_t i16Height, const uint16_t *pui16Pixels)
+{
+    tLCDQueueCmd sCmd;
+
+    if(!LCDQueueOnScreen(i16X, i16Y, i16Width, i16Height))
+    {
+        return(false);
+    }
+
+    sCmd.ui8Type = LCD_QUEUE_BITMAP;
+    sCmd.i16X = i16X;
+    sCmd.i16Y = i16Y;
+    sCmd.i16Width = i16Width;
+    sCmd.i16Height = i16Height;
+    sCmd.pui16Pixels = pui16Pixels;
+
+    return(LCDQueueAdd(&sCmd));
+}
+
+//*****************************************************************************
+//
+// Queues a rectangle whose rows are produced by a callback as they are
+// drawn, so its contents can be computed when there is time to send them.
+//
+// \return Returns false if the rectangle is not wholly on the screen or the
+// queue is full.
+//
+//*****************************************************************************
+bool
+LCDQueueRegion(int16_t i16X, int16_t i16Y, int16_t i16Width,
+               int16_t i16Height, tLCDQueueRowFn pfnRow, void *pvCBData)
+{
+    tLCDQueueCmd sCmd;
+
+    if(!LCDQueueOnScreen(i16X, i16Y, i16Width, i16Height))
+    {
+        return(false);
+    }
+
+    sCmd.ui8Type = LCD_QUEUE_REGION;
+    sCmd.i16X = i16X;
+    sCmd.i16Y = i16Y;
+    sCmd.i16Width = i16Width;
+    sCmd.i16Height = i16Height;
+    sCmd.pfnRow = pfnRow;
+    sCmd.pvCBData = pvCBData;
+
+    return(LCDQueueAdd(&sCmd));
+}
+
+//*****************************************************************************
+//
+// Draws the next slice of the oldest command, of up to ui32Rows rows.
+//
+//*****************************************************************************
+static void
+LCDQueueSlice(tLCDQueueCmd *psCmd, uint32_t ui32Rows)
+{
+    static uint16_t pui16Row[ST7735_TFTWIDTH];
+    uint32_t ui32Row;
+
+    switch(psCmd->ui8Type)
+    {
+        case LCD_QUEUE_FILL:
+        {
+            ST7735_FillRect(psCmd->i16X, psCmd->i16Y + psCmd->i16Done,
+                            psCmd->i16Width, ui32Rows, psCmd->ui16Color);
+            break;
+        }
+
+        case LCD_QUEUE_TEXT:
+        {
+            ST7735_DrawString(psCmd->i16X, psCmd->i16Y, psCmd->pcText,
+                              psCmd->ui16Color);
+            break;
+        }
+
+        case LCD_QUEUE_BITMAP:
+        {
+            ST7735_SetWindow(psCmd->i16X, psCmd->i16Y + psCmd->i16Done,
+                             psCmd->i16Width, ui32Rows);
+            ST7735_PushPixels(psCmd->pui16Pixels +
+                              (psCmd->i16Done * psCmd->i16Width),
+                              ui32Rows * psCmd->i16Width);
+            break;
+        }
+
+        case LCD_QUEUE_REGION:
+        {
+            ST7735_SetWindow(psCmd->i16X, psCmd->i16Y + psCmd->i16Done,
+                             psCmd->i16Width, ui32Rows);
+            for(ui32Row = 0; ui32Row < ui32Rows; ui32Row++)
+            {
+                psCmd->pfnRow(psCmd->pvCBData, psCmd->i16Done + ui32Row,
+                              pui16Row, psCmd->i16Width);
+                ST7735_PushPixels(pui16Row, psCmd->i16Width);
+            }
+            break;
+        }
+    }
+
+    psCmd->i16Done += ui32Rows;
+}
+
+//*****************************************************************************
+//
+// Draws from the queue until it is empty or this tick's budget is spent.
+// This must be called regularly from the main loop, and may be called as
+// often as liked.
+//
+//*****************************************************************************
+void
+LCDQueueProcess(void)
+{
+    tLCDQueueCmd *psCmd;
+    uint32_t ui32Now, ui32Rows, ui32Bytes, ui32Idx;
+
+    ui32Now = TimestampGet();
+    if((ui32Now - g_ui32LCDQueueTick) >= TimestampFromUs(LCD_QUEUE_TICK_US))
+    {
+        g_ui32LCDQueueTick = ui32Now;
+        g_ui32LCDQueueCredit = g_ui32LCDQueueBudget;
+    }
+
+    while(g_ui32LCDQueueCount)
+    {
+        psCmd = &g_psLCDQueue[0];
+
+        //
+        // Work out how many rows fit in what is left of the budget.  A fresh
+        // tick always draws at least one, however large.
+        //
+        ui32Bytes = LCDQueueRowBytes(psCmd);
+        if(psCmd->ui8Type == LCD_QUEUE_TEXT)
+        {
+            ui32Rows = (g_ui32LCDQueueCredit >= ui32Bytes) ? 1 : 0;
+        }
+        else if(g_ui32LCDQueueCredit > LCD_QUEUE_WINDOW_BYTES)
+        {
+            ui32Rows = (g_ui32LCDQueueCredit - LCD_QUEUE_WINDOW_BYTES) /
+                       ui32Bytes;
+            ui32Bytes = (ui32Bytes * ui32Rows) + LCD_QUEUE_WINDOW_BYTES;
+        }
+        else
+        {
+            ui32Rows = 0;
+        }
+
+        if(ui32Rows == 0)
+        {
+            if(g_ui32LCDQueueCredit < g_ui32LCDQueueBudget)
+            {
+                return;
+            }
+            ui32Rows = 1;
+            ui32Bytes = LCDQueueRowBytes(psCmd) +
+                        ((psCmd->ui8Type == LCD_QUEUE_TEXT) ?
+                         0 : LCD_QUEUE_WINDOW_BYTES);
+        }
+
+        if(ui32Rows > (uint32_t)(psCmd->i16Height - psCmd->i16Done))
+        {
+            ui32Rows = psCmd->i16Height - psCmd->i16Done;
+            ui32Bytes = LCDQueueCmdBytes(psCmd);
+        }
+
+        LCDQueueSlice(psCmd, ui32Rows);
+        g_ui32LCDQueueCredit -= (ui32Bytes < g_ui32LCDQueueCredit) ?
+                                ui32Bytes : g_ui32LCDQueueCredit;
+
+        if(psCmd->i16Done == psCmd->i16Height)
+        {
+            g_ui32LCDQueueCount--;
+            for(ui32Idx = 0; ui32Idx < g_ui32LCDQueueCount; ui32Idx++)
+            {
+                g_psLCDQueue[ui32Idx] = g_psLCDQueue[ui32Idx + 1];
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the queue's backlog and counts.
+//
+//*****************************************************************************
+void
+LCDQueueStatsGet(tLCDQueueStats *psStats)
+{
+    uint32_t ui32Idx;
+
+    psStats->ui32Commands = g_ui32LCDQueueCount;
+    psStats->ui32BacklogBytes = 0;
+    for(ui32Idx = 0; ui32Idx < g_ui32LCDQueueCount; ui32Idx++)
+    {
+        psStats->ui32BacklogBytes += LCDQueueCmdBytes(&g_psLCDQueue[ui32Idx]);
+    }
+    psStats->ui32MaxBacklogBytes = g_ui32LCDQueueMaxBacklog;
+    psStats->ui32Coalesced = g_ui32LCDQueueCoalesced;
+    psStats->ui32Refused = g_ui32LCDQueueRefused;
+}
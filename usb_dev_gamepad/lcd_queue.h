@@ -0,0 +1,87 @@
+//*****************************************************************************
+//
+// lcd_queue.h - Time-sliced drawing queue for the ST7735.
+//
+//*****************************************************************************
+
+#ifndef _LCD_QUEUE_H_
+#define _LCD_QUEUE_H_
+
+//*****************************************************************************
+//
+// The number of commands the queue holds.
+//
+//*****************************************************************************
+#define LCD_QUEUE_DEPTH         16
+
+//*****************************************************************************
+//
+// The length of a tick and the default number of SPI bytes the queue may
+// send in each.  At the 12.5MHz SPI clock used at 50MHz the bus moves about
+// 1560 bytes a millisecond, so a byte costs 0.64us.
+//
+//*****************************************************************************
+#define LCD_QUEUE_TICK_US       1000
+
+#ifndef LCD_QUEUE_TICK_BYTES
+#define LCD_QUEUE_TICK_BYTES    1024
+#endif
+
+//*****************************************************************************
+//
+// Supplies one row of a region: ui32Width pixels of row ui32Row, counted
+// from the region's top, into pui16Pixels.
+//
+//*****************************************************************************
+typedef void (*tLCDQueueRowFn)(void *pvCBData, uint32_t ui32Row,
+                               uint16_t *pui16Pixels, uint32_t ui32Width);
+
+//*****************************************************************************
+//
+// The queue's state and counts, from LCDQueueStatsGet().
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The commands waiting, including any part drawn, and an estimate of
+    // the SPI bytes they still need.  The estimate counts every character
+    // of text even though unchanged characters are not sent.
+    //
+    uint32_t ui32Commands;
+    uint32_t ui32BacklogBytes;
+
+    //
+    // The largest backlog seen.
+    //
+    uint32_t ui32MaxBacklogBytes;
+
+    //
+    // Commands dropped because a later one covered them, and commands
+    // refused because the queue was full.
+    //
+    uint32_t ui32Coalesced;
+    uint32_t ui32Refused;
+}
+tLCDQueueStats;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void LCDQueueInit(void);
+extern void LCDQueueBudgetSet(uint32_t ui32BytesPerTick);
+extern bool LCDQueueFill(int16_t i16X, int16_t i16Y, int16_t i16Width,
+                         int16_t i16Height, uint16_t ui16Color);
+extern bool LCDQueueText(uint32_t ui32Col, uint32_t ui32Row,
+                         const char *pcText, uint16_t ui16Color);
+extern bool LCDQueueBitmap(int16_t i16X, int16_t i16Y, int16_t i16Width,
+                           int16_t i16Height, const uint16_t *pui16Pixels);
+extern bool LCDQueueRegion(int16_t i16X, int16_t i16Y, int16_t i16Width,
+                           int16_t i16Height, tLCDQueueRowFn pfnRow,
+                           void *pvCBData);
+extern void LCDQueueProcess(void);
+extern void LCDQueueStatsGet(tLCDQueueStats *psStats);
+
+#endif
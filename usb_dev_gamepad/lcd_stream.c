@@ -0,0 +1,337 @@
+//*****************************************************************************
+//
+// lcd_stream.c - Decoder for the compressed screen update stream.
+//
+// The decoder is a byte-at-a-time state machine so that commands may be
+// split across USB packets at any point, and it emits runs of pixels as
+// soon as they are decoded so that no frame buffer is needed.  This file is
+// shared with the host tools and must stay free of target-specific code.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lcd_stream.h"
+
+//*****************************************************************************
+//
+// Decoder states.
+//
+//*****************************************************************************
+#define STATE_COMMAND           0   // Waiting for a command byte
+#define STATE_ARGS              1   // Collecting the command's fixed arguments
+#define STATE_PALETTE_LO        2   // Low byte of a palette entry
+#define STATE_PALETTE_HI        3   // High byte of a palette entry
+#define STATE_TOKEN             4   // RLE token header or palette run byte
+#define STATE_COLOR_LO          5   // Low byte of a pixel color
+#define STATE_COLOR_HI          6   // High byte of a pixel color
+
+//*****************************************************************************
+//
+// Sends a run of pixels to the output if the rectangle is being drawn.
+//
+//*****************************************************************************
+static void
+LCDStreamEmit(tLCDStreamDecoder *psDecoder, uint16_t ui16Color,
+              uint32_t ui32Count)
+{
+    if(ui32Count > psDecoder->ui32Pixels)
+    {
+        //
+        // The run overflows the rectangle.  Draw what fits.
+        //
+        psDecoder->ui32Errors++;
+        ui32Count = psDecoder->ui32Pixels;
+    }
+
+    if(psDecoder->bDraw)
+    {
+        psDecoder->pfnPixels(psDecoder->pvCBData, ui16Color, ui32Count);
+    }
+
+    psDecoder->ui32Pixels -= ui32Count;
+}
+
+//*****************************************************************************
+//
+// Returns the state that follows a completed run: the next token, or the
+// next command once the rectangle is full.
+//
+//*****************************************************************************
+static uint32_t
+LCDStreamNext(tLCDStreamDecoder *psDecoder)
+{
+    if(!psDecoder->ui32Pixels)
+    {
+        return(STATE_COMMAND);
+    }
+
+    return((psDecoder->ui8Encoding == LCD_STREAM_ENC_RAW) ? STATE_COLOR_LO :
+                                                            STATE_TOKEN);
+}
+
+//*****************************************************************************
+//
+// Acts on a command whose fixed arguments have all arrived.
+//
+//*****************************************************************************
+static uint32_t
+LCDStreamCommand(tLCDStreamDecoder *psDecoder)
+{
+    uint32_t ui32X, ui32Y, ui32W, ui32H;
+    uint8_t *pui8Args;
+
+    pui8Args = psDecoder->pui8Args;
+
+    if(psDecoder->ui8Cmd == LCD_STREAM_CMD_PALETTE)
+    {
+        if((pui8Args[0] == 0) || (pui8Args[0] > LCD_STREAM_PALETTE_SIZE))
+        {
+            psDecoder->ui32Errors++;
+            return(STATE_COMMAND);
+        }
+
+        psDecoder->ui32PaletteCount = pui8Args[0];
+        psDecoder->ui32PaletteIdx = 0;
+        return(STATE_PALETTE_LO);
+    }
+
+    ui32X = pui8Args[0];
+    ui32Y = pui8Args[1];
+    ui32W = pui8Args[2];
+    ui32H = pui8Args[3];
+
+    psDecoder->ui32Pixels = ui32W * ui32H;
+
+    //
+    // A rectangle that does not fit on the screen is still decoded so that
+    // the stream stays in step, but it is not drawn.
+    //
+    psDecoder->bDraw = (ui32W && ui32H &&
+                        ((ui32X + ui32W) <= LCD_STREAM_WIDTH) &&
+                        ((ui32Y + ui32H) <= LCD_STREAM_HEIGHT));
+    if(!psDecoder->bDraw)
+    {
+        psDecoder->ui32Errors++;
+    }
+    else
+    {
+        psDecoder->pfnWindow(psDecoder->pvCBData, ui32X, ui32Y, ui32W, ui32H);
+    }
+
+    if(psDecoder->ui8Cmd == LCD_STREAM_CMD_FILL)
+    {
+        LCDStreamEmit(psDecoder, (uint16_t)(pui8Args[4] | (pui8Args[5] << 8)),
+                      psDecoder->ui32Pixels);
+        return(STATE_COMMAND);
+    }
+
+    psDecoder->ui8Encoding = pui8Args[4];
+    if(psDecoder->ui8Encoding > LCD_STREAM_ENC_PAL_RLE)
+    {
+        //
+        // The data cannot be skipped without knowing how it is encoded, so
+        // give up on the rest of the stream until a valid command is seen.
+        //
+        psDecoder->ui32Errors++;
+        psDecoder->ui32Pixels = 0;
+        return(STATE_COMMAND);
+    }
+
+    psDecoder->ui32Run = 1;
+    psDecoder->bLiteral = true;
+
+    return(LCDStreamNext(psDecoder));
+}
+
+//*****************************************************************************
+//
+// Sets up the decoder with its output callbacks.
+//
+//*****************************************************************************
+void
+LCDStreamInit(tLCDStreamDecoder *psDecoder, tLCDStreamWindowFn pfnWindow,
+              tLCDStreamPixelsFn pfnPixels, void *pvCBData)
+{
+    uint32_t ui32Idx;
+
+    psDecoder->pfnWindow = pfnWindow;
+    psDecoder->pfnPixels = pfnPixels;
+    psDecoder->pvCBData = pvCBData;
+    psDecoder->ui32Errors = 0;
+
+    for(ui32Idx = 0; ui32Idx < LCD_STREAM_PALETTE_SIZE; ui32Idx++)
+    {
+        psDecoder->pui16Palette[ui32Idx] = 0;
+    }
+
+    LCDStreamReset(psDecoder);
+}
+
+//*****************************************************************************
+//
+// Abandons any command in progress, for example when the host reconnects.
+//
+//*****************************************************************************
+void
+LCDStreamReset(tLCDStreamDecoder *psDecoder)
+{
+    psDecoder->ui32State = STATE_COMMAND;
+    psDecoder->ui32Pixels = 0;
+}
+
+//*****************************************************************************
+//
+// Decodes the next ui32Len bytes of the stream.
+//
+//*****************************************************************************
+void
+LCDStreamDecode(tLCDStreamDecoder *psDecoder, const uint8_t *pui8Data,
+                uint32_t ui32Len)
+{
+    uint32_t ui32State;
+    uint16_t ui16Color;
+    uint8_t ui8Byte;
+
+    ui32State = psDecoder->ui32State;
+
+    while(ui32Len--)
+    {
+        ui8Byte = *pui8Data++;
+
+        switch(ui32State)
+        {
+            case STATE_COMMAND:
+            {
+                psDecoder->ui8Cmd = ui8Byte;
+                psDecoder->ui32ArgCount = 0;
+
+                switch(ui8Byte)
+                {
+                    case LCD_STREAM_CMD_RECT:
+                    {
+                        psDecoder->ui32ArgsNeeded = 5;
+                        ui32State = STATE_ARGS;
+                        break;
+                    }
+
+                    case LCD_STREAM_CMD_FILL:
+                    {
+                        psDecoder->ui32ArgsNeeded = 6;
+                        ui32State = STATE_ARGS;
+                        break;
+                    }
+
+                    case LCD_STREAM_CMD_PALETTE:
+                    {
+                        psDecoder->ui32ArgsNeeded = 1;
+                        ui32State = STATE_ARGS;
+                        break;
+                    }
+
+                    case LCD_STREAM_CMD_NOP:
+                    {
+                        break;
+                    }
+
+                    default:
+                    {
+                        psDecoder->ui32Errors++;
+                        break;
+                    }
+                }
+                break;
+            }
+
+            case STATE_ARGS:
+            {
+                psDecoder->pui8Args[psDecoder->ui32ArgCount++] = ui8Byte;
+                if(psDecoder->ui32ArgCount == psDecoder->ui32ArgsNeeded)
+                {
+                    ui32State = LCDStreamCommand(psDecoder);
+                }
+                break;
+            }
+
+            case STATE_PALETTE_LO:
+            {
+                psDecoder->pui16Palette[psDecoder->ui32PaletteIdx] = ui8Byte;
+                ui32State = STATE_PALETTE_HI;
+                break;
+            }
+
+            case STATE_PALETTE_HI:
+            {
+                psDecoder->pui16Palette[psDecoder->ui32PaletteIdx++] |=
+                    (uint16_t)ui8Byte << 8;
+                ui32State = (psDecoder->ui32PaletteIdx <
+                             psDecoder->ui32PaletteCount) ? STATE_PALETTE_LO :
+                                                            STATE_COMMAND;
+                break;
+            }
+
+            case STATE_TOKEN:
+            {
+                if(psDecoder->ui8Encoding == LCD_STREAM_ENC_PAL_RLE)
+                {
+                    LCDStreamEmit(psDecoder,
+                                  psDecoder->pui16Palette[ui8Byte & 0x0f],
+                                  (ui8Byte >> 4) + 1);
+                    ui32State = LCDStreamNext(psDecoder);
+                }
+                else
+                {
+                    psDecoder->bLiteral = (ui8Byte < 0x80);
+                    psDecoder->ui32Run = (ui8Byte & 0x7f) + 1;
+                    ui32State = STATE_COLOR_LO;
+                }
+                break;
+            }
+
+            case STATE_COLOR_LO:
+            {
+                psDecoder->pui8Args[0] = ui8Byte;
+                ui32State = STATE_COLOR_HI;
+                break;
+            }
+
+            case STATE_COLOR_HI:
+            {
+                ui16Color = (uint16_t)(psDecoder->pui8Args[0] |
+                                       (ui8Byte << 8));
+
+                if(psDecoder->ui8Encoding == LCD_STREAM_ENC_RAW)
+                {
+                    LCDStreamEmit(psDecoder, ui16Color, 1);
+                    ui32State = LCDStreamNext(psDecoder);
+                }
+                else if(!psDecoder->bLiteral)
+                {
+                    LCDStreamEmit(psDecoder, ui16Color, psDecoder->ui32Run);
+                    ui32State = LCDStreamNext(psDecoder);
+                }
+                else
+                {
+                    LCDStreamEmit(psDecoder, ui16Color, 1);
+                    if(--psDecoder->ui32Run && psDecoder->ui32Pixels)
+                    {
+                        ui32State = STATE_COLOR_LO;
+                    }
+                    else
+                    {
+                        ui32State = LCDStreamNext(psDecoder);
+                    }
+                }
+                break;
+            }
+
+            default:
+            {
+                ui32State = STATE_COMMAND;
+                break;
+            }
+        }
+    }
+
+    psDecoder->ui32State = ui32State;
+}
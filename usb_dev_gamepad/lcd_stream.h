@@ -0,0 +1,121 @@
+//*****************************************************************************
+//
+// lcd_stream.h - Compressed screen update stream for the ST7735.
+//
+// A host pushes images to the LCD as a stream of commands over the vendor
+// bulk interface.  This header defines the stream format and the decoder,
+// which is shared with the host-side encoder in tools/ and so must not
+// depend on any TivaWare header.
+//
+// All multi-byte values are little endian.  Colors are RGB565.
+//
+// LCD_STREAM_CMD_RECT x y w h enc <pixel data>
+//     Draw a w x h rectangle at (x, y), rows top to bottom and each row left
+//     to right, with its pixels encoded as enc.
+// LCD_STREAM_CMD_FILL x y w h color(2)
+//     Fill a rectangle with one color.
+// LCD_STREAM_CMD_PALETTE n color(2) * n
+//     Load palette entries 0 to n - 1, for LCD_STREAM_ENC_PAL_RLE.
+// LCD_STREAM_CMD_NOP
+//     Ignored.  Can be used as padding.
+//
+// Pixel encodings:
+//
+// LCD_STREAM_ENC_RAW
+//     w * h colors.
+// LCD_STREAM_ENC_RLE
+//     Tokens of a header byte n and colors.  If n < 0x80, n + 1 literal
+//     colors follow.  Otherwise a single color follows which is repeated
+//     (n & 0x7f) + 1 times.
+// LCD_STREAM_ENC_PAL_RLE
+//     One byte per run: the high nibble is the run length minus one and the
+//     low nibble is the palette index.
+//
+// Runs may cross row boundaries.  A rectangle's data ends once w * h pixels
+// have been decoded.
+//
+//*****************************************************************************
+
+#ifndef _LCD_STREAM_H_
+#define _LCD_STREAM_H_
+
+//*****************************************************************************
+//
+// The stream format.
+//
+//*****************************************************************************
+#define LCD_STREAM_CMD_NOP      0x00
+#define LCD_STREAM_CMD_RECT     0x01
+#define LCD_STREAM_CMD_FILL     0x02
+#define LCD_STREAM_CMD_PALETTE  0x03
+
+#define LCD_STREAM_ENC_RAW      0
+#define LCD_STREAM_ENC_RLE      1
+#define LCD_STREAM_ENC_PAL_RLE  2
+
+#define LCD_STREAM_PALETTE_SIZE 16
+#define LCD_STREAM_RLE_MAX      128
+
+//*****************************************************************************
+//
+// The size of the screen the stream is checked against.
+//
+//*****************************************************************************
+#define LCD_STREAM_WIDTH        128
+#define LCD_STREAM_HEIGHT       160
+
+//*****************************************************************************
+//
+// Output callbacks.  pfnWindow starts a new rectangle, and pfnPixels then
+// receives its pixels in order as runs of ui32Count pixels of one color.
+//
+//*****************************************************************************
+typedef void (*tLCDStreamWindowFn)(void *pvCBData, uint32_t ui32X,
+                                   uint32_t ui32Y, uint32_t ui32Width,
+                                   uint32_t ui32Height);
+typedef void (*tLCDStreamPixelsFn)(void *pvCBData, uint16_t ui16Color,
+                                   uint32_t ui32Count);
+
+//*****************************************************************************
+//
+// Decoder state.  Treat as opaque; set up with LCDStreamInit().
+//
+//*****************************************************************************
+typedef struct
+{
+    tLCDStreamWindowFn pfnWindow;
+    tLCDStreamPixelsFn pfnPixels;
+    void *pvCBData;
+
+    uint32_t ui32State;
+    uint8_t ui8Cmd;
+    uint8_t pui8Args[7];
+    uint32_t ui32ArgCount;
+    uint32_t ui32ArgsNeeded;
+
+    uint8_t ui8Encoding;
+    bool bDraw;
+    uint32_t ui32Pixels;
+    uint32_t ui32Run;
+    bool bLiteral;
+    uint32_t ui32PaletteCount;
+    uint32_t ui32PaletteIdx;
+    uint16_t pui16Palette[LCD_STREAM_PALETTE_SIZE];
+
+    uint32_t ui32Errors;
+}
+tLCDStreamDecoder;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void LCDStreamInit(tLCDStreamDecoder *psDecoder,
+                          tLCDStreamWindowFn pfnWindow,
+                          tLCDStreamPixelsFn pfnPixels, void *pvCBData);
+extern void LCDStreamReset(tLCDStreamDecoder *psDecoder);
+extern void LCDStreamDecode(tLCDStreamDecoder *psDecoder,
+                            const uint8_t *pui8Data, uint32_t ui32Len);
+
+#endif
@@ -0,0 +1,360 @@
+//*****************************************************************************
+//
+// lcd_view.c - Live input visualizer for the ST7735.
+//
+// Shows the 15 buttons as a grid of boxes, lit while pressed, and the stick
+// position as a dot in a square.  LCDViewInit() draws the fixed parts once.
+// After that LCDViewUpdate() redraws only the widgets whose state changed:
+// a button's inside and label, or the dot's old and new squares, each one
+// ST7735_FillRect() span.  Updates are at most LCD_VIEW_FRAME_US apart and
+// send at most LCD_VIEW_FRAME_BYTES each.  Widgets that do not fit stay
+// dirty for the next update, and each update starts from the widget after
+// the last one drawn, so none waits for long.
+//
+// The bottom two text rows are left for the status lines.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "timestamp.h"
+#include "lcd_view.h"
+#include "ST7735.h"
+
+//*****************************************************************************
+//
+// The layout.  The stick square's inside is LCD_VIEW_STICK_SIZE - 2 pixels
+// across.  Buttons are laid out five to a row.
+//
+//*****************************************************************************
+#define LCD_VIEW_STICK_X        34
+#define LCD_VIEW_STICK_Y        14
+#define LCD_VIEW_STICK_SIZE     60
+#define LCD_VIEW_DOT_SIZE       6
+#define LCD_VIEW_MARK_SIZE      2
+
+#define LCD_VIEW_BUTTON_X       4
+#define LCD_VIEW_BUTTON_Y       82
+#define LCD_VIEW_BUTTON_W       22
+#define LCD_VIEW_BUTTON_H       16
+#define LCD_VIEW_BUTTON_PITCH_X 24
+#define LCD_VIEW_BUTTON_PITCH_Y 20
+#define LCD_VIEW_BUTTON_COLS    5
+
+//*****************************************************************************
+//
+// The widgets: one per button, then the stick.
+//
+//*****************************************************************************
+#define LCD_VIEW_STICK          LCD_VIEW_BUTTONS
+#define LCD_VIEW_WIDGETS        (LCD_VIEW_BUTTONS + 1)
+
+//*****************************************************************************
+//
+// The SPI bytes to draw a filled rectangle, and a character of text.
+//
+//*****************************************************************************
+#define LCD_VIEW_FILL_BYTES(w, h)                                             \
+        (11 + (2 * (w) * (h)))
+#define LCD_VIEW_CHAR_BYTES     (11 + (6 * 8 * 2))
+
+//*****************************************************************************
+//
+// The colors, set by LCDViewInit().
+//
+//*****************************************************************************
+static uint16_t g_ui16ViewFrame;
+static uint16_t g_ui16ViewIdle;
+static uint16_t g_ui16ViewLit;
+static uint16_t g_ui16ViewMark;
+
+//*****************************************************************************
+//
+// What is on the screen: the buttons lit and the dot's top left corner.
+//
+//*****************************************************************************
+static uint16_t g_ui16ViewButtons;
+static int16_t g_i16ViewDotX;
+static int16_t g_i16ViewDotY;
+
+//*****************************************************************************
+//
+// The time of the last update and the widget the next one starts from.
+//
+//*****************************************************************************
+static uint32_t g_ui32ViewLast;
+static uint32_t g_ui32ViewNext;
+
+//*****************************************************************************
+//
+// Returns the top left corner of a button's box.
+//
+//*****************************************************************************
+static void
+LCDViewButtonPos(uint32_t ui32Button, int16_t *pi16X, int16_t *pi16Y)
+{
+    *pi16X = LCD_VIEW_BUTTON_X +
+             ((ui32Button % LCD_VIEW_BUTTON_COLS) * LCD_VIEW_BUTTON_PITCH_X);
+    *pi16Y = LCD_VIEW_BUTTON_Y +
+             ((ui32Button / LCD_VIEW_BUTTON_COLS) * LCD_VIEW_BUTTON_PITCH_Y);
+}
+
+//*****************************************************************************
+//
+// Draws the inside and label of a button and returns the SPI bytes sent.
+//
+//*****************************************************************************
+static uint32_t
+LCDViewButtonDraw(uint32_t ui32Button, bool bLit)
+{
+    int16_t i16X, i16Y, i16LabelX;
+    uint16_t ui16Back, ui16Text;
+    uint32_t ui32Chars;
+    char pcLabel[3];
+
+    LCDViewButtonPos(ui32Button, &i16X, &i16Y);
+    ui16Back = bLit ? g_ui16ViewLit : g_ui16ViewIdle;
+    ui16Text = bLit ? ST7735_BLACK : ST7735_WHITE;
+
+    ST7735_FillRect(i16X + 1, i16Y + 1, LCD_VIEW_BUTTON_W - 2,
+                    LCD_VIEW_BUTTON_H - 2, ui16Back);
+
+    //
+    // The label is the button number, centered.
+    //
+    if(ui32Button >= 9)
+    {
+        pcLabel[0] = '0' + ((ui32Button + 1) / 10);
+        pcLabel[1] = '0' + ((ui32Button + 1) % 10);
+        ui32Chars = 2;
+    }
+    else
+    {
+        pcLabel[0] = '1' + ui32Button;
+        ui32Chars = 1;
+    }
+
+    i16LabelX = i16X + 1 + ((LCD_VIEW_BUTTON_W - 2 - (6 * ui32Chars)) / 2);
+    ST7735_DrawCharS(i16LabelX, i16Y + 4, pcLabel[0], ui16Text, ui16Back, 1);
+    if(ui32Chars == 2)
+    {
+        ST7735_DrawCharS(i16LabelX + 6, i16Y + 4, pcLabel[1], ui16Text,
+                         ui16Back, 1);
+    }
+
+    return(LCD_VIEW_FILL_BYTES(LCD_VIEW_BUTTON_W - 2, LCD_VIEW_BUTTON_H - 2) +
+           (ui32Chars * LCD_VIEW_CHAR_BYTES));
+}
+
+//*****************************************************************************
+//
+// Returns the SPI bytes a button redraw costs.
+//
+//*****************************************************************************
+static uint32_t
+LCDViewButtonBytes(uint32_t ui32Button)
+{
+    return(LCD_VIEW_FILL_BYTES(LCD_VIEW_BUTTON_W - 2, LCD_VIEW_BUTTON_H - 2) +
+           (((ui32Button >= 9) ? 2 : 1) * LCD_VIEW_CHAR_BYTES));
+}
+
+//*****************************************************************************
+//
+// Returns the dot's top left corner for a pair of 10-bit axis values.
+//
+//*****************************************************************************
+static void
+LCDViewDotPos(uint16_t ui16X, uint16_t ui16Y, int16_t *pi16X, int16_t *pi16Y)
+{
+    uint32_t ui32Range;
+
+    ui32Range = LCD_VIEW_STICK_SIZE - 2 - LCD_VIEW_DOT_SIZE;
+    *pi16X = LCD_VIEW_STICK_X + 1 + ((ui16X * ui32Range) / 1023);
+    *pi16Y = LCD_VIEW_STICK_Y + 1 + ((ui16Y * ui32Range) / 1023);
+}
+
+//*****************************************************************************
+//
+// Draws the center mark of the stick square.
+//
+//*****************************************************************************
+static void
+LCDViewMarkDraw(void)
+{
+    ST7735_FillRect(LCD_VIEW_STICK_X + ((LCD_VIEW_STICK_SIZE -
+                                         LCD_VIEW_MARK_SIZE) / 2),
+                    LCD_VIEW_STICK_Y + ((LCD_VIEW_STICK_SIZE -
+                                         LCD_VIEW_MARK_SIZE) / 2),
+                    LCD_VIEW_MARK_SIZE, LCD_VIEW_MARK_SIZE, g_ui16ViewMark);
+}
+
+//*****************************************************************************
+//
+// Returns the SPI bytes a dot move costs: erasing it and drawing it again,
+// and at worst the center mark.
+//
+//*****************************************************************************
+static uint32_t
+LCDViewDotBytes(void)
+{
+    return((2 * LCD_VIEW_FILL_BYTES(LCD_VIEW_DOT_SIZE, LCD_VIEW_DOT_SIZE)) +
+           LCD_VIEW_FILL_BYTES(LCD_VIEW_MARK_SIZE, LCD_VIEW_MARK_SIZE));
+}
+
+//*****************************************************************************
+//
+// Moves the dot, erasing it where it was, and returns the SPI bytes sent.
+//
+//*****************************************************************************
+static uint32_t
+LCDViewDotMove(int16_t i16X, int16_t i16Y)
+{
+    int16_t i16Mark;
+
+    ST7735_FillRect(g_i16ViewDotX, g_i16ViewDotY, LCD_VIEW_DOT_SIZE,
+                    LCD_VIEW_DOT_SIZE, ST7735_BLACK);
+
+    //
+    // Put the center mark back if the old dot covered it and the new one
+    // does not.
+    //
+    i16Mark = (LCD_VIEW_STICK_SIZE - LCD_VIEW_MARK_SIZE) / 2;
+    if(((g_i16ViewDotX - LCD_VIEW_STICK_X) <= (i16Mark + LCD_VIEW_MARK_SIZE)) &&
+       ((g_i16ViewDotX - LCD_VIEW_STICK_X + LCD_VIEW_DOT_SIZE) >= i16Mark) &&
+       ((g_i16ViewDotY - LCD_VIEW_STICK_Y) <= (i16Mark + LCD_VIEW_MARK_SIZE)) &&
+       ((g_i16ViewDotY - LCD_VIEW_STICK_Y + LCD_VIEW_DOT_SIZE) >= i16Mark))
+    {
+        LCDViewMarkDraw();
+    }
+
+    ST7735_FillRect(i16X, i16Y, LCD_VIEW_DOT_SIZE, LCD_VIEW_DOT_SIZE,
+                    g_ui16ViewLit);
+    g_i16ViewDotX = i16X;
+    g_i16ViewDotY = i16Y;
+
+    return(LCDViewDotBytes());
+}
+
+//*****************************************************************************
+//
+// Clears the screen and draws the fixed parts and every widget.  Leaves the
+// status rows at the bottom untouched.
+//
+//*****************************************************************************
+void
+LCDViewInit(void)
+{
+    uint32_t ui32Button;
+    int16_t i16X, i16Y;
+
+    g_ui16ViewFrame = ST7735_Color565(96, 96, 96);
+    g_ui16ViewIdle = ST7735_Color565(32, 32, 32);
+    g_ui16ViewLit = ST7735_GREEN;
+    g_ui16ViewMark = ST7735_Color565(96, 96, 96);
+
+    ST7735_FillRect(0, 0, ST7735_TFTWIDTH, 140, ST7735_BLACK);
+    ST7735_DrawString(0, 0, "Inputs", ST7735_YELLOW);
+
+    //
+    // The stick square's outline, center mark and dot.
+    //
+    ST7735_FillRect(LCD_VIEW_STICK_X, LCD_VIEW_STICK_Y, LCD_VIEW_STICK_SIZE,
+                    1, g_ui16ViewFrame);
+    ST7735_FillRect(LCD_VIEW_STICK_X,
+                    LCD_VIEW_STICK_Y + LCD_VIEW_STICK_SIZE - 1,
+                    LCD_VIEW_STICK_SIZE, 1, g_ui16ViewFrame);
+    ST7735_FillRect(LCD_VIEW_STICK_X, LCD_VIEW_STICK_Y, 1,
+                    LCD_VIEW_STICK_SIZE, g_ui16ViewFrame);
+    ST7735_FillRect(LCD_VIEW_STICK_X + LCD_VIEW_STICK_SIZE - 1,
+                    LCD_VIEW_STICK_Y, 1, LCD_VIEW_STICK_SIZE,
+                    g_ui16ViewFrame);
+    LCDViewMarkDraw();
+    LCDViewDotPos(512, 512, &g_i16ViewDotX, &g_i16ViewDotY);
+    LCDViewDotMove(g_i16ViewDotX, g_i16ViewDotY);
+
+    //
+    // The button boxes, all released.
+    //
+    for(ui32Button = 0; ui32Button < LCD_VIEW_BUTTONS; ui32Button++)
+    {
+        LCDViewButtonPos(ui32Button, &i16X, &i16Y);
+        ST7735_FillRect(i16X, i16Y, LCD_VIEW_BUTTON_W, LCD_VIEW_BUTTON_H,
+                        g_ui16ViewFrame);
+        LCDViewButtonDraw(ui32Button, false);
+    }
+    g_ui16ViewButtons = 0;
+
+    g_ui32ViewLast = TimestampGet();
+    g_ui32ViewNext = 0;
+}
+
+//*****************************************************************************
+//
+// Brings the screen up to date with the inputs, as far as this update's
+// byte budget allows.  This is called from the main loop and returns at
+// once if the last update was less than LCD_VIEW_FRAME_US ago.
+//
+// \param ui16Buttons has bit n set while button n + 1 is pressed.
+// \param ui16X and ui16Y are the stick's 10-bit axis values.
+//
+//*****************************************************************************
+void
+LCDViewUpdate(uint16_t ui16Buttons, uint16_t ui16X, uint16_t ui16Y)
+{
+    uint32_t ui32Now, ui32Spent, ui32Cost, ui32Count, ui32Widget;
+    uint16_t ui16Bit;
+    int16_t i16DotX, i16DotY;
+
+    ui32Now = TimestampGet();
+    if((ui32Now - g_ui32ViewLast) < TimestampFromUs(LCD_VIEW_FRAME_US))
+    {
+        return;
+    }
+
+    LCDViewDotPos(ui16X, ui16Y, &i16DotX, &i16DotY);
+    ui32Spent = 0;
+    ui32Widget = g_ui32ViewNext;
+
+    for(ui32Count = 0; ui32Count < LCD_VIEW_WIDGETS; ui32Count++)
+    {
+        if(ui32Widget == LCD_VIEW_STICK)
+        {
+            if((i16DotX != g_i16ViewDotX) || (i16DotY != g_i16ViewDotY))
+            {
+                ui32Cost = LCDViewDotBytes();
+                if((ui32Spent + ui32Cost) > LCD_VIEW_FRAME_BYTES)
+                {
+                    break;
+                }
+                ui32Spent += LCDViewDotMove(i16DotX, i16DotY);
+            }
+        }
+        else
+        {
+            ui16Bit = 1 << ui32Widget;
+            if((ui16Buttons ^ g_ui16ViewButtons) & ui16Bit)
+            {
+                ui32Cost = LCDViewButtonBytes(ui32Widget);
+                if((ui32Spent + ui32Cost) > LCD_VIEW_FRAME_BYTES)
+                {
+                    break;
+                }
+                ui32Spent += LCDViewButtonDraw(ui32Widget,
+                                               (ui16Buttons & ui16Bit) != 0);
+                g_ui16ViewButtons ^= ui16Bit;
+            }
+        }
+
+        ui32Widget = (ui32Widget + 1) % LCD_VIEW_WIDGETS;
+    }
+
+    //
+    // Only count this as an update if something was drawn, so a change is
+    // shown as soon as it arrives rather than up to a frame later.
+    //
+    if(ui32Spent)
+    {
+        g_ui32ViewLast = ui32Now;
+        g_ui32ViewNext = ui32Widget;
+    }
+}
@@ -0,0 +1,38 @@
+//*****************************************************************************
+//
+// lcd_view.h - Live input visualizer for the ST7735.
+//
+//*****************************************************************************
+
+#ifndef _LCD_VIEW_H_
+#define _LCD_VIEW_H_
+
+//*****************************************************************************
+//
+// The shortest time between two screen updates, and the most SPI bytes one
+// update may send.  Widgets that do not fit are drawn in a later update.
+//
+//*****************************************************************************
+#define LCD_VIEW_FRAME_US       16667
+
+#ifndef LCD_VIEW_FRAME_BYTES
+#define LCD_VIEW_FRAME_BYTES    4096
+#endif
+
+//*****************************************************************************
+//
+// The number of buttons shown.
+//
+//*****************************************************************************
+#define LCD_VIEW_BUTTONS        15
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void LCDViewInit(void);
+extern void LCDViewUpdate(uint16_t ui16Buttons, uint16_t ui16X,
+                          uint16_t ui16Y);
+
+#endif
@@ -0,0 +1,79 @@
+//*****************************************************************************
+//
+// timestamp.c - Cycle-accurate timebase built on the Cortex-M4 DWT counter.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "timestamp.h"
+
+//*****************************************************************************
+//
+// The number of system clock cycles per microsecond.
+//
+//*****************************************************************************
+uint32_t g_ui32TimestampCyclesPerUs = 50;
+
+//*****************************************************************************
+//
+// The state of the extended microsecond clock: the cycle count it was last
+// advanced to, the microseconds elapsed up to then and the cycles left over
+// that did not make up a whole microsecond.
+//
+//*****************************************************************************
+static uint32_t g_ui32TimestampLast;
+static uint32_t g_ui32TimestampUs;
+static uint32_t g_ui32TimestampRemainder;
+
+//*****************************************************************************
+//
+// Starts the DWT cycle counter and latches the current system clock rate.
+//
+// This must be called after the final call to SysCtlClockSet() and again any
+// time the system clock is changed.  The counter itself is never reset so
+// timestamps taken before a clock change remain ordered.
+//
+//*****************************************************************************
+void
+TimestampInit(void)
+{
+    //
+    // Enable the trace block and the cycle counter.
+    //
+    DWT_DEMCR_R |= DWT_DEMCR_TRCENA;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;
+
+    //
+    // Latch the clock rate used for microsecond conversions.
+    //
+    g_ui32TimestampCyclesPerUs = ROM_SysCtlClockGet() / 1000000;
+    g_ui32TimestampLast = TimestampGet();
+    g_ui32TimestampRemainder = 0;
+}
+
+//*****************************************************************************
+//
+// Returns a 32-bit microsecond clock that wraps about every 71 minutes.
+//
+// The clock is extended from the cycle counter on every call, so it must be
+// called at least once per cycle counter wrap and always from the same
+// interrupt priority, since the update is not atomic.
+//
+//*****************************************************************************
+uint32_t
+TimestampUsGet(void)
+{
+    uint32_t ui32Now, ui32Cycles;
+
+    ui32Now = TimestampGet();
+    ui32Cycles = (ui32Now - g_ui32TimestampLast) + g_ui32TimestampRemainder;
+    g_ui32TimestampLast = ui32Now;
+
+    g_ui32TimestampUs += ui32Cycles / g_ui32TimestampCyclesPerUs;
+    g_ui32TimestampRemainder = ui32Cycles % g_ui32TimestampCyclesPerUs;
+
+    return(g_ui32TimestampUs);
+}
@@ -0,0 +1,58 @@
+//*****************************************************************************
+//
+// timestamp.h - Cycle-accurate timebase built on the Cortex-M4 DWT counter.
+//
+//*****************************************************************************
+
+#ifndef _TIMESTAMP_H_
+#define _TIMESTAMP_H_
+
+//*****************************************************************************
+//
+// Data Watchpoint and Trace unit registers.  These are not part of the
+// device header since they belong to the core rather than the TM4C123.
+//
+//*****************************************************************************
+#define DWT_CTRL_R              (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT_R            (*((volatile uint32_t *)0xE0001004))
+#define DWT_DEMCR_R             (*((volatile uint32_t *)0xE000EDFC))
+
+#define DWT_CTRL_CYCCNTENA      0x00000001  // Cycle counter enable
+#define DWT_DEMCR_TRCENA        0x01000000  // Trace enable
+
+//*****************************************************************************
+//
+// The number of system clock cycles per microsecond.  This is refreshed by
+// TimestampInit() and must be updated whenever the system clock changes.
+//
+//*****************************************************************************
+extern uint32_t g_ui32TimestampCyclesPerUs;
+
+//*****************************************************************************
+//
+// Returns the free-running cycle count.  The counter wraps every 2^32 cycles
+// (about 86 seconds at 50MHz), so only differences between two readings are
+// meaningful.
+//
+//*****************************************************************************
+#define TimestampGet()          (DWT_CYCCNT_R)
+
+//*****************************************************************************
+//
+// Conversions between cycle counts and microseconds at the current clock.
+//
+//*****************************************************************************
+#define TimestampToUs(ui32Cycles)                                             \
+        ((ui32Cycles) / g_ui32TimestampCyclesPerUs)
+#define TimestampFromUs(ui32Us)                                               \
+        ((ui32Us) * g_ui32TimestampCyclesPerUs)
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void TimestampInit(void);
+extern uint32_t TimestampUsGet(void);
+
+#endif
@@ -0,0 +1,551 @@
+//*****************************************************************************
+//
+// usb_config.c - Player one's configuration, set by the host through the
+// status feature report.
+//
+// The host writes a new configuration with SET_REPORT(Feature).  It is
+// checked and decoded into the shadow copy straight away, from the USB
+// interrupt, and the report builder swaps it in at the start of its next
+// pass.  The builder runs from the USB and Timer0A interrupts, which share
+// the USB interrupt's priority, so every report is built from exactly one
+// configuration and the swap is a single pointer write.  Only the builder
+// swaps, so the copy it is using is never the one being written.
+//
+// A saved configuration lives in the on-chip EEPROM and is written from the
+// main loop, since programming takes milliseconds.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/eeprom.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "usb_gamepad_report.h"
+#include "usb_config.h"
+#include "usb_telemetry.h"
+#include "timestamp.h"
+
+//*****************************************************************************
+//
+// The saved configuration: a marker followed by the configuration as it
+// appears in the status feature report.  The marker includes the report
+// version, so a saved configuration from an older layout is ignored.
+//
+//*****************************************************************************
+#define CONFIG_EEPROM_ADDR      0
+#define CONFIG_MAGIC            (0x47504300 | GAMEPAD_STATUS_VERSION)
+
+typedef struct
+{
+    uint32_t ui32Magic;
+    uint8_t pui8Status[GAMEPAD_STATUS_SIZE];
+}
+tConfigImage;
+
+//*****************************************************************************
+//
+// The built-in configuration: every input on its own report button, no
+// debounce or turbo, and the full ADC range.
+//
+//*****************************************************************************
+static const tGamepadConfig g_sConfigDefault =
+{
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    true,
+    0,
+    0,
+    0,
+    0,
+    {
+        { 0, 2048, GAMEPAD_CONFIG_ADC_MAX },
+        { 0, 2048, GAMEPAD_CONFIG_ADC_MAX }
+    }
+};
+
+//*****************************************************************************
+//
+// The two copies of the configuration, the one in use, and whether the
+// other holds a newer one waiting to be swapped in.
+//
+//*****************************************************************************
+static tGamepadConfig g_psConfig[2];
+static tGamepadConfig * volatile g_psConfigActive;
+static volatile bool g_bConfigPending;
+
+//*****************************************************************************
+//
+// The number of configurations swapped in, modulo 256, and whether the one
+// in use is to be saved once it has been.
+//
+//*****************************************************************************
+static volatile uint8_t g_ui8ConfigSeq;
+static volatile bool g_bConfigSave;
+
+//*****************************************************************************
+//
+// Button processing state: the report buttons after debounce, the time each
+// one last changed and the time each was last pressed, in microseconds.
+//
+//*****************************************************************************
+static uint16_t g_ui16ConfigButtons;
+static uint32_t g_pui32ConfigChangeUs[GAMEPAD_CONFIG_INPUTS];
+static uint32_t g_pui32ConfigPressUs[GAMEPAD_CONFIG_INPUTS];
+
+//*****************************************************************************
+//
+// Little endian field access.
+//
+//*****************************************************************************
+#define ConfigGet16(pui8Buf, ui32Ofs)                                        \
+    ((uint16_t)((pui8Buf)[ui32Ofs] | ((pui8Buf)[(ui32Ofs) + 1] << 8)))
+#define ConfigSet16(pui8Buf, ui32Ofs, ui16Value)                             \
+    do                                                                       \
+    {                                                                        \
+        (pui8Buf)[ui32Ofs] = (uint8_t)(ui16Value);                           \
+        (pui8Buf)[(ui32Ofs) + 1] = (uint8_t)((ui16Value) >> 8);              \
+    }                                                                        \
+    while(0)
+
+//*****************************************************************************
+//
+// Checks and decodes the configuration fields of a status feature report.
+//
+// The fields are decoded into a local copy, and psConfig is only written
+// once every field has been checked, so a rejected report never leaves a
+// waiting configuration half written.
+//
+// \return Returns false, leaving psConfig unchanged, if any field is out of
+// range.
+//
+//*****************************************************************************
+static bool
+ConfigParse(tGamepadConfig *psConfig, const uint8_t *pui8Status)
+{
+    tGamepadConfig sConfig;
+    uint32_t ui32Idx, ui32Axis;
+    uint16_t *pui16Cal;
+    uint8_t ui8Button;
+
+    sConfig.bMapIdentity = true;
+
+    for(ui32Idx = 0; ui32Idx < GAMEPAD_CONFIG_INPUTS; ui32Idx++)
+    {
+        ui8Button = pui8Status[GAMEPAD_STATUS_O_BUTTON_MAP + ui32Idx];
+        if((ui8Button >= GAMEPAD_CONFIG_INPUTS) &&
+           (ui8Button != GAMEPAD_CONFIG_BUTTON_NONE))
+        {
+            return(false);
+        }
+
+        sConfig.pui8ButtonMap[ui32Idx] = ui8Button;
+        if(ui8Button != ui32Idx)
+        {
+            sConfig.bMapIdentity = false;
+        }
+    }
+
+    sConfig.ui8DebounceMs = pui8Status[GAMEPAD_STATUS_O_DEBOUNCE];
+    sConfig.ui8TurboHz = pui8Status[GAMEPAD_STATUS_O_TURBO_HZ];
+    sConfig.ui16TurboMask = ConfigGet16(pui8Status,
+                                        GAMEPAD_STATUS_O_TURBO_MASK);
+    sConfig.ui8Options = pui8Status[GAMEPAD_STATUS_O_OPTIONS];
+
+    if(sConfig.ui8TurboHz > GAMEPAD_CONFIG_TURBO_HZ_MAX)
+    {
+        return(false);
+    }
+
+    for(ui32Axis = 0; ui32Axis < 2; ui32Axis++)
+    {
+        pui16Cal = sConfig.ppui16Cal[ui32Axis];
+        for(ui32Idx = 0; ui32Idx < 3; ui32Idx++)
+        {
+            pui16Cal[ui32Idx] =
+                ConfigGet16(pui8Status, (ui32Axis ? GAMEPAD_STATUS_O_CAL_Y :
+                                                    GAMEPAD_STATUS_O_CAL_X) +
+                                        (ui32Idx * 2));
+        }
+
+        if((pui16Cal[0] >= pui16Cal[1]) || (pui16Cal[1] >= pui16Cal[2]) ||
+           (pui16Cal[2] > GAMEPAD_CONFIG_ADC_MAX))
+        {
+            return(false);
+        }
+    }
+
+    *psConfig = sConfig;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Encodes a configuration into the configuration fields of a status feature
+// report.
+//
+//*****************************************************************************
+static void
+ConfigFormat(const tGamepadConfig *psConfig, uint8_t *pui8Status)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < GAMEPAD_CONFIG_INPUTS; ui32Idx++)
+    {
+        pui8Status[GAMEPAD_STATUS_O_BUTTON_MAP + ui32Idx] =
+            psConfig->pui8ButtonMap[ui32Idx];
+    }
+
+    pui8Status[GAMEPAD_STATUS_O_DEBOUNCE] = psConfig->ui8DebounceMs;
+    pui8Status[GAMEPAD_STATUS_O_TURBO_HZ] = psConfig->ui8TurboHz;
+    ConfigSet16(pui8Status, GAMEPAD_STATUS_O_TURBO_MASK,
+                psConfig->ui16TurboMask);
+    pui8Status[GAMEPAD_STATUS_O_OPTIONS] = psConfig->ui8Options;
+
+    for(ui32Idx = 0; ui32Idx < 3; ui32Idx++)
+    {
+        ConfigSet16(pui8Status, GAMEPAD_STATUS_O_CAL_X + (ui32Idx * 2),
+                    psConfig->ppui16Cal[0][ui32Idx]);
+        ConfigSet16(pui8Status, GAMEPAD_STATUS_O_CAL_Y + (ui32Idx * 2),
+                    psConfig->ppui16Cal[1][ui32Idx]);
+    }
+}
+
+//*****************************************************************************
+//
+// Starts with the saved configuration if there is a valid one, or the
+// built-in one otherwise.  This must be called before the device goes on the
+// bus.
+//
+//*****************************************************************************
+void
+ConfigInit(void)
+{
+    tConfigImage sImage;
+
+    g_psConfig[0] = g_sConfigDefault;
+    g_psConfigActive = &g_psConfig[0];
+    g_bConfigPending = false;
+
+    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    if(EEPROMInit() != EEPROM_INIT_OK)
+    {
+        TelemetryPrintf("EEPROM failed, using the default configuration\n");
+        return;
+    }
+
+    EEPROMRead((uint32_t *)&sImage, CONFIG_EEPROM_ADDR, sizeof(sImage));
+    if(sImage.ui32Magic != CONFIG_MAGIC)
+    {
+        return;
+    }
+
+    if(ConfigParse(&g_psConfig[1], sImage.pui8Status))
+    {
+        g_psConfig[0] = g_psConfig[1];
+        TelemetryPrintf("Using the saved configuration\n");
+    }
+}
+
+//*****************************************************************************
+//
+// Called from the main loop.  Saves the configuration in use once the host
+// has asked for it to be kept and it has been swapped in.
+//
+//*****************************************************************************
+void
+ConfigProcess(void)
+{
+    tConfigImage sImage;
+    tGamepadConfig sConfig;
+    uint32_t ui32Idx;
+
+    if(!g_bConfigSave || g_bConfigPending)
+    {
+        return;
+    }
+
+    //
+    // Once this copy is in use, the next write from the host goes into the
+    // other one, so take a private copy to work from.  A write staged since
+    // the check above has not been swapped in yet, so leave the save for
+    // when it has.
+    //
+    ROM_IntMasterDisable();
+    if(g_bConfigPending)
+    {
+        ROM_IntMasterEnable();
+        return;
+    }
+    sConfig = *g_psConfigActive;
+    g_bConfigSave = false;
+    ROM_IntMasterEnable();
+
+    for(ui32Idx = 0; ui32Idx < GAMEPAD_STATUS_SIZE; ui32Idx++)
+    {
+        sImage.pui8Status[ui32Idx] = 0;
+    }
+    sImage.ui32Magic = CONFIG_MAGIC;
+    ConfigFormat(&sConfig, sImage.pui8Status);
+
+    if(EEPROMProgram((uint32_t *)&sImage, CONFIG_EEPROM_ADDR,
+                     sizeof(sImage)) == 0)
+    {
+        TelemetryPrintf("Configuration saved\n");
+    }
+    else
+    {
+        TelemetryPrintf("Configuration save failed\n");
+    }
+}
+
+//*****************************************************************************
+//
+// Takes a configuration written by the host.  This is called from the USB
+// interrupt with the written status feature report.
+//
+// \param pui8Status is the report the host wrote.
+// \param ui32Size is the number of bytes it wrote.
+//
+// \return Returns true if a new configuration is waiting to be swapped in.
+//
+//*****************************************************************************
+bool
+ConfigStage(const uint8_t *pui8Status, uint32_t ui32Size)
+{
+    tGamepadConfig *psShadow;
+    uint8_t ui8Cmd;
+
+    if(ui32Size < GAMEPAD_STATUS_SIZE)
+    {
+        return(false);
+    }
+
+    ui8Cmd = pui8Status[GAMEPAD_STATUS_O_CONFIG_CMD];
+    if((ui8Cmd == 0) || (ui8Cmd > GAMEPAD_CONFIG_CMD_DEFAULTS))
+    {
+        return(false);
+    }
+
+    //
+    // The copy not in use is free, even if it already holds a configuration
+    // that has not been swapped in yet; the newest write wins.
+    //
+    psShadow = (g_psConfigActive == &g_psConfig[0]) ? &g_psConfig[1] :
+                                                      &g_psConfig[0];
+
+    if(ui8Cmd == GAMEPAD_CONFIG_CMD_DEFAULTS)
+    {
+        *psShadow = g_sConfigDefault;
+    }
+    else if(!ConfigParse(psShadow, pui8Status))
+    {
+        return(false);
+    }
+
+    g_bConfigPending = true;
+    g_bConfigSave = (ui8Cmd != GAMEPAD_CONFIG_CMD_APPLY);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Swaps in a waiting configuration.  This is called by the report builder
+// at the start of each pass, from the USB and Timer0A interrupts.
+//
+// \return Returns the configuration to build the report with.
+//
+//*****************************************************************************
+const tGamepadConfig *
+ConfigSwap(void)
+{
+    if(g_bConfigPending)
+    {
+        g_psConfigActive = (g_psConfigActive == &g_psConfig[0]) ?
+                           &g_psConfig[1] : &g_psConfig[0];
+        g_bConfigPending = false;
+        g_ui8ConfigSeq++;
+    }
+
+    return(g_psConfigActive);
+}
+
+//*****************************************************************************
+//
+// Returns the configuration in use.  A caller that can be interrupted by
+// the USB interrupt must not hold on to it, since the host may write a new
+// one into the same copy once it has been swapped out.
+//
+//*****************************************************************************
+const tGamepadConfig *
+ConfigGet(void)
+{
+    return(g_psConfigActive);
+}
+
+//*****************************************************************************
+//
+// Fills in the configuration fields of the status feature report.  This is
+// called from the USB interrupt.
+//
+//*****************************************************************************
+void
+ConfigStatusBuild(uint8_t *pui8Status)
+{
+    pui8Status[GAMEPAD_STATUS_O_CONFIG_CMD] = 0;
+    pui8Status[GAMEPAD_STATUS_O_CONFIG_SEQ] = g_ui8ConfigSeq;
+    ConfigFormat(g_psConfigActive, pui8Status);
+}
+
+//*****************************************************************************
+//
+// Maps player one's inputs to report buttons.
+//
+// \param ui16Inputs has bit n set if input n is pressed.
+//
+// \return Returns the report buttons.
+//
+//*****************************************************************************
+uint16_t
+ConfigButtonsMap(const tGamepadConfig *psConfig, uint16_t ui16Inputs)
+{
+    uint32_t ui32Idx;
+    uint16_t ui16Buttons;
+    uint8_t ui8Button;
+
+    if(psConfig->bMapIdentity)
+    {
+        return(ui16Inputs);
+    }
+
+    ui16Buttons = 0;
+
+    for(ui32Idx = 0; ui16Inputs; ui32Idx++, ui16Inputs >>= 1)
+    {
+        ui8Button = psConfig->pui8ButtonMap[ui32Idx];
+        if((ui16Inputs & 1) && (ui8Button != GAMEPAD_CONFIG_BUTTON_NONE))
+        {
+            ui16Buttons |= 1 << ui8Button;
+        }
+    }
+
+    return(ui16Buttons);
+}
+
+//*****************************************************************************
+//
+// Maps, debounces and applies turbo to player one's inputs.  This is only
+// called from the report builder.
+//
+// \param ui16Inputs has bit n set if input n is pressed.
+//
+// \return Returns the report buttons.
+//
+//*****************************************************************************
+uint16_t
+ConfigButtonsApply(const tGamepadConfig *psConfig, uint16_t ui16Inputs)
+{
+    uint32_t ui32Now, ui32Idx, ui32HoldUs, ui32HalfUs;
+    uint16_t ui16Buttons, ui16Changed, ui16Pressed;
+
+    ui16Buttons = ConfigButtonsMap(psConfig, ui16Inputs);
+
+    if(!psConfig->ui8DebounceMs && !psConfig->ui8TurboHz)
+    {
+        g_ui16ConfigButtons = ui16Buttons;
+        return(ui16Buttons);
+    }
+
+    ui32Now = TimestampUsGet();
+
+    //
+    // A button that changed recently keeps its state until the debounce
+    // time is up, so the first edge goes out at once and the bounces that
+    // follow it are dropped.
+    //
+    ui16Changed = ui16Buttons ^ g_ui16ConfigButtons;
+    ui32HoldUs = psConfig->ui8DebounceMs * 1000;
+
+    for(ui32Idx = 0; ui16Changed; ui32Idx++, ui16Changed >>= 1)
+    {
+        if((ui16Changed & 1) &&
+           ((ui32Now - g_pui32ConfigChangeUs[ui32Idx]) >= ui32HoldUs))
+        {
+            g_ui16ConfigButtons ^= 1 << ui32Idx;
+            g_pui32ConfigChangeUs[ui32Idx] = ui32Now;
+            if(g_ui16ConfigButtons & (1 << ui32Idx))
+            {
+                g_pui32ConfigPressUs[ui32Idx] = ui32Now;
+            }
+        }
+    }
+
+    ui16Buttons = g_ui16ConfigButtons;
+
+    //
+    // Turbo buttons are released for the second half of each period,
+    // counted from when they were pressed so the first press is immediate.
+    //
+    ui16Pressed = ui16Buttons & psConfig->ui16TurboMask;
+    if(!psConfig->ui8TurboHz || !ui16Pressed)
+    {
+        return(ui16Buttons);
+    }
+
+    ui32HalfUs = 500000 / psConfig->ui8TurboHz;
+
+    for(ui32Idx = 0; ui16Pressed; ui32Idx++, ui16Pressed >>= 1)
+    {
+        if((ui16Pressed & 1) &&
+           (((ui32Now - g_pui32ConfigPressUs[ui32Idx]) / ui32HalfUs) & 1))
+        {
+            ui16Buttons &= ~(1 << ui32Idx);
+        }
+    }
+
+    return(ui16Buttons);
+}
+
+//*****************************************************************************
+//
+// Converts a 12-bit ADC reading to the 10-bit axis value in the report,
+// using the axis calibration.  The minimum reading maps to 1023, the center
+// to 512 and the maximum to 0, matching the uncalibrated stick.
+//
+// \param ui32Axis is 0 for X or 1 for Y.
+//
+//*****************************************************************************
+uint32_t
+ConfigAxis(const tGamepadConfig *psConfig, uint32_t ui32Axis,
+           uint32_t ui32Raw)
+{
+    const uint16_t *pui16Cal;
+    uint32_t ui32Value;
+
+    pui16Cal = psConfig->ppui16Cal[ui32Axis];
+
+    if(ui32Raw <= pui16Cal[0])
+    {
+        return(1023);
+    }
+    if(ui32Raw >= pui16Cal[2])
+    {
+        return(0);
+    }
+
+    if(ui32Raw < pui16Cal[1])
+    {
+        ui32Value = ((ui32Raw - pui16Cal[0]) * 511) /
+                    (pui16Cal[1] - pui16Cal[0]);
+    }
+    else
+    {
+        ui32Value = 511 + (((ui32Raw - pui16Cal[1]) * 512) /
+                           (pui16Cal[2] - pui16Cal[1]));
+    }
+
+    return(1023 - ui32Value);
+}
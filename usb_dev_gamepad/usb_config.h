@@ -0,0 +1,67 @@
+//*****************************************************************************
+//
+// usb_config.h - Player one's configuration, set by the host through the
+// status feature report.
+//
+//*****************************************************************************
+
+#ifndef _USB_CONFIG_H_
+#define _USB_CONFIG_H_
+
+//*****************************************************************************
+//
+// A configuration, as decoded from the status feature report.  The fields
+// are described with GAMEPAD_STATUS_O_CONFIG_CMD in usb_gamepad_report.h.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The report button driven by each input, or GAMEPAD_CONFIG_BUTTON_NONE,
+    // and whether every input drives the report button of the same number.
+    //
+    uint8_t pui8ButtonMap[GAMEPAD_CONFIG_INPUTS];
+    bool bMapIdentity;
+
+    //
+    // How long a report button stays put after a change, in milliseconds.
+    //
+    uint8_t ui8DebounceMs;
+
+    //
+    // The report buttons that repeat while held, and how often.
+    //
+    uint16_t ui16TurboMask;
+    uint8_t ui8TurboHz;
+
+    //
+    // GAMEPAD_CONFIG_OPT_x flags.
+    //
+    uint8_t ui8Options;
+
+    //
+    // The raw ADC minimum, center and maximum of the X and Y axes.
+    //
+    uint16_t ppui16Cal[2][3];
+}
+tGamepadConfig;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void ConfigInit(void);
+extern void ConfigProcess(void);
+extern bool ConfigStage(const uint8_t *pui8Status, uint32_t ui32Size);
+extern const tGamepadConfig *ConfigSwap(void);
+extern const tGamepadConfig *ConfigGet(void);
+extern void ConfigStatusBuild(uint8_t *pui8Status);
+extern uint16_t ConfigButtonsMap(const tGamepadConfig *psConfig,
+                                 uint16_t ui16Inputs);
+extern uint16_t ConfigButtonsApply(const tGamepadConfig *psConfig,
+                                   uint16_t ui16Inputs);
+extern uint32_t ConfigAxis(const tGamepadConfig *psConfig, uint32_t ui32Axis,
+                           uint32_t ui32Raw);
+
+#endif
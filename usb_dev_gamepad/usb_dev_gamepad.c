@@ -42,8 +42,22 @@
 #include "usblib/device/usbdevice.h"
 #include "usblib/device/usbdhid.h"
 #include "usblib/device/usbdhidgamepad.h"
+#include "usb_gamepad_report.h"
 #include "usb_gamepad_structs.h"
+#include "usb_sof_sync.h"
+#include "usb_hires.h"
+#include "usb_hid_fast.h"
+#include "usb_telemetry.h"
+#include "usb_lcd_push.h"
+#include "usb_keyboard.h"
+#include "usb_power.h"
+#include "usb_config.h"
+#include "usb_latency.h"
+#include "lcd_queue.h"
+#include "lcd_view.h"
+#include "timestamp.h"
 #include "drivers/buttons.h"
+#include "button_map.h"
 #include "utils/uartstdio.h"
 #include "ST7735.h"
 #include "PLL.h"
@@ -83,6 +97,9 @@
 //! Button12 - PF0
 //! BUTTON13 - PF4
 //! BUTTON14 - PA4
+//! With GAMEPAD_PLAYERS set to 2, a second gamepad interface reports player
+//! two's buttons on PD0-PD3, PD6, PD7, PE0, PE4 and PE5.  The pin tables are
+//! in button_map.c.
 //! The X, Y, and Z coordinates are
 //! reported using the ADC input on GPIO port E pins 1, 2, and 3.  The X input
 //! is on PE3, the Y input is on PE2 and the Z input is on PE1.  These are
@@ -95,28 +112,113 @@
 
 //*****************************************************************************
 //
-// The HID gamepad report that is returned to the host.
+// The HID gamepad polled ADC data for the X/Y/Z coordinates.
 //
 //*****************************************************************************
-static tGamepadReport sReport;
+static uint32_t g_pui32ADCData[3];
 
-typedef struct
-{
-    uint16_t i16XPos;
-    uint16_t i16YPos;
-    uint16_t i16RXPos;
-    uint16_t i16RYPos;
-    uint16_t ui16Buttons;
-}
-PACKED tCustomReport;
 //*****************************************************************************
 //
-// The HID gamepad polled ADC data for the X/Y/Z coordinates.
+// The HID gamepad report that is sent to the host, both as fields and in the
+// packed form described by the report descriptor.
 //
 //*****************************************************************************
-static uint32_t g_pui32ADCData[3];
+static tGamepadReportFields g_sReportFields;
+static uint8_t g_pui8Report[GAMEPAD_REPORT_SIZE];
+
+//*****************************************************************************
+//
+// The status feature report, and the buffer the host writes it into.  A
+// polling interval change requested by the host is applied from the main
+// loop since it involves re-enumerating.
+//
+//*****************************************************************************
+static uint8_t g_pui8Status[GAMEPAD_STATUS_SIZE];
+static uint8_t g_pui8StatusIn[GAMEPAD_STATUS_SIZE];
+static volatile uint32_t g_ui32IntervalRequest;
+
+//*****************************************************************************
+//
+// An activity counter to slow the LED blink down to a visible rate.
+//
+//*****************************************************************************
+static uint32_t g_ui32Updates;
+
+//*****************************************************************************
+//
+// The latest button state, for the input view.
+//
+//*****************************************************************************
+static volatile uint16_t g_ui16ButtonState;
+
+#if GAMEPAD_PLAYERS > 1
+//*****************************************************************************
+//
+// Player two's report, its latest buttons from the shared sampling pass and
+// whether they have changed since its last report was sent.  Player two has
+// no axes, high resolution history or trace fields, so those stay at rest.
+//
+//*****************************************************************************
+static tGamepadReportFields g_sReport2Fields;
+static uint8_t g_pui8Report2[GAMEPAD_REPORT_SIZE];
+static uint16_t g_ui16Player2Buttons;
+static bool g_bPlayer2Changed;
+static volatile bool g_bPlayer2Idle;
+#endif
+
+#if GAMEPAD_TRACE
+//*****************************************************************************
+//
+// Latency trace state: the sequence number of the next report and the time
+// the oldest button change not yet reported was first seen, or 0 if none.
+//
+//*****************************************************************************
+static uint16_t g_ui16TraceSeq;
+static uint32_t g_ui32TraceEdgeUs;
+#endif
+
+//*****************************************************************************
+//
+// Status changes raised by the USB event handler.  The main loop reports them
+// on the UART and LCD so that no slow output happens in interrupt context.
+//
+//*****************************************************************************
+#define FLAG_CONNECTED          0
+#define FLAG_DISCONNECTED       1
+#define FLAG_SUSPENDED          2
+#define FLAG_RESUMED            3
+static volatile uint32_t g_ui32StatusFlags;
+
+//*****************************************************************************
+//
+// Set once button 15 has switched the display to the input visualizer.
+//
+//*****************************************************************************
+static bool g_bViewMode;
 
+//*****************************************************************************
+//
+// Set while the LCD shows the stick oscilloscope.
+//
+//*****************************************************************************
+static bool g_bScopeMode;
 
+//*****************************************************************************
+//
+// Boot timing.  The LCD is initialized in the background from the main loop
+// so that the USB device goes on the bus first, and is set once it is ready.
+// Times are measured from g_ui32BootStart, the cycle count once main() has
+// set the final clock, and are 0 until the host has configured the device
+// and collected the first report.  A first report later than
+// GAMEPAD_BOOT_TIMEOUT_MS is not timed, since the cycle counter could have
+// wrapped.
+//
+//*****************************************************************************
+#define GAMEPAD_BOOT_TIMEOUT_MS 60000
+static uint32_t g_ui32BootStart;
+static volatile uint32_t g_ui32BootConfiguredUs;
+static volatile uint32_t g_ui32BootReportUs;
+static bool g_bLCDReady;
 
 //*****************************************************************************
 //
@@ -148,6 +250,10 @@ volatile enum
 }
 g_iGamepadState;
 
+static void GamepadReportQueue(bool bForce);
+static void Gamepad2ReportQueue(bool bForce);
+static void GamepadStatusBuild(uint8_t *pui8Status);
+
 //*****************************************************************************
 //
 // The error routine that is called if the driver library encounters an error.
@@ -162,25 +268,41 @@ __error__(char *pcFilename, uint32_t ui32Line)
 
 //*****************************************************************************
 //
-// Macro used to convert the 12-bit unsigned values to an eight bit signed
-// value returned in the HID report.  This maps the values from the ADC that
-// range from 0 to 2047 over to 127 to -128.
+// The value reported for an axis at rest.
+//
+//*****************************************************************************
+#define AXIS_CENTER             512
+
+//*****************************************************************************
+//
+// Records the time since boot of an event, if it is the first.
 //
 //*****************************************************************************
-#define Convert8Bit(ui32Value)  ((int8_t)((0x7ff - ui32Value) >> 4))
+static void
+GamepadBootMark(volatile uint32_t *pui32Us)
+{
+    uint32_t ui32Us;
+
+    if(!*pui32Us)
+    {
+        ui32Us = TimestampToUs(TimestampGet() - g_ui32BootStart);
+        *pui32Us = ui32Us ? ui32Us : 1;
+    }
+}
 
 //*****************************************************************************
 //
-// Handles asynchronous events from the HID gamepad driver.
+// Handles asynchronous events from player one's HID interface, both the
+// receive events and the transmit completions.
 //
-// \param pvCBData is the event callback pointer provided during
-// USBDHIDGamepadInit().  This is a pointer to our gamepad device structure
+// \param pvCBData is the event callback pointer provided in the device
+// structure.  This is a pointer to our gamepad device structure
 // (&g_sGamepadDevice).
 // \param ui32Event identifies the event we are being called back for.
 // \param ui32MsgData is an event-specific value.
 // \param pvMsgData is an event-specific pointer.
 //
-// This function is called by the HID gamepad driver to inform the application
+// This function is called by the HID class driver to inform the application
 // of particular asynchronous events related to operation of the gamepad HID
 // device.
 //
@@ -198,13 +320,20 @@ GamepadHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
         //
         case USB_EVENT_CONNECTED:
         {
+            PowerWake();
             g_iGamepadState = eStateIdle;
+            SOFSyncReset();
+            GamepadBootMark(&g_ui32BootConfiguredUs);
+
+            //
+            // Get the first report on its way.
+            //
+            GamepadReportQueue(true);
 
             //
             // Update the status.
             //
-            UARTprintf("\nHost Connected...\n");
-            ST7735_OutString("\n  Host Connected...\n  MAME Controller\n  15 Buttons\n  Yellow:Print\n");
+            HWREGBITW(&g_ui32StatusFlags, FLAG_CONNECTED) = 1;
             break;
         }
 
@@ -213,13 +342,14 @@ GamepadHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
         //
         case USB_EVENT_DISCONNECTED:
         {
+            PowerWake();
             g_iGamepadState = eStateNotConfigured;
+            SOFSyncReset();
 
             //
             // Update the status.
             //
-            UARTprintf("\nHost Disconnected...\n");
-            ST7735_OutString("\nHost Disconnected...\n MAME Controller\n 14 Buttons\n");
+            HWREGBITW(&g_ui32StatusFlags, FLAG_DISCONNECTED) = 1;
             break;
         }
 
@@ -235,8 +365,23 @@ GamepadHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
             //
             g_iGamepadState = eStateIdle;
 
+            //
+            // The host just polled us, so let the SOF scheduler learn from
+            // it.
+            //
+            SOFSyncTxComplete();
+            PowerReportCollected();
+            LatencyCollected();
+            GamepadBootMark(&g_ui32BootReportUs);
+
             ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, 0);
 
+            //
+            // Queue the next report straight away from the latest inputs.
+            //
+            GamepadReportQueue(false);
+            Gamepad2ReportQueue(false);
+
             break;
         }
 
@@ -246,14 +391,16 @@ GamepadHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
         case USB_EVENT_SUSPEND:
         {
             //
-            // Go to the suspended state.
+            // Go to the suspended state.  The main loop goes to sleep.
             //
             g_iGamepadState = eStateSuspend;
+            SOFSyncReset();
+            PowerSuspend();
 
             //
             // Suspended.
             //
-            UARTprintf("\nBus Suspended\n");
+            HWREGBITW(&g_ui32StatusFlags, FLAG_SUSPENDED) = 1;
 
             ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, 0);
 
@@ -266,14 +413,21 @@ GamepadHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
         case USB_EVENT_RESUME:
         {
             //
-            // Go back to the idle state.
+            // Get the clock back up first, then go back to the idle state.
             //
+            PowerResume();
             g_iGamepadState = eStateIdle;
+            SOFSyncReset();
 
             //
             // Resume signaled.
             //
-            UARTprintf("\nBus Resume\n");
+            HWREGBITW(&g_ui32StatusFlags, FLAG_RESUMED) = 1;
+
+            //
+            // Restart the report chain.
+            //
+            GamepadReportQueue(true);
 
             break;
         }
@@ -281,11 +435,65 @@ GamepadHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
         //
         // Return the pointer to the current report.  This call is
         // rarely if ever made, but is required by the USB HID
-        // specification.
+        // specification.  An idle period set by the host running out asks
+        // for the input report the same way.
         //
         case USBD_HID_EVENT_GET_REPORT:
+        case USBD_HID_EVENT_IDLE_TIMEOUT:
+        {
+            //
+            // The high byte of the message data is the report type.  The
+            // feature report carries the status.
+            //
+            if((ui32MsgData >> 8) == USB_HID_REPORT_FEATURE)
+            {
+                GamepadStatusBuild(g_pui8Status);
+                *(void **)pvMsgData = (void *)g_pui8Status;
+
+                return(GAMEPAD_STATUS_SIZE);
+            }
+
+            *(void **)pvMsgData = (void *)g_pui8Report;
+
+            return(GAMEPAD_REPORT_SIZE);
+        }
+
+        //
+        // The host is about to write a report on the control endpoint and
+        // needs somewhere to put it.  Only the feature report is writable.
+        //
+        case USBD_HID_EVENT_GET_REPORT_BUFFER:
+        {
+            if(((ui32MsgData >> 8) == USB_HID_REPORT_FEATURE) &&
+               ((uint32_t)pvMsgData <= GAMEPAD_STATUS_SIZE))
+            {
+                return((uint32_t)g_pui8StatusIn);
+            }
+
+            return(0);
+        }
+
+        //
+        // The host wrote the feature report.  Pick up a polling interval
+        // change for the main loop to apply, switch the input mode straight
+        // away and stage any new configuration for the next report.
+        //
+        case USBD_HID_EVENT_SET_REPORT:
         {
-            *(void **)pvMsgData = (void *)&sReport;
+            if(ui32MsgData > GAMEPAD_STATUS_O_INTERVAL)
+            {
+                g_ui32IntervalRequest =
+                    g_pui8StatusIn[GAMEPAD_STATUS_O_INTERVAL];
+            }
+
+            if((ui32MsgData > GAMEPAD_STATUS_O_MODE) &&
+               g_pui8StatusIn[GAMEPAD_STATUS_O_MODE])
+            {
+                KeyboardModeSet(g_pui8StatusIn[GAMEPAD_STATUS_O_MODE] ==
+                                GAMEPAD_STATUS_MODE_KEYBOARD);
+            }
+
+            ConfigStage(g_pui8StatusIn, ui32MsgData);
 
             break;
         }
@@ -301,7 +509,105 @@ GamepadHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
 
     return(0);
 }
-void printButton();
+
+//*****************************************************************************
+//
+// Handles asynchronous events from player two's HID gamepad interface.
+//
+// Connection and suspend are reported on the status flags by player one's
+// handler, so this only tracks whether player two's endpoint is free.
+//
+// \return Returns 0 except for a report request.
+//
+//*****************************************************************************
+#if GAMEPAD_PLAYERS > 1
+uint32_t
+Gamepad2Handler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+                void *pvMsgData)
+{
+    switch (ui32Event)
+    {
+        //
+        // Send the current buttons as soon as the host is ready for them.
+        //
+        case USB_EVENT_CONNECTED:
+        case USB_EVENT_RESUME:
+        {
+            g_bPlayer2Idle = true;
+            Gamepad2ReportQueue(true);
+            break;
+        }
+
+        case USB_EVENT_DISCONNECTED:
+        case USB_EVENT_SUSPEND:
+        {
+            g_bPlayer2Idle = false;
+            break;
+        }
+
+        //
+        // The host collected the last report, so a change that arrived
+        // meanwhile can go straight out.
+        //
+        case USB_EVENT_TX_COMPLETE:
+        {
+            g_bPlayer2Idle = true;
+            Gamepad2ReportQueue(false);
+            break;
+        }
+
+        case USBD_HID_EVENT_GET_REPORT:
+        case USBD_HID_EVENT_IDLE_TIMEOUT:
+        {
+            *(void **)pvMsgData = (void *)g_pui8Report2;
+
+            return(GAMEPAD_REPORT_SIZE);
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+#endif
+
+//*****************************************************************************
+//
+// Sends player two's report if the endpoint is free and the buttons changed.
+//
+// This is called right after every chance player one gets to send, from the
+// same pass that sampled both players, and on player two's own TX_COMPLETE.
+// Keyboard mode only covers player one, so player two stays a gamepad.
+// Both interrupt endpoints are then armed ahead of each host poll, so both
+// players see the full polling rate.  Like player one's, this only runs from
+// the USB and Timer0A interrupts.
+//
+// \param bForce sends a report even if the buttons have not changed.
+//
+//*****************************************************************************
+static void
+Gamepad2ReportQueue(bool bForce)
+{
+#if GAMEPAD_PLAYERS > 1
+    if(!g_bPlayer2Idle || (!g_bPlayer2Changed && !bForce))
+    {
+        return;
+    }
+
+    g_sReport2Fields.ui32Buttons = g_ui16Player2Buttons;
+    GamepadReportPack(&g_sReport2Fields, g_pui8Report2);
+
+    if(HIDFastSend(&g_sGamepad2Device, g_pui8Report2, GAMEPAD_REPORT_SIZE))
+    {
+        g_bPlayer2Changed = false;
+        g_bPlayer2Idle = false;
+    }
+#endif
+}
+
 //*****************************************************************************
 //
 // Configure the UART and its pins.  This must be called before UARTprintf().
@@ -388,500 +694,931 @@ ADCInit(void)
     ROM_ADCSequenceEnable(ADC0_BASE, 0);
 }
 
+#if GAMEPAD_TRACE
 //*****************************************************************************
 //
-// This is the main loop that runs the application.
+// Returns the device time for the trace fields, which never reads 0.
 //
 //*****************************************************************************
-int
-main(void)
+static uint32_t
+GamepadTraceUs(void)
 {
-    PLL_Init();
-    ST7735_InitR(INITR_REDTAB);
-    ST7735_SetCursor(0,0);
-    ST7735_FillScreen(0);
-  //  uint8_t red, green, blue;
- //*****************************************************************************
- //
- // The HID gamepad report that is returned to the host.
- //
- //*****************************************************************************
-    static tCustomReport sReportA;
+    uint32_t ui32Us;
+
+    ui32Us = TimestampUsGet();
+
+    return(ui32Us ? ui32Us : 1);
+}
+#endif
+
 //*****************************************************************************
 //
-// An activity counter to slow the LED blink down to a visible rate.
+// Samples the buttons and the ADC and rebuilds g_sReportFields from them.
+// A configuration written by the host since the last pass takes effect
+// here, so no report mixes two configurations.
+//
+// \return Returns true if anything changed since the last call.
 //
 //*****************************************************************************
-    static uint32_t g_ui32Updates;
-    uint16_t ui16ButtonsChanged, ui16Buttons;
+static bool
+GamepadReportBuild(void)
+{
+    const tGamepadConfig *psConfig;
+    uint16_t pui16ButtonsChanged[BUTTON_MAP_PLAYERS];
+    uint16_t pui16Buttons[BUTTON_MAP_PLAYERS];
+    uint16_t ui16Report;
     bool bUpdate;
 
     //
-    // Set the clocking to run from the PLL at 50MHz
+    // No update by default.
     //
-    ROM_SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN |
-                       SYSCTL_XTAL_16MHZ);
+    bUpdate = false;
+
+    psConfig = ConfigSwap();
 
     //
-    // Enable the GPIO port that is used for the on-board LED.
+    // See if the buttons updated.  One pass samples every player.
     //
-    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
+    ButtonsPoll(pui16ButtonsChanged, pui16Buttons);
+
+#if GAMEPAD_PLAYERS > 1
+    if(pui16Buttons[1] != g_ui16Player2Buttons)
+    {
+        g_ui16Player2Buttons = pui16Buttons[1];
+        g_bPlayer2Changed = true;
+    }
+#endif
 
     //
-    // Enable the GPIO pin for the Blue LED (PF2).
+    // Map the inputs to report buttons and apply debounce and turbo.
+    // Those can change the buttons between input changes, so compare with
+    // the last report as well.
     //
-    ROM_GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE, GPIO_PIN_3);
+    ui16Report = ConfigButtonsApply(psConfig, pui16Buttons[0]);
+    if(ui16Report != g_ui16ButtonState)
+    {
+        bUpdate = true;
+    }
+    g_ui16ButtonState = ui16Report;
 
     //
-    // Open UART0 and show the application name on the UART.
+    // In keyboard mode the buttons are sent as keys instead.
     //
-    ConfigureUART();
+    KeyboardUpdate(ui16Report);
+    if(KeyboardModeGet())
+    {
+        ui16Report = 0;
+    }
 
-    UARTprintf("\033[2JTiva C Series USB gamepad device example\n");
-    UARTprintf("---------------------------------\n\n");
+    LatencyInput(pui16Buttons[0], ui16Report);
 
+#if GAMEPAD_TRACE
     //
-    // Not configured initially.
+    // Remember when the oldest change since the last report was seen.
     //
-    g_iGamepadState = eStateNotConfigured;
+    if((ui16Report != g_sReportFields.ui32Buttons) && !g_ui32TraceEdgeUs)
+    {
+        g_ui32TraceEdgeUs = GamepadTraceUs();
+    }
+#endif
 
-    //
-    // Enable the GPIO peripheral used for USB, and configure the USB
-    // pins.
-    //
-    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
-    SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOD);
-    ROM_GPIOPinTypeUSBAnalog(GPIO_PORTD_AHB_BASE, GPIO_PIN_4 | GPIO_PIN_5);
+    g_sReportFields.ui32Buttons = ui16Report;
 
-    //
-    // Configure the GPIOS for the buttons.
-    //
-    ButtonsInit();
+    if(pui16ButtonsChanged[0])
+    {
+        bUpdate = true;
+    }
 
     //
-    // Initialize the ADC channels.
+    // See if the ADC updated.
     //
-    ADCInit();
+    if(ADCIntStatus(ADC0_BASE, 0, false) != 0)
+    {
+        //
+        // Clear the ADC interrupt.
+        //
+        ADCIntClear(ADC0_BASE, 0);
 
-    //
-    // Tell the user what we are up to.
-    //
-    UARTprintf("Configuring USB\n");
+        //
+        // Read the data and trigger a new sample request.
+        //
+        ADCSequenceDataGet(ADC0_BASE, 0, &g_pui32ADCData[0]);
+        ADCProcessorTrigger(ADC0_BASE, 0);
 
-    //
-    // Set the USB stack mode to Device mode.
-    //
-    USBStackModeSet(0, eUSBModeForceDevice, 0);
+        //
+        // Update the report.
+        //
+        if(psConfig->ui8Options & GAMEPAD_CONFIG_OPT_NO_AXES)
+        {
+            g_sReportFields.ui16X = AXIS_CENTER;
+            g_sReportFields.ui16Y = AXIS_CENTER;
+        }
+        else
+        {
+            g_sReportFields.ui16X = ConfigAxis(psConfig, 0,
+                                               g_pui32ADCData[0]);
+            g_sReportFields.ui16Y = ConfigAxis(psConfig, 1,
+                                               g_pui32ADCData[1]);
+        }
+        bUpdate = true;
+    }
 
-    //
-    // Pass the device information to the USB library and place the device
-    // on the bus.
-    //
-    USBDHIDGamepadInit(0, &g_sGamepadDevice);
+    return(bUpdate);
+}
 
+//*****************************************************************************
+//
+// Packs g_sReportFields, hands it to the USB stack and blinks the activity
+// LED.
+//
+// This is only called from the USB and Timer0A interrupts, which share a
+// priority, so the state change needs no further protection.
+//
+//*****************************************************************************
+static void
+GamepadReportSend(void)
+{
+#if GAMEPAD_HIRES
     //
-    // Zero out the initial report.
+    // Take the button history as late as possible so that the newest slot
+    // is as fresh as the rest of the report.
     //
-    sReport.ui8Buttons = 0;
-    sReport.i8XPos = 0;
-    sReport.i8YPos = 0;
-    sReport.i8ZPos = 0;
+    HiresFill(&g_sReportFields);
+#endif
+
+#if GAMEPAD_TRACE
+    g_sReportFields.pui16TraceSeq[0] = g_ui16TraceSeq;
+    GamepadTraceTimeSet(g_sReportFields.pui16TraceEdgeUs, g_ui32TraceEdgeUs);
+    GamepadTraceTimeSet(g_sReportFields.pui16TraceSentUs, GamepadTraceUs());
+#endif
+
+    GamepadReportPack(&g_sReportFields, g_pui8Report);
+    LatencyEncoded();
+
+    if(!HIDFastSend(&g_sGamepadDevice, g_pui8Report, GAMEPAD_REPORT_SIZE))
+    {
+        return;
+    }
+    LatencySubmitted();
+
+#if GAMEPAD_TRACE
     //
-    // Initialize the reports to 0.
+    // The report is on its way, so its edge has been reported.
     //
-    sReportA.ui16Buttons = 0;
-    sReportA.i16XPos = 0;
-    sReportA.i16YPos = 0;
-    sReportA.i16RXPos = 0;
-    sReportA.i16YPos = 0;
+    g_ui16TraceSeq++;
+    g_ui32TraceEdgeUs = 0;
+#endif
+
+    g_iGamepadState = eStateSending;
+    PowerReportSent();
+
     //
-    // Tell the user what we are doing and provide some basic instructions.
+    // Limit the blink rate of the LED.
     //
-    UARTprintf("\nWaiting For Host...\n");
+    if(g_ui32Updates++ == 40)
+    {
+        //
+        // Turn on the Green LED.
+        //
+        ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, GPIO_PIN_3);
+
+        //
+        // Reset the update count.
+        //
+        g_ui32Updates = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Called by the high resolution sampler from the Timer1A interrupt.  The
+// history carries the mapped buttons, without debounce or turbo.  Timer1A
+// preempts the USB interrupt, so the configuration cannot change under it.
+//
+//*****************************************************************************
+static uint16_t
+GamepadHiresSample(void)
+{
+    return(ConfigButtonsMap(ConfigGet(), ButtonsRead(0)));
+}
+
+//*****************************************************************************
+//
+// Called by the SOF scheduler from the Timer0A interrupt just ahead of the
+// next host poll.  A report is always sent, even if nothing changed, so that
+// every poll carries the freshest possible sample and keeps the poll phase
+// measurement up to date.
+//
+// \return Returns true if a report was queued.
+//
+//*****************************************************************************
+static bool
+GamepadSOFSyncSample(void)
+{
+    if(g_iGamepadState != eStateIdle)
+    {
+        return(false);
+    }
+
+    GamepadReportBuild();
+    GamepadReportSend();
+    Gamepad2ReportQueue(false);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Builds and queues the next report from the USB event path.  This runs on
+// TX_COMPLETE, so a new report is waiting as soon as the previous one has
+// been collected, and on every SOF to pick up changes while the endpoint is
+// idle.  Once the SOF scheduler has locked on to the host's polling it owns
+// report submission and this does nothing.
+//
+// \param bForce sends a report even if the inputs have not changed.  With
+// the high resolution report every opportunity is taken regardless, since
+// each report carries button history that the host would otherwise lose.
+// The trace fields do the same so that the host always has fresh device
+// times to track the clock offset with.
+//
+//*****************************************************************************
+static void
+GamepadReportQueue(bool bForce)
+{
+    if((g_iGamepadState != eStateIdle) || SOFSyncActive())
+    {
+        return;
+    }
 
     //
-    // Trigger an initial ADC sequence.
+    // Send the report if there was an update, or always if the host asked
+    // for that.
     //
-    ADCProcessorTrigger(ADC0_BASE, 0);
+    if(ConfigGet()->ui8Options & GAMEPAD_CONFIG_OPT_ALWAYS)
+    {
+        bForce = true;
+    }
 
-    //
-    // The main loop starts here.  We begin by waiting for a host connection
-    // then drop into the main gamepad handling section.  If the host
-    // disconnects, we return to the top and wait for a new connection.
+    if(GamepadReportBuild() || bForce || GAMEPAD_HIRES || GAMEPAD_TRACE)
+    {
+        GamepadReportSend();
+    }
+}
 
+//*****************************************************************************
+//
+// Called by the SOF scheduler on every new frame.
+//
+//*****************************************************************************
+static void
+GamepadFrame(void)
+{
+    GamepadReportQueue(false);
+    Gamepad2ReportQueue(false);
+}
 
+//*****************************************************************************
+//
+// Shows status changes raised by the USB event handler.
+//
+//*****************************************************************************
+static void
+GamepadStatusShow(void)
+{
+    if(HWREGBITW(&g_ui32StatusFlags, FLAG_CONNECTED))
+    {
+        HWREGBITW(&g_ui32StatusFlags, FLAG_CONNECTED) = 0;
+        TelemetryPrintf("\nHost Connected...\n");
+        if(!g_bViewMode && !g_bScopeMode)
+        {
+            ST7735_OutString("\n  Host Connected...\n  MAME Controller\n  15 Buttons\n  Yellow:Inputs\n");
+        }
+    }
 
+    if(HWREGBITW(&g_ui32StatusFlags, FLAG_DISCONNECTED))
+    {
+        HWREGBITW(&g_ui32StatusFlags, FLAG_DISCONNECTED) = 0;
+        TelemetryPrintf("\nHost Disconnected...\n");
+        if(!g_bViewMode && !g_bScopeMode)
+        {
+            ST7735_OutString("\nHost Disconnected...\n MAME Controller\n 14 Buttons\n");
+        }
+    }
 
+    if(HWREGBITW(&g_ui32StatusFlags, FLAG_SUSPENDED))
+    {
+        HWREGBITW(&g_ui32StatusFlags, FLAG_SUSPENDED) = 0;
+        TelemetryPrintf("\nBus Suspended\n");
+    }
 
-    //
-    while(1)
+    if(HWREGBITW(&g_ui32StatusFlags, FLAG_RESUMED))
     {
+        HWREGBITW(&g_ui32StatusFlags, FLAG_RESUMED) = 0;
+        TelemetryPrintf("\nBus Resume\n");
+    }
+}
 
+//*****************************************************************************
+//
+// Once a second, shows the achieved report rate on the bottom line of the
+// LCD and prints it with the SOF phase error statistics on the UART.  The
+// line above shows the median and 99th percentile time from a button change
+// being sampled to the host collecting it.  The LCD lines go through the
+// drawing queue.
+//
+//*****************************************************************************
+static void
+GamepadStatsPrint(void)
+{
+    static uint32_t ui32Last;
+    tSOFSyncStats sStats;
+    tHIDSendStats sSendStats;
+    tLatencyHist sLatency;
+    tLCDQueueStats sQueue;
+    uint32_t ui32Now, ui32Path, ui32Sent, ui32Saved;
+    char pcLine[22];
+
+    ui32Now = TimestampGet();
+    if((ui32Now - ui32Last) < TimestampFromUs(1000000))
+    {
+        return;
+    }
+    ui32Last = ui32Now;
 
-        //
-        // Wait here until USB device is connected to a host.
-        //
-        if(g_iGamepadState == eStateIdle)
+    if(g_iGamepadState == eStateNotConfigured)
+    {
+        return;
+    }
+
+    SOFSyncStatsGet(&sStats);
+
+    snprintf(pcLine, sizeof(pcLine), "Rate %4uHz bInt %2ums",
+             (unsigned int)sStats.ui32ReportRateHz,
+             (unsigned int)GamepadPollIntervalGet());
+    LCDQueueText(0, 15, pcLine, ST7735_YELLOW);
+
+    LatencyHistGet(LATENCY_STAGE_TOTAL, &sLatency);
+    if(sLatency.ui32Count)
+    {
+        snprintf(pcLine, sizeof(pcLine), "Lat%5u p99%5u us",
+                 (unsigned int)LatencyPercentileUs(&sLatency, 50),
+                 (unsigned int)LatencyPercentileUs(&sLatency, 99));
+        LCDQueueText(0, 14, pcLine, ST7735_YELLOW);
+    }
+
+    TelemetryPrintf("Rate: %dHz reports, %dHz SOF, bInterval %dms\n",
+                    sStats.ui32ReportRateHz, sStats.ui32SOFRateHz,
+                    GamepadPollIntervalGet());
+
+    for(ui32Path = 0; ui32Path < HID_SEND_PATHS; ui32Path++)
+    {
+        HIDFastStatsGet(ui32Path, &sSendStats);
+        if(sSendStats.ui32Count)
         {
-            //
-            // No update by default.
-            //
-            bUpdate = false;
+            TelemetryPrintf("Send %s: %d/%d/%d cycles (min/avg/max) "
+                            "over %d\n",
+                            (ui32Path == HID_SEND_FAST) ? "fast  " : "usblib",
+                            sSendStats.ui32MinCycles,
+                            sSendStats.ui32AvgCycles,
+                            sSendStats.ui32MaxCycles, sSendStats.ui32Count);
+        }
+    }
 
-            //
-            // See if the buttons updated.
-            //
-            ButtonsPoll(&ui16ButtonsChanged, &ui16Buttons);
+    LCDQueueStatsGet(&sQueue);
+    TelemetryPrintf("LCD queue: %d commands, %d bytes waiting (max %d), "
+                    "%d coalesced, %d refused\n", sQueue.ui32Commands,
+                    sQueue.ui32BacklogBytes, sQueue.ui32MaxBacklogBytes,
+                    sQueue.ui32Coalesced, sQueue.ui32Refused);
 
-            sReportA.ui16Buttons = 0;
-            //Button0
-            if(ui16Buttons & BUTTON0)
-            {
-                sReportA.ui16Buttons |= 0x0001;
+    ST7735_TransferStats(&ui32Sent, &ui32Saved);
+    TelemetryPrintf("LCD SPI: %d bytes sent, %d window setup bytes saved\n",
+                    ui32Sent, ui32Saved);
 
-            }
-            //Button1
-            if(ui16Buttons & BUTTON1)
-            {
-                sReportA.ui16Buttons |= 0x0002;
+    if(!SOFSyncActive())
+    {
+        return;
+    }
 
-            }
-            //Button2
-            if(ui16Buttons & BUTTON2)
-            {
-                sReportA.ui16Buttons |= 0x0004;
+    TelemetryPrintf("SOF sync: poll %dus/%dms work %dus err %d/%d/%d us "
+                    "(last/min/max) avg %dus late %d missed %d of %d\n",
+                    sStats.ui32PollPhaseUs, sStats.ui32PollInterval,
+                    sStats.ui32WorkUs, sStats.i32LastErrorUs,
+                    sStats.i32MinErrorUs, sStats.i32MaxErrorUs,
+                    sStats.ui32AvgAbsErrorUs, sStats.ui32Late,
+                    sStats.ui32Missed, sStats.ui32Reports);
+}
 
-            }
-            //Button3
-            if(ui16Buttons & BUTTON3)
-            {
-                sReportA.ui16Buttons |= 0x0008;
+//*****************************************************************************
+//
+// Fills in the status feature report.
+//
+//*****************************************************************************
+static void
+GamepadStatusBuild(uint8_t *pui8Status)
+{
+    tSOFSyncStats sStats;
+    uint32_t ui32Idx;
 
-            }
-            //Button4
-            if(ui16Buttons & BUTTON4)
-            {
-                sReportA.ui16Buttons |= 0x0010;
+    SOFSyncStatsGet(&sStats);
 
-            }
-            //Button5
-            if(ui16Buttons & BUTTON5)
-            {
-                sReportA.ui16Buttons |= 0x0020;
+    for(ui32Idx = 0; ui32Idx < GAMEPAD_STATUS_SIZE; ui32Idx++)
+    {
+        pui8Status[ui32Idx] = 0;
+    }
 
-            }
-            //Button6
-            if(ui16Buttons & BUTTON6)
-            {
-                sReportA.ui16Buttons |= 0x0040;
+    pui8Status[GAMEPAD_STATUS_O_VERSION] = GAMEPAD_STATUS_VERSION;
+    pui8Status[GAMEPAD_STATUS_O_INTERVAL] = (uint8_t)GamepadPollIntervalGet();
+    pui8Status[GAMEPAD_STATUS_O_REPORT_HZ] = sStats.ui32ReportRateHz;
+    pui8Status[GAMEPAD_STATUS_O_REPORT_HZ + 1] = sStats.ui32ReportRateHz >> 8;
+    pui8Status[GAMEPAD_STATUS_O_SOF_HZ] = sStats.ui32SOFRateHz;
+    pui8Status[GAMEPAD_STATUS_O_SOF_HZ + 1] = sStats.ui32SOFRateHz >> 8;
+    pui8Status[GAMEPAD_STATUS_O_PHASE_US] = sStats.ui32PollPhaseUs;
+    pui8Status[GAMEPAD_STATUS_O_PHASE_US + 1] = sStats.ui32PollPhaseUs >> 8;
+    pui8Status[GAMEPAD_STATUS_O_ERROR_US] = sStats.ui32AvgAbsErrorUs;
+    pui8Status[GAMEPAD_STATUS_O_ERROR_US + 1] = sStats.ui32AvgAbsErrorUs >> 8;
+    pui8Status[GAMEPAD_STATUS_O_MISSED] = sStats.ui32Missed;
+    pui8Status[GAMEPAD_STATUS_O_MISSED + 1] = sStats.ui32Missed >> 8;
+    pui8Status[GAMEPAD_STATUS_O_REPORTS] = sStats.ui32Reports;
+    pui8Status[GAMEPAD_STATUS_O_REPORTS + 1] = sStats.ui32Reports >> 8;
+    pui8Status[GAMEPAD_STATUS_O_REPORTS + 2] = sStats.ui32Reports >> 16;
+    pui8Status[GAMEPAD_STATUS_O_REPORTS + 3] = sStats.ui32Reports >> 24;
+    pui8Status[GAMEPAD_STATUS_O_MODE] =
+        KeyboardModeGet() ? GAMEPAD_STATUS_MODE_KEYBOARD :
+                            GAMEPAD_STATUS_MODE_GAMEPAD;
+
+    ConfigStatusBuild(pui8Status);
+}
 
-            }
-            //Button7
-            if(ui16Buttons & BUTTON7)
-            {
-                sReportA.ui16Buttons |= 0x0080;
+//*****************************************************************************
+//
+// Applies a polling interval change requested by the host.
+//
+//*****************************************************************************
+static void
+GamepadIntervalCheck(void)
+{
+    uint32_t ui32Interval;
 
-            }
-            //Button8
-            if( (ui16Buttons>>8) & 0x01)
-            {
-                sReportA.ui16Buttons |= 0x0100;
+    ui32Interval = g_ui32IntervalRequest;
+    if(ui32Interval == 0)
+    {
+        return;
+    }
+    g_ui32IntervalRequest = 0;
 
-            }
-            //Button9
-            if((ui16Buttons>>8) & 0x02)
-            {
-                sReportA.ui16Buttons |= 0x0200;
+    if(ui32Interval == GamepadPollIntervalGet())
+    {
+        return;
+    }
 
-            }
-            //Button10
-            if((ui16Buttons>>8) & 0x04)
-            {
-                sReportA.ui16Buttons |= 0x0400;
+    if(GamepadPollIntervalSet(ui32Interval))
+    {
+        TelemetryPrintf("\nPolling interval %dms, re-enumerating\n",
+                        ui32Interval);
+    }
+    else
+    {
+        TelemetryPrintf("\nPolling interval %dms out of range\n",
+                        ui32Interval);
+    }
+}
 
-            }
-            //Button11
-            if((ui16Buttons>>8) & 0x08)
-            {
-                sReportA.ui16Buttons |= 0x0800;
+//*****************************************************************************
+//
+// Set GAMEPAD_LCD_SCOPE to 1 to show the raw X and Y ADC readings on the LCD
+// as a scrolling oscilloscope instead of the console, one row every
+// GAMEPAD_LCD_SCOPE_US.  Each row is one address window and the scrolling is
+// done by the panel, so a row costs about 270 bytes of SPI whatever the
+// trace looks like.  Button 15 still switches to the input visualizer.
+//
+//*****************************************************************************
+#ifndef GAMEPAD_LCD_SCOPE
+#define GAMEPAD_LCD_SCOPE       0
+#endif
 
-            }
-            //Button12 - PF so negative logic
-            if(!((ui16Buttons>>8) & 0x10))
-            {
-                sReportA.ui16Buttons |= 0x1000;
+#ifndef GAMEPAD_LCD_SCOPE_US
+#define GAMEPAD_LCD_SCOPE_US    10000
+#endif
 
-            }
-            //Button13 - PF so negative logic
-            if(!((ui16Buttons>>8) & 0x20))
-            {
-                sReportA.ui16Buttons |= 0x2000;
+#if GAMEPAD_LCD_SCOPE
+//*****************************************************************************
+//
+// Adds a row to the oscilloscope once every GAMEPAD_LCD_SCOPE_US.  The ADC
+// words are written whole from interrupt context, so they can be read here
+// without locking.
+//
+//*****************************************************************************
+static void
+GamepadScopeProcess(void)
+{
+    static uint32_t ui32Last;
+    uint32_t ui32Now;
 
-            }
-            //Button14
-            if((ui16Buttons>>8) & 0x40)
-            {
-                sReportA.ui16Buttons |= 0x4000;
-                printButton();
+    if(!g_bScopeMode)
+    {
+        return;
+    }
 
-            }
+    ui32Now = TimestampGet();
+    if((ui32Now - ui32Last) < TimestampFromUs(GAMEPAD_LCD_SCOPE_US))
+    {
+        return;
+    }
+    ui32Last = ui32Now;
 
+    ST7735_ScopeSample(g_pui32ADCData[0], g_pui32ADCData[1]);
+}
+#endif
 
-            if(ui16ButtonsChanged)
-            {
-                bUpdate = true;
-            }
+//*****************************************************************************
+//
+// Set GAMEPAD_LCD_BENCH to 1 to measure the LCD fill rate at startup, first
+// the way the driver used to run the panel (8-bit frames and an SSI prescaler
+// of 10) and then with 16-bit pixel frames and the prescaler worked out from
+// the system clock.  The rates are printed on the telemetry output.
+//
+//*****************************************************************************
+#ifndef GAMEPAD_LCD_BENCH
+#define GAMEPAD_LCD_BENCH       0
+#endif
 
-            //
-            // See if the ADC updated.
-            //
-            if(ADCIntStatus(ADC0_BASE, 0, false) != 0)
+#if GAMEPAD_LCD_BENCH
+//*****************************************************************************
+//
+// The number of screens drawn for each rate.
+//
+//*****************************************************************************
+#define LCD_BENCH_SCREENS       4
+
+//*****************************************************************************
+//
+// Draws LCD_BENCH_SCREENS full screens, either solid fills or a row of
+// distinct pixels streamed line by line, and returns the rate in pixels per
+// second.  The time runs until the last pixel has left SSI0.
+//
+//*****************************************************************************
+static uint32_t
+LCDBenchRate(bool bSolid)
+{
+    static uint16_t pui16Row[ST7735_TFTWIDTH];
+    uint32_t ui32Start, ui32Cycles, ui32Screen, ui32Row;
+    uint64_t ui64Pixels;
+
+    for(ui32Row = 0; ui32Row < ST7735_TFTWIDTH; ui32Row++)
+    {
+        pui16Row[ui32Row] = ui32Row * 0x0421;
+    }
+
+    ST7735_Flush();
+    ui32Start = TimestampGet();
+
+    for(ui32Screen = 0; ui32Screen < LCD_BENCH_SCREENS; ui32Screen++)
+    {
+        if(bSolid)
+        {
+            ST7735_FillScreen((ui32Screen & 1) ? ST7735_WHITE : ST7735_BLACK);
+        }
+        else
+        {
+            ST7735_SetWindow(0, 0, ST7735_TFTWIDTH, ST7735_TFTHEIGHT);
+            for(ui32Row = 0; ui32Row < ST7735_TFTHEIGHT; ui32Row++)
             {
-                //
-                // Clear the ADC interrupt.
-                //
-                ADCIntClear(ADC0_BASE, 0);
-
-                //
-                // Read the data and trigger a new sample request.
-                //
-                ADCSequenceDataGet(ADC0_BASE, 0, &g_pui32ADCData[0]);
-                ADCProcessorTrigger(ADC0_BASE, 0);
-
-                //
-                // Update the report.
-                //
-                sReportA.i16XPos = Convert8Bit(g_pui32ADCData[0]);
-                sReportA.i16YPos = Convert8Bit(g_pui32ADCData[1]);
-                bUpdate = true;
+                ST7735_PushPixels(pui16Row, ST7735_TFTWIDTH);
             }
+        }
+    }
 
-            //
-            // Send the report if there was an update.
-            //
-            if(bUpdate)
-            {
+    ST7735_Flush();
+    ui32Cycles = TimestampGet() - ui32Start;
 
+    ui64Pixels = LCD_BENCH_SCREENS * ST7735_TFTWIDTH * ST7735_TFTHEIGHT;
+    return((uint32_t)((ui64Pixels * g_ui32TimestampCyclesPerUs * 1000000) /
+                      ui32Cycles));
+}
 
-                USBDHIDGamepadSendReport(&g_sGamepadDevice, &sReportA,
-                                         sizeof(sReportA));
-
-
-                //
-                // Now sending data but protect this from an interrupt since
-                // it can change in interrupt context as well.
-                //
-                IntMasterDisable();
-                g_iGamepadState = eStateSending;
-                IntMasterEnable();
-
-                //
-                // Limit the blink rate of the LED.
-                //
-                if(g_ui32Updates++ == 40)
-                {
-                    //
-                    // Turn on the Green LED.
-                    //
-                    ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, GPIO_PIN_3);
-
-                    //
-                    // Reset the update count.
-                    //
-                    g_ui32Updates = 0;
-                }
-            }
+//*****************************************************************************
+//
+// Prints the fill rates before and after the 16-bit frame and SPI clock
+// changes, then leaves the faster settings in place and clears the screen.
+//
+//*****************************************************************************
+static void
+LCDBenchmark(void)
+{
+    uint32_t ui32Clock, ui32SCLK;
+
+    ui32Clock = ROM_SysCtlClockGet();
+    TelemetryPrintf("LCD fill rate in pixels/s, solid and streamed\n");
+
+    ST7735_SetPixelFrames(8);
+    ui32SCLK = ST7735_SetSPIClock(ui32Clock, ui32Clock / 10);
+    TelemetryPrintf("  before:  8-bit frames, %8d Hz SPI: %7d %7d\n",
+                    ui32SCLK, LCDBenchRate(true), LCDBenchRate(false));
+
+    ST7735_SetPixelFrames(16);
+    ui32SCLK = ST7735_SetSPIClock(ui32Clock, ST7735_SCLK_MAX);
+    TelemetryPrintf("  after:  16-bit frames, %8d Hz SPI: %7d %7d\n",
+                    ui32SCLK, LCDBenchRate(true), LCDBenchRate(false));
+
+    ST7735_FillScreen(0);
+}
+#endif
+
+//*****************************************************************************
+//
+// Runs the input visualizer.  Button 15 switches the LCD from the console to
+// a live view of the buttons and the stick, which then stays up.  The view
+// redraws only what changed, at most once a frame and within a byte budget,
+// and never blocks, so it does not hold up the reports sent to the host.
+//
+//*****************************************************************************
+static void
+GamepadViewProcess(void)
+{
+    if(!g_bViewMode)
+    {
+        if(!(g_ui16ButtonState & 0x4000))
+        {
+            return;
         }
+
+        g_bViewMode = true;
+        g_bScopeMode = false;
+        ST7735_ConsoleOff();
+        ST7735_FillScreen(0);
+        LCDViewInit();
     }
+
+    LCDViewUpdate(g_ui16ButtonState, g_sReportFields.ui16X,
+                  g_sReportFields.ui16Y);
 }
 
-void printButton(){
-    //*****************************************************************************
+//*****************************************************************************
+//
+// Called from the main loop.  Steps the LCD initialization until the panel
+// is ready and then sets up the console or the scope on it.  Also prints the
+// boot times once the first report has been collected.
+//
+// \return Returns true once the LCD may be drawn on.
+//
+//*****************************************************************************
+static bool
+GamepadBootProcess(void)
+{
+    static bool bPrinted;
+    uint32_t ui32Ms;
+
+    ui32Ms = TimestampToUs(TimestampGet() - g_ui32BootStart) / 1000;
+
+    if(!bPrinted && g_ui32BootReportUs)
+    {
+        bPrinted = true;
+        TelemetryPrintf("Boot: configured after %dms, first report collected "
+                        "after %dms\n", g_ui32BootConfiguredUs / 1000,
+                        g_ui32BootReportUs / 1000);
+    }
+    else if(!bPrinted && (ui32Ms > GAMEPAD_BOOT_TIMEOUT_MS))
+    {
+        bPrinted = true;
+        TelemetryPrintf("Boot: no report collected within %dms\n",
+                        GAMEPAD_BOOT_TIMEOUT_MS);
+    }
+
+    if(g_bLCDReady)
+    {
+        return(true);
+    }
+
+    if(!ST7735_InitProcess(ui32Ms))
+    {
+        return(false);
+    }
+
+    g_bLCDReady = true;
+    TelemetryPrintf("LCD ready after %dms\n", ui32Ms);
+
+#if GAMEPAD_LCD_SCOPE
+    //
+    // Trace the stick under a one row legend, above the two status rows
+    // drawn by GamepadStatsPrint().
+    //
+    g_bScopeMode = ST7735_ScopeInit(1, 2, 0, 4095);
+    ST7735_DrawString(0, 0, "ADC X", ST7735_GREEN);
+    ST7735_DrawString(6, 0, "Y", ST7735_RED);
+#else
     //
-    // The HID gamepad report that is returned to the host.
+    // Log to the LCD through a scrolling console, above the two status rows
+    // drawn by GamepadStatsPrint().
     //
-    //*****************************************************************************
-       static tCustomReport sReportA;
-   //*****************************************************************************
-   //
-   // An activity counter to slow the LED blink down to a visible rate.
-   //
-   //*****************************************************************************
-       static uint32_t g_ui32Updates;
-       uint16_t ui16ButtonsChanged, ui16Buttons;
-       bool bUpdate;
-       ST7735_SetCursor(0,0);
-       ST7735_FillScreen(0);
-       ST7735_OutString("\n  PRINT BUTTON\n  Press Buttons\n");
+    ST7735_ConsoleInit(0, 2);
+#endif
+
+#if GAMEPAD_LCD_BENCH
+    LCDBenchmark();
+#endif
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// This is the main loop that runs the application.
+//
+//*****************************************************************************
+int
+main(void)
+{
+    PLL_Init();
 
-    while (1){
     //
-    // Wait here until USB device is connected to a host.
+    // Set the clocking to run from the PLL at 50MHz
     //
-    if(g_iGamepadState == eStateIdle)
-    {
-        //
-        // No update by default.
-        //
-        bUpdate = false;
+    ROM_SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN |
+                       SYSCTL_XTAL_16MHZ);
 
-        //
-        // See if the buttons updated.
-        //
-        ButtonsPoll(&ui16ButtonsChanged, &ui16Buttons);
+    //
+    // Start the cycle counter now that the clock is final.  Boot times are
+    // measured from here.
+    //
+    TimestampInit();
+    g_ui32BootStart = TimestampGet();
 
-        sReportA.ui16Buttons = 0;
+    //
+    // Start the LCD's reset.  Its initialization takes most of a second of
+    // delays, which GamepadBootProcess() steps through from the main loop
+    // so that the device is on the bus meanwhile.  The driver assumes
+    // PLL_Init()'s 80MHz, so run the SPI clock as fast as the panel allows
+    // at the real clock.
+    //
+    ST7735_InitRStart(INITR_REDTAB, 0);
+    ST7735_SetSPIClock(ROM_SysCtlClockGet(), ST7735_SCLK_MAX);
 
-        if(ui16Buttons & BUTTON0)
-        {
-            sReportA.ui16Buttons |= 0x0001;
-            ST7735_OutString("  Button1\r");
+    //
+    // Start the LCD drawing queue's ticks.
+    //
+    LCDQueueInit();
 
-        }
+    //
+    // Enable the GPIO port that is used for the on-board LED.
+    //
+    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
 
-        if(ui16Buttons & BUTTON1)
-        {
-            sReportA.ui16Buttons |= 0x0002;
-            ST7735_OutString("  Button2\r");
-        }
+    //
+    // Enable the GPIO pin for the Blue LED (PF2).
+    //
+    ROM_GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE, GPIO_PIN_3);
 
-        if(ui16Buttons & BUTTON2)
-        {
-            sReportA.ui16Buttons |= 0x0004;
-            ST7735_OutString("  Button3\r");
-        }
-        if(ui16Buttons & BUTTON3)
-        {
-            sReportA.ui16Buttons |= 0x0008;
-            ST7735_OutString("  Button4\r");
-        }
-        if(ui16Buttons & BUTTON4)
-        {
-            sReportA.ui16Buttons |= 0x0010;
-            ST7735_OutString("  Button5\r");
-        }
-        if(ui16Buttons & BUTTON5)
-        {
-            sReportA.ui16Buttons |= 0x0020;
-            ST7735_OutString("  Button6\r");
-        }
-        if(ui16Buttons & BUTTON6)
-        {
-            sReportA.ui16Buttons |= 0x0040;
-            ST7735_OutString("  Button7\r");
-        }
-        if(ui16Buttons & BUTTON7)
-        {
-            sReportA.ui16Buttons |= 0x0080;
-            ST7735_OutString("  Button8\r");
-        }
+    //
+    // Open UART0 and show the application name on the UART.
+    //
+    ConfigureUART();
 
-        if( (ui16Buttons>>8) & 0x01)
-        {
-            sReportA.ui16Buttons |= 0x0100;
-            ST7735_OutString("  Button9\r");
-        }
+    TelemetryPrintf("\033[2JTiva C Series USB gamepad device example\n");
+    TelemetryPrintf("---------------------------------\n\n");
 
-        if((ui16Buttons>>8) & 0x02)
-        {
-            sReportA.ui16Buttons |= 0x0200;
-            ST7735_OutString("  Button10\r");
-        }
-        if((ui16Buttons>>8) & 0x04)
-        {
-            sReportA.ui16Buttons |= 0x0400;
-            ST7735_OutString("  Button11\r");
-        }
-        if((ui16Buttons>>8) & 0x08)
-        {
-            sReportA.ui16Buttons |= 0x0800;
-            ST7735_OutString("  Button12\r");
-        }
-        if((ui16Buttons>>8) & 0x10)
-        {
-            sReportA.ui16Buttons |= 0x1000;
-            ST7735_OutString("  Button13\r");
-        }
-        if((ui16Buttons>>8) & 0x20)
-        {
-            sReportA.ui16Buttons |= 0x2000;
-            ST7735_OutString("  Button14\r");
-        }
+    //
+    // Not configured initially.
+    //
+    g_iGamepadState = eStateNotConfigured;
 
-        if((ui16Buttons>>8) & 0x40)
-        {
-            sReportA.ui16Buttons |= 0x4000;
-            ST7735_OutString("  Button15\r");
-        }
+    //
+    // Enable the GPIO peripheral used for USB, and configure the USB
+    // pins.
+    //
+    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
+    SysCtlGPIOAHBEnable(SYSCTL_PERIPH_GPIOD);
+    ROM_GPIOPinTypeUSBAnalog(GPIO_PORTD_AHB_BASE, GPIO_PIN_4 | GPIO_PIN_5);
 
+    //
+    // Configure the GPIOS for the buttons.
+    //
+    ButtonsInit(GAMEPAD_PLAYERS);
 
-        if(ui16ButtonsChanged)
-        {
-            bUpdate = true;
-        }
+    //
+    // Holding the keyboard mode buttons at power up starts in keyboard
+    // mode.
+    //
+    if((ButtonsRead(0) & KEYBOARD_BOOT_BUTTONS) ==
+       KEYBOARD_BOOT_BUTTONS)
+    {
+        KeyboardModeSet(true);
+    }
 
-        //
-        // See if the ADC updated.
-        //
-        if(ADCIntStatus(ADC0_BASE, 0, false) != 0)
-        {
-            //
-            // Clear the ADC interrupt.
-            //
-            ADCIntClear(ADC0_BASE, 0);
+    //
+    // Load the configuration the host last saved, if any.
+    //
+    ConfigInit();
 
-            //
-            // Read the data and trigger a new sample request.
-            //
-            ADCSequenceDataGet(ADC0_BASE, 0, &g_pui32ADCData[0]);
-            ADCProcessorTrigger(ADC0_BASE, 0);
+    //
+    // Initialize the ADC channels.
+    //
+    ADCInit();
 
-            //
-            // Update the report.
-            //
-            sReportA.i16XPos = Convert8Bit(g_pui32ADCData[0]);
-            sReportA.i16YPos = Convert8Bit(g_pui32ADCData[1]);
-            bUpdate = true;
-        }
+    //
+    // Initialize the report with the buttons released and the axes centered.
+    //
+    g_sReportFields.ui32Buttons = 0;
+    g_sReportFields.ui16X = AXIS_CENTER;
+    g_sReportFields.ui16Y = AXIS_CENTER;
+    g_sReportFields.ui16Z = AXIS_CENTER;
+    g_sReportFields.ui16RX = AXIS_CENTER;
+    GamepadReportPack(&g_sReportFields, g_pui8Report);
 
-        //
-        // Send the report if there was an update.
-        //
-        if(bUpdate)
-        {
+#if GAMEPAD_PLAYERS > 1
+    g_sReport2Fields = g_sReportFields;
+    GamepadReportPack(&g_sReport2Fields, g_pui8Report2);
+#endif
+
+    //
+    // Trigger an initial ADC sequence.  Reports are built from interrupt
+    // context as soon as the host connects, so this must happen before the
+    // device goes on the bus.
+    //
+    ADCProcessorTrigger(ADC0_BASE, 0);
 
+    //
+    // Set up the SOF scheduler before the device goes on the bus since the
+    // USB event handler calls into it.
+    //
+    SOFSyncInit(SOF_SYNC_LEAD_US, GamepadSOFSyncSample);
+    SOFSyncFrameHookSet(GamepadFrame);
 
-            USBDHIDGamepadSendReport(&g_sGamepadDevice, &sReportA,
-                                     sizeof(sReportA));
+#if GAMEPAD_HIRES
+    //
+    // Start sampling the buttons for the high resolution report.
+    //
+    HiresInit(GamepadHiresSample);
+#endif
 
+    //
+    // Prepare the telemetry channel.  Until a host opens it, output still
+    // goes to the UART.
+    //
+    TelemetryInit();
 
-            //
-            // Now sending data but protect this from an interrupt since
-            // it can change in interrupt context as well.
-            //
-            IntMasterDisable();
-            g_iGamepadState = eStateSending;
-            IntMasterEnable();
+    //
+    // Prepare the interface that lets a host draw on the LCD.
+    //
+    LCDPushInit();
 
-            //
-            // Limit the blink rate of the LED.
-            //
-            if(g_ui32Updates++ == 40)
-            {
-                //
-                // Turn on the Green LED.
-                //
-                ROM_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, GPIO_PIN_3);
-
-                //
-                // Reset the update count.
-                //
-                g_ui32Updates = 0;
-            }
-        }
+    //
+    // Let the stick sleep while the bus is suspended.
+    //
+    PowerInit();
+
+    //
+    // Tell the user what we are up to.
+    //
+    TelemetryPrintf("Configuring USB\n");
+    if(KeyboardModeGet())
+    {
+        TelemetryPrintf("Keyboard mode\n");
     }
-}
-}
 
+    //
+    // Set the USB stack mode to Device mode.
+    //
+    USBStackModeSet(0, eUSBModeForceDevice, 0);
 
+    //
+    // Pass the device information to the USB library and place the device
+    // on the bus, requesting the configured polling interval.
+    //
+    GamepadDeviceInit(GAMEPAD_POLL_INTERVAL_MS);
+
+    //
+    // Tell the user what we are doing and provide some basic instructions.
+    //
+    TelemetryPrintf("\nWaiting For Host...\n");
 
+    //
+    // The main loop starts here.  Reports are built and sent entirely from
+    // the USB event path (or the SOF scheduler), so this loop only looks
+    // after the LCD and the UART and can take as long as it likes.
+    //
+    while(1)
+    {
+        PowerProcess();
+        GamepadStatsPrint();
+        LatencyPrint();
+        GamepadIntervalCheck();
+        ConfigProcess();
+
+        //
+        // The rest draws on the LCD, so waits until it is ready.  Status
+        // changes stay flagged until then.
+        //
+        if(!GamepadBootProcess())
+        {
+            continue;
+        }
+
+        GamepadStatusShow();
+        GamepadViewProcess();
+#if GAMEPAD_LCD_SCOPE
+        GamepadScopeProcess();
+#endif
+        LCDPushProcess();
+        LCDQueueProcess();
+    }
+}
@@ -0,0 +1,181 @@
+//*****************************************************************************
+//
+// usb_gamepad_report.c - Bit-packed encoder and decoder for the gamepad
+// input report.
+//
+// Both functions are generated from the schema in usb_gamepad_report.h.  This
+// file is shared with the host-side decoder in tools/ and must stay free of
+// target-specific code.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usb_gamepad_report.h"
+
+//*****************************************************************************
+//
+// Bit stream state.  Fields are written LSB first; the accumulator never
+// holds more than 7 bits between calls so a 16-bit field always fits.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t *pui8Data;
+    uint32_t ui32Acc;
+    uint32_t ui32Count;
+}
+tBitWriter;
+
+typedef struct
+{
+    const uint8_t *pui8Data;
+    uint32_t ui32Acc;
+    uint32_t ui32Count;
+}
+tBitReader;
+
+//*****************************************************************************
+//
+// Appends the low ui32Width bits (at most 16) of ui32Value to the stream.
+//
+//*****************************************************************************
+static void
+BitPut(tBitWriter *psWriter, uint32_t ui32Value, uint32_t ui32Width)
+{
+    psWriter->ui32Acc |= (ui32Value & ((1 << ui32Width) - 1)) <<
+                         psWriter->ui32Count;
+    psWriter->ui32Count += ui32Width;
+
+    while(psWriter->ui32Count >= 8)
+    {
+        *psWriter->pui8Data++ = (uint8_t)psWriter->ui32Acc;
+        psWriter->ui32Acc >>= 8;
+        psWriter->ui32Count -= 8;
+    }
+}
+
+//*****************************************************************************
+//
+// Appends up to 32 bits by splitting them into 16-bit pieces.
+//
+//*****************************************************************************
+static void
+BitPutWide(tBitWriter *psWriter, uint32_t ui32Value, uint32_t ui32Width)
+{
+    if(ui32Width > 16)
+    {
+        BitPut(psWriter, ui32Value & 0xffff, 16);
+        BitPut(psWriter, ui32Value >> 16, ui32Width - 16);
+    }
+    else
+    {
+        BitPut(psWriter, ui32Value, ui32Width);
+    }
+}
+
+//*****************************************************************************
+//
+// Removes the next ui32Width bits (at most 16) from the stream.
+//
+//*****************************************************************************
+static uint32_t
+BitGet(tBitReader *psReader, uint32_t ui32Width)
+{
+    uint32_t ui32Value;
+
+    while(psReader->ui32Count < ui32Width)
+    {
+        psReader->ui32Acc |= (uint32_t)*psReader->pui8Data++ <<
+                             psReader->ui32Count;
+        psReader->ui32Count += 8;
+    }
+
+    ui32Value = psReader->ui32Acc & ((1 << ui32Width) - 1);
+    psReader->ui32Acc >>= ui32Width;
+    psReader->ui32Count -= ui32Width;
+
+    return(ui32Value);
+}
+
+//*****************************************************************************
+//
+// Removes up to 32 bits by splitting them into 16-bit pieces.
+//
+//*****************************************************************************
+static uint32_t
+BitGetWide(tBitReader *psReader, uint32_t ui32Width)
+{
+    uint32_t ui32Value;
+
+    if(ui32Width > 16)
+    {
+        ui32Value = BitGet(psReader, 16);
+        ui32Value |= BitGet(psReader, ui32Width - 16) << 16;
+        return(ui32Value);
+    }
+
+    return(BitGet(psReader, ui32Width));
+}
+
+//*****************************************************************************
+//
+// Packs the fields into a report of GAMEPAD_REPORT_SIZE bytes.
+//
+//*****************************************************************************
+#define PACK_AXIS(name, usage, bits, min, max)                                \
+    BitPut(&sWriter, psFields->ui16##name, bits);
+#define PACK_BUTTONS(name, count)                                             \
+    BitPutWide(&sWriter, psFields->ui32##name, count);
+#define PACK_VENDOR(name, bits, count)                                        \
+    for(ui32Idx = 0; ui32Idx < (count); ui32Idx++)                            \
+    {                                                                         \
+        BitPut(&sWriter, psFields->pui16##name[ui32Idx], bits);               \
+    }
+
+void
+GamepadReportPack(const tGamepadReportFields *psFields, uint8_t *pui8Report)
+{
+    tBitWriter sWriter;
+    uint32_t ui32Idx;
+
+    sWriter.pui8Data = pui8Report;
+    sWriter.ui32Acc = 0;
+    sWriter.ui32Count = 0;
+    ui32Idx = 0;
+
+    GAMEPAD_REPORT_FIELDS(PACK_AXIS, PACK_BUTTONS, PACK_VENDOR)
+
+    (void)ui32Idx;
+}
+
+//*****************************************************************************
+//
+// Unpacks a report of GAMEPAD_REPORT_SIZE bytes into its fields.
+//
+//*****************************************************************************
+#define UNPACK_AXIS(name, usage, bits, min, max)                              \
+    psFields->ui16##name = (uint16_t)BitGet(&sReader, bits);
+#define UNPACK_BUTTONS(name, count)                                           \
+    psFields->ui32##name = BitGetWide(&sReader, count);
+#define UNPACK_VENDOR(name, bits, count)                                      \
+    for(ui32Idx = 0; ui32Idx < (count); ui32Idx++)                            \
+    {                                                                         \
+        psFields->pui16##name[ui32Idx] = (uint16_t)BitGet(&sReader, bits);    \
+    }
+
+void
+GamepadReportUnpack(const uint8_t *pui8Report, tGamepadReportFields *psFields)
+{
+    tBitReader sReader;
+    uint32_t ui32Idx;
+
+    sReader.pui8Data = pui8Report;
+    sReader.ui32Acc = 0;
+    sReader.ui32Count = 0;
+    ui32Idx = 0;
+
+    GAMEPAD_REPORT_FIELDS(UNPACK_AXIS, UNPACK_BUTTONS, UNPACK_VENDOR)
+
+    (void)ui32Idx;
+}
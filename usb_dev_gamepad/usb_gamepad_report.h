@@ -0,0 +1,312 @@
+//*****************************************************************************
+//
+// usb_gamepad_report.h - The single definition of the gamepad input report.
+//
+// The report layout is described once, by GAMEPAD_REPORT_FIELDS() below.
+// Everything else that depends on the layout is generated from it: the HID
+// report descriptor, the unpacked field structure, the bit-packed encoder and
+// decoder and the report size.  This header is also used by the host-side
+// decoder in tools/, so it must not depend on any TivaWare header.
+//
+//*****************************************************************************
+
+#ifndef _USB_GAMEPAD_REPORT_H_
+#define _USB_GAMEPAD_REPORT_H_
+
+//*****************************************************************************
+//
+// The report schema.  Each row is one of:
+//
+// AXIS(name, usage, bits, min, max)
+//     An absolute generic desktop axis of the given width.
+// BUTTONS(name, count)
+//     count one-bit buttons, usages Button 1 to Button count.
+// VENDOR(name, bits, count)
+//     count unsigned vendor-defined values of the given width.
+//
+// Fields are packed LSB first with no padding between them, in the order
+// listed.  Axes and vendor fields may be at most 16 bits wide and there may be
+// at most 32 buttons in a row.  The usage is only expanded by the descriptor
+// generator, so the host decoder does not need the HID usage definitions.
+//
+// Optional extensions are appended by the GAMEPAD_REPORT_EXT_*() rows so
+// that the base layout never moves.
+//
+//*****************************************************************************
+#define GAMEPAD_REPORT_FIELDS(AXIS, BUTTONS, VENDOR)                          \
+    AXIS(X, USB_HID_X, 10, 0, 1023)                                           \
+    AXIS(Y, USB_HID_Y, 10, 0, 1023)                                           \
+    AXIS(Z, USB_HID_Z, 10, 0, 1023)                                           \
+    AXIS(RX, USB_HID_RX, 10, 0, 1023)                                         \
+    BUTTONS(Buttons, 16)                                                      \
+    GAMEPAD_REPORT_EXT_HIRES(AXIS, BUTTONS, VENDOR)                           \
+    GAMEPAD_REPORT_EXT_TRACE(AXIS, BUTTONS, VENDOR)
+
+//*****************************************************************************
+//
+// Set GAMEPAD_HIRES to 1 to append the high resolution button history to the
+// report.  The buttons are sampled every GAMEPAD_HIRES_SLOT_US microseconds
+// and each report carries the last GAMEPAD_HIRES_SLOTS samples, oldest
+// first, in the same bit layout as the Buttons field.  HiresSeq is the
+// sample number of the newest slot, modulo 256, so the host can discard
+// slots it has already seen or detect samples that were never delivered.
+// HiresAge is how long before the report was packed the newest slot was
+// sampled, in microseconds.  Slot k was therefore sampled
+// HiresAge + (GAMEPAD_HIRES_SLOTS - 1 - k) * GAMEPAD_HIRES_SLOT_US
+// microseconds before the report was packed.
+//
+// The firmware and the host tools must be built with the same setting.
+//
+//*****************************************************************************
+#ifndef GAMEPAD_HIRES
+#define GAMEPAD_HIRES           0
+#endif
+
+#define GAMEPAD_HIRES_SLOTS     8
+#define GAMEPAD_HIRES_SLOT_US   125
+
+#if GAMEPAD_HIRES
+#define GAMEPAD_REPORT_EXT_HIRES(AXIS, BUTTONS, VENDOR)                       \
+    VENDOR(HiresSlots, 16, GAMEPAD_HIRES_SLOTS)                               \
+    VENDOR(HiresSeq, 8, 1)                                                    \
+    VENDOR(HiresAge, 8, 1)
+#else
+#define GAMEPAD_REPORT_EXT_HIRES(AXIS, BUTTONS, VENDOR)
+#endif
+
+//*****************************************************************************
+//
+// Set GAMEPAD_TRACE to 1 to append latency trace fields to the report.
+// TraceSeq counts the reports accepted by the USB stack, so a jump shows a
+// report the host never saw.  TraceEdgeUs is the device time of the first
+// sample that saw a button change since the previous report, or 0 if the
+// buttons did not change.  TraceSentUs is the device time the report was
+// packed.  Both times are on the device's 32-bit microsecond clock, sent as
+// two 16-bit halves, low half first.  The clock never reads 0, so 0 is free
+// to mean "no edge".
+//
+//*****************************************************************************
+#ifndef GAMEPAD_TRACE
+#define GAMEPAD_TRACE           0
+#endif
+
+#if GAMEPAD_TRACE
+#define GAMEPAD_REPORT_EXT_TRACE(AXIS, BUTTONS, VENDOR)                       \
+    VENDOR(TraceSeq, 16, 1)                                                   \
+    VENDOR(TraceEdgeUs, 16, 2)                                                \
+    VENDOR(TraceSentUs, 16, 2)
+#else
+#define GAMEPAD_REPORT_EXT_TRACE(AXIS, BUTTONS, VENDOR)
+#endif
+
+#define GamepadTraceTimeGet(pui16Field)                                       \
+        ((uint32_t)(pui16Field)[0] | ((uint32_t)(pui16Field)[1] << 16))
+#define GamepadTraceTimeSet(pui16Field, ui32Us)                               \
+        do                                                                    \
+        {                                                                     \
+            (pui16Field)[0] = (uint16_t)(ui32Us);                             \
+            (pui16Field)[1] = (uint16_t)((ui32Us) >> 16);                     \
+        }                                                                     \
+        while(0)
+
+//*****************************************************************************
+//
+// The unpacked report.  The members are named ui16<name> for axes, ui32<name>
+// for buttons and pui16<name>[] for vendor fields.
+//
+//*****************************************************************************
+#define GAMEPAD_STRUCT_AXIS(name, usage, bits, min, max)                      \
+    uint16_t ui16##name;
+#define GAMEPAD_STRUCT_BUTTONS(name, count)                                   \
+    uint32_t ui32##name;
+#define GAMEPAD_STRUCT_VENDOR(name, bits, count)                              \
+    uint16_t pui16##name[count];
+
+typedef struct
+{
+    GAMEPAD_REPORT_FIELDS(GAMEPAD_STRUCT_AXIS, GAMEPAD_STRUCT_BUTTONS,
+                          GAMEPAD_STRUCT_VENDOR)
+}
+tGamepadReportFields;
+
+//*****************************************************************************
+//
+// The size of the packed report.
+//
+//*****************************************************************************
+#define GAMEPAD_BITS_AXIS(name, usage, bits, min, max)                        \
+    + (bits)
+#define GAMEPAD_BITS_BUTTONS(name, count)                                     \
+    + (count)
+#define GAMEPAD_BITS_VENDOR(name, bits, count)                                \
+    + ((bits) * (count))
+
+#define GAMEPAD_REPORT_BITS                                                   \
+    (0 GAMEPAD_REPORT_FIELDS(GAMEPAD_BITS_AXIS, GAMEPAD_BITS_BUTTONS,         \
+                             GAMEPAD_BITS_VENDOR))
+#define GAMEPAD_REPORT_SIZE     (GAMEPAD_REPORT_BITS / 8)
+
+//*****************************************************************************
+//
+// Compile-time checks on the schema.  The report must be a whole number of
+// bytes, since no padding is generated, and must fit in a single full speed
+// interrupt packet.
+//
+//*****************************************************************************
+#define GAMEPAD_REPORT_ASSERT(bCond, name)                                    \
+    typedef char name[(bCond) ? 1 : -1]
+
+GAMEPAD_REPORT_ASSERT((GAMEPAD_REPORT_BITS % 8) == 0,
+                      g_pcGamepadReportByteAligned);
+GAMEPAD_REPORT_ASSERT(GAMEPAD_REPORT_SIZE <= 64,
+                      g_pcGamepadReportFitsPacket);
+GAMEPAD_REPORT_ASSERT((GAMEPAD_HIRES_SLOTS & (GAMEPAD_HIRES_SLOTS - 1)) == 0,
+                      g_pcGamepadHiresSlotsPow2);
+
+//*****************************************************************************
+//
+// HID descriptor items not provided by usbhid.h.  The 4-byte forms of the
+// logical limits allow any unsigned 16-bit range.
+//
+//*****************************************************************************
+#define GamepadUsagePageVendor                                                \
+                                0x06, 0x00, 0xff
+#define GamepadLogicalMinimum(i32Value)                                       \
+                                0x17, ((i32Value) & 0xff),                    \
+                                (((i32Value) >> 8) & 0xff),                   \
+                                (((i32Value) >> 16) & 0xff),                  \
+                                (((i32Value) >> 24) & 0xff)
+#define GamepadLogicalMaximum(i32Value)                                       \
+                                0x27, ((i32Value) & 0xff),                    \
+                                (((i32Value) >> 8) & 0xff),                   \
+                                (((i32Value) >> 16) & 0xff),                  \
+                                (((i32Value) >> 24) & 0xff)
+
+//*****************************************************************************
+//
+// The report descriptor items for each row.  These expand to usbhid.h macros
+// so they may only be used where that header is included.
+//
+//*****************************************************************************
+#define GAMEPAD_DESC_AXIS(name, usage, bits, min, max)                        \
+    UsagePage(USB_HID_GENERIC_DESKTOP),                                       \
+    Usage(usage),                                                             \
+    GamepadLogicalMinimum(min),                                               \
+    GamepadLogicalMaximum(max),                                               \
+    ReportSize(bits),                                                         \
+    ReportCount(1),                                                           \
+    Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
+#define GAMEPAD_DESC_BUTTONS(name, count)                                     \
+    UsagePage(USB_HID_BUTTONS),                                               \
+    UsageMinimum(1),                                                          \
+    UsageMaximum(count),                                                      \
+    GamepadLogicalMinimum(0),                                                 \
+    GamepadLogicalMaximum(1),                                                 \
+    ReportSize(1),                                                            \
+    ReportCount(count),                                                       \
+    Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
+#define GAMEPAD_DESC_VENDOR(name, bits, count)                                \
+    GamepadUsagePageVendor,                                                   \
+    Usage(1),                                                                 \
+    GamepadLogicalMinimum(0),                                                 \
+    GamepadLogicalMaximum((1 << (bits)) - 1),                                 \
+    ReportSize(bits),                                                         \
+    ReportCount(count),                                                       \
+    Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
+
+#define GAMEPAD_REPORT_DESCRIPTOR_ITEMS                                       \
+    GAMEPAD_REPORT_FIELDS(GAMEPAD_DESC_AXIS, GAMEPAD_DESC_BUTTONS,            \
+                          GAMEPAD_DESC_VENDOR)
+
+//*****************************************************************************
+//
+// The status feature report.  The host reads this with GET_REPORT(Feature)
+// to check the polling rate it is really achieving, and may write it with
+// SET_REPORT(Feature) to request a different polling interval or input
+// mode; only the interval and mode bytes are used on a write, and 0 in
+// either leaves it unchanged.  Multi-byte values are little endian.
+//
+// The report also carries player one's configuration from
+// GAMEPAD_STATUS_O_CONFIG_CMD on.  A read returns the configuration in use.
+// A write only changes it if the command byte is non-zero, in which case
+// every configuration field is taken from the write, so the host should
+// read the report, change what it needs and write the whole report back.
+//
+//*****************************************************************************
+#define GAMEPAD_STATUS_SIZE     56
+#define GAMEPAD_STATUS_VERSION  3
+
+#define GAMEPAD_STATUS_O_VERSION    0   // Layout version, u8
+#define GAMEPAD_STATUS_O_INTERVAL   1   // Published bInterval in ms, u8
+#define GAMEPAD_STATUS_O_REPORT_HZ  2   // Reports collected per second, u16
+#define GAMEPAD_STATUS_O_SOF_HZ     4   // SOFs per local second, u16
+#define GAMEPAD_STATUS_O_PHASE_US   6   // Poll phase after SOF in us, u16
+#define GAMEPAD_STATUS_O_ERROR_US   8   // Mean SOF sync error in us, u16
+#define GAMEPAD_STATUS_O_MISSED     10  // Scheduled reports missed, u16
+#define GAMEPAD_STATUS_O_REPORTS    12  // Scheduled reports, u32
+#define GAMEPAD_STATUS_O_MODE       16  // Input mode, u8
+#define GAMEPAD_STATUS_O_CONFIG_CMD 20  // Configuration command, u8
+#define GAMEPAD_STATUS_O_CONFIG_SEQ 21  // Configurations applied, u8
+#define GAMEPAD_STATUS_O_DEBOUNCE   22  // Button lockout in ms, u8
+#define GAMEPAD_STATUS_O_TURBO_HZ   23  // Turbo presses per second, u8
+#define GAMEPAD_STATUS_O_TURBO_MASK 24  // Report buttons with turbo, u16
+#define GAMEPAD_STATUS_O_OPTIONS    26  // Report options, u8
+#define GAMEPAD_STATUS_O_BUTTON_MAP 28  // Report button per input, u8 x 16
+#define GAMEPAD_STATUS_O_CAL_X      44  // X min, center, max ADC, u16 x 3
+#define GAMEPAD_STATUS_O_CAL_Y      50  // Y min, center, max ADC, u16 x 3
+
+#define GAMEPAD_STATUS_MODE_GAMEPAD 1   // Buttons reported on the gamepad
+#define GAMEPAD_STATUS_MODE_KEYBOARD 2  // Buttons reported as keys
+
+//*****************************************************************************
+//
+// Configuration commands, written to GAMEPAD_STATUS_O_CONFIG_CMD.  Reads
+// return 0.  A configuration that fails validation is ignored, which the
+// host sees as GAMEPAD_STATUS_O_CONFIG_SEQ not moving.
+//
+//*****************************************************************************
+#define GAMEPAD_CONFIG_CMD_APPLY    1   // Use the written configuration
+#define GAMEPAD_CONFIG_CMD_SAVE     2   // Use it and keep it over power off
+#define GAMEPAD_CONFIG_CMD_DEFAULTS 3   // Use and keep the built-in one
+
+//*****************************************************************************
+//
+// Configuration fields.  Entry n of the button map is the report button,
+// counting from 0, that player one's input n drives, or
+// GAMEPAD_CONFIG_BUTTON_NONE to ignore the input.  Inputs are numbered as in
+// the pin table.  The debounce time is how long a report button is held in
+// its new state after a change, so that contact bounce is not reported; the
+// first edge is still reported at once.  Turbo buttons repeat at the turbo
+// rate while held.  The calibration gives the raw 12-bit ADC readings at
+// each end and the center of travel; the center must lie strictly between
+// the ends.
+//
+//*****************************************************************************
+#define GAMEPAD_CONFIG_INPUTS       16
+#define GAMEPAD_CONFIG_BUTTON_NONE  0xff
+#define GAMEPAD_CONFIG_ADC_MAX      4095
+#define GAMEPAD_CONFIG_TURBO_HZ_MAX 30
+
+#define GAMEPAD_CONFIG_OPT_ALWAYS   0x01    // Send a report every poll
+#define GAMEPAD_CONFIG_OPT_NO_AXES  0x02    // Report the axes centered
+
+#define GAMEPAD_STATUS_DESCRIPTOR_ITEMS                                       \
+    GamepadUsagePageVendor,                                                   \
+    Usage(2),                                                                 \
+    GamepadLogicalMinimum(0),                                                 \
+    GamepadLogicalMaximum(255),                                               \
+    ReportSize(8),                                                            \
+    ReportCount(GAMEPAD_STATUS_SIZE),                                         \
+    Feature(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void GamepadReportPack(const tGamepadReportFields *psFields,
+                              uint8_t *pui8Report);
+extern void GamepadReportUnpack(const uint8_t *pui8Report,
+                                tGamepadReportFields *psFields);
+
+#endif
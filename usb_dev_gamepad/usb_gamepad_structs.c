@@ -24,15 +24,27 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
+#include "driverlib/debug.h"
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/usb.h"
 #include "usblib/usblib.h"
 #include "usblib/usbhid.h"
+#include "usblib/usbcdc.h"
 #include "usblib/usb-ids.h"
 #include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdbulk.h"
+#include "usblib/device/usbdcdc.h"
 #include "usblib/device/usbdcomp.h"
 #include "usblib/device/usbdhid.h"
 #include "usblib/device/usbdhidgamepad.h"
+#include "usb_gamepad_report.h"
 #include "usb_gamepad_structs.h"
+#include "usb_telemetry.h"
+#include "usb_lcd_push.h"
+#include "usb_keyboard.h"
 
 //****************************************************************************
 //
@@ -151,91 +163,829 @@ static const uint8_t g_pui8GameReportDescriptor[] =
         Collection (USB_HID_PHYSICAL),
 
             //
-            // The X, Y, RX, and RY values which are specified as 8-bit
-            // absolute position values.
+            // The axes, buttons and any vendor fields, generated from the
+            // schema in usb_gamepad_report.h.  The fields are bit-packed with
+            // no padding between them.
             //
-            Usage(USB_HID_X),
+            GAMEPAD_REPORT_DESCRIPTOR_ITEMS
 
-            //
-            // 4 8-bit absolute values.
-            //
-            ReportSize(10),
-            ReportCount(1),
-            Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
-                  USB_HID_INPUT_ABS),
-
-            ReportCount(1),
-            ReportSize(6),
-            Input(USB_HID_INPUT_CONSTANT),
-
-            Usage (USB_HID_Y),
-            ReportSize(10),
-            ReportCount(1),
-            Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
-                  USB_HID_INPUT_ABS),
-
-            ReportCount(1),
-            ReportSize(6),
-            Input(USB_HID_INPUT_CONSTANT),
-
-            Usage (USB_HID_Z),
-            ReportSize(10),
-            ReportCount(1),
-            Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
-                  USB_HID_INPUT_ABS),
-
-            ReportCount(1),
-            ReportSize(6),
-            Input(USB_HID_INPUT_CONSTANT),
-
-            Usage (USB_HID_RX),
-            ReportSize(10),
-            ReportCount(1),
-            Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
-                  USB_HID_INPUT_ABS),
-
-            ReportCount(1),
-            ReportSize(6),
-            Input(USB_HID_INPUT_CONSTANT),
-
-            //
-            // The 16 buttons.
-            //
-            UsagePage(USB_HID_BUTTONS),
-            UsageMinimum(1),
-            UsageMaximum(16),
-            LogicalMinimum(0),
-            LogicalMaximum(1),
-            PhysicalMinimum(0),
-            PhysicalMaximum(1),
+        EndCollection,
 
-            //
-            // 16 - 1 bit values for the buttons.
-            //
-            ReportSize(1),
-            ReportCount(16),
-            Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
-                  USB_HID_INPUT_ABS),
+        //
+        // The status feature report.
+        //
+        GAMEPAD_STATUS_DESCRIPTOR_ITEMS
 
-        EndCollection,
     EndCollection
 };
 
 //*****************************************************************************
 //
-// The HID game pad device initialization and customization structures.
+// The gamepads' configuration descriptor, built from sections in the same
+// way as the class drivers' own.  Both players share all but the HID
+// descriptor.  The interrupt IN endpoint is the one the HID class driver
+// uses on its own, and the composite driver renumbers the interface and
+// endpoint.
+//
+// The gamepads are registered with the generic HID class driver rather
+// than the gamepad class driver, since only the former passes feature
+// report writes on to the application.
+//
+//*****************************************************************************
+static const uint8_t g_pui8GamepadConfigDescriptor[] =
+{
+    9,                                  // Size of the configuration descriptor.
+    USB_DTYPE_CONFIGURATION,            // Type of this descriptor.
+    USBShort(34),                       // The total size of this full structure.
+    1,                                  // The number of interfaces.
+    1,                                  // The unique value for this configuration.
+    5,                                  // The string identifier for this configuration.
+    GAMEPAD_PWR_ATTRIBUTES,             // Configuration attributes.
+    0,                                  // The maximum power in 2mA increments.
+};
+
+static const uint8_t g_pui8GamepadInterface[] =
+{
+    9,                                  // Size of the interface descriptor.
+    USB_DTYPE_INTERFACE,                // Type of this descriptor.
+    0,                                  // The index for this interface.
+    0,                                  // The alternate setting for this interface.
+    1,                                  // The number of endpoints used by this interface.
+    USB_CLASS_HID,                      // The interface class
+    USB_HID_SCLASS_NONE,                // The interface sub-class.
+    USB_HID_PROTOCOL_NONE,              // The interface protocol.
+    4,                                  // The string index for this interface.
+};
+
+static const uint8_t g_pui8GamepadInEndpoint[] =
+{
+    7,                                  // The size of the endpoint descriptor.
+    USB_DTYPE_ENDPOINT,                 // Descriptor type is an endpoint.
+    USB_EP_DESC_IN | USBEPToIndex(USB_EP_3),
+    USB_EP_ATTR_INT,                    // Endpoint is an interrupt endpoint.
+    USBShort(USBFIFOSizeToBytes(USB_FIFO_SZ_64)),
+    1,                                  // Patched to the polling interval.
+};
+
+static const tConfigSection g_sGamepadConfigSection =
+{
+    sizeof(g_pui8GamepadConfigDescriptor),
+    g_pui8GamepadConfigDescriptor
+};
+
+static const tConfigSection g_sGamepadInterfaceSection =
+{
+    sizeof(g_pui8GamepadInterface),
+    g_pui8GamepadInterface
+};
+
+static const tConfigSection g_sGamepadInEndpointSection =
+{
+    sizeof(g_pui8GamepadInEndpoint),
+    g_pui8GamepadInEndpoint
+};
+
+//*****************************************************************************
+//
+// Reports are sent from the report builder, so the idle rate is infinite
+// unless the host asks otherwise.
 //
 //*****************************************************************************
-tUSBDHIDGamepadDevice g_sGamepadDevice =
+static tHIDReportIdle g_psGamepadReportIdle[1] =
+{
+    { 0, 0, 0, 0 }
+};
+
+//*****************************************************************************
+//
+// Player one's HID descriptor, configuration descriptor and device.
+//
+//*****************************************************************************
+static const tHIDDescriptor g_sGamepadHIDDescriptor =
+{
+    9,                                  // bLength
+    USB_HID_DTYPE_HID,                  // bDescriptorType
+    0x111,                              // bcdHID (version 1.11 compliant)
+    0,                                  // bCountryCode (not localized)
+    1,                                  // bNumDescriptors
+    {
+        {
+            USB_HID_DTYPE_REPORT,       // Report descriptor
+            sizeof(g_pui8GameReportDescriptor)
+        }
+    }
+};
+
+static const uint8_t * const g_ppui8GamepadClassDescriptors[] =
+{
+    g_pui8GameReportDescriptor
+};
+
+static const tConfigSection g_sGamepadHIDSection =
+{
+    sizeof(g_sGamepadHIDDescriptor),
+    (const uint8_t *)&g_sGamepadHIDDescriptor
+};
+
+static const tConfigSection * const g_psGamepadSections[] =
+{
+    &g_sGamepadConfigSection,
+    &g_sGamepadInterfaceSection,
+    &g_sGamepadHIDSection,
+    &g_sGamepadInEndpointSection
+};
+
+static const tConfigHeader g_sGamepadConfigHeader =
+{
+    sizeof(g_psGamepadSections) / sizeof(g_psGamepadSections[0]),
+    g_psGamepadSections
+};
+
+static const tConfigHeader * const g_ppsGamepadConfigDescriptors[] =
+{
+    &g_sGamepadConfigHeader
+};
+
+tUSBDHIDDevice g_sGamepadDevice =
 {
     USB_VID_TI_1CBE,
     USB_PID_GAMEPAD,
     0,
-    USB_CONF_ATTR_SELF_PWR,
+    GAMEPAD_PWR_ATTRIBUTES,
+    USB_HID_SCLASS_NONE,
+    USB_HID_PROTOCOL_NONE,
+    1,
+    g_psGamepadReportIdle,
     GamepadHandler,
     (void *)&g_sGamepadDevice,
+    GamepadHandler,
+    (void *)&g_sGamepadDevice,
+    false,
+    &g_sGamepadHIDDescriptor,
+    g_ppui8GamepadClassDescriptors,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS,
+    g_ppsGamepadConfigDescriptors
+};
+
+#if GAMEPAD_PLAYERS > 1
+//*****************************************************************************
+//
+// Player two's report descriptor.  The input report is laid out exactly as
+// player one's, but there is no status feature report.
+//
+//*****************************************************************************
+static const uint8_t g_pui8Game2ReportDescriptor[] =
+{
+    UsagePage(USB_HID_GENERIC_DESKTOP),
+    Usage(USB_HID_JOYSTICK),
+    Collection(USB_HID_APPLICATION),
+
+        UsagePage(USB_HID_GENERIC_DESKTOP),
+        Usage (USB_HID_POINTER),
+        Collection (USB_HID_PHYSICAL),
+
+            GAMEPAD_REPORT_DESCRIPTOR_ITEMS
+
+        EndCollection,
+
+    EndCollection
+};
+
+//*****************************************************************************
+//
+// Player two's HID descriptor, configuration descriptor and device.
+//
+//*****************************************************************************
+static tHIDReportIdle g_psGamepad2ReportIdle[1] =
+{
+    { 0, 0, 0, 0 }
+};
+
+static const tHIDDescriptor g_sGamepad2HIDDescriptor =
+{
+    9,                                  // bLength
+    USB_HID_DTYPE_HID,                  // bDescriptorType
+    0x111,                              // bcdHID (version 1.11 compliant)
+    0,                                  // bCountryCode (not localized)
+    1,                                  // bNumDescriptors
+    {
+        {
+            USB_HID_DTYPE_REPORT,       // Report descriptor
+            sizeof(g_pui8Game2ReportDescriptor)
+        }
+    }
+};
+
+static const uint8_t * const g_ppui8Gamepad2ClassDescriptors[] =
+{
+    g_pui8Game2ReportDescriptor
+};
+
+static const tConfigSection g_sGamepad2HIDSection =
+{
+    sizeof(g_sGamepad2HIDDescriptor),
+    (const uint8_t *)&g_sGamepad2HIDDescriptor
+};
+
+static const tConfigSection * const g_psGamepad2Sections[] =
+{
+    &g_sGamepadConfigSection,
+    &g_sGamepadInterfaceSection,
+    &g_sGamepad2HIDSection,
+    &g_sGamepadInEndpointSection
+};
+
+static const tConfigHeader g_sGamepad2ConfigHeader =
+{
+    sizeof(g_psGamepad2Sections) / sizeof(g_psGamepad2Sections[0]),
+    g_psGamepad2Sections
+};
+
+static const tConfigHeader * const g_ppsGamepad2ConfigDescriptors[] =
+{
+    &g_sGamepad2ConfigHeader
+};
+
+tUSBDHIDDevice g_sGamepad2Device =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_COMP_HID_SER,
+    0,
+    GAMEPAD_PWR_ATTRIBUTES,
+    USB_HID_SCLASS_NONE,
+    USB_HID_PROTOCOL_NONE,
+    1,
+    g_psGamepad2ReportIdle,
+    Gamepad2Handler,
+    (void *)&g_sGamepad2Device,
+    Gamepad2Handler,
+    (void *)&g_sGamepad2Device,
+    false,
+    &g_sGamepad2HIDDescriptor,
+    g_ppui8Gamepad2ClassDescriptors,
     g_ppui8StringDescriptors,
     NUM_STRING_DESCRIPTORS,
-    g_pui8GameReportDescriptor,
-    sizeof(g_pui8GameReportDescriptor)
+    g_ppsGamepad2ConfigDescriptors
 };
+#endif
+
+#if GAMEPAD_CDC
+//*****************************************************************************
+//
+// The CDC serial telemetry interface and its buffers.
+//
+//*****************************************************************************
+extern tUSBDCDCDevice g_sTelemetryDevice;
+
+static uint8_t g_pui8TelemetryTxBuffer[TELEMETRY_TX_BUFFER_SIZE];
+static uint8_t g_pui8TelemetryRxBuffer[TELEMETRY_RX_BUFFER_SIZE];
+
+const tUSBBuffer g_sTelemetryTxBuffer =
+{
+    true,                               // This is a transmit buffer.
+    TelemetryTxHandler,                 // pfnCallback
+    (void *)&g_sTelemetryDevice,        // Callback data is our device pointer.
+    USBDCDCPacketWrite,                 // pfnTransfer
+    USBDCDCTxPacketAvailable,           // pfnAvailable
+    (void *)&g_sTelemetryDevice,        // pvHandle
+    g_pui8TelemetryTxBuffer,            // pui8Buffer
+    TELEMETRY_TX_BUFFER_SIZE,           // ui32BufferSize
+};
+
+const tUSBBuffer g_sTelemetryRxBuffer =
+{
+    false,                              // This is a receive buffer.
+    TelemetryRxHandler,                 // pfnCallback
+    (void *)&g_sTelemetryDevice,        // Callback data is our device pointer.
+    USBDCDCPacketRead,                  // pfnTransfer
+    USBDCDCRxPacketAvailable,           // pfnAvailable
+    (void *)&g_sTelemetryDevice,        // pvHandle
+    g_pui8TelemetryRxBuffer,            // pui8Buffer
+    TELEMETRY_RX_BUFFER_SIZE,           // ui32BufferSize
+};
+
+tUSBDCDCDevice g_sTelemetryDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_COMP_HID_SER,
+    0,
+    GAMEPAD_PWR_ATTRIBUTES,
+    TelemetryControlHandler,
+    (void *)&g_sTelemetryDevice,
+    USBBufferEventCallback,
+    (void *)&g_sTelemetryRxBuffer,
+    USBBufferEventCallback,
+    (void *)&g_sTelemetryTxBuffer,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS
+};
+#endif
+
+#if GAMEPAD_LCD_PUSH
+//*****************************************************************************
+//
+// The vendor bulk interface used to draw on the LCD, and its receive buffer.
+// Nothing is ever sent back, so there is no transmit buffer.
+//
+//*****************************************************************************
+extern tUSBDBulkDevice g_sLCDPushDevice;
+
+static uint8_t g_pui8LCDPushRxBuffer[LCD_PUSH_RX_BUFFER_SIZE];
+
+const tUSBBuffer g_sLCDPushRxBuffer =
+{
+    false,                              // This is a receive buffer.
+    LCDPushRxHandler,                   // pfnCallback
+    (void *)&g_sLCDPushDevice,          // Callback data is our device pointer.
+    USBDBulkPacketRead,                 // pfnTransfer
+    USBDBulkRxPacketAvailable,          // pfnAvailable
+    (void *)&g_sLCDPushDevice,          // pvHandle
+    g_pui8LCDPushRxBuffer,              // pui8Buffer
+    LCD_PUSH_RX_BUFFER_SIZE,            // ui32BufferSize
+};
+
+tUSBDBulkDevice g_sLCDPushDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_COMP_HID_SER,
+    0,
+    GAMEPAD_PWR_ATTRIBUTES,
+    USBBufferEventCallback,
+    (void *)&g_sLCDPushRxBuffer,
+    LCDPushTxHandler,
+    (void *)&g_sLCDPushDevice,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS
+};
+#endif
+
+#if GAMEPAD_KEYBOARD
+//*****************************************************************************
+//
+// The N-key rollover keyboard report: a byte of modifier keys followed by
+// one bit for each key usage below KEYBOARD_KEYS.
+//
+//*****************************************************************************
+static const uint8_t g_pui8KeyboardReportDescriptor[] =
+{
+    UsagePage(USB_HID_GENERIC_DESKTOP),
+    Usage(USB_HID_KEYBOARD),
+    Collection(USB_HID_APPLICATION),
+
+        //
+        // The modifier keys.
+        //
+        UsagePage(USB_HID_USAGE_KEYCODES),
+        UsageMinimum(KEYBOARD_USAGE_MOD_FIRST),
+        UsageMaximum(KEYBOARD_USAGE_MOD_LAST),
+        LogicalMinimum(0),
+        LogicalMaximum(1),
+        ReportSize(1),
+        ReportCount(8),
+        Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
+
+        //
+        // Every other key.
+        //
+        UsageMinimum(0),
+        UsageMaximum(KEYBOARD_KEYS - 1),
+        ReportCount(KEYBOARD_KEYS),
+        Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE | USB_HID_INPUT_ABS),
+
+    EndCollection
+};
+
+//*****************************************************************************
+//
+// The keyboard's configuration descriptor, built from sections in the same
+// way as the class drivers' own.  It is not a boot keyboard, since the boot
+// protocol cannot carry more than six keys.  The composite driver renumbers
+// the interface and endpoint.
+//
+//*****************************************************************************
+static const uint8_t g_pui8KeyboardConfigDescriptor[] =
+{
+    9,                                  // Size of the configuration descriptor.
+    USB_DTYPE_CONFIGURATION,            // Type of this descriptor.
+    USBShort(34),                       // The total size of this full structure.
+    1,                                  // The number of interfaces.
+    1,                                  // The unique value for this configuration.
+    5,                                  // The string identifier for this configuration.
+    GAMEPAD_PWR_ATTRIBUTES,             // Configuration attributes.
+    0,                                  // The maximum power in 2mA increments.
+};
+
+static const uint8_t g_pui8KeyboardInterface[] =
+{
+    9,                                  // Size of the interface descriptor.
+    USB_DTYPE_INTERFACE,                // Type of this descriptor.
+    0,                                  // The index for this interface.
+    0,                                  // The alternate setting for this interface.
+    1,                                  // The number of endpoints used by this interface.
+    USB_CLASS_HID,                      // The interface class
+    USB_HID_SCLASS_NONE,                // The interface sub-class.
+    USB_HID_PROTOCOL_NONE,              // The interface protocol.
+    0,                                  // The string index for this interface.
+};
+
+static const uint8_t g_pui8KeyboardInEndpoint[] =
+{
+    7,                                  // The size of the endpoint descriptor.
+    USB_DTYPE_ENDPOINT,                 // Descriptor type is an endpoint.
+    USB_EP_DESC_IN | USBEPToIndex(USB_EP_1),
+    USB_EP_ATTR_INT,                    // Endpoint is an interrupt endpoint.
+    USBShort(USBFIFOSizeToBytes(USB_FIFO_SZ_64)),
+    1,                                  // Patched to the gamepad's interval.
+};
+
+static const tHIDDescriptor g_sKeyboardHIDDescriptor =
+{
+    9,                                  // bLength
+    USB_HID_DTYPE_HID,                  // bDescriptorType
+    0x111,                              // bcdHID (version 1.11 compliant)
+    0,                                  // bCountryCode (not localized)
+    1,                                  // bNumDescriptors
+    {
+        {
+            USB_HID_DTYPE_REPORT,       // Report descriptor
+            sizeof(g_pui8KeyboardReportDescriptor)
+        }
+    }
+};
+
+static const uint8_t * const g_ppui8KeyboardClassDescriptors[] =
+{
+    g_pui8KeyboardReportDescriptor
+};
+
+static const tConfigSection g_sKeyboardConfigSection =
+{
+    sizeof(g_pui8KeyboardConfigDescriptor),
+    g_pui8KeyboardConfigDescriptor
+};
+
+static const tConfigSection g_sKeyboardInterfaceSection =
+{
+    sizeof(g_pui8KeyboardInterface),
+    g_pui8KeyboardInterface
+};
+
+static const tConfigSection g_sKeyboardHIDSection =
+{
+    sizeof(g_sKeyboardHIDDescriptor),
+    (const uint8_t *)&g_sKeyboardHIDDescriptor
+};
+
+static const tConfigSection g_sKeyboardInEndpointSection =
+{
+    sizeof(g_pui8KeyboardInEndpoint),
+    g_pui8KeyboardInEndpoint
+};
+
+static const tConfigSection * const g_psKeyboardSections[] =
+{
+    &g_sKeyboardConfigSection,
+    &g_sKeyboardInterfaceSection,
+    &g_sKeyboardHIDSection,
+    &g_sKeyboardInEndpointSection
+};
+
+static const tConfigHeader g_sKeyboardConfigHeader =
+{
+    sizeof(g_psKeyboardSections) / sizeof(g_psKeyboardSections[0]),
+    g_psKeyboardSections
+};
+
+static const tConfigHeader * const g_ppsKeyboardConfigDescriptors[] =
+{
+    &g_sKeyboardConfigHeader
+};
+
+//*****************************************************************************
+//
+// Reports are only sent when the keys change, so the idle rate is infinite
+// unless the host asks otherwise.
+//
+//*****************************************************************************
+static tHIDReportIdle g_psKeyboardReportIdle[1] =
+{
+    { 0, 0, 0, 0 }
+};
+
+tUSBDHIDDevice g_sKeyboardDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_COMP_HID_SER,
+    0,
+    GAMEPAD_PWR_ATTRIBUTES,
+    USB_HID_SCLASS_NONE,
+    USB_HID_PROTOCOL_NONE,
+    1,
+    g_psKeyboardReportIdle,
+    KeyboardHandler,
+    (void *)&g_sKeyboardDevice,
+    KeyboardHandler,
+    (void *)&g_sKeyboardDevice,
+    false,
+    &g_sKeyboardHIDDescriptor,
+    g_ppui8KeyboardClassDescriptors,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS,
+    g_ppsKeyboardConfigDescriptors
+};
+#endif
+
+#if GAMEPAD_COMPOSITE
+//*****************************************************************************
+//
+// The composite device made of the gamepads and the optional telemetry, LCD
+// and keyboard interfaces.  The class drivers fill in the entries.
+//
+//*****************************************************************************
+#define NUM_COMPOSITE_DEVICES   (GAMEPAD_PLAYERS + GAMEPAD_CDC +              \
+                                 GAMEPAD_LCD_PUSH + GAMEPAD_KEYBOARD)
+#define COMPOSITE_DESC_SIZE     ((GAMEPAD_PLAYERS * COMPOSITE_DHID_SIZE) +    \
+                                 (GAMEPAD_CDC ? COMPOSITE_DCDC_SIZE : 0) +    \
+                                 (GAMEPAD_LCD_PUSH ? COMPOSITE_DBULK_SIZE :   \
+                                                     0) +                     \
+                                 (GAMEPAD_KEYBOARD ? COMPOSITE_DHID_SIZE : 0))
+
+static tCompositeEntry g_psCompositeEntries[NUM_COMPOSITE_DEVICES];
+static uint8_t g_pui8CompositeDescriptor[COMPOSITE_DESC_SIZE];
+
+tUSBDCompositeDevice g_sCompositeDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_COMP_HID_SER,
+    0,
+    GAMEPAD_PWR_ATTRIBUTES,
+    0,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS,
+    NUM_COMPOSITE_DEVICES,
+    g_psCompositeEntries
+};
+#endif
+
+//*****************************************************************************
+//
+// The maximum size of the configuration descriptor and the number of
+// sections it may be built from.  The HID gamepad uses four sections
+// (configuration, interface, HID and endpoint descriptors) and the composite
+// device two (configuration and everything else).  The composite descriptor
+// is built in g_pui8CompositeDescriptor, so it can be no larger than that.
+//
+//*****************************************************************************
+#if GAMEPAD_COMPOSITE
+#define CONFIG_DESC_MAX_SIZE    COMPOSITE_DESC_SIZE
+#else
+#define CONFIG_DESC_MAX_SIZE    (sizeof(g_pui8GamepadConfigDescriptor) +      \
+                                 sizeof(g_pui8GamepadInterface) +             \
+                                 sizeof(g_sGamepadHIDDescriptor) +            \
+                                 sizeof(g_pui8GamepadInEndpoint))
+#endif
+#define CONFIG_DESC_MAX_SECTIONS 4
+
+GAMEPAD_REPORT_ASSERT((sizeof(g_psGamepadSections) /
+                       sizeof(g_psGamepadSections[0])) <=
+                      CONFIG_DESC_MAX_SECTIONS,
+                      g_pcGamepadConfigSectionsFit);
+
+//*****************************************************************************
+//
+// A RAM copy of the configuration descriptor published by the HID class
+// driver.  The class driver's descriptors are in flash so the endpoint's
+// polling interval is patched in this copy instead.
+//
+//*****************************************************************************
+static uint8_t g_pui8ConfigDescriptor[CONFIG_DESC_MAX_SIZE];
+static tConfigSection g_psConfigSections[CONFIG_DESC_MAX_SECTIONS];
+static const tConfigSection *g_ppsConfigSections[CONFIG_DESC_MAX_SECTIONS];
+static tConfigHeader g_sConfigHeader;
+static const tConfigHeader * const g_ppsConfigDescriptors[] =
+{
+    &g_sConfigHeader
+};
+
+//*****************************************************************************
+//
+// The polling interval currently published, in milliseconds.
+//
+//*****************************************************************************
+static uint32_t g_ui32PollInterval;
+
+//*****************************************************************************
+//
+// Walks the RAM copy of the configuration descriptor and sets the
+// configuration attributes and the interrupt IN endpoints' bInterval, so
+// the keyboard is polled as often as the gamepad.
+//
+//*****************************************************************************
+static void
+ConfigDescriptorPatch(uint32_t ui32IntervalMs)
+{
+    tDescriptorHeader *psHdr;
+    tConfigDescriptor *psConfig;
+    tEndpointDescriptor *psEndpoint;
+    uint32_t ui32Section, ui32Offset;
+
+    for(ui32Section = 0; ui32Section < g_sConfigHeader.ui8NumSections;
+        ui32Section++)
+    {
+        ui32Offset = 0;
+
+        while(ui32Offset < g_psConfigSections[ui32Section].ui16Size)
+        {
+            psHdr = (tDescriptorHeader *)
+                    (g_psConfigSections[ui32Section].pui8Data + ui32Offset);
+
+            if(psHdr->bLength == 0)
+            {
+                break;
+            }
+
+            if(psHdr->bDescriptorType == USB_DTYPE_CONFIGURATION)
+            {
+                //
+                // USBDHIDInit() normally fills these in from the device
+                // structure.
+                //
+                psConfig = (tConfigDescriptor *)psHdr;
+                psConfig->bmAttributes = g_sGamepadDevice.ui8PwrAttributes;
+                psConfig->bMaxPower =
+                    (uint8_t)(g_sGamepadDevice.ui16MaxPowermA / 2);
+            }
+            else if(psHdr->bDescriptorType == USB_DTYPE_ENDPOINT)
+            {
+                psEndpoint = (tEndpointDescriptor *)psHdr;
+                if((psEndpoint->bEndpointAddress & USB_EP_DESC_IN) &&
+                   ((psEndpoint->bmAttributes & USB_EP_ATTR_TYPE_M) ==
+                    USB_EP_ATTR_INT))
+                {
+                    psEndpoint->bInterval = (uint8_t)ui32IntervalMs;
+                }
+            }
+
+            ui32Offset += psHdr->bLength;
+        }
+    }
+
+    g_ui32PollInterval = ui32IntervalMs;
+}
+
+//*****************************************************************************
+//
+// Initializes the gamepad device and places it on the bus, requesting the
+// given polling interval.
+//
+// This replaces USBDHIDInit().  It performs the same steps, but
+// copies the class driver's configuration descriptor to RAM and patches it
+// before the device is connected.
+//
+// With GAMEPAD_COMPOSITE the gamepad and the other interfaces are combined
+// with USBDCompositeInit() instead.  That places the device on the bus itself, so
+// it is taken straight back off until the patched descriptor is in place.
+//
+//*****************************************************************************
+void
+GamepadDeviceInit(uint32_t ui32IntervalMs)
+{
+    tDeviceInfo *psDevInfo;
+    const tConfigHeader *psHeader;
+    uint32_t ui32Section, ui32Size, ui32Len, ui32Idx;
+
+    if((ui32IntervalMs < GAMEPAD_POLL_INTERVAL_MIN) ||
+       (ui32IntervalMs > GAMEPAD_POLL_INTERVAL_MAX))
+    {
+        ui32IntervalMs = GAMEPAD_POLL_INTERVAL_MS;
+    }
+
+#if GAMEPAD_COMPOSITE
+    //
+    // Build the composite device from the class drivers.
+    //
+    ui32Idx = 0;
+    USBDHIDCompositeInit(0, &g_sGamepadDevice,
+                         &g_psCompositeEntries[ui32Idx++]);
+#if GAMEPAD_PLAYERS > 1
+    USBDHIDCompositeInit(0, &g_sGamepad2Device,
+                         &g_psCompositeEntries[ui32Idx++]);
+#endif
+#if GAMEPAD_CDC
+    USBDCDCCompositeInit(0, &g_sTelemetryDevice,
+                         &g_psCompositeEntries[ui32Idx++]);
+#endif
+#if GAMEPAD_LCD_PUSH
+    USBDBulkCompositeInit(0, &g_sLCDPushDevice,
+                          &g_psCompositeEntries[ui32Idx++]);
+#endif
+#if GAMEPAD_KEYBOARD
+    USBDHIDCompositeInit(0, &g_sKeyboardDevice,
+                         &g_psCompositeEntries[ui32Idx++]);
+#endif
+    USBDCompositeInit(0, &g_sCompositeDevice, COMPOSITE_DESC_SIZE,
+                      g_pui8CompositeDescriptor);
+    USBDevDisconnect(USB0_BASE);
+
+    psDevInfo = &g_sCompositeDevice.sPrivateData.sDevInfo;
+#else
+    //
+    // Let the class driver set itself up without connecting.
+    //
+    USBDHIDCompositeInit(0, &g_sGamepadDevice, 0);
+
+    psDevInfo = &g_sGamepadDevice.sPrivateData.sDevInfo;
+#endif
+
+    //
+    // Copy each section of its configuration descriptor to RAM.
+    //
+    psHeader = psDevInfo->ppsConfigDescriptors[0];
+    ui32Size = 0;
+
+    ASSERT(psHeader->ui8NumSections <= CONFIG_DESC_MAX_SECTIONS);
+
+    for(ui32Section = 0; ui32Section < psHeader->ui8NumSections;
+        ui32Section++)
+    {
+        ui32Len = psHeader->psSections[ui32Section]->ui16Size;
+
+        ASSERT((ui32Size + ui32Len) <= CONFIG_DESC_MAX_SIZE);
+
+        for(ui32Idx = 0; ui32Idx < ui32Len; ui32Idx++)
+        {
+            g_pui8ConfigDescriptor[ui32Size + ui32Idx] =
+                psHeader->psSections[ui32Section]->pui8Data[ui32Idx];
+        }
+
+        g_psConfigSections[ui32Section].ui16Size = (uint16_t)ui32Len;
+        g_psConfigSections[ui32Section].pui8Data =
+            &g_pui8ConfigDescriptor[ui32Size];
+        g_ppsConfigSections[ui32Section] = &g_psConfigSections[ui32Section];
+        ui32Size += ui32Len;
+    }
+
+    g_sConfigHeader.ui8NumSections = (uint8_t)ui32Section;
+    g_sConfigHeader.psSections = g_ppsConfigSections;
+
+    ConfigDescriptorPatch(ui32IntervalMs);
+
+    //
+    // Publish the patched copy and place the device on the bus.
+    //
+    psDevInfo->ppsConfigDescriptors = g_ppsConfigDescriptors;
+#if GAMEPAD_COMPOSITE
+    USBDevConnect(USB0_BASE);
+#else
+    USBDCDInit(0, psDevInfo, (void *)&g_sGamepadDevice);
+#endif
+}
+
+//*****************************************************************************
+//
+// Changes the polling interval at run time.  The host only reads the
+// endpoint descriptor during enumeration, so the device is briefly
+// disconnected from the bus to make it enumerate again.  This blocks for
+// about 100ms and must not be called from interrupt context.
+//
+// \return Returns false if the interval is out of range.
+//
+//*****************************************************************************
+bool
+GamepadPollIntervalSet(uint32_t ui32IntervalMs)
+{
+    if((ui32IntervalMs < GAMEPAD_POLL_INTERVAL_MIN) ||
+       (ui32IntervalMs > GAMEPAD_POLL_INTERVAL_MAX))
+    {
+        return(false);
+    }
+
+    if(ui32IntervalMs == g_ui32PollInterval)
+    {
+        return(true);
+    }
+
+    USBDevDisconnect(USB0_BASE);
+    ConfigDescriptorPatch(ui32IntervalMs);
+
+    //
+    // Stay off the bus long enough for the host to notice.
+    //
+    ROM_SysCtlDelay(ROM_SysCtlClockGet() / 30);
+
+    USBDevConnect(USB0_BASE);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns the polling interval currently published, in milliseconds.
+//
+//*****************************************************************************
+uint32_t
+GamepadPollIntervalGet(void)
+{
+    return(g_ui32PollInterval);
+}
@@ -28,6 +28,104 @@
 extern uint32_t GamepadHandler(void *pvCBData, uint32_t ui32Event,
                                uint32_t ui32MsgData, void *pvMsgData);
 
-extern tUSBDHIDGamepadDevice g_sGamepadDevice;
+extern tUSBDHIDDevice g_sGamepadDevice;
+
+//*****************************************************************************
+//
+// The configuration attributes of every interface.  The stick can wake a
+// suspended host when a button is pressed.
+//
+//*****************************************************************************
+#define GAMEPAD_PWR_ATTRIBUTES          (USB_CONF_ATTR_SELF_PWR |             \
+                                         USB_CONF_ATTR_RWAKE)
+
+//*****************************************************************************
+//
+// The number of players.  Set to 2 for a second gamepad interface that
+// reports player two's buttons, read from the pins in button_map.c.  This is
+// off by default: on a stock LaunchPad PD0 and PD1 are tied to PB6 and PB7,
+// so player two would echo player one's buttons 7 and 8.
+//
+//*****************************************************************************
+#ifndef GAMEPAD_PLAYERS
+#define GAMEPAD_PLAYERS                 1
+#endif
+
+#if GAMEPAD_PLAYERS > 1
+extern uint32_t Gamepad2Handler(void *pvCBData, uint32_t ui32Event,
+                                uint32_t ui32MsgData, void *pvMsgData);
+
+extern tUSBDHIDDevice g_sGamepad2Device;
+#endif
+
+//*****************************************************************************
+//
+// Set GAMEPAD_CDC to 0 to build the plain HID gamepad without the CDC serial
+// telemetry interface.  With it the stick enumerates as a composite device.
+//
+//*****************************************************************************
+#ifndef GAMEPAD_CDC
+#define GAMEPAD_CDC                     1
+#endif
+
+#if GAMEPAD_CDC
+extern const tUSBBuffer g_sTelemetryTxBuffer;
+extern const tUSBBuffer g_sTelemetryRxBuffer;
+#endif
+
+//*****************************************************************************
+//
+// Set GAMEPAD_LCD_PUSH to 0 to leave out the vendor bulk interface that lets
+// a host draw on the LCD.
+//
+//*****************************************************************************
+#ifndef GAMEPAD_LCD_PUSH
+#define GAMEPAD_LCD_PUSH                1
+#endif
+
+#if GAMEPAD_LCD_PUSH
+extern const tUSBBuffer g_sLCDPushRxBuffer;
+#endif
+
+//*****************************************************************************
+//
+// Set GAMEPAD_KEYBOARD to 0 to leave out the keyboard interface used by
+// keyboard mode.
+//
+//*****************************************************************************
+#ifndef GAMEPAD_KEYBOARD
+#define GAMEPAD_KEYBOARD                1
+#endif
+
+#if GAMEPAD_KEYBOARD
+extern tUSBDHIDDevice g_sKeyboardDevice;
+#endif
+
+//*****************************************************************************
+//
+// The stick is a composite device whenever it has any interface besides
+// player one's gamepad.
+//
+//*****************************************************************************
+#define GAMEPAD_COMPOSITE               (GAMEPAD_CDC || GAMEPAD_LCD_PUSH ||   \
+                                         GAMEPAD_KEYBOARD ||                  \
+                                         (GAMEPAD_PLAYERS > 1))
+
+//*****************************************************************************
+//
+// The interrupt IN endpoint polling interval requested from the host, in
+// milliseconds.  This can be overridden at build time and changed at run
+// time with GamepadPollIntervalSet().
+//
+//*****************************************************************************
+#ifndef GAMEPAD_POLL_INTERVAL_MS
+#define GAMEPAD_POLL_INTERVAL_MS        1
+#endif
+#define GAMEPAD_POLL_INTERVAL_MIN       1
+#define GAMEPAD_POLL_INTERVAL_MAX       10
+
+extern void GamepadDeviceInit(uint32_t ui32IntervalMs);
+extern bool GamepadPollIntervalSet(uint32_t ui32IntervalMs);
+extern uint32_t GamepadPollIntervalGet(void);
 
 #endif
@@ -0,0 +1,236 @@
+//*****************************************************************************
+//
+// usb_hid_fast.c - Direct FIFO send path for the HID interrupt IN endpoint.
+//
+// USBDHIDReportWrite() goes through the HID class and the driverlib
+// endpoint calls before the report reaches the FIFO, and copies it one byte
+// at a time.  HIDFastSend() instead writes the packed report straight into
+// the endpoint FIFO with word accesses and sets TXRDY, while leaving usblib's
+// state exactly as USBDHIDReportWrite() would have.  usblib therefore still
+// owns enumeration, control requests and the transmit complete interrupt, and
+// raises USB_EVENT_TX_COMPLETE as usual.
+//
+// The state updates below mirror usbdhid.c from TivaWare 2.1.4 and must be
+// checked against them if usblib is updated.  The fast path does not restart
+// the HID idle report timer.  Gamepads are left at the default idle rate of
+// zero by the host, where that timer is not used.
+//
+// This must only be called from the USB interrupt or from an interrupt of
+// the same priority, so that the transmit complete handling cannot run part
+// way through.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_usb.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/usb.h"
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdhid.h"
+#include "timestamp.h"
+#include "usb_hid_fast.h"
+
+//*****************************************************************************
+//
+// The endpoint's FIFO and TXCSRL registers, from a driverlib USB_EP_n value.
+// These are the same calculations as USBFIFOAddrGet() and EP_OFFSET() in
+// usb.c.
+//
+//*****************************************************************************
+#define HID_FAST_FIFO(ui32Base, ui32Endpoint)                                 \
+        ((ui32Base) + USB_O_FIFO0 + ((ui32Endpoint) >> 2))
+#define HID_FAST_TXCSRL(ui32Base, ui32Endpoint)                               \
+        ((ui32Base) + USB_O_TXCSRL1 + ((ui32Endpoint) - USB_EP_1))
+
+//*****************************************************************************
+//
+// Per path statistics.  The average is kept in 1/16th cycles.
+//
+//*****************************************************************************
+static tHIDSendStats g_psHIDSendStats[HID_SEND_PATHS];
+static uint32_t g_pui32HIDSendAvg16[HID_SEND_PATHS];
+
+//*****************************************************************************
+//
+// Adds one accepted send to a path's statistics.
+//
+//*****************************************************************************
+static void
+HIDFastStatsAdd(uint32_t ui32Path, uint32_t ui32Cycles)
+{
+    tHIDSendStats *psStats;
+
+    psStats = &g_psHIDSendStats[ui32Path];
+
+    if(!psStats->ui32Count || (ui32Cycles < psStats->ui32MinCycles))
+    {
+        psStats->ui32MinCycles = ui32Cycles;
+    }
+    if(ui32Cycles > psStats->ui32MaxCycles)
+    {
+        psStats->ui32MaxCycles = ui32Cycles;
+    }
+
+    if(!psStats->ui32Count)
+    {
+        g_pui32HIDSendAvg16[ui32Path] = ui32Cycles << 4;
+    }
+    else
+    {
+        g_pui32HIDSendAvg16[ui32Path] += ui32Cycles -
+                                         (g_pui32HIDSendAvg16[ui32Path] >> 4);
+    }
+    psStats->ui32AvgCycles = g_pui32HIDSendAvg16[ui32Path] >> 4;
+    psStats->ui32Count++;
+}
+
+//*****************************************************************************
+//
+// Writes the report into the IN endpoint FIFO and arms it.
+//
+// \return Returns true if the report was queued, or false if the endpoint
+// is not configured or still holds the previous report.
+//
+//*****************************************************************************
+static bool
+HIDFastWrite(tUSBDHIDDevice *psHIDDevice, const uint8_t *pui8Report,
+             uint32_t ui32Size)
+{
+    tHIDInstance *psInst;
+    uint32_t ui32Base, ui32Endpoint, ui32Fifo, ui32Word;
+
+    psInst = &psHIDDevice->sPrivateData;
+
+    //
+    // The transmit state is only idle while the interface is configured.
+    //
+    if(psInst->iHIDTxState != eHIDStateIdle)
+    {
+        return(false);
+    }
+
+    ui32Base = psInst->ui32USBBase;
+    ui32Endpoint = psInst->ui8INEndpoint;
+
+    //
+    // The FIFO should be empty once the class state is idle, but do not
+    // queue behind a packet the hardware has not sent.
+    //
+    if(HWREGB(HID_FAST_TXCSRL(ui32Base, ui32Endpoint)) & USB_TXCSRL1_TXRDY)
+    {
+        return(false);
+    }
+
+    //
+    // Mark the transfer in progress the way USBDHIDReportWrite() does, so
+    // usblib handles its completion.
+    //
+    psInst->iHIDTxState = eHIDStateWaitData;
+    psInst->pui8InReport = (uint8_t *)pui8Report;
+    psInst->ui16InReportSize = (uint16_t)ui32Size;
+    psInst->ui16InReportIndex = (uint16_t)ui32Size;
+
+    //
+    // Copy the report with word writes, then the remaining bytes.  The FIFO
+    // register accepts any access size.
+    //
+    ui32Fifo = HID_FAST_FIFO(ui32Base, ui32Endpoint);
+    for(; ui32Size >= 4; ui32Size -= 4, pui8Report += 4)
+    {
+        ui32Word = (uint32_t)pui8Report[0] |
+                   ((uint32_t)pui8Report[1] << 8) |
+                   ((uint32_t)pui8Report[2] << 16) |
+                   ((uint32_t)pui8Report[3] << 24);
+        HWREG(ui32Fifo) = ui32Word;
+    }
+    for(; ui32Size; ui32Size--)
+    {
+        HWREGB(ui32Fifo) = *pui8Report++;
+    }
+
+    //
+    // Hand the packet to the hardware.
+    //
+    HWREGB(HID_FAST_TXCSRL(ui32Base, ui32Endpoint)) = USB_TXCSRL1_TXRDY;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Sends a report on a gamepad's interrupt IN endpoint through the path
+// selected at build time, and records how many cycles it took.
+//
+// \return Returns true if the report was queued.
+//
+//*****************************************************************************
+bool
+HIDFastSend(tUSBDHIDDevice *psHIDDevice, const uint8_t *pui8Report,
+            uint32_t ui32Size)
+{
+    uint32_t ui32Start, ui32Path;
+    bool bSent;
+#if HID_FAST_COMPARE
+    static uint32_t ui32Toggle;
+
+    ui32Path = (ui32Toggle++ & 1) ? HID_SEND_FAST : HID_SEND_USBLIB;
+#else
+    ui32Path = HID_FAST_PATH ? HID_SEND_FAST : HID_SEND_USBLIB;
+#endif
+
+    ui32Start = TimestampGet();
+
+    if(ui32Path == HID_SEND_FAST)
+    {
+        bSent = HIDFastWrite(psHIDDevice, pui8Report, ui32Size);
+    }
+    else
+    {
+        bSent = (USBDHIDReportWrite(psHIDDevice, (uint8_t *)pui8Report,
+                                    ui32Size, false) != 0);
+    }
+
+    if(bSent)
+    {
+        HIDFastStatsAdd(ui32Path, TimestampGet() - ui32Start);
+    }
+
+    return(bSent);
+}
+
+//*****************************************************************************
+//
+// Returns the statistics for one send path.  The copy is made with the
+// sending interrupts masked, and they are left as they were found so that
+// this may also be called from those interrupts.
+//
+//*****************************************************************************
+void
+HIDFastStatsGet(uint32_t ui32Path, tHIDSendStats *psStats)
+{
+    bool bUSB, bTimer;
+
+    bUSB = IntIsEnabled(INT_USB0) ? true : false;
+    bTimer = IntIsEnabled(INT_TIMER0A) ? true : false;
+
+    ROM_IntDisable(INT_TIMER0A);
+    ROM_IntDisable(INT_USB0);
+
+    *psStats = g_psHIDSendStats[ui32Path];
+
+    if(bUSB)
+    {
+        ROM_IntEnable(INT_USB0);
+    }
+    if(bTimer)
+    {
+        ROM_IntEnable(INT_TIMER0A);
+    }
+}
@@ -0,0 +1,61 @@
+//*****************************************************************************
+//
+// usb_hid_fast.h - Direct FIFO send path for the HID interrupt IN endpoint.
+//
+//*****************************************************************************
+
+#ifndef _USB_HID_FAST_H_
+#define _USB_HID_FAST_H_
+
+//*****************************************************************************
+//
+// Set HID_FAST_PATH to 0 to send every report through USBDHIDReportWrite()
+// instead of writing the endpoint FIFO directly.
+//
+// Set HID_FAST_COMPARE to 1 to alternate between the two paths report by
+// report so that both sets of cycle counts are gathered under the same
+// conditions.
+//
+//*****************************************************************************
+#ifndef HID_FAST_PATH
+#define HID_FAST_PATH           1
+#endif
+
+#ifndef HID_FAST_COMPARE
+#define HID_FAST_COMPARE        0
+#endif
+
+//*****************************************************************************
+//
+// The send paths, used to index the statistics.
+//
+//*****************************************************************************
+#define HID_SEND_USBLIB         0
+#define HID_SEND_FAST           1
+#define HID_SEND_PATHS          2
+
+//*****************************************************************************
+//
+// Cycle counts for the reports accepted by one send path, measured from the
+// call to the report being armed in the endpoint.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Count;
+    uint32_t ui32MinCycles;
+    uint32_t ui32MaxCycles;
+    uint32_t ui32AvgCycles;
+}
+tHIDSendStats;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern bool HIDFastSend(tUSBDHIDDevice *psHIDDevice,
+                        const uint8_t *pui8Report, uint32_t ui32Size);
+extern void HIDFastStatsGet(uint32_t ui32Path, tHIDSendStats *psStats);
+
+#endif
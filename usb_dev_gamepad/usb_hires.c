@@ -0,0 +1,145 @@
+//*****************************************************************************
+//
+// usb_hires.c - High resolution button sampling for the batched report.
+//
+// Full speed USB delivers at most one interrupt report per millisecond, but
+// the buttons can be read much faster than that.  Timer1A samples them every
+// GAMEPAD_HIRES_SLOT_US microseconds into a small ring, and HiresFill()
+// copies the most recent GAMEPAD_HIRES_SLOTS samples into the report just
+// before it is packed, so one transfer carries the whole polling interval at
+// sub-millisecond resolution.
+//
+// Timer1A runs at a higher priority than the USB interrupt and Timer0A so the
+// sampling period does not pick up their execution time as jitter.  Those two
+// are lowered together to keep them at a shared priority, which the SOF
+// scheduler relies on.  Because the sampler can now preempt the report
+// builder, HiresFill() reads the ring optimistically and retries if a sample
+// arrived part way through the copy.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "timestamp.h"
+#include "usb_gamepad_report.h"
+#include "usb_hires.h"
+
+//*****************************************************************************
+//
+// Interrupt priorities.  Only the top three bits are implemented.
+//
+//*****************************************************************************
+#define HIRES_INT_PRIORITY      0x00
+#define HIRES_USB_PRIORITY      0x20
+
+//*****************************************************************************
+//
+// The sample ring.  g_ui32HiresCount is the total number of samples taken;
+// the newest is in slot (g_ui32HiresCount - 1) of the ring and was taken at
+// DWT time g_ui32HiresTime.
+//
+//*****************************************************************************
+#define HIRES_RING_MASK         (GAMEPAD_HIRES_SLOTS - 1)
+
+static uint16_t g_pui16HiresRing[GAMEPAD_HIRES_SLOTS];
+static volatile uint32_t g_ui32HiresCount;
+static volatile uint32_t g_ui32HiresTime;
+static tHiresSampleFn g_pfnHiresSample;
+
+//*****************************************************************************
+//
+// Timer1A interrupt handler.  Takes one sample.
+//
+//*****************************************************************************
+void
+HiresTimerIntHandler(void)
+{
+    uint32_t ui32Count;
+
+    ROM_TimerIntClear(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
+
+    ui32Count = g_ui32HiresCount;
+    g_pui16HiresRing[ui32Count & HIRES_RING_MASK] = g_pfnHiresSample();
+    g_ui32HiresTime = TimestampGet();
+    g_ui32HiresCount = ui32Count + 1;
+}
+
+//*****************************************************************************
+//
+// Copies the most recent samples, oldest first, into the report fields along
+// with the sequence number and age of the newest one.
+//
+//*****************************************************************************
+void
+HiresFill(tGamepadReportFields *psFields)
+{
+#if GAMEPAD_HIRES
+    uint32_t ui32Count, ui32Time, ui32Idx, ui32AgeUs;
+
+    do
+    {
+        ui32Count = g_ui32HiresCount;
+        ui32Time = g_ui32HiresTime;
+
+        for(ui32Idx = 0; ui32Idx < GAMEPAD_HIRES_SLOTS; ui32Idx++)
+        {
+            psFields->pui16HiresSlots[ui32Idx] =
+                g_pui16HiresRing[(ui32Count + ui32Idx) & HIRES_RING_MASK];
+        }
+    }
+    while(ui32Count != g_ui32HiresCount);
+
+    ui32AgeUs = TimestampToUs(TimestampGet() - ui32Time);
+
+    psFields->pui16HiresSeq[0] = (uint16_t)((ui32Count - 1) & 0xff);
+    psFields->pui16HiresAge[0] = (uint16_t)((ui32AgeUs > 255) ? 255 :
+                                            ui32AgeUs);
+#else
+    (void)psFields;
+#endif
+}
+
+//*****************************************************************************
+//
+// Starts Timer1A sampling the buttons with pfnSample.  This must be called
+// after TimestampInit() and SOFSyncInit().
+//
+//*****************************************************************************
+void
+HiresInit(tHiresSampleFn pfnSample)
+{
+    uint32_t ui32Idx;
+    uint16_t ui16Sample;
+
+    //
+    // Fill the ring with the current state so that the first reports do not
+    // show edges that never happened.
+    //
+    g_pfnHiresSample = pfnSample;
+    ui16Sample = pfnSample();
+    for(ui32Idx = 0; ui32Idx < GAMEPAD_HIRES_SLOTS; ui32Idx++)
+    {
+        g_pui16HiresRing[ui32Idx] = ui16Sample;
+    }
+    g_ui32HiresTime = TimestampGet();
+    g_ui32HiresCount = GAMEPAD_HIRES_SLOTS;
+
+    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
+    ROM_TimerConfigure(TIMER1_BASE, TIMER_CFG_PERIODIC);
+    ROM_TimerLoadSet(TIMER1_BASE, TIMER_A,
+                     TimestampFromUs(GAMEPAD_HIRES_SLOT_US) - 1);
+    ROM_TimerIntEnable(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
+
+    ROM_IntPrioritySet(INT_USB0, HIRES_USB_PRIORITY);
+    ROM_IntPrioritySet(INT_TIMER0A, HIRES_USB_PRIORITY);
+    ROM_IntPrioritySet(INT_TIMER1A, HIRES_INT_PRIORITY);
+
+    ROM_IntEnable(INT_TIMER1A);
+    ROM_TimerEnable(TIMER1_BASE, TIMER_A);
+}
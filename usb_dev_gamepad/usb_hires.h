@@ -0,0 +1,27 @@
+//*****************************************************************************
+//
+// usb_hires.h - High resolution button sampling for the batched report.
+//
+//*****************************************************************************
+
+#ifndef _USB_HIRES_H_
+#define _USB_HIRES_H_
+
+//*****************************************************************************
+//
+// The function called from the sampling interrupt to read the buttons.  It
+// returns them in the bit layout of the report's Buttons field.
+//
+//*****************************************************************************
+typedef uint16_t (*tHiresSampleFn)(void);
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void HiresInit(tHiresSampleFn pfnSample);
+extern void HiresFill(tGamepadReportFields *psFields);
+extern void HiresTimerIntHandler(void);
+
+#endif
@@ -0,0 +1,302 @@
+//*****************************************************************************
+//
+// usb_keyboard.c - N-key rollover keyboard interface for the arcade stick.
+//
+// In keyboard mode the buttons are reported as key presses on a separate
+// HID keyboard interface of the composite device, so emulators and
+// frontends that only read the keyboard work without a joystick-to-key
+// mapper on the host.  The gamepad interface stays enumerated but reports
+// no buttons, so nothing is pressed twice.
+//
+// The report is a bitmap rather than the boot protocol's list of six keys,
+// so every button can be held at once.  Buttons are turned into key usages
+// through a lookup table that starts out with MAME's default keys.  A report
+// is only sent when the set of keys changes, from the same interrupt path
+// that builds the gamepad reports, and the endpoint is polled at the same
+// interval as the gamepad's.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdhid.h"
+#include "usblib/device/usbdhidgamepad.h"
+#include "usb_gamepad_structs.h"
+#include "usb_keyboard.h"
+
+//*****************************************************************************
+//
+// The key usage reported for each button, indexed by the button's bit in
+// the gamepad report.  0 leaves a button unmapped.  The defaults are MAME's
+// player one controls.
+//
+//*****************************************************************************
+static uint8_t g_pui8KeyboardMap[KEYBOARD_BUTTONS] =
+{
+    0xe0,                               // Button 1: left Ctrl, P1 button 1
+    0xe2,                               // Button 2: left Alt, P1 button 2
+    0x2c,                               // Button 3: Space, P1 button 3
+    0xe1,                               // Button 4: left Shift, P1 button 4
+    0x1d,                               // Button 5: Z, P1 button 5
+    0x1b,                               // Button 6: X, P1 button 6
+    0x06,                               // Button 7: C, P1 button 7
+    0x19,                               // Button 8: V, P1 button 8
+    0x1e,                               // Button 9: 1, P1 start
+    0x22,                               // Button 10: 5, coin 1
+    0x1f,                               // Button 11: 2, P2 start
+    0x23,                               // Button 12: 6, coin 2
+    0x2b,                               // Button 13: Tab, menu
+    0x13,                               // Button 14: P, pause
+    0x00                                // Button 15: input view, unmapped
+};
+
+//*****************************************************************************
+//
+// Set while the stick reports its buttons as keys.
+//
+//*****************************************************************************
+static volatile bool g_bKeyboardMode = KEYBOARD_DEFAULT;
+
+#if GAMEPAD_KEYBOARD
+//*****************************************************************************
+//
+// The report the USB stack last accepted, the buffer it sends from, the
+// buttons the report should reflect and the interface state.  These are
+// only touched from the USB and Timer0A interrupts, which share a priority.
+//
+//*****************************************************************************
+static uint8_t g_pui8KeyboardReport[KEYBOARD_REPORT_SIZE];
+static uint8_t g_pui8KeyboardTxReport[KEYBOARD_REPORT_SIZE];
+static uint16_t g_ui16KeyboardButtons;
+static bool g_bKeyboardConfigured;
+static bool g_bKeyboardSending;
+
+//*****************************************************************************
+//
+// Builds a report from the button state.
+//
+//*****************************************************************************
+static void
+KeyboardReportBuild(uint16_t ui16Buttons, uint8_t *pui8Report)
+{
+    uint32_t ui32Idx;
+    uint8_t ui8Usage;
+
+    for(ui32Idx = 0; ui32Idx < KEYBOARD_REPORT_SIZE; ui32Idx++)
+    {
+        pui8Report[ui32Idx] = 0;
+    }
+
+    for(ui32Idx = 0; ui32Idx < KEYBOARD_BUTTONS; ui32Idx++)
+    {
+        if(!(ui16Buttons & (1 << ui32Idx)))
+        {
+            continue;
+        }
+
+        ui8Usage = g_pui8KeyboardMap[ui32Idx];
+
+        if((ui8Usage >= KEYBOARD_USAGE_MOD_FIRST) &&
+           (ui8Usage <= KEYBOARD_USAGE_MOD_LAST))
+        {
+            pui8Report[0] |= 1 << (ui8Usage - KEYBOARD_USAGE_MOD_FIRST);
+        }
+        else if(ui8Usage && (ui8Usage < KEYBOARD_KEYS))
+        {
+            pui8Report[1 + (ui8Usage >> 3)] |= 1 << (ui8Usage & 7);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Sends a report if the keys have changed since the last one the stack
+// accepted and the endpoint is free.  Otherwise TX_COMPLETE will call this
+// again.  A write the stack refuses is not remembered, so the change is
+// retried on the next call.
+//
+//*****************************************************************************
+static void
+KeyboardSend(void)
+{
+    uint32_t ui32Idx;
+
+    if(!g_bKeyboardConfigured || g_bKeyboardSending)
+    {
+        return;
+    }
+
+    KeyboardReportBuild(g_bKeyboardMode ? g_ui16KeyboardButtons : 0,
+                        g_pui8KeyboardTxReport);
+
+    for(ui32Idx = 0; ui32Idx < KEYBOARD_REPORT_SIZE; ui32Idx++)
+    {
+        if(g_pui8KeyboardTxReport[ui32Idx] != g_pui8KeyboardReport[ui32Idx])
+        {
+            break;
+        }
+    }
+
+    if(ui32Idx == KEYBOARD_REPORT_SIZE)
+    {
+        return;
+    }
+
+    if(!USBDHIDReportWrite(&g_sKeyboardDevice, g_pui8KeyboardTxReport,
+                           KEYBOARD_REPORT_SIZE, false))
+    {
+        return;
+    }
+
+    g_bKeyboardSending = true;
+
+    for(ui32Idx = 0; ui32Idx < KEYBOARD_REPORT_SIZE; ui32Idx++)
+    {
+        g_pui8KeyboardReport[ui32Idx] = g_pui8KeyboardTxReport[ui32Idx];
+    }
+}
+
+//*****************************************************************************
+//
+// Handles events from the keyboard's HID class driver.
+//
+//*****************************************************************************
+uint32_t
+KeyboardHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+                void *pvMsgData)
+{
+    uint32_t ui32Idx;
+
+    switch(ui32Event)
+    {
+        //
+        // The host has configured the device and assumes no keys are held.
+        //
+        case USB_EVENT_CONNECTED:
+        {
+            for(ui32Idx = 0; ui32Idx < KEYBOARD_REPORT_SIZE; ui32Idx++)
+            {
+                g_pui8KeyboardReport[ui32Idx] = 0;
+            }
+            g_bKeyboardConfigured = true;
+            g_bKeyboardSending = false;
+            KeyboardSend();
+            break;
+        }
+
+        case USB_EVENT_DISCONNECTED:
+        {
+            g_bKeyboardConfigured = false;
+            break;
+        }
+
+        //
+        // The host has collected a report.  Send the next change, if any.
+        //
+        case USB_EVENT_TX_COMPLETE:
+        {
+            g_bKeyboardSending = false;
+            KeyboardSend();
+            break;
+        }
+
+        //
+        // The host asked for the current report, either on the control
+        // endpoint or because an idle period it set has run out.
+        //
+        case USBD_HID_EVENT_GET_REPORT:
+        case USBD_HID_EVENT_IDLE_TIMEOUT:
+        {
+            *(void **)pvMsgData = (void *)g_pui8KeyboardReport;
+            return(KEYBOARD_REPORT_SIZE);
+        }
+
+        //
+        // There are no output or feature reports, so the LED state a host
+        // may try to write is not accepted.
+        //
+        case USBD_HID_EVENT_GET_REPORT_BUFFER:
+        {
+            return(0);
+        }
+
+        //
+        // We ignore all other events.
+        //
+        default:
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+#endif
+
+//*****************************************************************************
+//
+// Switches between reporting the buttons on the gamepad and as keys.  Any
+// keys held when keyboard mode is left are released.
+//
+//*****************************************************************************
+void
+KeyboardModeSet(bool bKeyboard)
+{
+    g_bKeyboardMode = GAMEPAD_KEYBOARD && bKeyboard;
+}
+
+//*****************************************************************************
+//
+// Returns true if the buttons are being reported as keys.
+//
+//*****************************************************************************
+bool
+KeyboardModeGet(void)
+{
+    return(g_bKeyboardMode);
+}
+
+//*****************************************************************************
+//
+// Changes the key a button is reported as.  The change takes effect on the
+// next report.
+//
+//*****************************************************************************
+void
+KeyboardMapSet(uint32_t ui32Button, uint8_t ui8Usage)
+{
+    if(ui32Button < KEYBOARD_BUTTONS)
+    {
+        g_pui8KeyboardMap[ui32Button] = ui8Usage;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the key a button is reported as, or 0 if it is unmapped.
+//
+//*****************************************************************************
+uint8_t
+KeyboardMapGet(uint32_t ui32Button)
+{
+    return((ui32Button < KEYBOARD_BUTTONS) ? g_pui8KeyboardMap[ui32Button] :
+                                             0);
+}
+
+//*****************************************************************************
+//
+// Passes the latest debounced buttons, in gamepad report bit order, to the
+// keyboard.  This must be called from the USB or Timer0A interrupt.
+//
+//*****************************************************************************
+void
+KeyboardUpdate(uint16_t ui16Buttons)
+{
+#if GAMEPAD_KEYBOARD
+    g_ui16KeyboardButtons = ui16Buttons;
+    KeyboardSend();
+#endif
+}
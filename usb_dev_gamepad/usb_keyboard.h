@@ -0,0 +1,55 @@
+//*****************************************************************************
+//
+// usb_keyboard.h - N-key rollover keyboard interface for the arcade stick.
+//
+//*****************************************************************************
+
+#ifndef _USB_KEYBOARD_H_
+#define _USB_KEYBOARD_H_
+
+//*****************************************************************************
+//
+// The keyboard report is a modifier byte followed by one bit for each key
+// usage from 0 to KEYBOARD_KEYS - 1, so any number of keys may be held at
+// once.  Usages 0xe0 to 0xe7 are the modifier keys.
+//
+//*****************************************************************************
+#define KEYBOARD_KEYS           120
+#define KEYBOARD_REPORT_SIZE    (1 + (KEYBOARD_KEYS / 8))
+
+#define KEYBOARD_USAGE_MOD_FIRST 0xe0
+#define KEYBOARD_USAGE_MOD_LAST  0xe7
+
+//*****************************************************************************
+//
+// The number of buttons with an entry in the key map.
+//
+//*****************************************************************************
+#define KEYBOARD_BUTTONS        15
+
+//*****************************************************************************
+//
+// Set KEYBOARD_DEFAULT to 1 to start in keyboard mode.  Otherwise holding
+// the buttons in KEYBOARD_BOOT_BUTTONS (report bits) while the stick powers
+// up selects it.
+//
+//*****************************************************************************
+#ifndef KEYBOARD_DEFAULT
+#define KEYBOARD_DEFAULT        0
+#endif
+#define KEYBOARD_BOOT_BUTTONS   0x1000
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void KeyboardModeSet(bool bKeyboard);
+extern bool KeyboardModeGet(void);
+extern void KeyboardMapSet(uint32_t ui32Button, uint8_t ui8Usage);
+extern uint8_t KeyboardMapGet(uint32_t ui32Button);
+extern void KeyboardUpdate(uint16_t ui16Buttons);
+extern uint32_t KeyboardHandler(void *pvCBData, uint32_t ui32Event,
+                                uint32_t ui32MsgData, void *pvMsgData);
+
+#endif
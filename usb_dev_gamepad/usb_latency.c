@@ -0,0 +1,323 @@
+//*****************************************************************************
+//
+// usb_latency.c - Histograms of the time a button change spends in each
+// stage of the input path.
+//
+// One change is followed at a time.  The sampling pass that sees player
+// one's inputs change starts it, and it is carried through the report
+// builder, the packer and the send path to the host collecting the report.
+// Changes that arrive while one is being followed go out in the same or a
+// later report and are not timed separately.  A change that never reaches
+// the report, because it was debounced away, is on an unmapped input or the
+// buttons are being sent as keys, is dropped once it has waited
+// LATENCY_TIMEOUT_US.
+//
+// The time from the pin changing to the sampling pass seeing it depends on
+// when the pass runs, once per frame, and is not included.
+//
+// Everything but the printing runs from the USB and Timer0A interrupts,
+// which share a priority, so the state needs no locking there.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "timestamp.h"
+#include "usb_latency.h"
+#include "usb_telemetry.h"
+
+//*****************************************************************************
+//
+// How long a change may take to get through before it is given up on, and
+// how often the histograms are printed.
+//
+//*****************************************************************************
+#define LATENCY_TIMEOUT_US      500000
+#define LATENCY_PRINT_US        10000000
+
+//*****************************************************************************
+//
+// The progress of the change being followed: the number of stages it has
+// finished, or LATENCY_IDLE if there is none.
+//
+//*****************************************************************************
+#define LATENCY_IDLE            0xffffffff
+
+static uint32_t g_ui32LatencyStage = LATENCY_IDLE;
+
+//*****************************************************************************
+//
+// The cycle count at the sampling pass that saw the change, and at the end
+// of each stage so far.
+//
+//*****************************************************************************
+static uint32_t g_ui32LatencyEdge;
+static uint32_t g_pui32LatencyTimes[LATENCY_STAGE_TOTAL];
+
+//*****************************************************************************
+//
+// The inputs and report buttons at the last sampling pass.
+//
+//*****************************************************************************
+static uint16_t g_ui16LatencyInputs;
+static uint16_t g_ui16LatencyReport;
+
+static tLatencyHist g_psLatencyHist[LATENCY_STAGES];
+
+//*****************************************************************************
+//
+// The printable stage names.
+//
+//*****************************************************************************
+static const char * const g_ppcLatencyNames[LATENCY_STAGES] =
+{
+    "debounce",
+    "encode",
+    "submit",
+    "collect",
+    "total"
+};
+
+//*****************************************************************************
+//
+// Adds a time to a stage's histogram.
+//
+//*****************************************************************************
+static void
+LatencyAdd(uint32_t ui32Stage, uint32_t ui32Cycles)
+{
+    tLatencyHist *psHist;
+    uint32_t ui32Bucket, ui32Value;
+
+    psHist = &g_psLatencyHist[ui32Stage];
+
+    ui32Bucket = 0;
+    for(ui32Value = ui32Cycles; ui32Value; ui32Value >>= 1)
+    {
+        ui32Bucket++;
+    }
+    if(ui32Bucket >= LATENCY_BUCKETS)
+    {
+        ui32Bucket = LATENCY_BUCKETS - 1;
+    }
+
+    psHist->pui32Buckets[ui32Bucket]++;
+    psHist->ui32Count++;
+    if(ui32Cycles > psHist->ui32MaxCycles)
+    {
+        psHist->ui32MaxCycles = ui32Cycles;
+    }
+}
+
+//*****************************************************************************
+//
+// Ends the current stage of the change being followed, if it has reached
+// it.
+//
+//*****************************************************************************
+static void
+LatencyStageEnd(uint32_t ui32Stage, uint32_t ui32Now)
+{
+    if(g_ui32LatencyStage == ui32Stage)
+    {
+        g_pui32LatencyTimes[ui32Stage] = ui32Now;
+        g_ui32LatencyStage++;
+    }
+}
+
+//*****************************************************************************
+//
+// Called from each sampling pass of the report builder.
+//
+// \param ui16Inputs is player one's inputs as read from the pins.
+// \param ui16Report is the report buttons built from them.
+//
+//*****************************************************************************
+void
+LatencyInput(uint16_t ui16Inputs, uint16_t ui16Report)
+{
+    uint32_t ui32Now;
+
+    ui32Now = TimestampGet();
+
+    if((g_ui32LatencyStage != LATENCY_IDLE) &&
+       ((ui32Now - g_ui32LatencyEdge) > TimestampFromUs(LATENCY_TIMEOUT_US)))
+    {
+        g_ui32LatencyStage = LATENCY_IDLE;
+    }
+
+    if((g_ui32LatencyStage == LATENCY_IDLE) &&
+       (ui16Inputs != g_ui16LatencyInputs))
+    {
+        g_ui32LatencyEdge = ui32Now;
+        g_ui32LatencyStage = LATENCY_STAGE_DEBOUNCE;
+    }
+
+    if(ui16Report != g_ui16LatencyReport)
+    {
+        LatencyStageEnd(LATENCY_STAGE_DEBOUNCE, ui32Now);
+    }
+
+    g_ui16LatencyInputs = ui16Inputs;
+    g_ui16LatencyReport = ui16Report;
+}
+
+//*****************************************************************************
+//
+// Called once player one's report has been packed.
+//
+//*****************************************************************************
+void
+LatencyEncoded(void)
+{
+    LatencyStageEnd(LATENCY_STAGE_ENCODE, TimestampGet());
+}
+
+//*****************************************************************************
+//
+// Called once player one's report has been armed in the endpoint.
+//
+//*****************************************************************************
+void
+LatencySubmitted(void)
+{
+    LatencyStageEnd(LATENCY_STAGE_SUBMIT, TimestampGet());
+}
+
+//*****************************************************************************
+//
+// Called when the host collects player one's report.  If it carried the
+// change being followed, the change's times go into the histograms.
+//
+//*****************************************************************************
+void
+LatencyCollected(void)
+{
+    uint32_t ui32Stage, ui32Start;
+
+    LatencyStageEnd(LATENCY_STAGE_COLLECT, TimestampGet());
+
+    if(g_ui32LatencyStage != LATENCY_STAGE_TOTAL)
+    {
+        return;
+    }
+
+    ui32Start = g_ui32LatencyEdge;
+    for(ui32Stage = 0; ui32Stage < LATENCY_STAGE_TOTAL; ui32Stage++)
+    {
+        LatencyAdd(ui32Stage, g_pui32LatencyTimes[ui32Stage] - ui32Start);
+        ui32Start = g_pui32LatencyTimes[ui32Stage];
+    }
+    LatencyAdd(LATENCY_STAGE_TOTAL, ui32Start - g_ui32LatencyEdge);
+
+    g_ui32LatencyStage = LATENCY_IDLE;
+}
+
+//*****************************************************************************
+//
+// Returns a copy of a stage's histogram.
+//
+//*****************************************************************************
+void
+LatencyHistGet(uint32_t ui32Stage, tLatencyHist *psHist)
+{
+    ROM_IntMasterDisable();
+    *psHist = g_psLatencyHist[ui32Stage];
+    ROM_IntMasterEnable();
+}
+
+//*****************************************************************************
+//
+// Returns an upper bound on a percentile of a histogram.
+//
+// \param ui32Percent is the percentile, from 1 to 100.
+//
+// \return Returns the top of the bucket holding the percentile, or the
+// longest time if that is lower, in microseconds rounded up.  Returns 0 for
+// an empty histogram.
+//
+//*****************************************************************************
+uint32_t
+LatencyPercentileUs(const tLatencyHist *psHist, uint32_t ui32Percent)
+{
+    uint32_t ui32Bucket, ui32Seen, ui32Want, ui32Cycles;
+
+    if(!psHist->ui32Count)
+    {
+        return(0);
+    }
+
+    ui32Want = ((psHist->ui32Count * ui32Percent) + 99) / 100;
+    ui32Seen = 0;
+
+    for(ui32Bucket = 0; ui32Bucket < (LATENCY_BUCKETS - 1); ui32Bucket++)
+    {
+        ui32Seen += psHist->pui32Buckets[ui32Bucket];
+        if(ui32Seen >= ui32Want)
+        {
+            break;
+        }
+    }
+
+    ui32Cycles = (1 << ui32Bucket) - 1;
+    if((ui32Bucket == (LATENCY_BUCKETS - 1)) ||
+       (ui32Cycles > psHist->ui32MaxCycles))
+    {
+        ui32Cycles = psHist->ui32MaxCycles;
+    }
+
+    return(TimestampToUs(ui32Cycles + g_ui32TimestampCyclesPerUs - 1));
+}
+
+//*****************************************************************************
+//
+// Called from the main loop.  Every LATENCY_PRINT_US, if any change has been
+// timed since the last print, prints each stage's median, 99th percentile,
+// longest time and the non-empty buckets.
+//
+//*****************************************************************************
+void
+LatencyPrint(void)
+{
+    static uint32_t ui32Last, ui32LastCount;
+    tLatencyHist sHist;
+    uint32_t ui32Now, ui32Stage, ui32Bucket;
+
+    ui32Now = TimestampGet();
+    if((ui32Now - ui32Last) < TimestampFromUs(LATENCY_PRINT_US))
+    {
+        return;
+    }
+    ui32Last = ui32Now;
+
+    LatencyHistGet(LATENCY_STAGE_TOTAL, &sHist);
+    if(sHist.ui32Count == ui32LastCount)
+    {
+        return;
+    }
+    ui32LastCount = sHist.ui32Count;
+
+    TelemetryPrintf("Latency over %d changes, us (p50/p99/max), "
+                    "log2(cycles):count\n", sHist.ui32Count);
+
+    for(ui32Stage = 0; ui32Stage < LATENCY_STAGES; ui32Stage++)
+    {
+        LatencyHistGet(ui32Stage, &sHist);
+        TelemetryPrintf("  %8s %5d/%5d/%5d ", g_ppcLatencyNames[ui32Stage],
+                        LatencyPercentileUs(&sHist, 50),
+                        LatencyPercentileUs(&sHist, 99),
+                        TimestampToUs(sHist.ui32MaxCycles));
+
+        for(ui32Bucket = 0; ui32Bucket < LATENCY_BUCKETS; ui32Bucket++)
+        {
+            if(sHist.pui32Buckets[ui32Bucket])
+            {
+                TelemetryPrintf(" %d:%d", ui32Bucket,
+                                sHist.pui32Buckets[ui32Bucket]);
+            }
+        }
+        TelemetryPrintf("\n");
+    }
+}
@@ -0,0 +1,75 @@
+//*****************************************************************************
+//
+// usb_latency.h - Histograms of the time a button change spends in each
+// stage of the input path.
+//
+//*****************************************************************************
+
+#ifndef _USB_LATENCY_H_
+#define _USB_LATENCY_H_
+
+//*****************************************************************************
+//
+// The stages.  Each is timed from the end of the one before, starting from
+// the sampling pass that first saw the input change:
+//
+// LATENCY_STAGE_DEBOUNCE  until the change reaches the report buttons, after
+//                         mapping and debounce.
+// LATENCY_STAGE_ENCODE    until the report holding it is packed.
+// LATENCY_STAGE_SUBMIT    until that report is armed in the endpoint.
+// LATENCY_STAGE_COLLECT   until the host collects it (TX_COMPLETE).
+// LATENCY_STAGE_TOTAL     the whole path, from the sample to TX_COMPLETE.
+//
+//*****************************************************************************
+#define LATENCY_STAGE_DEBOUNCE  0
+#define LATENCY_STAGE_ENCODE    1
+#define LATENCY_STAGE_SUBMIT    2
+#define LATENCY_STAGE_COLLECT   3
+#define LATENCY_STAGE_TOTAL     4
+#define LATENCY_STAGES          5
+
+//*****************************************************************************
+//
+// Bucket n counts the times of n significant bits in system clock cycles,
+// so times from 2^(n-1) up to 2^n - 1 cycles; bucket 0 counts times of 0.
+// The last bucket also takes anything longer, which at 50MHz is anything
+// over 168ms.
+//
+//*****************************************************************************
+#define LATENCY_BUCKETS         24
+
+//*****************************************************************************
+//
+// One stage's histogram.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of changes timed and the longest, in cycles.
+    //
+    uint32_t ui32Count;
+    uint32_t ui32MaxCycles;
+
+    //
+    // The number of changes in each bucket.
+    //
+    uint32_t pui32Buckets[LATENCY_BUCKETS];
+}
+tLatencyHist;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void LatencyInput(uint16_t ui16Inputs, uint16_t ui16Report);
+extern void LatencyEncoded(void);
+extern void LatencySubmitted(void);
+extern void LatencyCollected(void);
+extern void LatencyHistGet(uint32_t ui32Stage, tLatencyHist *psHist);
+extern uint32_t LatencyPercentileUs(const tLatencyHist *psHist,
+                                    uint32_t ui32Percent);
+extern void LatencyPrint(void);
+
+#endif
@@ -0,0 +1,273 @@
+//*****************************************************************************
+//
+// usb_lcd_push.c - Host-driven LCD updates over a vendor bulk interface.
+//
+// A host program (tools/lcd_push) sends images for the ST7735 as a
+// compressed command stream, described in lcd_stream.h, on a bulk OUT
+// endpoint of the composite device.  Like the telemetry interface this is
+// bulk traffic, which the host only schedules around the gamepad's
+// interrupt transfers.
+//
+// The USB interrupt only copies packets into the receive buffer.  All
+// decoding and drawing is done by LCDPushProcess() from the main loop,
+// which draws a bounded number of pixels per call so the rest of the loop
+// keeps running.  While the buffer is full usblib leaves the next packet in
+// the endpoint FIFO and the host is NAKed, so a fast host is throttled to
+// the speed of the display rather than losing data.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdbulk.h"
+#include "usblib/device/usbdhid.h"
+#include "usblib/device/usbdhidgamepad.h"
+#include "usb_gamepad_structs.h"
+#include "usb_lcd_push.h"
+#include "lcd_stream.h"
+#include "ST7735.h"
+
+#if GAMEPAD_LCD_PUSH
+//*****************************************************************************
+//
+// The stream decoder.  It is only ever used from the main loop.
+//
+//*****************************************************************************
+static tLCDStreamDecoder g_sLCDPushDecoder;
+
+//*****************************************************************************
+//
+// Set by the USB interrupt when the host configures or drops the interface,
+// so that the main loop empties the receive buffer and abandons any
+// half-decoded command.  The flush is left to the main loop since it may be
+// part way through USBBufferRead() on the same buffer.
+//
+//*****************************************************************************
+static volatile bool g_bLCDPushReset;
+
+//*****************************************************************************
+//
+// The rectangle being drawn and the number of its pixels written so far.
+// Other code in the main loop draws on the LCD between calls to
+// LCDPushProcess(), so the controller's address window has to be set again
+// each time drawing resumes.  If the rectangle stopped part way along a
+// row, the rest of that row is written through a one row window first.
+//
+//*****************************************************************************
+static uint32_t g_ui32LCDPushX;
+static uint32_t g_ui32LCDPushY;
+static uint32_t g_ui32LCDPushWidth;
+static uint32_t g_ui32LCDPushHeight;
+static uint32_t g_ui32LCDPushDone;
+static bool g_bLCDPushWindowSet;
+static bool g_bLCDPushPartialRow;
+
+//*****************************************************************************
+//
+// The number of pixels left to draw in the current call to
+// LCDPushProcess().
+//
+//*****************************************************************************
+static uint32_t g_ui32LCDPushBudget;
+
+//*****************************************************************************
+//
+// Starts a new rectangle.
+//
+//*****************************************************************************
+static void
+LCDPushWindow(void *pvCBData, uint32_t ui32X, uint32_t ui32Y,
+              uint32_t ui32Width, uint32_t ui32Height)
+{
+    //
+    // Pushed images are placed in screen RAM, which the console's scrolling
+    // rotates, so leave console mode for them to appear where intended.
+    //
+    ST7735_ConsoleOff();
+
+    g_ui32LCDPushX = ui32X;
+    g_ui32LCDPushY = ui32Y;
+    g_ui32LCDPushWidth = ui32Width;
+    g_ui32LCDPushHeight = ui32Height;
+    g_ui32LCDPushDone = 0;
+    g_bLCDPushWindowSet = false;
+}
+
+//*****************************************************************************
+//
+// Draws the next run of pixels of the current rectangle.
+//
+//*****************************************************************************
+static void
+LCDPushPixels(void *pvCBData, uint16_t ui16Color, uint32_t ui32Count)
+{
+    uint32_t ui32Col, ui32Row, ui32Len;
+
+    g_ui32LCDPushBudget -= (ui32Count < g_ui32LCDPushBudget) ?
+                           ui32Count : g_ui32LCDPushBudget;
+
+    while(ui32Count)
+    {
+        ui32Col = g_ui32LCDPushDone % g_ui32LCDPushWidth;
+        ui32Row = g_ui32LCDPushDone / g_ui32LCDPushWidth;
+
+        if(!g_bLCDPushWindowSet)
+        {
+            if(ui32Col)
+            {
+                ST7735_SetWindow(g_ui32LCDPushX + ui32Col,
+                                 g_ui32LCDPushY + ui32Row,
+                                 g_ui32LCDPushWidth - ui32Col, 1);
+                g_bLCDPushPartialRow = true;
+            }
+            else
+            {
+                ST7735_SetWindow(g_ui32LCDPushX, g_ui32LCDPushY + ui32Row,
+                                 g_ui32LCDPushWidth,
+                                 g_ui32LCDPushHeight - ui32Row);
+                g_bLCDPushPartialRow = false;
+            }
+            g_bLCDPushWindowSet = true;
+        }
+
+        ui32Len = ui32Count;
+        if(g_bLCDPushPartialRow &&
+           (ui32Len > (g_ui32LCDPushWidth - ui32Col)))
+        {
+            ui32Len = g_ui32LCDPushWidth - ui32Col;
+        }
+
+        ST7735_PushColor(ui16Color, ui32Len);
+        g_ui32LCDPushDone += ui32Len;
+        ui32Count -= ui32Len;
+
+        //
+        // Once the partial row is finished, switch to a window covering the
+        // rest of the rectangle.
+        //
+        if(g_bLCDPushPartialRow &&
+           !(g_ui32LCDPushDone % g_ui32LCDPushWidth))
+        {
+            g_bLCDPushWindowSet = false;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Handles bulk driver notifications related to the receive channel.  The
+// USB buffer has already stored any received data, which is left for the
+// main loop.
+//
+//*****************************************************************************
+uint32_t
+LCDPushRxHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+                 void *pvMsgData)
+{
+    switch(ui32Event)
+    {
+        case USB_EVENT_CONNECTED:
+        case USB_EVENT_DISCONNECTED:
+        {
+            g_bLCDPushReset = true;
+            break;
+        }
+
+        case USB_EVENT_RX_AVAILABLE:
+        case USB_EVENT_DATA_REMAINING:
+        case USB_EVENT_REQUEST_BUFFER:
+        default:
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Handles bulk driver notifications related to the transmit channel.  The
+// device never sends on this interface.
+//
+//*****************************************************************************
+uint32_t
+LCDPushTxHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+                 void *pvMsgData)
+{
+    return(0);
+}
+#endif
+
+//*****************************************************************************
+//
+// Prepares the receive buffer and the decoder.  This must be called before
+// the device is placed on the bus.
+//
+//*****************************************************************************
+void
+LCDPushInit(void)
+{
+#if GAMEPAD_LCD_PUSH
+    USBBufferInit(&g_sLCDPushRxBuffer);
+    LCDStreamInit(&g_sLCDPushDecoder, LCDPushWindow, LCDPushPixels, 0);
+#endif
+}
+
+//*****************************************************************************
+//
+// Decodes and draws received data until the buffer is empty or the pixel
+// budget is spent.  This must be called regularly from the main loop.
+//
+//*****************************************************************************
+void
+LCDPushProcess(void)
+{
+#if GAMEPAD_LCD_PUSH
+    uint8_t pui8Chunk[16];
+    uint32_t ui32Len;
+
+    if(g_bLCDPushReset)
+    {
+        g_bLCDPushReset = false;
+        USBBufferFlush(&g_sLCDPushRxBuffer);
+        LCDStreamReset(&g_sLCDPushDecoder);
+    }
+
+    //
+    // Whatever ran since the last call may have moved the address window.
+    //
+    g_bLCDPushWindowSet = false;
+    g_ui32LCDPushBudget = LCD_PUSH_PIXEL_BUDGET;
+
+    while(g_ui32LCDPushBudget)
+    {
+        ui32Len = USBBufferRead(&g_sLCDPushRxBuffer, pui8Chunk,
+                                sizeof(pui8Chunk));
+        if(!ui32Len)
+        {
+            break;
+        }
+
+        LCDStreamDecode(&g_sLCDPushDecoder, pui8Chunk, ui32Len);
+    }
+#endif
+}
+
+//*****************************************************************************
+//
+// Returns the number of malformed commands seen in the stream.
+//
+//*****************************************************************************
+uint32_t
+LCDPushErrorsGet(void)
+{
+#if GAMEPAD_LCD_PUSH
+    return(g_sLCDPushDecoder.ui32Errors);
+#else
+    return(0);
+#endif
+}
@@ -0,0 +1,42 @@
+//*****************************************************************************
+//
+// usb_lcd_push.h - Host-driven LCD updates over a vendor bulk interface.
+//
+//*****************************************************************************
+
+#ifndef _USB_LCD_PUSH_H_
+#define _USB_LCD_PUSH_H_
+
+//*****************************************************************************
+//
+// The size of the USB receive buffer.  When it is full the host is NAKed
+// until the main loop has drawn enough to make room.
+//
+//*****************************************************************************
+#define LCD_PUSH_RX_BUFFER_SIZE     512
+
+//*****************************************************************************
+//
+// The number of pixels LCDPushProcess() draws before returning to the main
+// loop.  Data is decoded in small chunks, so a single chunk holding a large
+// run may overshoot this.
+//
+//*****************************************************************************
+#ifndef LCD_PUSH_PIXEL_BUDGET
+#define LCD_PUSH_PIXEL_BUDGET       1024
+#endif
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void LCDPushInit(void);
+extern void LCDPushProcess(void);
+extern uint32_t LCDPushErrorsGet(void);
+extern uint32_t LCDPushRxHandler(void *pvCBData, uint32_t ui32Event,
+                                 uint32_t ui32MsgData, void *pvMsgData);
+extern uint32_t LCDPushTxHandler(void *pvCBData, uint32_t ui32Event,
+                                 uint32_t ui32MsgData, void *pvMsgData);
+
+#endif
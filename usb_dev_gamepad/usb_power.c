@@ -0,0 +1,372 @@
+//*****************************************************************************
+//
+// usb_power.c - Low power USB suspend and remote wakeup.
+//
+// When the host suspends the bus the main loop blanks the LCD, drops the
+// system clock to the lowest rate the USB controller allows and sleeps with
+// WFI.  Automatic clock gating keeps only the USB controller and the GPIO
+// ports clocked in sleep, so the ADC, SSI, UART and timers stop.  A button
+// press interrupts, puts the clock back and signals remote wakeup.  The
+// host then resumes the bus and the first report is sent from the resume
+// event, before the main loop has done anything.
+//
+// The time from the wake cause to the resume, to the first report being
+// armed and to the host collecting it is measured and printed once the
+// first report is out.  The DWT cycle counter stops while the core sleeps,
+// so the loop does not sleep again once a remote wakeup is under way.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_sysctl.h"
+#include "inc/hw_types.h"
+#include "driverlib/debug.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "usblib/usblib.h"
+#include "usblib/device/usbdevice.h"
+#include "drivers/buttons.h"
+#include "timestamp.h"
+#include "usb_power.h"
+#include "usb_telemetry.h"
+#include "ST7735.h"
+
+//*****************************************************************************
+//
+// The system clock divider used while suspended.  The USB controller needs
+// a system clock of at least 20MHz, which is the PLL divided by 10.
+//
+//*****************************************************************************
+#define POWER_SLEEP_SYSDIV      SYSCTL_SYSDIV_10
+
+//*****************************************************************************
+//
+// The measurements still waiting for their event.
+//
+//*****************************************************************************
+#define POWER_WAIT_REPORT       0x00000001
+#define POWER_WAIT_POLL         0x00000002
+
+//*****************************************************************************
+//
+// Set by the suspend event and cleared by resume or reconnection.
+//
+//*****************************************************************************
+static volatile bool g_bPowerSuspended;
+
+//*****************************************************************************
+//
+// Set while the system clock is lowered, with the clock registers to put
+// back when it is raised again.
+//
+//*****************************************************************************
+static volatile bool g_bPowerClockLow;
+static uint32_t g_ui32PowerRCC;
+static uint32_t g_ui32PowerRCC2;
+
+//*****************************************************************************
+//
+// Set when a button press has signalled remote wakeup and cleared when the
+// bus resumes.
+//
+//*****************************************************************************
+static volatile bool g_bPowerWaking;
+
+//*****************************************************************************
+//
+// The cycle counts of the wake cause and the bus resume, the measurements
+// still outstanding and whether a finished one is waiting to be printed.
+//
+//*****************************************************************************
+static uint32_t g_ui32PowerWakeTime;
+static uint32_t g_ui32PowerResumeTime;
+static volatile uint32_t g_ui32PowerWait;
+static volatile bool g_bPowerPrint;
+
+static tPowerStats g_sPowerStats;
+
+//*****************************************************************************
+//
+// Lowers the system clock.  Called with interrupts disabled.
+//
+//*****************************************************************************
+static void
+PowerClockLow(void)
+{
+    if(g_bPowerClockLow)
+    {
+        return;
+    }
+
+    //
+    // Bring the microsecond clock up to date at the old rate first.
+    //
+    TimestampUsGet();
+
+    g_ui32PowerRCC = HWREG(SYSCTL_RCC);
+    g_ui32PowerRCC2 = HWREG(SYSCTL_RCC2);
+    ROM_SysCtlClockSet(POWER_SLEEP_SYSDIV | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN |
+                       SYSCTL_XTAL_16MHZ);
+    g_bPowerClockLow = true;
+
+    TimestampInit();
+}
+
+//*****************************************************************************
+//
+// Puts the full system clock back.  This is on the wake path, so rather
+// than going through SysCtlClockSet() the saved clock registers are written
+// back directly, with no wait for the PLL to lock.  That relies on the PLL
+// having stayed powered and locked while suspended: PowerClockLow() only
+// changes the divider and keeps the PLL as the clock source, and the stick
+// sleeps with SysCtlSleep(), never deep sleep, which could switch the PLL
+// off.
+//
+// This is called from the USB and button interrupts, and from the main loop
+// with interrupts disabled.
+//
+//*****************************************************************************
+static void
+PowerClockRestore(void)
+{
+    if(!g_bPowerClockLow)
+    {
+        return;
+    }
+
+    TimestampUsGet();
+
+    ASSERT(HWREG(SYSCTL_PLLSTAT) & SYSCTL_PLLSTAT_LOCK);
+
+    HWREG(SYSCTL_RCC) = g_ui32PowerRCC;
+    HWREG(SYSCTL_RCC2) = g_ui32PowerRCC2;
+    g_bPowerClockLow = false;
+
+    TimestampInit();
+}
+
+//*****************************************************************************
+//
+// Called from the button interrupt when a button is pressed while asleep.
+//
+//*****************************************************************************
+static void
+PowerButtonWake(void)
+{
+    ButtonsIntDisable();
+
+    //
+    // Remote wakeup only works if the host enabled it.  If not, the button
+    // cannot wake anything, so stay asleep until the host resumes.
+    //
+    if(!USBDCDRemoteWakeupRequest(0))
+    {
+        g_sPowerStats.ui32WakeRefused++;
+        return;
+    }
+
+    PowerClockRestore();
+
+    g_ui32PowerWakeTime = TimestampGet();
+    g_bPowerWaking = true;
+    g_sPowerStats.ui32RemoteWakes++;
+}
+
+//*****************************************************************************
+//
+// Sets up clock gating for sleep.  Only the USB controller and the GPIO
+// ports keep their clocks while the processor sleeps.
+//
+//*****************************************************************************
+void
+PowerInit(void)
+{
+    ROM_SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_USB0);
+    ROM_SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_GPIOA);
+    ROM_SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_GPIOB);
+    ROM_SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_GPIOC);
+    ROM_SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_GPIOD);
+    ROM_SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_GPIOE);
+    ROM_SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_GPIOF);
+    ROM_SysCtlPeripheralClockGating(true);
+}
+
+//*****************************************************************************
+//
+// Called from the main loop.  While the bus is suspended this does not
+// return until the stick wakes, and meanwhile sleeps at a low clock.  It
+// also prints the timings of the last wakeup once they are complete.
+//
+//*****************************************************************************
+void
+PowerProcess(void)
+{
+    tPowerStats sStats;
+
+    if(g_bPowerPrint)
+    {
+        g_bPowerPrint = false;
+        PowerStatsGet(&sStats);
+        TelemetryPrintf("Wake: resume %dus, first report %dus (max %d), "
+                        "first poll %dus (max %d)\n", sStats.ui32ResumeUs,
+                        sStats.ui32ReportUs, sStats.ui32MaxReportUs,
+                        sStats.ui32PollUs, sStats.ui32MaxPollUs);
+    }
+
+    if(!g_bPowerSuspended || g_bPowerWaking)
+    {
+        return;
+    }
+
+    //
+    // This only queues the commands and waits for them to go out, since the
+    // USB specification allows 10ms to get down to suspend current.  The
+    // controller's wait before it may be woken is taken on the way out.
+    //
+    ST7735_Sleep(1);
+
+    //
+    // Interrupts are held off between checking the state and sleeping so
+    // that a wake event cannot slip in between.  WFI still wakes on a
+    // pending interrupt, which then runs as soon as they are enabled again.
+    //
+    ROM_IntMasterDisable();
+
+    if(g_bPowerSuspended && !g_bPowerWaking)
+    {
+        PowerClockLow();
+        ButtonsIntEnable(PowerButtonWake, ROM_IntPriorityGet(INT_USB0));
+    }
+
+    while(g_bPowerSuspended && !g_bPowerWaking)
+    {
+        ROM_SysCtlSleep();
+        ROM_IntMasterEnable();
+        ROM_IntMasterDisable();
+    }
+
+    ButtonsIntDisable();
+    PowerClockRestore();
+    ROM_IntMasterEnable();
+
+    ST7735_Sleep(0);
+}
+
+//*****************************************************************************
+//
+// Called from the USB suspend event.
+//
+//*****************************************************************************
+void
+PowerSuspend(void)
+{
+    g_bPowerSuspended = true;
+    g_bPowerWaking = false;
+    g_ui32PowerWait = 0;
+    g_sPowerStats.ui32Suspends++;
+}
+
+//*****************************************************************************
+//
+// Called from the USB resume event, before the first report is queued.
+//
+//*****************************************************************************
+void
+PowerResume(void)
+{
+    PowerClockRestore();
+
+    g_ui32PowerResumeTime = TimestampGet();
+
+    //
+    // If no button woke the stick then the host did.
+    //
+    if(!g_bPowerWaking)
+    {
+        g_ui32PowerWakeTime = g_ui32PowerResumeTime;
+    }
+    g_sPowerStats.ui32ResumeUs =
+        TimestampToUs(g_ui32PowerResumeTime - g_ui32PowerWakeTime);
+
+    if(g_bPowerSuspended)
+    {
+        g_ui32PowerWait = POWER_WAIT_REPORT | POWER_WAIT_POLL;
+    }
+
+    g_bPowerSuspended = false;
+    g_bPowerWaking = false;
+}
+
+//*****************************************************************************
+//
+// Called from the USB connect and disconnect events.  A bus reset also ends
+// a suspend, but without a resume event.
+//
+//*****************************************************************************
+void
+PowerWake(void)
+{
+    PowerClockRestore();
+
+    g_bPowerSuspended = false;
+    g_bPowerWaking = false;
+    g_ui32PowerWait = 0;
+}
+
+//*****************************************************************************
+//
+// Called each time a gamepad report has been armed in the endpoint.
+//
+//*****************************************************************************
+void
+PowerReportSent(void)
+{
+    if(g_ui32PowerWait & POWER_WAIT_REPORT)
+    {
+        g_ui32PowerWait &= ~POWER_WAIT_REPORT;
+        g_sPowerStats.ui32ReportUs =
+            TimestampToUs(TimestampGet() - g_ui32PowerResumeTime);
+        if(g_sPowerStats.ui32ReportUs > g_sPowerStats.ui32MaxReportUs)
+        {
+            g_sPowerStats.ui32MaxReportUs = g_sPowerStats.ui32ReportUs;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Called each time the host collects a gamepad report.
+//
+//*****************************************************************************
+void
+PowerReportCollected(void)
+{
+    if(g_ui32PowerWait == POWER_WAIT_POLL)
+    {
+        g_ui32PowerWait = 0;
+        g_sPowerStats.ui32PollUs =
+            TimestampToUs(TimestampGet() - g_ui32PowerWakeTime);
+        if(g_sPowerStats.ui32PollUs > g_sPowerStats.ui32MaxPollUs)
+        {
+            g_sPowerStats.ui32MaxPollUs = g_sPowerStats.ui32PollUs;
+        }
+        g_bPowerPrint = true;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns a copy of the wakeup statistics.
+//
+//*****************************************************************************
+void
+PowerStatsGet(tPowerStats *psStats)
+{
+    ROM_IntMasterDisable();
+    *psStats = g_sPowerStats;
+    ROM_IntMasterEnable();
+}
@@ -0,0 +1,61 @@
+//*****************************************************************************
+//
+// usb_power.h - Low power USB suspend and remote wakeup.
+//
+//*****************************************************************************
+
+#ifndef _USB_POWER_H_
+#define _USB_POWER_H_
+
+//*****************************************************************************
+//
+// Wakeup counts and timings.  Times are in microseconds and measured from
+// the wake cause: the button press for a remote wakeup, or the bus resume
+// if the host woke the stick itself.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of times the bus was suspended.
+    //
+    uint32_t ui32Suspends;
+
+    //
+    // The number of remote wakeups signalled, and of button presses that
+    // could not wake the host because it had not enabled remote wakeup.
+    //
+    uint32_t ui32RemoteWakes;
+    uint32_t ui32WakeRefused;
+
+    //
+    // The last wakeup: wake cause to bus resume, bus resume to the first
+    // report being armed, and wake cause to the host collecting it.
+    //
+    uint32_t ui32ResumeUs;
+    uint32_t ui32ReportUs;
+    uint32_t ui32PollUs;
+
+    //
+    // The worst seen of the last two.
+    //
+    uint32_t ui32MaxReportUs;
+    uint32_t ui32MaxPollUs;
+}
+tPowerStats;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void PowerInit(void);
+extern void PowerProcess(void);
+extern void PowerSuspend(void);
+extern void PowerResume(void);
+extern void PowerWake(void);
+extern void PowerReportSent(void);
+extern void PowerReportCollected(void);
+extern void PowerStatsGet(tPowerStats *psStats);
+
+#endif
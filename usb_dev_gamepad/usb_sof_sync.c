@@ -0,0 +1,669 @@
+//*****************************************************************************
+//
+// usb_sof_sync.c - USB start-of-frame phase-aligned input sampling.
+//
+// The host polls the interrupt IN endpoint at a fixed offset into the USB
+// frame.  By timestamping every start-of-frame (SOF) and every completed
+// transfer, this module learns that offset (the poll phase) and the polling
+// interval, then uses Timer0A to run the input sampling so that the report
+// lands in the endpoint FIFO a configurable lead time before the next poll
+// instead of at a random point in the polling interval.
+//
+// Both the USB interrupt and Timer0A run at the same (default) priority so
+// they never preempt each other and the state below needs no locking between
+// them.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/usb.h"
+#include "timestamp.h"
+#include "usb_sof_sync.h"
+
+//*****************************************************************************
+//
+// The USB library interrupt handler that is wrapped by SOFSyncUSBIntHandler().
+//
+//*****************************************************************************
+extern void USB0DeviceIntHandler(void);
+
+//*****************************************************************************
+//
+// USB frame numbers are 11 bits wide and wrap every 2048 frames.
+//
+//*****************************************************************************
+#define FRAME_MASK              0x7ff
+#define FRAME_HALF              0x400
+
+//*****************************************************************************
+//
+// The number of polls that must be observed before the scheduler takes over
+// from free-running sampling.
+//
+//*****************************************************************************
+#define SOF_SYNC_LOCK_POLLS     8
+
+//*****************************************************************************
+//
+// The largest polling interval a full speed interrupt endpoint may request.
+//
+//*****************************************************************************
+#define SOF_SYNC_MAX_INTERVAL   255
+
+//*****************************************************************************
+//
+// Configuration.
+//
+//*****************************************************************************
+static volatile bool g_bSOFSyncEnabled;
+static tSOFSyncSampleFn g_pfnSOFSyncSample;
+static tSOFSyncFrameFn g_pfnSOFSyncFrame;
+static uint32_t g_ui32LeadCycles;
+
+//*****************************************************************************
+//
+// The most recent start-of-frame and the filtered frame period in cycles.
+//
+//*****************************************************************************
+static bool g_bSOFValid;
+static uint32_t g_ui32SOFFrame;
+static uint32_t g_ui32SOFTime;
+static uint32_t g_ui32FramePeriod;
+
+//*****************************************************************************
+//
+// What has been learned about the host's polling.  The poll phase is the
+// time from SOF to the completion of the IN transfer, in cycles.
+//
+//*****************************************************************************
+static uint32_t g_ui32PollCount;
+static uint32_t g_ui32PollFrame;
+static uint32_t g_ui32PollPhase;
+static uint32_t g_ui32PollInterval;
+
+//*****************************************************************************
+//
+// Scheduler state.  The target is the poll that the armed (or most recently
+// run) sample is aimed at.
+//
+//*****************************************************************************
+static bool g_bArmed;
+static bool g_bTargetValid;
+static uint32_t g_ui32TargetFrame;
+static uint32_t g_ui32TargetTime;
+static uint32_t g_ui32WorkCycles;
+
+//*****************************************************************************
+//
+// The report most recently queued by the scheduler, if it has not yet been
+// collected by the host.
+//
+//*****************************************************************************
+static bool g_bQueued;
+static uint32_t g_ui32QueuedTime;
+static uint32_t g_ui32QueuedFrame;
+
+//*****************************************************************************
+//
+// Rate measurement.  Frames and completed transfers are counted over windows
+// of SOF_SYNC_RATE_FRAMES frames.
+//
+//*****************************************************************************
+#define SOF_SYNC_RATE_FRAMES    1000
+static uint32_t g_ui32RateFrames;
+static uint32_t g_ui32RateTx;
+static uint32_t g_ui32RateStart;
+static uint32_t g_ui32ReportRateHz;
+static uint32_t g_ui32SOFRateHz;
+
+//*****************************************************************************
+//
+// Phase error statistics.  The average is kept scaled by 16.
+//
+//*****************************************************************************
+static tSOFSyncStats g_sSOFSyncStats;
+static uint32_t g_ui32AvgAbsError16;
+
+//*****************************************************************************
+//
+// Masks the USB and Timer0A interrupts, returning which of them were
+// enabled so that SOFSyncIntRestore() can put them back as they were.  This
+// may be called from the main loop or from those interrupts themselves.
+//
+//*****************************************************************************
+#define SOF_SYNC_INT_USB        0x00000001
+#define SOF_SYNC_INT_TIMER      0x00000002
+
+static uint32_t
+SOFSyncIntMask(void)
+{
+    uint32_t ui32Enabled;
+
+    ui32Enabled = 0;
+    if(IntIsEnabled(INT_USB0))
+    {
+        ui32Enabled |= SOF_SYNC_INT_USB;
+    }
+    if(IntIsEnabled(INT_TIMER0A))
+    {
+        ui32Enabled |= SOF_SYNC_INT_TIMER;
+    }
+
+    ROM_IntDisable(INT_TIMER0A);
+    ROM_IntDisable(INT_USB0);
+
+    return(ui32Enabled);
+}
+
+static void
+SOFSyncIntRestore(uint32_t ui32Enabled)
+{
+    if(ui32Enabled & SOF_SYNC_INT_USB)
+    {
+        ROM_IntEnable(INT_USB0);
+    }
+    if(ui32Enabled & SOF_SYNC_INT_TIMER)
+    {
+        ROM_IntEnable(INT_TIMER0A);
+    }
+}
+
+//*****************************************************************************
+//
+// Returns true if frame ui32A is after frame ui32B, allowing for wrap.
+//
+//*****************************************************************************
+static bool
+FrameAfter(uint32_t ui32A, uint32_t ui32B)
+{
+    return((((ui32A - ui32B) & FRAME_MASK) != 0) &&
+           (((ui32A - ui32B) & FRAME_MASK) < FRAME_HALF));
+}
+
+//*****************************************************************************
+//
+// Runs the sample callback and records how long it took.
+//
+//*****************************************************************************
+static void
+SOFSyncRun(void)
+{
+    uint32_t ui32Start, ui32End, ui32Work;
+
+    if(!g_bSOFSyncEnabled || !g_pfnSOFSyncSample)
+    {
+        return;
+    }
+
+    ui32Start = TimestampGet();
+
+    if(g_pfnSOFSyncSample())
+    {
+        ui32End = TimestampGet();
+
+        g_bQueued = true;
+        g_ui32QueuedTime = ui32End;
+        g_ui32QueuedFrame = g_ui32TargetFrame;
+        g_sSOFSyncStats.ui32Reports++;
+
+        //
+        // The report is late if it became ready after the point that leaves
+        // the requested lead before the poll.
+        //
+        if((int32_t)(ui32End - (g_ui32TargetTime - g_ui32LeadCycles)) > 0)
+        {
+            g_sSOFSyncStats.ui32Late++;
+        }
+    }
+    else
+    {
+        ui32End = TimestampGet();
+    }
+
+    //
+    // Track the worst case work time, decaying slowly so that a single
+    // outlier does not push every later sample earlier forever.
+    //
+    ui32Work = ui32End - ui32Start;
+    g_ui32WorkCycles -= g_ui32WorkCycles >> 6;
+    if(ui32Work > g_ui32WorkCycles)
+    {
+        g_ui32WorkCycles = ui32Work;
+    }
+}
+
+//*****************************************************************************
+//
+// Picks the next poll to aim for and arms Timer0A if the sample for that
+// poll has to start before the next SOF.
+//
+//*****************************************************************************
+static void
+SOFSyncSchedule(uint32_t ui32Now)
+{
+    uint32_t ui32Frames, ui32Target, ui32Poll, ui32Fire;
+    int32_t i32Delay;
+
+    //
+    // Find the first poll frame at or after the current frame.
+    //
+    ui32Frames = (g_ui32SOFFrame - g_ui32PollFrame) & FRAME_MASK;
+    ui32Frames = ((ui32Frames + g_ui32PollInterval - 1) / g_ui32PollInterval) *
+                 g_ui32PollInterval;
+    ui32Target = (g_ui32PollFrame + ui32Frames) & FRAME_MASK;
+
+    //
+    // Skip any poll that already has a sample aimed at it.
+    //
+    while(g_bTargetValid && !FrameAfter(ui32Target, g_ui32TargetFrame))
+    {
+        ui32Target = (ui32Target + g_ui32PollInterval) & FRAME_MASK;
+    }
+
+    //
+    // Predict when that poll happens and when sampling must start.
+    //
+    ui32Frames = (ui32Target - g_ui32SOFFrame) & FRAME_MASK;
+    ui32Poll = g_ui32SOFTime + (ui32Frames * g_ui32FramePeriod) +
+               g_ui32PollPhase;
+    ui32Fire = ui32Poll - g_ui32LeadCycles - g_ui32WorkCycles;
+    i32Delay = (int32_t)(ui32Fire - ui32Now);
+
+    //
+    // Leave it to a later SOF if the start time is more than a frame away,
+    // so the prediction is always made from a fresh frame timestamp.
+    //
+    if(i32Delay > (int32_t)(g_ui32FramePeriod + (g_ui32FramePeriod / 4)))
+    {
+        return;
+    }
+
+    g_bTargetValid = true;
+    g_ui32TargetFrame = ui32Target;
+    g_ui32TargetTime = ui32Poll;
+
+    //
+    // If the start time has already passed, sample right away.
+    //
+    if(i32Delay <= 0)
+    {
+        SOFSyncRun();
+        return;
+    }
+
+    ROM_TimerLoadSet(TIMER0_BASE, TIMER_A, (uint32_t)i32Delay);
+    ROM_TimerEnable(TIMER0_BASE, TIMER_A);
+    g_bArmed = true;
+}
+
+//*****************************************************************************
+//
+// Called once for every new frame number seen by the USB interrupt.
+//
+//*****************************************************************************
+static void
+SOFSyncFrame(uint32_t ui32Frame, uint32_t ui32Now)
+{
+    uint32_t ui32Period, ui32Elapsed;
+
+    //
+    // Count frames for the rate measurement, starting a new window on the
+    // first frame after a reset.
+    //
+    if(g_bSOFValid)
+    {
+        g_ui32RateFrames += (ui32Frame - g_ui32SOFFrame) & FRAME_MASK;
+        if(g_ui32RateFrames >= SOF_SYNC_RATE_FRAMES)
+        {
+            ui32Elapsed = TimestampToUs(ui32Now - g_ui32RateStart);
+            g_ui32ReportRateHz = (g_ui32RateTx * 1000) / g_ui32RateFrames;
+            if(ui32Elapsed)
+            {
+                g_ui32SOFRateHz = (g_ui32RateFrames * 1000000) / ui32Elapsed;
+            }
+            g_ui32RateFrames = 0;
+            g_ui32RateTx = 0;
+            g_ui32RateStart = ui32Now;
+        }
+    }
+    else
+    {
+        g_ui32RateFrames = 0;
+        g_ui32RateTx = 0;
+        g_ui32RateStart = ui32Now;
+    }
+
+    //
+    // Refine the frame period from back to back SOFs, ignoring any pair
+    // distorted by a missed SOF or a long interrupt latency.
+    //
+    if(g_bSOFValid && (((ui32Frame - g_ui32SOFFrame) & FRAME_MASK) == 1))
+    {
+        ui32Period = ui32Now - g_ui32SOFTime;
+
+        if((ui32Period > (g_ui32FramePeriod - (g_ui32FramePeriod / 8))) &&
+           (ui32Period < (g_ui32FramePeriod + (g_ui32FramePeriod / 8))))
+        {
+            g_ui32FramePeriod += (int32_t)(ui32Period - g_ui32FramePeriod) / 16;
+        }
+    }
+
+    g_bSOFValid = true;
+    g_ui32SOFFrame = ui32Frame;
+    g_ui32SOFTime = ui32Now;
+
+    if(g_bSOFSyncEnabled && !g_bArmed &&
+       (g_ui32PollCount >= SOF_SYNC_LOCK_POLLS))
+    {
+        SOFSyncSchedule(ui32Now);
+    }
+
+    if(g_pfnSOFSyncFrame)
+    {
+        g_pfnSOFSyncFrame();
+    }
+}
+
+//*****************************************************************************
+//
+// Interrupt handler installed in the USB0 vector in place of the USB
+// library's handler.  It timestamps each new frame and then passes the
+// interrupt on to the library.
+//
+//*****************************************************************************
+void
+SOFSyncUSBIntHandler(void)
+{
+    uint32_t ui32Now, ui32Frame;
+
+    ui32Now = TimestampGet();
+    ui32Frame = USBFrameNumberGet(USB0_BASE);
+
+    if(!g_bSOFValid || (ui32Frame != g_ui32SOFFrame))
+    {
+        SOFSyncFrame(ui32Frame, ui32Now);
+    }
+
+    USB0DeviceIntHandler();
+}
+
+//*****************************************************************************
+//
+// Timer0A interrupt handler.  Fires when it is time to sample for the next
+// poll.
+//
+//*****************************************************************************
+void
+SOFSyncTimerIntHandler(void)
+{
+    ROM_TimerIntClear(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+    g_bArmed = false;
+
+    SOFSyncRun();
+}
+
+//*****************************************************************************
+//
+// Called from the USB_EVENT_TX_COMPLETE handler.  The host just collected a
+// report, which marks a poll: learn the phase and interval from it and score
+// the scheduler's phase error.
+//
+//*****************************************************************************
+void
+SOFSyncTxComplete(void)
+{
+    uint32_t ui32Now, ui32Phase, ui32Frame, ui32Frames;
+    int32_t i32Diff, i32Error;
+
+    ui32Now = TimestampGet();
+    g_ui32RateTx++;
+
+    if(!g_bSOFValid)
+    {
+        return;
+    }
+
+    ui32Phase = ui32Now - g_ui32SOFTime;
+    ui32Frame = g_ui32SOFFrame;
+
+    //
+    // A missed SOF leaves nothing to measure against.
+    //
+    if(ui32Phase >= g_ui32FramePeriod)
+    {
+        g_bQueued = false;
+        return;
+    }
+
+    if(g_ui32PollCount == 0)
+    {
+        g_ui32PollPhase = ui32Phase;
+    }
+    else
+    {
+        //
+        // Work out the difference to the learned phase modulo one frame so
+        // that a poll that jitters across the SOF boundary is attributed to
+        // the frame it belongs to rather than dragging the average.
+        //
+        i32Diff = (int32_t)(ui32Phase - g_ui32PollPhase);
+        if(i32Diff > (int32_t)(g_ui32FramePeriod / 2))
+        {
+            i32Diff -= g_ui32FramePeriod;
+            ui32Frame = (ui32Frame + 1) & FRAME_MASK;
+        }
+        else if(i32Diff < -(int32_t)(g_ui32FramePeriod / 2))
+        {
+            i32Diff += g_ui32FramePeriod;
+            ui32Frame = (ui32Frame - 1) & FRAME_MASK;
+        }
+
+        //
+        // The gap between polls that both found a report waiting is the
+        // polling interval, so the smallest gap seen is taken as the
+        // interval.
+        //
+        ui32Frames = (ui32Frame - g_ui32PollFrame) & FRAME_MASK;
+        if((ui32Frames != 0) && (ui32Frames < g_ui32PollInterval))
+        {
+            g_ui32PollInterval = ui32Frames;
+        }
+
+        g_ui32PollPhase += i32Diff / 8;
+    }
+
+    g_ui32PollFrame = ui32Frame;
+    if(g_ui32PollCount < SOF_SYNC_LOCK_POLLS)
+    {
+        g_ui32PollCount++;
+    }
+
+    //
+    // Score the report the scheduler queued, if this was it.
+    //
+    if(g_bQueued)
+    {
+        g_bQueued = false;
+
+        if(FrameAfter(ui32Frame, g_ui32QueuedFrame))
+        {
+            g_sSOFSyncStats.ui32Missed++;
+        }
+        else
+        {
+            i32Error = (int32_t)(ui32Now - g_ui32QueuedTime - g_ui32LeadCycles) /
+                       (int32_t)g_ui32TimestampCyclesPerUs;
+
+            g_sSOFSyncStats.i32LastErrorUs = i32Error;
+            if(i32Error < g_sSOFSyncStats.i32MinErrorUs)
+            {
+                g_sSOFSyncStats.i32MinErrorUs = i32Error;
+            }
+            if(i32Error > g_sSOFSyncStats.i32MaxErrorUs)
+            {
+                g_sSOFSyncStats.i32MaxErrorUs = i32Error;
+            }
+
+            if(i32Error < 0)
+            {
+                i32Error = -i32Error;
+            }
+            g_ui32AvgAbsError16 += (int32_t)((i32Error * 16) -
+                                             g_ui32AvgAbsError16) / 16;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Forgets everything learned about the host.  Called on connect, disconnect,
+// suspend and resume since the host may poll differently afterwards.
+//
+//*****************************************************************************
+void
+SOFSyncReset(void)
+{
+    ROM_TimerDisable(TIMER0_BASE, TIMER_A);
+    ROM_TimerIntClear(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+
+    g_bArmed = false;
+    g_bTargetValid = false;
+    g_bQueued = false;
+    g_bSOFValid = false;
+    g_ui32PollCount = 0;
+    g_ui32PollInterval = SOF_SYNC_MAX_INTERVAL;
+    g_ui32FramePeriod = TimestampFromUs(1000);
+
+    g_sSOFSyncStats.ui32Reports = 0;
+    g_sSOFSyncStats.ui32Late = 0;
+    g_sSOFSyncStats.ui32Missed = 0;
+    g_sSOFSyncStats.i32LastErrorUs = 0;
+    g_sSOFSyncStats.i32MinErrorUs = INT32_MAX;
+    g_sSOFSyncStats.i32MaxErrorUs = INT32_MIN;
+    g_ui32AvgAbsError16 = 0;
+    g_ui32ReportRateHz = 0;
+    g_ui32SOFRateHz = 0;
+}
+
+//*****************************************************************************
+//
+// Sets the time before the predicted poll at which the report should be
+// ready.
+//
+//*****************************************************************************
+void
+SOFSyncLeadSet(uint32_t ui32LeadUs)
+{
+    g_ui32LeadCycles = TimestampFromUs(ui32LeadUs);
+}
+
+//*****************************************************************************
+//
+// Installs a function to be called on every new frame.
+//
+//*****************************************************************************
+void
+SOFSyncFrameHookSet(tSOFSyncFrameFn pfnFrame)
+{
+    g_pfnSOFSyncFrame = pfnFrame;
+}
+
+//*****************************************************************************
+//
+// Turns phase-aligned sampling on or off.  While it is off (or before the
+// poll phase has been learned) the application samples free-running.
+//
+//*****************************************************************************
+void
+SOFSyncEnable(bool bEnable)
+{
+    uint32_t ui32Enabled;
+
+    ui32Enabled = SOFSyncIntMask();
+
+    if(!bEnable)
+    {
+        ROM_TimerDisable(TIMER0_BASE, TIMER_A);
+        g_bArmed = false;
+        g_bQueued = false;
+    }
+    g_bTargetValid = false;
+    g_bSOFSyncEnabled = bEnable;
+
+    SOFSyncIntRestore(ui32Enabled);
+}
+
+//*****************************************************************************
+//
+// Returns true when the scheduler owns report submission.
+//
+//*****************************************************************************
+bool
+SOFSyncActive(void)
+{
+    return(g_bSOFSyncEnabled && (g_ui32PollCount >= SOF_SYNC_LOCK_POLLS));
+}
+
+//*****************************************************************************
+//
+// Takes a consistent copy of the phase statistics.  This is called from the
+// main loop and, while building the status feature report, from the USB
+// interrupt, so the interrupts are left as they were found.
+//
+//*****************************************************************************
+void
+SOFSyncStatsGet(tSOFSyncStats *psStats)
+{
+    uint32_t ui32Enabled;
+
+    ui32Enabled = SOFSyncIntMask();
+
+    *psStats = g_sSOFSyncStats;
+    psStats->ui32AvgAbsErrorUs = g_ui32AvgAbsError16 / 16;
+    psStats->ui32PollPhaseUs = TimestampToUs(g_ui32PollPhase);
+    psStats->ui32PollInterval = g_ui32PollInterval;
+    psStats->ui32FramePeriodUs = TimestampToUs(g_ui32FramePeriod);
+    psStats->ui32WorkUs = TimestampToUs(g_ui32WorkCycles);
+    psStats->ui32ReportRateHz = g_ui32ReportRateHz;
+    psStats->ui32SOFRateHz = g_ui32SOFRateHz;
+
+    SOFSyncIntRestore(ui32Enabled);
+
+    if(psStats->i32MinErrorUs > psStats->i32MaxErrorUs)
+    {
+        psStats->i32MinErrorUs = 0;
+        psStats->i32MaxErrorUs = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Sets up Timer0A as the one-shot sampling timer.  This must be called after
+// TimestampInit() and before the USB device is placed on the bus, since the
+// USB event handler calls into this module.  The USB library enables the SOF
+// interrupt itself for its internal tick, so every frame reaches
+// SOFSyncUSBIntHandler() without further setup.
+//
+//*****************************************************************************
+void
+SOFSyncInit(uint32_t ui32LeadUs, tSOFSyncSampleFn pfnSample)
+{
+    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
+    ROM_TimerConfigure(TIMER0_BASE, TIMER_CFG_ONE_SHOT);
+    ROM_TimerIntEnable(TIMER0_BASE, TIMER_TIMA_TIMEOUT);
+
+    g_pfnSOFSyncSample = pfnSample;
+    SOFSyncLeadSet(ui32LeadUs);
+    SOFSyncReset();
+    g_ui32WorkCycles = 0;
+    g_bSOFSyncEnabled = SOF_SYNC_DEFAULT ? true : false;
+
+    ROM_IntEnable(INT_TIMER0A);
+}
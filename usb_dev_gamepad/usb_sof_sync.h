@@ -0,0 +1,125 @@
+//*****************************************************************************
+//
+// usb_sof_sync.h - USB start-of-frame phase-aligned input sampling.
+//
+//*****************************************************************************
+
+#ifndef _USB_SOF_SYNC_H_
+#define _USB_SOF_SYNC_H_
+
+//*****************************************************************************
+//
+// The number of microseconds before the predicted host poll at which a
+// report should be ready in the endpoint FIFO.  The time taken to sample and
+// encode the report is learned at run time and added on top of this.
+//
+//*****************************************************************************
+#ifndef SOF_SYNC_LEAD_US
+#define SOF_SYNC_LEAD_US        50
+#endif
+
+//*****************************************************************************
+//
+// Set to 0 to start with phase-aligned sampling disabled.  It can still be
+// turned on at run time with SOFSyncEnable().
+//
+//*****************************************************************************
+#ifndef SOF_SYNC_DEFAULT
+#define SOF_SYNC_DEFAULT        1
+#endif
+
+//*****************************************************************************
+//
+// The function called from the scheduling timer interrupt to sample the
+// inputs, encode a report and hand it to the USB stack.  It returns true if
+// a report was queued.
+//
+//*****************************************************************************
+typedef bool (*tSOFSyncSampleFn)(void);
+
+//*****************************************************************************
+//
+// An optional function called from the USB interrupt on every new frame,
+// after the frame has been timestamped.
+//
+//*****************************************************************************
+typedef void (*tSOFSyncFrameFn)(void);
+
+//*****************************************************************************
+//
+// Phase error statistics.  The error is the time the report actually sat in
+// the FIFO before the host collected it, minus the configured lead.  A
+// positive error means the report was ready earlier than requested (staler
+// than necessary), a negative error means it was ready later.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // The number of reports queued by the scheduler.
+    //
+    uint32_t ui32Reports;
+
+    //
+    // The number of scheduled samples that ran after their target time.
+    //
+    uint32_t ui32Late;
+
+    //
+    // The number of reports that missed the poll they were scheduled for
+    // and went out one or more polling intervals later.
+    //
+    uint32_t ui32Missed;
+
+    //
+    // The most recent, smallest and largest phase error in microseconds.
+    //
+    int32_t i32LastErrorUs;
+    int32_t i32MinErrorUs;
+    int32_t i32MaxErrorUs;
+
+    //
+    // Running average of the absolute phase error in microseconds.
+    //
+    uint32_t ui32AvgAbsErrorUs;
+
+    //
+    // The learned poll phase relative to SOF, the polling interval in frames
+    // and the measured frame period.
+    //
+    uint32_t ui32PollPhaseUs;
+    uint32_t ui32PollInterval;
+    uint32_t ui32FramePeriodUs;
+
+    //
+    // The current worst-case sample-and-encode time in microseconds.
+    //
+    uint32_t ui32WorkUs;
+
+    //
+    // The achieved rates over the last second: reports collected by the
+    // host (TX_COMPLETE events) per 1000 frames, and frames per second of
+    // local time.
+    //
+    uint32_t ui32ReportRateHz;
+    uint32_t ui32SOFRateHz;
+}
+tSOFSyncStats;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void SOFSyncInit(uint32_t ui32LeadUs, tSOFSyncSampleFn pfnSample);
+extern void SOFSyncEnable(bool bEnable);
+extern void SOFSyncLeadSet(uint32_t ui32LeadUs);
+extern void SOFSyncFrameHookSet(tSOFSyncFrameFn pfnFrame);
+extern bool SOFSyncActive(void);
+extern void SOFSyncReset(void);
+extern void SOFSyncTxComplete(void);
+extern void SOFSyncStatsGet(tSOFSyncStats *psStats);
+extern void SOFSyncUSBIntHandler(void);
+extern void SOFSyncTimerIntHandler(void);
+
+#endif
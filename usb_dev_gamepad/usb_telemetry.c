@@ -0,0 +1,259 @@
+//*****************************************************************************
+//
+// usb_telemetry.c - Logs and statistics over the USB CDC serial interface.
+//
+// When the stick is built as a composite HID and CDC device, everything the
+// firmware prints goes to the CDC serial port whenever a host has it open
+// (DTR set), so a sealed cabinet can be monitored over the same USB cable
+// as the gamepad.  Otherwise output falls back to UART0 as before.
+//
+// The CDC data endpoints are bulk endpoints, which the host only schedules
+// in bandwidth left over after the periodic interrupt transfers, so
+// telemetry cannot delay the gamepad's reports on the bus.  On the device
+// side output is written only from the main loop and never waits: anything
+// that does not fit in the transmit buffer is counted and dropped.
+//
+//*****************************************************************************
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "usblib/usblib.h"
+#include "usblib/usbcdc.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdcdc.h"
+#include "usblib/device/usbdhid.h"
+#include "usblib/device/usbdhidgamepad.h"
+#include "utils/uartstdio.h"
+#include "utils/ustdlib.h"
+#include "usb_gamepad_structs.h"
+#include "usb_telemetry.h"
+
+//*****************************************************************************
+//
+// The number of bytes dropped because the transmit buffer was full.
+//
+//*****************************************************************************
+static uint32_t g_ui32TelemetryDropped;
+
+#if GAMEPAD_CDC
+//*****************************************************************************
+//
+// Set while the CDC interface is configured and the host has the port open.
+//
+//*****************************************************************************
+static volatile bool g_bTelemetryConfigured;
+static volatile bool g_bTelemetryOpen;
+
+//*****************************************************************************
+//
+// Handles CDC driver notifications related to control and setup of the
+// device.  The line coding is accepted and ignored since there is no real
+// UART behind the port.
+//
+//*****************************************************************************
+uint32_t
+TelemetryControlHandler(void *pvCBData, uint32_t ui32Event,
+                        uint32_t ui32MsgData, void *pvMsgData)
+{
+    tLineCoding *psLineCoding;
+
+    switch(ui32Event)
+    {
+        //
+        // The host has configured the device.  Start from empty buffers.
+        //
+        case USB_EVENT_CONNECTED:
+        {
+            USBBufferFlush(&g_sTelemetryTxBuffer);
+            USBBufferFlush(&g_sTelemetryRxBuffer);
+            g_bTelemetryConfigured = true;
+            break;
+        }
+
+        case USB_EVENT_DISCONNECTED:
+        {
+            g_bTelemetryConfigured = false;
+            g_bTelemetryOpen = false;
+            break;
+        }
+
+        //
+        // Report a plausible line coding to the host.
+        //
+        case USBD_CDC_EVENT_GET_LINE_CODING:
+        {
+            psLineCoding = (tLineCoding *)pvMsgData;
+            psLineCoding->ui32Rate = 115200;
+            psLineCoding->ui8Databits = 8;
+            psLineCoding->ui8Parity = USB_CDC_PARITY_NONE;
+            psLineCoding->ui8Stop = USB_CDC_STOP_BITS_1;
+            break;
+        }
+
+        //
+        // The host opens the port by raising DTR and closes it by dropping
+        // it.  Only send while someone is listening.
+        //
+        case USBD_CDC_EVENT_SET_CONTROL_LINE_STATE:
+        {
+            g_bTelemetryOpen = (ui32MsgData & USB_CDC_DTE_PRESENT) ? true :
+                                                                     false;
+            break;
+        }
+
+        //
+        // We ignore all other events.
+        //
+        default:
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Handles CDC driver notifications related to the transmit channel.  The USB
+// buffer does all the work.
+//
+//*****************************************************************************
+uint32_t
+TelemetryTxHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+                   void *pvMsgData)
+{
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Handles CDC driver notifications related to the receive channel.  Nothing
+// is accepted from the host yet, so received data is discarded.
+//
+//*****************************************************************************
+uint32_t
+TelemetryRxHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+                   void *pvMsgData)
+{
+    uint8_t pui8Discard[16];
+
+    switch(ui32Event)
+    {
+        case USB_EVENT_RX_AVAILABLE:
+        {
+            while(USBBufferRead(&g_sTelemetryRxBuffer, pui8Discard,
+                                sizeof(pui8Discard)))
+            {
+            }
+            break;
+        }
+
+        case USB_EVENT_DATA_REMAINING:
+        case USB_EVENT_REQUEST_BUFFER:
+        default:
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+#endif
+
+//*****************************************************************************
+//
+// Prepares the USB buffers.  This must be called before the device is placed
+// on the bus.
+//
+//*****************************************************************************
+void
+TelemetryInit(void)
+{
+#if GAMEPAD_CDC
+    USBBufferInit(&g_sTelemetryTxBuffer);
+    USBBufferInit(&g_sTelemetryRxBuffer);
+#endif
+}
+
+//*****************************************************************************
+//
+// Returns true if output is currently going over USB.
+//
+//*****************************************************************************
+bool
+TelemetryOpen(void)
+{
+#if GAMEPAD_CDC
+    return(g_bTelemetryConfigured && g_bTelemetryOpen);
+#else
+    return(false);
+#endif
+}
+
+//*****************************************************************************
+//
+// Writes raw bytes to the telemetry channel without waiting.  This must only
+// be called from the main loop.
+//
+// \return Returns the number of bytes accepted.
+//
+//*****************************************************************************
+uint32_t
+TelemetryWrite(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+#if GAMEPAD_CDC
+    uint32_t ui32Written;
+
+    if(TelemetryOpen())
+    {
+        ui32Written = USBBufferWrite(&g_sTelemetryTxBuffer, pui8Data,
+                                     ui32Len);
+        g_ui32TelemetryDropped += ui32Len - ui32Written;
+
+        return(ui32Written);
+    }
+#endif
+
+    return((uint32_t)UARTwrite((const char *)pui8Data, ui32Len));
+}
+
+//*****************************************************************************
+//
+// A printf() for the telemetry channel, supporting the same conversions as
+// UARTprintf().  Lines longer than TELEMETRY_LINE_MAX are truncated.  This
+// must only be called from the main loop.
+//
+//*****************************************************************************
+void
+TelemetryPrintf(const char *pcString, ...)
+{
+    char pcLine[TELEMETRY_LINE_MAX];
+    va_list vaArgP;
+    int iLen;
+
+    va_start(vaArgP, pcString);
+    iLen = uvsnprintf(pcLine, sizeof(pcLine), pcString, vaArgP);
+    va_end(vaArgP);
+
+    if(iLen > (int)(sizeof(pcLine) - 1))
+    {
+        iLen = sizeof(pcLine) - 1;
+    }
+
+    TelemetryWrite((const uint8_t *)pcLine, (uint32_t)iLen);
+}
+
+//*****************************************************************************
+//
+// Returns the number of bytes dropped because the host was not reading fast
+// enough.
+//
+//*****************************************************************************
+uint32_t
+TelemetryDroppedGet(void)
+{
+    return(g_ui32TelemetryDropped);
+}
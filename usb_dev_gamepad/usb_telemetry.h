@@ -0,0 +1,44 @@
+//*****************************************************************************
+//
+// usb_telemetry.h - Logs and statistics over the USB CDC serial interface.
+//
+//*****************************************************************************
+
+#ifndef _USB_TELEMETRY_H_
+#define _USB_TELEMETRY_H_
+
+//*****************************************************************************
+//
+// The size of the USB transmit and receive buffers.  Output that does not fit
+// in the transmit buffer is dropped rather than waited for.
+//
+//*****************************************************************************
+#define TELEMETRY_TX_BUFFER_SIZE    1024
+#define TELEMETRY_RX_BUFFER_SIZE    64
+
+//*****************************************************************************
+//
+// The longest single line TelemetryPrintf() will format.
+//
+//*****************************************************************************
+#define TELEMETRY_LINE_MAX          160
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void TelemetryInit(void);
+extern bool TelemetryOpen(void);
+extern uint32_t TelemetryWrite(const uint8_t *pui8Data, uint32_t ui32Len);
+extern void TelemetryPrintf(const char *pcString, ...);
+extern uint32_t TelemetryDroppedGet(void);
+extern uint32_t TelemetryControlHandler(void *pvCBData, uint32_t ui32Event,
+                                        uint32_t ui32MsgData,
+                                        void *pvMsgData);
+extern uint32_t TelemetryTxHandler(void *pvCBData, uint32_t ui32Event,
+                                   uint32_t ui32MsgData, void *pvMsgData);
+extern uint32_t TelemetryRxHandler(void *pvCBData, uint32_t ui32Event,
+                                   uint32_t ui32MsgData, void *pvMsgData);
+
+#endif